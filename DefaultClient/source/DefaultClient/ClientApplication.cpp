@@ -64,7 +64,11 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "OgreClient/Object/Text.h"
 #include "OgreClient/Physics/PhysicsManager.h"
 #include "OgreClient/Resource/ResourceManager.h"
+#include "Shared/Camp/PropertyIdTable.h"
 #include "Shared/Communication/GridPosition.h"
+#include "Shared/Communication/NetworkStage.h"
+#include "Shared/Communication/TrafficStatistics.h"
+#include "Shared/Communication/PacketReplay.h"
 #include "Shared/Communication/ServerInfo.h"
 #include "Shared/Crash/CrashReporter.h"
 #include "Shared/Object/TemplateComponentFactory.h"
@@ -72,6 +76,8 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "Shared/Plugin/Factories/TemplatePluginFactory.h"
 #include "Shared/Plugin/PluginManager.h"
 #include "Object/DefaultClientObjectManager.h"
+#include "Object/ReplicationChannels.h"
+#include "Object/DirtyReplicas.h"
 #include "State/LoadingState.h"
 #include "Util/Config/ConfigManager.h"
 #include "Util/Serialization/XMLSerializationFile.h"
@@ -227,6 +233,9 @@ void ClientApplication::init( int argc, char* argv[] )
         GameModePlugin::setDefaultSlot( sigc::ptr_fun( &DefaultGameMode::createGameMode ) );
         PluginManager::addAutoCreatePlugin<GameModePlugin>();
 
+        // Report properties that are sent by name because their identifiers collide.
+        PropertyIdTable::checkClasses();
+
         // Initialize graphics
         mGraphicsManager.reset( new GraphicsManager() );
         mConfigManager->registerObject( *mGraphicsManager );
@@ -261,6 +270,12 @@ void ClientApplication::init( int argc, char* argv[] )
         mGridManager.reset( new GridManager( mUpdateSignal ) );
         mConfigManager->registerObject( mGridManager.get() );
         mConfigManager->registerObject( ServerConnection::getSettings() );
+        mConfigManager->registerObject( NetworkStage::getSettings() );
+        mConfigManager->registerObject( TrafficStatistics::getSettings() );
+        mConfigManager->registerObject( PacketReplay::getSettings() );
+        mConfigManager->registerObject( TransformInterpolator::getSettings() );
+        mConfigManager->registerObject( ReplicationChannels::getSettings() );
+        mConfigManager->registerObject( DirtyReplicas::getSettings() );
         mCameraManager->setGridManager( *mGridManager.get() );
         ClientGlobals::mGrid = mGridManager.get();
 
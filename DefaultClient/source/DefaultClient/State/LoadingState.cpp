@@ -32,10 +32,13 @@ namespace DefaultClient
 {
 //------------------------------------------------------------------------------
 
-LoadingState::LoadingState()
+LoadingState::LoadingState():
+    mLastProgress( 0 )
 {
     ClientGlobals::mGrid->connectLoadingCompleted( sigc::mem_fun( this, 
         &LoadingState::loadingComplete ) );
+    ClientGlobals::mGrid->connectLoadingProgress( sigc::mem_fun( this, 
+        &LoadingState::loadingProgress ) );
     ClientGlobals::mGrid->connectActiveServerDisconnect( sigc::mem_fun( this, 
         &LoadingState::activeServerDisconnected ) );
 }
@@ -68,6 +71,20 @@ void LoadingState::loadingComplete()
     ClientGlobals::mState->pushState( new PlayState() );
 }
 
+void LoadingState::loadingProgress( ServerAbstract& rServer, unsigned int received, 
+    unsigned int total )
+{
+    if( !total ) return;
+
+    // Report progress in steps of 10 percent.
+    unsigned int progress = (unsigned int)( ( received * 10.0 ) / total ) * 10;
+    if( progress != mLastProgress || received == total )
+    {
+        LOGI << "Loading world: " << progress << "%";
+        mLastProgress = progress;
+    }
+}
+
 void LoadingState::activeServerDisconnected( ServerAbstract& rActiveServer )
 {
     if( mActive )
@@ -46,9 +46,11 @@ public:
     
 private:
     void loadingComplete();
+    void loadingProgress( ServerAbstract& rServer, unsigned int received, unsigned int total );
     void activeServerDisconnected( ServerAbstract& rActiveServer );
 
-    bool mActive;
+    bool            mActive;
+    unsigned int    mLastProgress;
 
 };
 
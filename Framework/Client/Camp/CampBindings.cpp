@@ -139,6 +139,12 @@ void CampBindings::bindGridManager()
         .property( "ConnectRange", &GridManager::mConnectRange )
             .tag( "Configurable" )
         .property( "SwitchStayTime", &GridManager::mSwitchStayTimeS )
+            .tag( "Configurable" )
+        .property( "Predictive", &GridManager::mPredictive )
+            .tag( "Configurable" )
+        .property( "PredictionTime", &GridManager::mPredictionTimeS )
+            .tag( "Configurable" )
+        .property( "PredictionMinSpeed", &GridManager::mPredictionMinSpeed )
             .tag( "Configurable" );
         // Functions
         // Static functions
@@ -160,6 +166,11 @@ void CampBindings::bindServerConnectionSettings()
         .property( "Timeout", &ServerConnection::Settings::mTimeoutMS )
             .tag( "Configurable" )
         .property( "ShutdownBlockDuraction", &ServerConnection::Settings::mShutdownBlockDuractionMS )
+        .property( "Loopback", &ServerConnection::Settings::mLoopback )
+            .tag( "Configurable" )
+        .property( "RecordFile", &ServerConnection::Settings::mRecordFile )
+            .tag( "Configurable" )
+        .property( "ReplayFile", &ServerConnection::Settings::mReplayFile )
             .tag( "Configurable" );
         // Functions
         // Static functions
@@ -29,6 +29,8 @@ THE SOFTWARE.
 #include "Client/Communication/GridManager.h"
 #include "Client/Communication/OfflineServer.h"
 #include "Client/Communication/ServerAbstract.h"
+#include "Client/Communication/ServerNeighborsPlugin.h"
+#include "Client/Plugin/ClientPluginManager.h"
 #include "Object/Object.h"
 #include "Shared/Communication/ServerPosition.h"
 #include <boost/timer.hpp>
@@ -43,11 +45,17 @@ GridManager::GridManager( sigc::signal<void>& rUpdateSignal ):
     mActiveServer( 0 ),
     mAvatar( 0 ),
     mAvatarLastPosition( Vector3::ZERO ),
+    mAvatarVelocity( Vector3::ZERO ),
+    mLastUpdateTime( RakNet::GetTime() ),
     mSwitchTimer( new boost::timer() ),
+    mSwitching( false ),
     mUpdateSignal( rUpdateSignal ),
     mConnectRange( 1 ),
     mHalfConnectRange( 2 ),
     mSwitchStayTimeS( 3.0 ),
+    mPredictive( false ),
+    mPredictionTimeS( 5.0 ),
+    mPredictionMinSpeed( 1.0 ),
     mLoadingSignalEmitted( false )
 {
     mUpdateSignal.connect( sigc::mem_fun( this, &GridManager::update ) );
@@ -92,6 +100,8 @@ ServerAbstract& GridManager::createServer( const GridPosition& rGridPosition,
         }
 
         server->connect( sigc::mem_fun( this, &GridManager::serverStateChanged ) );
+        server->getServerConnection().getReplicaManager().connectSnapshotProgress( sigc::bind( 
+            sigc::mem_fun( this, &GridManager::snapshotProgress ), server ) );
         mLoadingServers.insert( rGridPosition );
         return *server;
     }
@@ -155,6 +165,8 @@ void GridManager::clear()
         mRemovedServers.insert( i->second );
     }
 
+    mPredictedServers.clear();
+    mAwayServers.clear();
     mLoadingSignalEmitted = false;
 }
 
@@ -184,6 +196,10 @@ void GridManager::update()
     }
     mRemovedServers.clear();
 
+    RakNet::Time time = RakNet::GetTime();
+    Real elapsed = ( time - mLastUpdateTime ) / 1000.0;
+    mLastUpdateTime = time;
+
     // Check for server switch.
     if( mActiveServer && mAvatar )
     {
@@ -191,15 +207,26 @@ void GridManager::update()
         GridPosition avatarGridPos = GridPosition( ServerPosition( position ) );
         GridPosition lastAvatarGridPos = GridPosition( ServerPosition( mAvatarLastPosition ) );
 
+        if( mPredictive && elapsed > 0 )
+        {
+            // Smooth the avatar velocity over about a quarter of a second.
+            Vector3 velocity = ( position - mAvatarLastPosition ) / elapsed;
+            mAvatarVelocity += ( velocity - mAvatarVelocity ) * std::min( elapsed / 0.25, 1.0 );
+            GridManager::updatePrediction( position );
+        }
+
         if( avatarGridPos != lastAvatarGridPos )
         {
             // The avatar crossed a server boundary.
             mSwitching = true;
             mSwitchTimer->restart();
         }
-        else if( mSwitching && mSwitchTimer->elapsed() >= mSwitchStayTimeS )
+
+        if( mSwitching && ( mSwitchTimer->elapsed() >= mSwitchStayTimeS || 
+            GridManager::willStay( position, avatarGridPos ) ) )
         {
-            // The avatar stayed on the other server for mSwitchStayTimeS, set new active server.
+            // The avatar stayed on the other server for mSwitchStayTimeS, or is predicted to 
+            // stay there, set new active server.
             mSwitching = false;
             setActiveServer( avatarGridPos );
         }
@@ -212,6 +239,10 @@ void GridManager::update()
 
         mAvatarLastPosition = position;
     }
+    else
+    {
+        mAvatarVelocity = Vector3::ZERO;
+    }
 }
 
 void GridManager::serverStateChanged( ServerState state, ServerAbstract& rServer )
@@ -238,6 +269,12 @@ void GridManager::serverStateChanged( ServerState state, ServerAbstract& rServer
     }
 }
 
+void GridManager::snapshotProgress( unsigned int received, unsigned int total, 
+    ServerAbstract* pServer )
+{
+    mLoadingProgressSignal( *pServer, received, total );
+}
+
 void GridManager::setActiveServer( const GridPosition& rGridPosition )
 {
     if( !mActiveServer || mActiveServer->getGridPosition() != rGridPosition )
@@ -266,7 +303,8 @@ void GridManager::setState( const GridPosition& rGridPosition )
     unsigned short distance = mActiveServer->getGridPosition().distanceBetween( rGridPosition );
     if( distance != 0 )
     {
-        if( distance <= mConnectRange )
+        if( ( distance <= mConnectRange && !GridManager::isMovingAway( rGridPosition ) ) || 
+            mPredictedServers.count( rGridPosition ) )
         {
             server.setStateConnected();
         }
@@ -281,6 +319,90 @@ void GridManager::setState( const GridPosition& rGridPosition )
     }
 }
 
+void GridManager::updatePrediction( const Vector3& rPosition )
+{
+    GridManager::discoverNeighbors();
+
+    // Servers on the predicted path of the avatar, and servers the avatar is moving away from.
+    std::set<GridPosition> predicted;
+    std::set<GridPosition> away;
+    if( mAvatarVelocity.length() >= mPredictionMinSpeed )
+    {
+        const unsigned int steps = 8;
+        for( unsigned int i = 1; i <= steps; ++i )
+        {
+            Vector3 position = rPosition + mAvatarVelocity * ( mPredictionTimeS * i / steps );
+            GridPosition gridPosition = GridPosition( ServerPosition( position ) );
+            if( gridPosition != mActiveServer->getGridPosition() ) 
+                predicted.insert( gridPosition );
+        }
+
+        for( ServerGrid::iterator i = mServerGrid.begin(); i != mServerGrid.end(); ++i )
+        {
+            std::pair<short, short> active = mActiveServer->getGridPosition().getPosition();
+            std::pair<short, short> server = i->first.getPosition();
+            Real dot = mAvatarVelocity.x * ( server.first - active.first ) + 
+                mAvatarVelocity.z * ( server.second - active.second );
+            if( dot < 0 && !predicted.count( i->first ) ) away.insert( i->first );
+        }
+    }
+
+    predicted.swap( mPredictedServers );
+    away.swap( mAwayServers );
+
+    // Only update the state of servers that are predicted differently, so that servers that 
+    // failed to connect are not retried every update.
+    for( ServerGrid::iterator i = mServerGrid.begin(); i != mServerGrid.end(); ++i )
+    {
+        if( i->second == mActiveServer || mRemovedServers.count( i->second ) ) continue;
+
+        if( predicted.count( i->first ) != mPredictedServers.count( i->first ) || 
+            away.count( i->first ) != mAwayServers.count( i->first ) )
+        {
+            GridManager::setState( i->first );
+        }
+    }
+}
+
+void GridManager::discoverNeighbors()
+{
+    ClientPluginManager& pluginManager = mActiveServer->getPluginManager();
+    if( !pluginManager.hasPlugin<ServerNeighborsPlugin>() ) return;
+
+    // Add the neighbors of the active server to the grid.
+    const NeighborsMap& neighbors = pluginManager.getPlugin<ServerNeighborsPlugin>().
+        getServerNeighbors().getNeighbors();
+    for( NeighborsMap::const_iterator i = neighbors.begin(); i != neighbors.end(); ++i )
+    {
+        GridPosition gridPosition = GridPosition( 
+            mActiveServer->getGridPosition().getPositionAtDirection( i->first ) );
+        if( !GridManager::hasServer( gridPosition ) )
+        {
+            GridManager::createServer( gridPosition, i->second, mActiveServer->getUserInfo() );
+
+            // Discovered servers do not delay the loading completed signal.
+            mLoadingServers.erase( gridPosition );
+            GridManager::setState( gridPosition );
+        }
+    }
+}
+
+bool GridManager::isMovingAway( const GridPosition& rGridPosition ) const
+{
+    return mPredictive && mAwayServers.count( rGridPosition );
+}
+
+bool GridManager::willStay( const Vector3& rPosition, const GridPosition& rGridPosition )
+{
+    if( !mPredictive || !GridManager::hasServer( rGridPosition ) ) return false;
+
+    // Switch right away to a server that is already connected, when the avatar is not predicted
+    // to leave it again within the switch stay time.
+    ServerState state = GridManager::getServer( rGridPosition ).getServerState();
+    return state >= CONNECTED && GridPosition( ServerPosition( rPosition + mAvatarVelocity * 
+        mSwitchStayTimeS ) ) == rGridPosition;
+}
+
 //------------------------------------------------------------------------------
 } // Namespace Client
 } // Namespace Diversia
\ No newline at end of file
@@ -149,6 +149,20 @@ public:
         return mLoadingCompletedSignal.connect( rSlot );
     }
     /**
+    Connects a slot to the loading progress signal, emitted when a part of the world of a server
+    is received.
+    
+    @param [in,out] rSlot   The slot (signature: void func(ServerAbstract&, unsigned int 
+    [received bytes], unsigned int [total bytes])) to connect. 
+    
+    @return Connection object to block or disconnect the connection.
+    **/
+    inline sigc::connection connectLoadingProgress( 
+        const sigc::slot<void, ServerAbstract&, unsigned int, unsigned int>& rSlot ) 
+    {
+        return mLoadingProgressSignal.connect( rSlot );
+    }
+    /**
     Connects a slot to the active server disconnect signal. 
     
     @param [in,out] rSlot   The slot (signature: void func(ServerAbstract& [active server])) to connect. 
@@ -165,21 +179,31 @@ private:
 
     void update();
     void serverStateChanged( ServerState state, ServerAbstract& rServer );
+    void snapshotProgress( unsigned int received, unsigned int total, ServerAbstract* pServer );
     void setActiveServer( const GridPosition& rGridPosition );
     void setState( const GridPosition& rGridPosition );
+    void updatePrediction( const Vector3& rPosition );
+    void discoverNeighbors();
+    bool isMovingAway( const GridPosition& rGridPosition ) const;
+    bool willStay( const Vector3& rPosition, const GridPosition& rGridPosition );
 
     ServerGrid                          mServerGrid;
     Servers                             mRemovedServers;
     ServerAbstract*                     mActiveServer;
     Object*                             mAvatar;
     Vector3                             mAvatarLastPosition;
+    Vector3                             mAvatarVelocity;
+    RakNet::Time                        mLastUpdateTime;
     boost::scoped_ptr<boost::timer>     mSwitchTimer;
     bool                                mSwitching;
     std::set<GridPosition>              mLoadingServers;
     bool                                mLoadingSignalEmitted;
+    std::set<GridPosition>              mPredictedServers;  ///< Servers the avatar is heading to.
+    std::set<GridPosition>              mAwayServers;       ///< Servers the avatar moves away from.
 
     sigc::signal<void, ServerAbstract&, bool>   mServerChangeSignal;
     sigc::signal<void>                          mLoadingCompletedSignal;
+    sigc::signal<void, ServerAbstract&, unsigned int, unsigned int> mLoadingProgressSignal;
     sigc::signal<void, ServerAbstract&>         mActiveServerDisconnectSignal;
     sigc::signal<void>&                         mUpdateSignal;
 
@@ -187,6 +211,9 @@ private:
     unsigned short  mConnectRange;
     unsigned short  mHalfConnectRange;
     Real            mSwitchStayTimeS;
+    bool            mPredictive;            ///< Connect to servers along the avatar's velocity.
+    Real            mPredictionTimeS;       ///< How far ahead the avatar's path is predicted.
+    Real            mPredictionMinSpeed;    ///< Minimum avatar speed to predict a path.
     
 };
 
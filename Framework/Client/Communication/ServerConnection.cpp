@@ -27,6 +27,7 @@ THE SOFTWARE.
 #include "Client/Platform/StableHeaders.h"
 
 #include "Client/Communication/ServerConnection.h"
+#include "Shared/Communication/TrafficStatistics.h"
 
 namespace Diversia
 {
@@ -50,29 +51,44 @@ ServerConnection::ServerConnection( const ServerInfo& rServerInfo,
     sigc::signal<void>& rUpdateSignal ):
     mServerInfo( rServerInfo ),
     mConnectionState( DISCONNECTED ),
-    mRakPeer( *RakNet::RakPeerInterface::GetInstance() )
+    mRakPeer( *new LoopbackPeer() ),
+    mNetworkStage( mRakPeer )
 {
     rUpdateSignal.connect( sigc::mem_fun( this, &ServerConnection::update ) );
 
     mRPC3.SetNetworkIDManager( &mNetworkIDManager );
     mReplicaManager.SetNetworkIDManager( &mNetworkIDManager );
 
-    mRakPeer.AttachPlugin( &mRPC3 );
-    mRakPeer.AttachPlugin( &mReplicaManager );
-    
+    mNetworkStage.attachPlugin( mRPC3 );
+    mNetworkStage.attachPlugin( mReplicaManager );
 }
 
 ServerConnection::~ServerConnection()
 {
-    mRakPeer.DetachPlugin( &mRPC3 );
+    mNetworkStage.stop();
+    mNetworkStage.setRecorder( 0 );
+    mNetworkStage.setReplay( 0 );
+    mNetworkStage.detachPlugin( mRPC3 );
     mRakPeer.Shutdown( msSettings.mShutdownBlockDuractionMS );
-    RakNet::RakPeerInterface::DestroyInstance( &mRakPeer );
+    delete &mRakPeer;
 }
 
 bool ServerConnection::connect()
 {
     if( mConnectionState != AUTHENTICATING && mConnectionState != CONNECTED )
     {
+        if( !msSettings.mReplayFile.empty() ) return ServerConnection::replay();
+
+        if( msSettings.mLoopback && mRakPeer.connect( mServerInfo ) )
+        {
+            // Server is running in this process, connected without sockets.
+            LCLOGI << "Connecting to server in this process: " << mServerInfo.getAddressMerged();
+            if( !msSettings.mRecordFile.empty() ) ServerConnection::startRecording();
+            mNetworkStage.start();
+            ServerConnection::setState( CONNECTING );
+            return true;
+        }
+
         if( mRakPeer.Startup( 1, &RakNet::SocketDescriptor(), 1 ) == RakNet::RAKNET_STARTED )
         {
             if( msSettings.mTimeoutMS != 0 )
@@ -83,6 +99,8 @@ bool ServerConnection::connect()
                 msSettings.mTimeoutMS ) == RakNet::CONNECTION_ATTEMPT_STARTED )
             {
                 // RakNet is trying to connect.
+                if( !msSettings.mRecordFile.empty() ) ServerConnection::startRecording();
+                mNetworkStage.start();
                 ServerConnection::setState( CONNECTING );
                 return true;
             }
@@ -102,55 +120,61 @@ bool ServerConnection::connect()
 
 void ServerConnection::disconnect()
 {
+    mNetworkStage.stop();
+    mNetworkStage.setRecorder( 0 );
+    mRecorder.reset();
     mRakPeer.Shutdown( msSettings.mShutdownBlockDuractionMS );
     ServerConnection::setState( DISCONNECTED );
 }
 
 void ServerConnection::update()
 {
+    mNetworkStage.update();
+    TrafficStatistics::update();
+
     RakNet::Packet *packet;
-    for( packet = mRakPeer.Receive(); packet; mRakPeer.DeallocatePacket( packet ), 
-        packet = mRakPeer.Receive() )
+    for( packet = mNetworkStage.receive(); packet; mNetworkStage.deallocatePacket( packet ), 
+        packet = mNetworkStage.receive() )
     {
         switch ( packet->data[0] )
         {
             case ID_DISCONNECTION_NOTIFICATION:
                 // Connection lost normally.
                 LCLOGI << "Disconnected from server: " << packet->systemAddress.ToString();
-                mRakPeer.DeallocatePacket( packet );
+                mNetworkStage.deallocatePacket( packet );
                 disconnect();
                 return;
             case ID_ALREADY_CONNECTED:
                 // Already connected to the server.
                 LCLOGE << "Already connected to server: " << packet->systemAddress.ToString();
-                mRakPeer.DeallocatePacket( packet );
+                mNetworkStage.deallocatePacket( packet );
                 disconnect();
                 return;
             case ID_CONNECTION_BANNED:
                 // Banned from this server.
                 LCLOGE << "Banned from server: " << packet->systemAddress.ToString();
-                mRakPeer.DeallocatePacket( packet );
+                mNetworkStage.deallocatePacket( packet );
                 disconnect();
                 ServerConnection::setState( BANNED );
                 return;
             case ID_CONNECTION_ATTEMPT_FAILED:
                 // Connection attempt failed.
                 LCLOGE << "Connection attempt failed: " << packet->systemAddress.ToString();
-                mRakPeer.DeallocatePacket( packet );
+                mNetworkStage.deallocatePacket( packet );
                 disconnect();
                 ServerConnection::setState( CONNFAIL );
                 return;
             case ID_NO_FREE_INCOMING_CONNECTIONS:
                 // The server is full.
                 LCLOGE << "Server is full: " << packet->systemAddress.ToString();
-                mRakPeer.DeallocatePacket( packet );
+                mNetworkStage.deallocatePacket( packet );
                 disconnect();
                 ServerConnection::setState( FULL );
                 return;
             case ID_CONNECTION_LOST:
                 // Packet modification, disconnect.
                 LCLOGE << "Connection to server was lost: " << packet->systemAddress.ToString();
-                mRakPeer.DeallocatePacket( packet );
+                mNetworkStage.deallocatePacket( packet );
                 disconnect();
                 ServerConnection::setState( CONNLOST );
                 return;
@@ -199,6 +223,45 @@ void ServerConnection::update()
     }
 }
 
+bool ServerConnection::replay()
+{
+    // Replay a recorded session instead of connecting, the recording contains the connection
+    // messages.
+    try
+    {
+        mReplay.reset( new PacketReplay( msSettings.mReplayFile, mRakPeer ) );
+    }
+    catch( Exception e )
+    {
+        LCLOGE << "Could not replay server packets: " << e.what();
+        ServerConnection::setState( CONNFAIL );
+        return false;
+    }
+
+    mNetworkStage.setReplay( mReplay.get() );
+    mNetworkStage.start();
+    ServerConnection::setState( CONNECTING );
+    return true;
+}
+
+void ServerConnection::startRecording()
+{
+    // Every server connection records to its own file.
+    Path file = msSettings.mRecordFile.parent_path() / ( msSettings.mRecordFile.stem() + "_" + 
+        mServerInfo.getAddressMergedSafe() + msSettings.mRecordFile.extension() );
+
+    try
+    {
+        mRecorder.reset( new PacketRecorder( file ) );
+        mNetworkStage.setRecorder( mRecorder.get() );
+        LCLOGI << "Recording server packets to " << file.file_string();
+    }
+    catch( Exception e )
+    {
+        LCLOGW << "Could not record server packets: " << e.what();
+    }
+}
+
 void ServerConnection::setState( State state )
 {
     mConnectionState = state;
@@ -30,6 +30,10 @@ THE SOFTWARE.
 #include "Client/Platform/Prerequisites.h"
 
 #include "Object/RPC3/RPC3.h"
+#include "Shared/Communication/LoopbackPeer.h"
+#include "Shared/Communication/NetworkStage.h"
+#include "Shared/Communication/PacketRecorder.h"
+#include "Shared/Communication/PacketReplay.h"
 #include "Shared/Communication/ReplicaManager.h"
 #include "Shared/Communication/ServerInfo.h"
 
@@ -86,7 +90,8 @@ public:
     virtual ~ServerConnection();
 
     /**
-    Connects to the server. 
+    Connects to the server, or replays the packets of a recorded session if a replay file is set.
+    Servers that listen in this process are connected to without sockets.
     
     @return True if it succeeds, false if it fails. 
     **/
@@ -141,6 +146,14 @@ private:
     **/
     void update();
     /**
+    Replays the packets in the replay file instead of connecting.
+    **/
+    bool replay();
+    /**
+    Starts recording received packets to the record file of this server.
+    **/
+    void startRecording();
+    /**
     Sets the connection state. 
     **/
     void setState( State state );
@@ -148,10 +161,13 @@ private:
     ServerInfo                  mServerInfo;
     State                       mConnectionState;
 
-    RakNet::RakPeerInterface&   mRakPeer;
+    LoopbackPeer&               mRakPeer;
     RakNet::NetworkIDManager    mNetworkIDManager;
     ReplicaManager              mReplicaManager;
     RakNet::RPC3                mRPC3;
+    NetworkStage                mNetworkStage;
+    boost::scoped_ptr<PacketRecorder>   mRecorder;
+    boost::scoped_ptr<PacketReplay>     mReplay;
 
     sigc::signal<void, State, ServerConnection&> mStateChangedSignal;
 
@@ -165,13 +181,19 @@ private:
             mConnectionAttemptCount( 12 ),
             mTimeBetweenConnectionAttemptsMS( 500 ),
             mTimeoutMS( 0 ),
-            mShutdownBlockDuractionMS( 5000 ) {}
+            mShutdownBlockDuractionMS( 5000 ),
+            mLoopback( true ),
+            mRecordFile( "" ),
+            mReplayFile( "" ) {}
 
         unsigned short  mThreadSleepTimer;
         unsigned short  mConnectionAttemptCount;
         unsigned short  mTimeBetweenConnectionAttemptsMS;
         RakNet::Time    mTimeoutMS;	///< 0 uses default value. 
         unsigned short  mShutdownBlockDuractionMS;
+        bool            mLoopback;      ///< Connects to servers in this process without sockets.
+        Path            mRecordFile;    ///< Records received packets if not empty, per server.
+        Path            mReplayFile;    ///< Replays instead of connecting if not empty.
     } msSettings;
 
 public:
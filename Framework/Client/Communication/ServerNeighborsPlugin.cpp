@@ -55,8 +55,8 @@ bool ServerNeighborsPlugin::DeserializeConstruction( RakNet::BitStream* pConstru
 
 void ServerNeighborsPlugin::Deserialize( RakNet::DeserializeParameters* pDeserializeParameters )
 {
-    // Receive neighbor map.
-    pDeserializeParameters->serializationBitstream[0] >> mServerNeighbors;
+    // Receive changes to the neighbor map.
+    mServerNeighbors.readDelta( pDeserializeParameters->serializationBitstream[0] );
     mNeighborUpdateSignal( mServerNeighbors );
 }
 
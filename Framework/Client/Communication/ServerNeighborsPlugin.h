@@ -55,6 +55,10 @@ public:
     **/
     inline String getTypeName() const { return PLUGINNAME_SERVERNEIGHBORS; }
     static inline String getTypeNameStatic() { return PLUGINNAME_SERVERNEIGHBORS; }
+    /**
+    Gets the neighbors of the server.
+    **/
+    inline ServerNeighbors& getServerNeighbors() { return mServerNeighbors; }
 
     /**
     Connects a slot to the neighbors changed signal.
@@ -24,9 +24,11 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 
 #include "Object/ComponentFactoryManager.h"
 #include "Object/ComponentFactory.h"
+#include "Object/ComponentTemplate.h"
 #include "Client/Object/ClientComponent.h"
 #include "Client/Object/ClientObject.h"
 #include "Client/Permission/PermissionManager.h"
+#include "Shared/Communication/ReplicaConnection.h"
 #include "Shared/Camp/CampStringInterpreter.h"
 
 namespace Diversia
@@ -259,12 +261,45 @@ void ClientComponent::queryInsertProperty( const String& rQuery, camp::Value& rV
         rValue, "ClientComponent::queryInsertProperty" );
 }
 
+RakNet::Replica3* ClientComponent::getConstructionReference( 
+    RakNet::Connection_RM3* pDestinationConnection, const PropertyValueMap*& rpProperties )
+{
+    // Construct the component relative to the component template it was created from, so that
+    // only the properties that differ from the template are sent. Only done when running in server
+    // mode, the server does not know about component templates created by clients.
+    ComponentTemplate* componentTemplate = Component::getTemplate();
+    if( Component::getMode() == SERVER && componentTemplate && 
+        componentTemplate->getNetworkingType() == REMOTE && 
+        pDestinationConnection->HasReplicaConstructed( componentTemplate ) )
+    {
+        rpProperties = &componentTemplate->getProperties();
+        return componentTemplate;
+    }
+
+    return 0;
+}
+
+const PropertyValueMap* ClientComponent::getConstructionReferenceProperties( 
+    RakNet::NetworkID networkID )
+{
+    RakNet::Replica3* replica = Replica3::GetNetworkIDManager()->
+        GET_OBJECT_FROM_ID<RakNet::Replica3*>( networkID );
+    ComponentTemplate* componentTemplate = dynamic_cast<ComponentTemplate*>( replica );
+    if( componentTemplate ) return &componentTemplate->getProperties();
+
+    return 0;
+}
+
 RakNet::RM3ConstructionState ClientComponent::QueryConstruction( 
     RakNet::Connection_RM3* pDestinationConnection, RakNet::ReplicaManager3* pReplicaManager3 )
 {
     // Always allow, permission checking is done in Object.
-    return Replica3::QueryConstruction_ClientConstruction( pDestinationConnection,
-        Component::getMode() == SERVER ? true : false );
+    RakNet::RM3ConstructionState state = Replica3::QueryConstruction_ClientConstruction( 
+        pDestinationConnection, Component::getMode() == SERVER ? true : false );
+
+    // Replicas from the world snapshot already exist on the server.
+    return static_cast<ReplicaConnection*>( pDestinationConnection )->getWorldSnapshot(
+        ).queryConstruction( *this, state, *pReplicaManager3 );
 }
 
 bool ClientComponent::QueryRemoteConstruction( RakNet::Connection_RM3* pSourceConnection )
@@ -296,8 +331,8 @@ void ClientComponent::SerializeConstruction( RakNet::BitStream* pConstructionBit
 bool ClientComponent::DeserializeConstruction( RakNet::BitStream* pConstructionBitstream, 
     RakNet::Connection_RM3* pSourceConnection )
 {
-    PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, pSourceConnection );
-    return true;
+    return PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, 
+        pSourceConnection );
 }
 
 RakNet::RM3SerializationResult ClientComponent::Serialize( 
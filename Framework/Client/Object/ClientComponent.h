@@ -134,6 +134,15 @@ protected:
     virtual RakNet::RM3SerializationResult Serialize( 
         RakNet::SerializeParameters* pSerializeParameters );
     virtual void Deserialize( RakNet::DeserializeParameters* pDeserializeParameters );
+    inline virtual unsigned char getReplicaType() const { return REPLICATYPE_COMPONENT; }
+    /**
+    Components are owned by the client that controls their object when running in server mode.
+    **/
+    inline virtual RakNet::RakNetGUID getPropertyOwner() 
+    { 
+        return Component::getMode() == SERVER ? Component::getObject().getClientController() : 
+            RakNet::UNASSIGNED_RAKNET_GUID;
+    }
 
     ResourceList mResourceList;
 
@@ -143,6 +152,9 @@ private:
     void cleanupQuerySetNetworkingType( NetworkingType type );
     void querySetProperty( const String& rQuery, camp::Value& rValue );
     void queryInsertProperty( const String& rQuery, camp::Value& rValue );
+    RakNet::Replica3* getConstructionReference( RakNet::Connection_RM3* pDestinationConnection, 
+        const PropertyValueMap*& rpProperties );
+    const PropertyValueMap* getConstructionReferenceProperties( RakNet::NetworkID networkID );
 
     PermissionManager&  mPermissionManager;
 
@@ -281,8 +281,8 @@ void ClientComponentTemplate::SerializeConstruction( RakNet::BitStream* pConstru
 bool ClientComponentTemplate::DeserializeConstruction( RakNet::BitStream* pConstructionBitstream, 
     RakNet::Connection_RM3* pSourceConnection )
 {
-    PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, pSourceConnection );
-    return true;
+    return PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, 
+        pSourceConnection );
 }
 
 RakNet::RM3SerializationResult ClientComponentTemplate::Serialize( 
@@ -88,6 +88,7 @@ private:
     RakNet::RM3SerializationResult Serialize(
         RakNet::SerializeParameters* pSerializeParameters );
     void Deserialize( RakNet::DeserializeParameters* pDeserializeParameters );
+    inline unsigned char getReplicaType() const { return REPLICATYPE_COMPONENTTEMPLATE; }
 
     PermissionManager& mPermissionManager;
 
@@ -27,6 +27,7 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "Client/Object/ClientObject.h"
 #include "Client/Object/ClientComponent.h"
 #include "Client/Permission/PermissionManager.h"
+#include "Shared/Communication/ReplicaConnection.h"
 
 namespace Diversia
 {
@@ -201,8 +202,12 @@ RakNet::RM3ConstructionState ClientObject::QueryConstruction(
     RakNet::Connection_RM3* pDestinationConnection, RakNet::ReplicaManager3* pReplicaManager3 )
 {
     // Always allow, permission checking is done in ObjectManager.
-    return Replica3::QueryConstruction_ClientConstruction( pDestinationConnection, 
-        Object::getMode() == SERVER ? true : false );
+    RakNet::RM3ConstructionState state = Replica3::QueryConstruction_ClientConstruction( 
+        pDestinationConnection, Object::getMode() == SERVER ? true : false );
+
+    // Replicas from the world snapshot already exist on the server.
+    return static_cast<ReplicaConnection*>( pDestinationConnection )->getWorldSnapshot(
+        ).queryConstruction( *this, state, *pReplicaManager3 );
 }
 
 bool ClientObject::QueryRemoteConstruction( RakNet::Connection_RM3* pSourceConnection )
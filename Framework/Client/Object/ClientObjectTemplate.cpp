@@ -317,8 +317,8 @@ void ClientObjectTemplate::SerializeConstruction( RakNet::BitStream* pConstructi
 bool ClientObjectTemplate::DeserializeConstruction( RakNet::BitStream* pConstructionBitstream, 
     RakNet::Connection_RM3* pSourceConnection )
 {
-    PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, pSourceConnection );
-    return true;
+    return PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, 
+        pSourceConnection );
 }
 
 RakNet::RM3SerializationResult ClientObjectTemplate::Serialize( 
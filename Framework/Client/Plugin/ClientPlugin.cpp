@@ -81,8 +81,8 @@ void ClientPlugin::SerializeConstruction( RakNet::BitStream* pConstructionBitstr
 bool ClientPlugin::DeserializeConstruction( RakNet::BitStream* pConstructionBitstream, 
     RakNet::Connection_RM3* pSourceConnection )
 {
-    PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, pSourceConnection );
-    return true;
+    return PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, 
+        pSourceConnection );
 }
 
 RakNet::RM3SerializationResult ClientPlugin::Serialize( 
@@ -96,6 +96,12 @@ void ClientPlugin::Deserialize( RakNet::DeserializeParameters* pDeserializeParam
     PropertySynchronization::doDeserialize( pDeserializeParameters );
 }
 
+RakNet::RM3QuerySerializationResult ClientPlugin::QuerySerialization( 
+    RakNet::Connection_RM3* pDestinationConnection )
+{
+    return PropertySynchronization::doQuerySerialization( pDestinationConnection );
+}
+
 void ClientPlugin::querySetProperty( const String& rQuery, camp::Value& rValue )
 {
     if( mPermissionManager )
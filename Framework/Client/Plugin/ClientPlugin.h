@@ -112,6 +112,8 @@ protected:
     virtual RakNet::RM3SerializationResult Serialize( 
         RakNet::SerializeParameters* pSerializeParameters );
     virtual void Deserialize( RakNet::DeserializeParameters* pDeserializeParameters );
+    virtual RakNet::RM3QuerySerializationResult QuerySerialization( 
+        RakNet::Connection_RM3* pDestinationConnection );
 
     void querySetProperty( const String& rQuery, camp::Value& rValue );
     void queryInsertProperty( const String& rQuery, camp::Value& rValue );
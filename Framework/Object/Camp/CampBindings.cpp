@@ -33,6 +33,9 @@ THE SOFTWARE.
 #include "Object/ObjectManager.h"
 #include "Object/ObjectTemplate.h"
 #include "Object/ObjectTemplateManager.h"
+#include "Object/ReplicationChannels.h"
+#include "Object/DirtyReplicas.h"
+#include "Object/TransformInterpolator.h"
 #include "Util/Camp/ValueMapper.h"
 #include "Util/Math/Node.h"
 
@@ -156,6 +159,10 @@ void CampBindings::bindObject()
         // Properties (read/write)
         .property( "DisplayName", &Object::getDisplayName, &Object::setDisplayName )
             .tag( "NoBitStream" )
+        .property( "PositionPrecision", &Object::getPositionPrecision, &Object::setPositionPrecision )
+            .tag( "NoBitStream" )
+        .property( "OrientationPrecision", &Object::getOrientationPrecision, &Object::setOrientationPrecision )
+            .tag( "NoBitStream" )
         .property( "NetworkingType", &Object::getNetworkingType, boost::bind( &Object::setNetworkingType, _1, _2, false ) )
             .tag( "NoBitStream" )
         .property<Object*>( "Parent", &Object::getParentObjectRef, boost::bind( (void(Object::*)(Object*, RakNet::RakNetGUID))&Object::parent, _1, _2, RakNet::RakNetGUID( 0 ) ) )
@@ -447,6 +454,64 @@ void CampBindings::bindComponentTemplate()
         // Operators
 }
 
+void CampBindings::bindTransformInterpolatorSettings()
+{
+    camp::Class::declare<TransformInterpolator::Settings>( "TransformInterpolatorSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Enabled", &TransformInterpolator::Settings::mEnabled )
+            .tag( "Configurable" )
+        .property( "InterpolationDelay", &TransformInterpolator::Settings::mInterpolationDelayMS )
+            .tag( "Configurable" )
+        .property( "MaxExtrapolation", &TransformInterpolator::Settings::mMaxExtrapolationMS )
+            .tag( "Configurable" )
+        .property( "ExtrapolationDecay", 
+            &TransformInterpolator::Settings::mExtrapolationDecayMS )
+            .tag( "Configurable" )
+        .property( "TeleportDistance", &TransformInterpolator::Settings::mTeleportDistance )
+            .tag( "Configurable" )
+        .property( "MaxSnapshots", &TransformInterpolator::Settings::mMaxSnapshots )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindReplicationChannelsSettings()
+{
+    camp::Class::declare<ReplicationChannels::Settings>( "ReplicationChannelsSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Enabled", &ReplicationChannels::Settings::mEnabled )
+            .tag( "Configurable" )
+        .property( "TransformChannel", &ReplicationChannels::Settings::mTransformChannel )
+            .tag( "Configurable" )
+        .property( "StateChannel", &ReplicationChannels::Settings::mStateChannel )
+            .tag( "Configurable" )
+        .property( "RestDelay", &ReplicationChannels::Settings::mRestDelayMS )
+            .tag( "Configurable" )
+        .property( "ComponentChannels", &ReplicationChannels::Settings::mComponentChannels )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindDirtyReplicasSettings()
+{
+    camp::Class::declare<DirtyReplicas::Settings>( "DirtyReplicasSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Enabled", &DirtyReplicas::Settings::mEnabled )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
 //------------------------------------------------------------------------------
 } // Namespace Bindings
 } // Namespace ObjectSystem
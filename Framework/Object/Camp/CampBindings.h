@@ -50,6 +50,9 @@ public:
     static void bindObjectTemplate();
     static void bindObjectTemplateManager();
     static void bindComponentTemplate();
+    static void bindTransformInterpolatorSettings();
+    static void bindReplicationChannelsSettings();
+    static void bindDirtyReplicasSettings();
 
 };
 
@@ -0,0 +1,94 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Object/Platform/StableHeaders.h"
+
+#include "Object/DirtyReplicas.h"
+
+namespace Diversia
+{
+namespace ObjectSystem
+{
+//------------------------------------------------------------------------------
+
+DirtyReplicas::Settings DirtyReplicas::msSettings = DirtyReplicas::Settings();
+DirtyReplicas::ReplicasByManager DirtyReplicas::msReplicas = DirtyReplicas::ReplicasByManager();
+unsigned int DirtyReplicas::msQueriedCount = 0;
+
+void DirtyReplicas::mark( RakNet::Replica3& rReplica )
+{
+    if( !msSettings.mEnabled || !rReplica.replicaManager ) return;
+
+    msReplicas[rReplica.replicaManager].mDirty.insert( &rReplica );
+}
+
+void DirtyReplicas::unmark( RakNet::Replica3& rReplica )
+{
+    // The replica manager may already have dereferenced the replica, remove it everywhere.
+    for( ReplicasByManager::iterator i = msReplicas.begin(); i != msReplicas.end(); ++i )
+    {
+        i->second.mDirty.erase( &rReplica );
+        i->second.mTaken.erase( &rReplica );
+    }
+}
+
+void DirtyReplicas::beginUpdate( RakNet::ReplicaManager3& rReplicaManager )
+{
+    Replicas& replicas = msReplicas[&rReplicaManager];
+    replicas.mTaken.swap( replicas.mDirty );
+    replicas.mDirty.clear();
+    replicas.mQueried = false;
+}
+
+const std::set<RakNet::Replica3*>& DirtyReplicas::query( 
+    RakNet::ReplicaManager3& rReplicaManager )
+{
+    Replicas& replicas = msReplicas[&rReplicaManager];
+    if( !replicas.mQueried ) msQueriedCount = (unsigned int)replicas.mTaken.size();
+    replicas.mQueried = true;
+    return replicas.mTaken;
+}
+
+void DirtyReplicas::endUpdate( RakNet::ReplicaManager3& rReplicaManager )
+{
+    Replicas& replicas = msReplicas[&rReplicaManager];
+    if( !replicas.mQueried ) 
+        replicas.mDirty.insert( replicas.mTaken.begin(), replicas.mTaken.end() );
+    replicas.mTaken.clear();
+}
+
+unsigned int DirtyReplicas::getDirtyCount()
+{
+    unsigned int count = 0;
+    for( ReplicasByManager::const_iterator i = msReplicas.begin(); i != msReplicas.end(); ++i )
+    {
+        count += (unsigned int)i->second.mDirty.size();
+    }
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+} // Namespace ObjectSystem
+} // Namespace Diversia
@@ -0,0 +1,140 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_OBJECT_DIRTYREPLICAS_H
+#define DIVERSIA_OBJECT_DIRTYREPLICAS_H
+
+#include "Object/Platform/Prerequisites.h"
+
+namespace Diversia
+{
+namespace ObjectSystem
+{
+//------------------------------------------------------------------------------
+
+/**
+Keeps track of the replicas that have changed since the last serialization tick. Replicas mark
+themselves dirty when their state changes, the replica manager then only queries serialization
+of dirty replicas instead of polling every replica for every connection. Serialization cost of an
+idle world is constant instead of growing with the amount of replicas.
+
+A replica stays dirty until the replica manager has taken it in a tick where it serialized, so 
+changes made between serialization ticks are not lost. Replicas that are not referenced by a 
+replica manager are not marked, they send their full state when they are constructed.
+**/
+class DIVERSIA_OBJECT_API DirtyReplicas
+{
+public:
+    /**
+    Marks a replica dirty so that serialization is queried in the next serialization tick. Does
+    nothing if the replica is not referenced by a replica manager.
+    
+    @param [in,out] rReplica    The replica.
+    **/
+    static void mark( RakNet::Replica3& rReplica );
+    /**
+    Removes a replica from the dirty set, must be called when a replica is destroyed.
+    
+    @param [in,out] rReplica    The replica.
+    **/
+    static void unmark( RakNet::Replica3& rReplica );
+    /**
+    Takes the dirty replicas of a replica manager at the start of its update, replicas that are 
+    marked during the update are dirty in the next update.
+    
+    @param [in,out] rReplicaManager The replica manager.
+    **/
+    static void beginUpdate( RakNet::ReplicaManager3& rReplicaManager );
+    /**
+    Gets the replicas that were taken at the start of the update of a replica manager and 
+    flags them as queried.
+    
+    @param [in,out] rReplicaManager The replica manager.
+    **/
+    static const std::set<RakNet::Replica3*>& query( RakNet::ReplicaManager3& rReplicaManager );
+    /**
+    Ends the update of a replica manager. Taken replicas that were not queried because no 
+    serialization happened in this update are marked dirty again.
+    
+    @param [in,out] rReplicaManager The replica manager.
+    **/
+    static void endUpdate( RakNet::ReplicaManager3& rReplicaManager );
+    /**
+    Gets the amount of dirty replicas of all replica managers.
+    **/
+    static unsigned int getDirtyCount();
+    /**
+    Gets the amount of replicas that were queried in the last serialization tick.
+    **/
+    inline static unsigned int getQueriedCount() { return msQueriedCount; }
+    /**
+    Query if dirty tracking is enabled, replicas are polled every serialization tick otherwise.
+    **/
+    inline static bool isEnabled() { return msSettings.mEnabled; }
+
+private:
+    struct Replicas
+    {
+        Replicas() : mQueried( false ) {}
+
+        std::set<RakNet::Replica3*> mDirty;
+        std::set<RakNet::Replica3*> mTaken;
+        bool                        mQueried;
+    };
+
+    typedef std::map<RakNet::ReplicaManager3*, Replicas> ReplicasByManager;
+
+    static ReplicasByManager    msReplicas;
+    static unsigned int         msQueriedCount;
+
+    /**
+    Settings for dirty replica tracking.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mEnabled( true )
+        {
+
+        }
+
+        bool    mEnabled;   ///< False to poll every replica every serialization tick.
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static DirtyReplicas::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace ObjectSystem
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::ObjectSystem::DirtyReplicas::Settings, 
+    &Diversia::ObjectSystem::Bindings::CampBindings::bindDirtyReplicasSettings );
+
+#endif // DIVERSIA_OBJECT_DIRTYREPLICAS_H
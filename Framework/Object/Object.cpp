@@ -31,6 +31,8 @@ THE SOFTWARE.
 #include "Object/Object.h"
 #include "Object/ObjectManager.h"
 #include "Object/ObjectTemplate.h"
+#include "Object/ReplicationChannels.h"
+#include "Object/DirtyReplicas.h"
 
 namespace Diversia
 {
@@ -38,6 +40,9 @@ namespace ObjectSystem
 {
 //------------------------------------------------------------------------------
 
+/// Maximum amount of inputs that are remembered for reconciliation.
+static const unsigned int cMaxInputHistory = 128;
+
 std::map<ComponentType, String> Object::mAutoCreateComponents = std::map<ComponentType, String>();
 
 Object::Object( const String& rName, Mode mode, NetworkingType type, const String& rDisplayName,
@@ -59,6 +64,12 @@ Object::Object( const String& rName, Mode mode, NetworkingType type, const Strin
     mSourceGUID( source ),
     mParentChanged( false ),
     mTemplate( 0 ),
+    mTransformCodecChanged( false ),
+    mRestTime( 0 ),
+    mSerializedTime( 0 ),
+    mSerializedChanges( 0 ),
+    mInputSequence( 0 ),
+    mInputCorrected( false ),
     mUpdateSignal( rUpdateSignal ),
     mObjectManager( rObjectManager ),
     mObjectTemplateManager( rObjectManager.getObjectTemplateManager() ),
@@ -69,6 +80,10 @@ Object::Object( const String& rName, Mode mode, NetworkingType type, const Strin
     OLOGD << "Object " << mName << " created";
 
     mUpdateConnection = mUpdateSignal.connect( sigc::mem_fun( this, &Object::update ) );
+    mInterpolationConnection = mUpdateSignal.connect( sigc::mem_fun( this, 
+        &Object::updateInterpolation ) );
+    mInterpolationConnection.block( true );
+    Node::connectLocalTransformChange( sigc::mem_fun( this, &Object::transformChange ) );
 
     this->SetNetworkIDManager( &mNetworkIDManager );
 
@@ -83,6 +98,7 @@ Object::Object( const String& rName, Mode mode, NetworkingType type, const Strin
 Object::~Object()
 {
     mDestructionSignal( *this );
+    DirtyReplicas::unmark( *this );
 
     // Destroy all components that were queued for destruction in the next tick.
     for( ComponentsByType::reverse_iterator i = mDestroyedComponents.rbegin();
@@ -238,6 +254,7 @@ void Object::setDisplayName( const String& rDisplayName )
 {
     mDisplayName = rDisplayName;
     mDisplayNameChanged = true;
+    Object::markChanged();
     mDisplayNameSignal( mDisplayName );
 }
 
@@ -470,10 +487,22 @@ void Object::setClientControlled(
     if( controller != mController )
     {
         mController = controller;
+        mObjectManager.mStateChangeSignal( *this );
         mControllerSignal( mController );
     }
 }
 
+void Object::setTransformPrecision( unsigned char positionBits, unsigned char orientationBits )
+{
+    TransformCodec codec( positionBits, orientationBits );
+    if( codec != mTransformCodec )
+    {
+        mTransformCodec = codec;
+        mTransformCodecChanged = true;
+        Object::markChanged();
+    }
+}
+
 void Object::parent( Object* pObject, RakNet::RakNetGUID source /*= RakNet::RakNetGUID( 0 )*/ )
 {
     if( Object::getParentObject() == pObject ) return;
@@ -624,9 +653,10 @@ void Object::SerializeConstruction( RakNet::BitStream* pConstructionBitstream,
     pConstructionBitstream->Write( mController );
 
     // Serialize transform
-    *pConstructionBitstream << Node::mPosition;
-    *pConstructionBitstream << Node::mOrientation;
-    *pConstructionBitstream << Node::mScale;
+    mTransformCodec.writePrecision( *pConstructionBitstream );
+    mTransformCodec.writePosition( *pConstructionBitstream, Node::mPosition );
+    mTransformCodec.writeOrientation( *pConstructionBitstream, Node::mOrientation );
+    mTransformCodec.writeScale( *pConstructionBitstream, Node::mScale );
 }
 
 bool Object::DeserializeConstruction( RakNet::BitStream* pConstructionBitstream,
@@ -642,9 +672,14 @@ bool Object::DeserializeConstruction( RakNet::BitStream* pConstructionBitstream,
     pConstructionBitstream->Read<RakNet::RakNetGUID>( mController );
 
     // Deserialize transform
-    *pConstructionBitstream >> Node::mPosition;
-    *pConstructionBitstream >> Node::mOrientation;
-    *pConstructionBitstream >> Node::mScale;
+    if( !mTransformCodec.readPrecision( *pConstructionBitstream ) )
+    {
+        OLOGE << "Cannot construct object " << mName << ", transform has an invalid precision";
+        return false;
+    }
+    mTransformCodec.readPosition( *pConstructionBitstream, Node::mPosition );
+    mTransformCodec.readOrientation( *pConstructionBitstream, Node::mOrientation );
+    mTransformCodec.readScale( *pConstructionBitstream, Node::mScale );
     Node::needUpdate();
 
     // Broadcast construction now if this is a remote object on the server, created by a client.
@@ -666,45 +701,192 @@ bool Object::DeserializeDestruction( RakNet::BitStream* pDestructionBitstream,
 RakNet::RM3QuerySerializationResult Object::QuerySerialization(
     RakNet::Connection_RM3* pDestinationConnection )
 {
-    if( mMode == SERVER || ( mMode == CLIENT && ( Object::isThisControlled() || mParentChanged ||
-        mDisplayNameChanged ) ) )
+    // Changes that were taken in this serialize tick still have to be written to connections
+    // that did not get them yet.
+    if( mSerializedChanges && 
+        !mSerializedConnections.count( pDestinationConnection->GetRakNetGUID() ) )
+        return RakNet::RM3QSR_CALL_SERIALIZE;
+
+    // Only serialize objects that have changed since the last serialization.
+    if( mParentChanged || mDisplayNameChanged || ( Object::canSerializeTransform() &&
+        ( Node::hasTransformChanges() || mTransformCodecChanged ) ) )
     {
         return RakNet::RM3QSR_CALL_SERIALIZE;
     }
 
+    // Send the final transform when the object came to rest, stay dirty until then.
+    if( mRestTime && Object::canSerializeTransform() )
+    {
+        if( RakNet::GetTime() >= mRestTime ) return RakNet::RM3QSR_CALL_SERIALIZE;
+        DirtyReplicas::mark( *this );
+    }
+
     return RakNet::RM3QSR_DO_NOT_CALL_SERIALIZE;
 }
 
 RakNet::RM3SerializationResult Object::Serialize( RakNet::SerializeParameters* pSerializeParameters )
 {
-    // Serialize parent
-    if( Node::hasParent() && mParentChanged )
+    RakNet::RakNetGUID connection = pSerializeParameters->destinationConnection->GetRakNetGUID();
+
+    // Serialize is called for every connection in a serialize tick, changes are only taken once
+    // per tick.
+    if( pSerializeParameters->curTime != mSerializedTime || 
+        mSerializedConnections.count( connection ) )
     {
-        pSerializeParameters->outputBitstream[0].Write( Object::getParentObject()->GetNetworkID() );
-        mParentChanged = false;
+        mSerializedChanges = Object::takeSerializationChanges();
+        mSerializedTime = pSerializeParameters->curTime;
+        mSerializedConnections.clear();
     }
-    else if( mParentChanged )
+    mSerializedConnections.insert( connection );
+
+    if( !mSerializedChanges ) return RakNet::RM3SR_DO_NOT_SERIALIZE;
+
+    Object::serializeChanges( pSerializeParameters, mSerializedChanges );
+    return RakNet::RM3SR_SERIALIZED_ALWAYS;	///< RakNet doesn't have to check changes.
+}
+
+unsigned char Object::takeSerializationChanges()
+{
+    unsigned char changes = 0;
+
+    if( mParentChanged ) changes |= SC_PARENT;
+    if( mDisplayNameChanged ) changes |= SC_DISPLAYNAME;
+    mParentChanged = false;
+    mDisplayNameChanged = false;
+
+    if( Object::canSerializeTransform() )
     {
-        pSerializeParameters->outputBitstream[1].Write1();
-        mParentChanged = false;
+        changes |= Node::getTransformChanges();
+        if( mTransformCodecChanged ) changes |= SC_PRECISION;
+
+        // Unreliable transforms can be lost, send the transform reliable once when it did not 
+        // change for a while.
+        RakNet::Time now = RakNet::GetTime();
+        if( changes & SC_TRANSFORM )
+        {
+            mRestTime = ReplicationChannels::isTransformUnreliable() ? 
+                now + std::max( ReplicationChannels::getSettings().mRestDelayMS, 1u ) : 0;
+        }
+        else if( mRestTime && now >= mRestTime )
+        {
+            changes |= SC_TRANSFORM | SC_REST;
+            mRestTime = 0;
+        }
+
+        if( mInputCorrected ) changes |= SC_CORRECTION;
+        Node::clearTransformChanges();
+        mTransformCodecChanged = false;
+        mInputCorrected = false;
+
+        // Every transform a client sends is an input, remember the predicted transform so it can 
+        // be reconciled with the server.
+        if( mMode == CLIENT && ( changes & SC_TRANSFORM ) )
+        {
+            Input input;
+            input.mSequence = ++mInputSequence;
+            input.mPosition = Node::mPosition;
+            input.mOrientation = Node::mOrientation;
+            mInputHistory.push_back( input );
+            if( mInputHistory.size() > cMaxInputHistory ) mInputHistory.pop_front();
+        }
     }
 
+    return changes;
+}
+
+void Object::serializeChanges( RakNet::SerializeParameters* pSerializeParameters, 
+    unsigned char changes ) const
+{
+    changes = Object::completeUnreliableTransform( changes );
+
+    // Parent and display name changes must arrive, transforms are sent unreliable.
+    ReplicationChannels::setStateChannel( pSerializeParameters, 0 );
+    ReplicationChannels::setStateChannel( pSerializeParameters, 1 );
+    ReplicationChannels::setStateChannel( pSerializeParameters, 2 );
+    ReplicationChannels::setTransformChannel( pSerializeParameters, 3, 
+        ( changes & SC_REST ) != 0 );
+
+    // Serialize parent
+    if( Node::hasParent() && ( changes & SC_PARENT ) )
+        pSerializeParameters->outputBitstream[0].Write( Object::getParentObject()->GetNetworkID() );
+    else if( changes & SC_PARENT )
+        pSerializeParameters->outputBitstream[1].Write1();
+
     // Serialize display name
-    if( mDisplayNameChanged )
-    {
+    if( changes & SC_DISPLAYNAME )
         pSerializeParameters->outputBitstream[2] << RakNet::RakString( mDisplayName.c_str() );
-        mDisplayNameChanged = false;
+
+    // Serialize transform, only the parts of the transform that have changed are written.
+    if( changes & ( SC_TRANSFORM | SC_PRECISION | SC_CORRECTION ) )
+    {
+        RakNet::BitStream& stream = pSerializeParameters->outputBitstream[3];
+
+        // Timestamp transforms so clients can interpolate them and the server can validate them.
+        if( changes & SC_TRANSFORM )
+            pSerializeParameters->messageTimestamp = RakNet::GetTime();
+
+        // Serialize precision if it has changed since the last serialization.
+        stream.Write( ( changes & SC_PRECISION ) != 0 );
+        if( changes & SC_PRECISION ) mTransformCodec.writePrecision( stream );
+
+        unsigned char transformChanges = changes & SC_TRANSFORM;
+        stream.WriteBits( &transformChanges, 3 );
+
+        // Clients send the sequence number of the input, the server sends the sequence number of 
+        // the last input it processed from the controller.
+        bool input = mMode == CLIENT || Object::isClientControlled();
+        stream.Write( input );
+        if( input )
+        {
+            stream.WriteCompressed( mInputSequence );
+            if( mMode == SERVER ) stream.Write( ( changes & SC_CORRECTION ) != 0 );
+        }
+
+        if( changes & SC_POSITION )
+            mTransformCodec.writePosition( stream, Node::mPosition );
+        if( changes & SC_ORIENTATION )
+            mTransformCodec.writeOrientation( stream, Node::mOrientation );
+        if( changes & SC_SCALE )
+            mTransformCodec.writeScale( stream, Node::mScale );
     }
+}
 
-    // Serialize transform
-    if( mMode == SERVER || ( mMode == CLIENT && Object::isThisControlled() ) )
+unsigned char Object::completeUnreliableTransform( unsigned char changes )
+{
+    // A lost transform is not resent, so precision and all parts of the transform are sent every
+    // time to make sure the next transform that arrives can be decoded and is complete.
+    if( ( changes & ( SC_TRANSFORM | SC_PRECISION | SC_CORRECTION ) ) && 
+        ReplicationChannels::isTransformUnreliable() )
     {
-        pSerializeParameters->outputBitstream[3] << Node::mPosition;
-        pSerializeParameters->outputBitstream[3] << Node::mOrientation;
-        pSerializeParameters->outputBitstream[3] << Node::mScale;
+        changes |= SC_PRECISION;
+        if( changes & SC_TRANSFORM ) changes |= SC_TRANSFORM;
     }
 
-    return RakNet::RM3SR_BROADCAST_IDENTICALLY;
+    return changes;
+}
+
+unsigned int Object::getSerializationSize( unsigned char changes ) const
+{
+    changes = Object::completeUnreliableTransform( changes );
+
+    // Replica header and a length per written bitstream.
+    unsigned int bits = 64;
+
+    if( changes & SC_PARENT ) bits += 16 + sizeof( RakNet::NetworkID ) * 8;
+    if( changes & SC_DISPLAYNAME ) bits += 16 + ( 2 + mDisplayName.size() ) * 8;
+
+    if( changes & ( SC_TRANSFORM | SC_PRECISION | SC_CORRECTION ) )
+    {
+        bits += 16 + 5;
+        if( mMode == CLIENT || Object::isClientControlled() ) bits += 33;
+        if( changes & SC_PRECISION ) bits += 10;
+        if( changes & SC_TRANSFORM ) bits += 8 + sizeof( RakNet::Time ) * 8;
+        if( changes & SC_POSITION ) bits += 1 + 3 * mTransformCodec.getPositionBits();
+        if( changes & SC_ORIENTATION ) bits += 2 + 3 * mTransformCodec.getOrientationBits();
+        if( changes & SC_SCALE ) bits += Node::mScale == Vector3::UNIT_SCALE ? 1 : 2 + 96;
+    }
+
+    return ( bits + 7 ) / 8;
 }
 
 void Object::Deserialize( RakNet::DeserializeParameters* pDeserializeParameters )
@@ -747,19 +929,191 @@ void Object::Deserialize( RakNet::DeserializeParameters* pDeserializeParameters
             mDisplayNameSignal( mDisplayName );
         }
 
-        if( pDeserializeParameters->bitstreamWrittenTo[3] &&
-            !( mMode == CLIENT && Object::isThisControlled() ) )
+        if( pDeserializeParameters->bitstreamWrittenTo[3] )
         {
             // TODO: Only allow controller to change the transform.
             // Deserialize transform
-            pDeserializeParameters->serializationBitstream[3] >> Node::mPosition;
-            pDeserializeParameters->serializationBitstream[3] >> Node::mOrientation;
-            pDeserializeParameters->serializationBitstream[3] >> Node::mScale;
-            Node::needUpdate();
+            RakNet::BitStream& stream = pDeserializeParameters->serializationBitstream[3];
+            RakNet::Time time = pDeserializeParameters->timeStamp ? 
+                pDeserializeParameters->timeStamp : RakNet::GetTime();
+            if( stream.ReadBit() )
+            {
+                unsigned char positionBits = mTransformCodec.getPositionBits();
+                unsigned char orientationBits = mTransformCodec.getOrientationBits();
+                if( !mTransformCodec.readPrecision( stream ) )
+                {
+                    // The rest of the transform cannot be read without a valid precision.
+                    OLOGW << "Ignoring transform of object " << mName << 
+                        " with an invalid precision";
+                    return;
+                }
+
+                // Unreliable transforms always contain the precision, only relay real changes.
+                if( mMode == SERVER && ( positionBits != mTransformCodec.getPositionBits() || 
+                    orientationBits != mTransformCodec.getOrientationBits() ) )
+                {
+                    mTransformCodecChanged = true;
+                    Object::markChanged();
+                }
+            }
+
+            unsigned char changes = 0; stream.ReadBits( &changes, 3 );
+
+            unsigned int sequence = 0;
+            bool corrected = false;
+            bool input = stream.ReadBit();
+            if( input )
+            {
+                stream.ReadCompressed( sequence );
+                if( mMode == CLIENT ) corrected = stream.ReadBit();
+            }
+
+            if( mMode == CLIENT && Object::isThisControlled() )
+            {
+                // The transform of controlled objects is predicted.
+                if( input ) Object::reconcile( sequence, corrected, changes, stream );
+            }
+            else if( mMode == CLIENT && TransformInterpolator::getSettings().mEnabled )
+            {
+                // Smooth out the transform on clients, it is applied in updateInterpolation.
+                Object::bufferTransform( time, changes, stream );
+            }
+            else if( mMode == SERVER )
+            {
+                Vector3 position = Node::mPosition;
+                Quaternion orientation = Node::mOrientation;
+                if( changes & Node::TC_POSITION )
+                    mTransformCodec.readPosition( stream, position );
+                if( changes & Node::TC_ORIENTATION )
+                    mTransformCodec.readOrientation( stream, orientation );
+                if( changes & Node::TC_SCALE )
+                    mTransformCodec.readScale( stream, Node::mScale );
+
+                // Process the input of the controller, a corrected transform is sent back 
+                // completely so the controller can reconcile with it.
+                if( input && sequence > mInputSequence )
+                {
+                    mInputSequence = sequence;
+                    // Use the receive time, a timestamp from the client can not be trusted.
+                    if( Object::correctControlledTransform( position, orientation, 
+                        RakNet::GetTime() ) )
+                    {
+                        mInputCorrected = true;
+                        changes |= Node::TC_POSITION | Node::TC_ORIENTATION;
+                        Object::markChanged();
+                    }
+                }
+
+                Node::mPosition = position;
+                Node::mOrientation = orientation;
+                Node::needUpdate();
+
+                // The server relays transform changes from clients to the other clients.
+                Node::mTransformChanges |= changes;
+            }
+            else
+            {
+                if( changes & Node::TC_POSITION )
+                    mTransformCodec.readPosition( stream, Node::mPosition );
+                if( changes & Node::TC_ORIENTATION )
+                    mTransformCodec.readOrientation( stream, Node::mOrientation );
+                if( changes & Node::TC_SCALE )
+                    mTransformCodec.readScale( stream, Node::mScale );
+                Node::needUpdate();
+            }
         }
     }
 }
 
+void Object::bufferTransform( RakNet::Time time, unsigned char changes, 
+    RakNet::BitStream& rStream )
+{
+    Vector3 position = Node::mPosition;
+    Quaternion orientation = Node::mOrientation;
+    Vector3 scale = Node::mScale;
+
+    if( !mTransformInterpolator.getLastSnapshot( position, orientation, scale ) )
+    {
+        // Start interpolating from the current transform.
+        RakNet::Time delay = TransformInterpolator::getSettings().mInterpolationDelayMS + 1;
+        mTransformInterpolator.addSnapshot( time > delay ? time - delay : 0, position, 
+            orientation, scale );
+    }
+
+    if( changes & Node::TC_POSITION )
+        mTransformCodec.readPosition( rStream, position );
+    if( changes & Node::TC_ORIENTATION )
+        mTransformCodec.readOrientation( rStream, orientation );
+    if( changes & Node::TC_SCALE )
+        mTransformCodec.readScale( rStream, scale );
+
+    mTransformInterpolator.addSnapshot( time, position, orientation, scale );
+    mInterpolationConnection.block( false );
+}
+
+void Object::updateInterpolation()
+{
+    if( Object::isThisControlled() || !TransformInterpolator::getSettings().mEnabled )
+    {
+        mTransformInterpolator.clear();
+        mInterpolationConnection.block( true );
+        return;
+    }
+
+    if( mTransformInterpolator.sample( RakNet::GetTime(), Node::mPosition, Node::mOrientation, 
+        Node::mScale ) )
+    {
+        Node::needUpdate();
+    }
+    else
+    {
+        mInterpolationConnection.block( true );
+    }
+}
+
+void Object::reconcile( unsigned int sequence, bool corrected, unsigned char changes, 
+    RakNet::BitStream& rStream )
+{
+    Vector3 position = Node::mPosition;
+    Quaternion orientation = Node::mOrientation;
+    Vector3 scale = Node::mScale;
+    if( changes & Node::TC_POSITION )
+        mTransformCodec.readPosition( rStream, position );
+    if( changes & Node::TC_ORIENTATION )
+        mTransformCodec.readOrientation( rStream, orientation );
+    if( changes & Node::TC_SCALE )
+        mTransformCodec.readScale( rStream, scale );
+
+    // Forget inputs that the server has processed before the acknowledged input.
+    while( !mInputHistory.empty() && mInputHistory.front().mSequence < sequence )
+        mInputHistory.pop_front();
+    if( mInputHistory.empty() || mInputHistory.front().mSequence != sequence ) return;
+
+    Input acknowledged = mInputHistory.front();
+    mInputHistory.pop_front();
+    if( !corrected ) return;
+
+    // Replay the inputs after the acknowledged input on top of the corrected transform by 
+    // applying the difference between the predicted and the corrected transform.
+    Vector3 offset = Vector3::ZERO;
+    Quaternion rotation = Quaternion::IDENTITY;
+    if( changes & Node::TC_POSITION ) offset = position - acknowledged.mPosition;
+    if( changes & Node::TC_ORIENTATION ) 
+        rotation = orientation * acknowledged.mOrientation.Inverse();
+
+    for( std::deque<Input>::iterator i = mInputHistory.begin(); i != mInputHistory.end(); ++i )
+    {
+        i->mPosition += offset;
+        i->mOrientation = rotation * i->mOrientation;
+    }
+
+    OLOGD << "Reconciled object " << mName << " with input " << sequence << ", position error " 
+        << offset.length();
+
+    Node::setPosition( Node::mPosition + offset );
+    Node::setOrientation( rotation * Node::mOrientation );
+}
+
 bool Object::delayedDestruction()
 {
     if( !mDelayedDestruction.empty() )
@@ -877,7 +1231,7 @@ void Object::DeallocReplica( RakNet::Connection_RM3* pSourceConnection )
         try
         {
             mDestructionSignal( *this );
-            mObjectManager.destroyObject( mName, mServerGUID );
+            mObjectManager.destroyObject( *this, mServerGUID );
         }
         catch ( Exception e )
         {
@@ -907,6 +1261,7 @@ void Object::setParent( Node* pParent )
     {
         mParentSignal( static_cast<Object*>( pParent ) );
         mParentChanged = true;
+        Object::markChanged();
     }
 }
 
@@ -920,6 +1275,17 @@ void Object::objectChange( Object& rObject, bool created )
     }
 }
 
+void Object::transformChange( const Node& rNode )
+{
+    Object::markChanged();
+}
+
+void Object::markChanged()
+{
+    DirtyReplicas::mark( *this );
+    mObjectManager.mStateChangeSignal( *this );
+}
+
 //------------------------------------------------------------------------------
 } // Namespace Object
 } // Namespace Diversia
\ No newline at end of file
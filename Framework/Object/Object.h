@@ -28,6 +28,8 @@ THE SOFTWARE.
 #include "Object/Platform/Prerequisites.h"
 
 #include "Object/ObjectManager.h"
+#include "Object/TransformCodec.h"
+#include "Object/TransformInterpolator.h"
 #include "Util/Math/Node.h"
 
 namespace Diversia
@@ -209,7 +211,7 @@ public:
     /**
     Convenience function for destroying this object.
     **/
-    inline void destroyObject() { mObjectManager.destroyObject( mName ); }
+    inline void destroyObject() { mObjectManager.destroyObject( *this ); }
 
     /**
     Creates a component. The component specific part is initialized in the next update tick.
@@ -445,6 +447,39 @@ public:
     **/
     inline bool isThisControlled() const { return mController == mOwnGUID; }
 
+    /**
+    Sets the precision that is used to replicate the transform of this object.
+
+    @param  positionBits    Amount of bits per position component, between 8 and 24.
+    @param  orientationBits Amount of bits per orientation component, between 6 and 16.
+    **/
+    void setTransformPrecision( unsigned char positionBits, unsigned char orientationBits );
+    /**
+    Sets the amount of bits per position component that is used to replicate the transform.
+    **/
+    inline void setPositionPrecision( unsigned char bits ) 
+    { 
+        Object::setTransformPrecision( bits, mTransformCodec.getOrientationBits() ); 
+    }
+    /**
+    Gets the amount of bits per position component that is used to replicate the transform.
+    **/
+    inline unsigned char getPositionPrecision() const { return mTransformCodec.getPositionBits(); }
+    /**
+    Sets the amount of bits per orientation component that is used to replicate the transform.
+    **/
+    inline void setOrientationPrecision( unsigned char bits ) 
+    { 
+        Object::setTransformPrecision( mTransformCodec.getPositionBits(), bits ); 
+    }
+    /**
+    Gets the amount of bits per orientation component that is used to replicate the transform.
+    **/
+    inline unsigned char getOrientationPrecision() const 
+    { 
+        return mTransformCodec.getOrientationBits(); 
+    }
+
     /**
     Gets the parent object.
     **/
@@ -671,6 +706,12 @@ protected:
     **/
     void update();
 
+    /**
+    Marks the object dirty for serialization and notifies the object manager that the state of
+    the object changed, see ObjectManager::connectStateChange.
+    **/
+    void markChanged();
+
     /**
     Provide implementation for these functions based on permissions in the client/server.
     **/
@@ -697,11 +738,72 @@ protected:
     virtual RakNet::RM3SerializationResult Serialize(
         RakNet::SerializeParameters* pSerializeParameters );
     virtual void Deserialize( RakNet::DeserializeParameters* pDeserializeParameters );
+    /**
+    Corrects a transform that is received from the client that controls this object, the client 
+    reconciles its predicted transform with the corrected transform. Does nothing by default.
+
+    @param [in,out] rPosition       The received position.
+    @param [in,out] rOrientation    The received orientation.
+    @param  time                    The time at which the server received the transform.
+
+    @return True if the transform was corrected.
+    **/
+    inline virtual bool correctControlledTransform( Vector3& rPosition, Quaternion& rOrientation,
+        RakNet::Time time ) { return false; }
+
+    /**
+    Changes of an object that have to be serialized. The transform changes match the changes in
+    Node::TransformChange.
+    **/
+    enum SerializationChange
+    {
+        SC_POSITION = Node::TC_POSITION,
+        SC_ORIENTATION = Node::TC_ORIENTATION,
+        SC_SCALE = Node::TC_SCALE,
+        SC_TRANSFORM = Node::TC_ALL,
+        SC_PRECISION = 8,
+        SC_PARENT = 16,
+        SC_DISPLAYNAME = 32,
+        SC_CORRECTION = 64,
+        SC_REST = 128,  ///< Final transform of an object that came to rest, sent reliable.
+        SC_ALL = SC_TRANSFORM | SC_PRECISION | SC_PARENT | SC_DISPLAYNAME | SC_CORRECTION
+    };
+    /**
+    Gets the changes that have to be serialized since the last call and clears them.
+
+    @return Combination of SerializationChange flags.
+    **/
+    unsigned char takeSerializationChanges();
+    /**
+    Query if the final transform still has to be sent because the object came to rest, 
+    takeSerializationChanges returns it when the rest delay has passed.
+    **/
+    inline bool isRestPending() const { return mRestTime != 0; }
+    /**
+    Writes the current state of the changed parts of this object.
+
+    @param [in,out] pSerializeParameters    The serialize parameters to write to.
+    @param  changes                         Combination of SerializationChange flags.
+    **/
+    void serializeChanges( RakNet::SerializeParameters* pSerializeParameters, 
+        unsigned char changes ) const;
+    /**
+    Estimates the amount of bytes that serializeChanges will write.
+
+    @param  changes Combination of SerializationChange flags.
+    **/
+    unsigned int getSerializationSize( unsigned char changes ) const;
 
 private:
     friend class Bindings::CampBindings;    ///< Allow private access for camp bindings.
     friend void camp::detail::destroy<Object>( const UserObject& object );  ///< Allow private access for camp.
 
+    /**
+    Adds the parts of the transform that are always sent when transforms are sent unreliable.
+
+    @param  changes Combination of SerializationChange flags.
+    **/
+    static unsigned char completeUnreliableTransform( unsigned char changes );
     /**
     Starts delayed destruction. Will ask all components if a delayed destruction is needed, if any
     of the components return true then a delayed destruction will take place. Once a component is
@@ -750,11 +852,38 @@ private:
     Object change notification.
     **/
     void objectChange( Object& rObject, bool created );
+    /**
+    Local transform change notification, marks the object dirty for serialization.
+    **/
+    void transformChange( const Node& rNode );
 
     /**
     Gets the parent object by reference.
     **/
     inline Object& getParentObjectRef() const { return *static_cast<Object*>( Node::getParent() ); }
+    /**
+    Buffers a received transform for interpolation, parts of the transform that are not in the
+    stream are taken from the last received transform.
+    **/
+    void bufferTransform( RakNet::Time time, unsigned char changes, RakNet::BitStream& rStream );
+    /**
+    Applies the interpolated transform, blocks itself when the transform stops changing.
+    **/
+    void updateInterpolation();
+    /**
+    Reconciles the predicted transform of a controlled object with the transform that the server
+    acknowledged, replaying the inputs the server has not processed yet.
+    **/
+    void reconcile( unsigned int sequence, bool corrected, unsigned char changes, 
+        RakNet::BitStream& rStream );
+    /**
+    Query if this object may serialize its transform, the server serializes all transforms and
+    clients only serialize the transforms of objects they control.
+    **/
+    inline bool canSerializeTransform() const
+    {
+        return mMode == SERVER || ( mMode == CLIENT && Object::isThisControlled() );
+    }
 
     /**
     Implemented by Object.
@@ -798,6 +927,27 @@ private:
     RakNet::RakNetGUID                          mController;
     sigc::signal<void, RakNet::RakNetGUID>      mControllerSignal;
 
+    TransformCodec                              mTransformCodec;
+    bool                                        mTransformCodecChanged;
+    RakNet::Time                                mRestTime;  ///< 0 if the object is at rest.
+    // Changes taken in the last serialize tick, written to every connection in that tick.
+    RakNet::Time                                mSerializedTime;
+    unsigned char                               mSerializedChanges;
+    std::set<RakNet::RakNetGUID>                mSerializedConnections;
+    TransformInterpolator                       mTransformInterpolator;
+    sigc::connection                            mInterpolationConnection;
+
+    struct Input
+    {
+        unsigned int    mSequence;
+        Vector3         mPosition;
+        Quaternion      mOrientation;
+    };
+
+    unsigned int                                mInputSequence; ///< Last sent or processed input.
+    bool                                        mInputCorrected;
+    std::deque<Input>                           mInputHistory;
+
     RakNet::ReplicaManager3&					mReplicaManager;
     RakNet::NetworkIDManager&					mNetworkIDManager;
     RakNet::RPC3&                               mRPC3;
@@ -251,6 +251,19 @@ public:
     {
         return mObjectSignal.connect( rSlot );
     }
+    /**
+    Connects a slot to the object state change signal. The signal is emitted when the replicated 
+    state (transform, parent, display name or transform precision) or the controller of an object 
+    changes, so that changed objects can be tracked instead of polling every object.
+
+    @param [in,out] rSlot   The slot (signature: void func(Object&)) to connect.
+
+    @return Connection object to block or disconnect the connection.
+    **/
+    inline sigc::connection connectStateChange( const sigc::slot<void, Object&>& rSlot )
+    {
+        return mStateChangeSignal.connect( rSlot );
+    }
 
 protected:
     friend class Object;	///< For delayed destruction.
@@ -314,6 +327,7 @@ private:
     Objects                             mObjects;
     std::set<Object*>                   mDestroyedObjects;
     sigc::signal<void, Object&, bool>   mObjectSignal;
+    sigc::signal<void, Object&>         mStateChangeSignal;
     sigc::signal<void>&                 mUpdateSignal;
     sigc::connection                    mUpdateConnection;
 
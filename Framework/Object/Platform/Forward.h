@@ -39,10 +39,14 @@ class Component;
 class ComponentHandle;
 class ComponentFactory;
 class ComponentTemplate;
+class DirtyReplicas;
 class Object;
 class ObjectManager;
 class ObjectTemplate;
 class ObjectTemplateManager;
+class ReplicationChannels;
+class TransformCodec;
+class TransformInterpolator;
 
 //------------------------------------------------------------------------------
 } // Namespace ObjectSystem
@@ -0,0 +1,102 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Object/Platform/StableHeaders.h"
+
+#include "Object/ReplicationChannels.h"
+
+namespace Diversia
+{
+namespace ObjectSystem
+{
+//------------------------------------------------------------------------------
+
+ReplicationChannels::Settings ReplicationChannels::msSettings = ReplicationChannels::Settings();
+std::map<String, unsigned char> ReplicationChannels::msComponentChannels = 
+    std::map<String, unsigned char>();
+String ReplicationChannels::msParsedComponentChannels = "";
+
+void ReplicationChannels::setTransformChannel( 
+    RakNet::SerializeParameters* pSerializeParameters, unsigned int slot, 
+    bool reliable /*= false*/ )
+{
+    if( !msSettings.mEnabled ) return;
+
+    // Reliable ordered and unreliable sequenced messages share the sequence of a channel, older
+    // unreliable transforms that arrive after the reliable transform are dropped.
+    pSerializeParameters->pro[slot].reliability = reliable ? RELIABLE_ORDERED : 
+        UNRELIABLE_SEQUENCED;
+    pSerializeParameters->pro[slot].orderingChannel = (char)msSettings.mTransformChannel;
+}
+
+void ReplicationChannels::setStateChannel( RakNet::SerializeParameters* pSerializeParameters, 
+    unsigned int slot, const String& rClass /*= ""*/ )
+{
+    if( !msSettings.mEnabled ) return;
+
+    pSerializeParameters->pro[slot].reliability = RELIABLE_ORDERED;
+    pSerializeParameters->pro[slot].orderingChannel = 
+        (char)ReplicationChannels::getStateChannel( rClass );
+}
+
+unsigned char ReplicationChannels::getStateChannel( const String& rClass )
+{
+    if( msSettings.mComponentChannels != msParsedComponentChannels ) 
+        ReplicationChannels::parseComponentChannels();
+
+    std::map<String, unsigned char>::const_iterator i = msComponentChannels.find( rClass );
+    if( i != msComponentChannels.end() ) return i->second;
+
+    return (unsigned char)msSettings.mStateChannel;
+}
+
+void ReplicationChannels::parseComponentChannels()
+{
+    msComponentChannels.clear();
+    msParsedComponentChannels = msSettings.mComponentChannels;
+
+    std::istringstream stream( msParsedComponentChannels );
+    String pair;
+    while( stream >> pair )
+    {
+        String::size_type found = pair.find( '=' );
+        try
+        {
+            if( found == String::npos ) throw boost::bad_lexical_cast();
+
+            unsigned int channel = boost::lexical_cast<unsigned int>( pair.substr( found + 1 ) );
+            if( channel >= 32 ) throw boost::bad_lexical_cast();
+            msComponentChannels[pair.substr( 0, found )] = (unsigned char)channel;
+        }
+        catch( boost::bad_lexical_cast e )
+        {
+            OLOGW << "Invalid component replication channel " << pair << 
+                ", expected <Class>=<0-31>.";
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+} // Namespace ObjectSystem
+} // Namespace Diversia
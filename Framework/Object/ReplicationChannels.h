@@ -0,0 +1,129 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_OBJECT_REPLICATIONCHANNELS_H
+#define DIVERSIA_OBJECT_REPLICATIONCHANNELS_H
+
+#include "Object/Platform/Prerequisites.h"
+
+namespace Diversia
+{
+namespace ObjectSystem
+{
+//------------------------------------------------------------------------------
+
+/**
+Assigns the reliability and ordering channel that each part of a replica serialization is sent 
+with. RakNet sends the parts of a serialization that have different send parameters as separate
+messages, so a lost message only holds back the parts that share its ordering channel.
+
+Transforms are sent unreliable sequenced on their own ordering channel, a newer transform always
+replaces an older one so a lost transform is never resent and never blocks other updates. Because
+any transform may be lost, transforms are then sent completely instead of only the parts that
+changed. When an object comes to rest its final transform is sent once reliable ordered on the 
+transform channel, so a lost last transform does not leave the object at the wrong place. 
+Property transactions and function calls are sent reliable ordered on the same channel
+so calls keep their order relative to property changes. Component types can be given their own
+ordering channel so their updates do not wait on each other.
+**/
+class DIVERSIA_OBJECT_API ReplicationChannels
+{
+public:
+    /**
+    Sets the send parameters of a bitstream slot that contains a transform. Does nothing if 
+    channels are disabled.
+    
+    @param [in,out] pSerializeParameters    The serialize parameters.
+    @param  slot                            The bitstream slot.
+    @param  reliable                        True to send the transform reliable ordered, for the
+                                            final transform of an object that came to rest.
+    **/
+    static void setTransformChannel( RakNet::SerializeParameters* pSerializeParameters, 
+        unsigned int slot, bool reliable = false );
+    /**
+    Sets the send parameters of a bitstream slot that contains state that must arrive, such as
+    property transactions and function calls. Does nothing if channels are disabled.
+    
+    @param [in,out] pSerializeParameters    The serialize parameters.
+    @param  slot                            The bitstream slot.
+    @param  rClass                          The class name of the replica, used to look up the 
+                                            ordering channel of component types.
+    **/
+    static void setStateChannel( RakNet::SerializeParameters* pSerializeParameters, 
+        unsigned int slot, const String& rClass = "" );
+    /**
+    Gets the ordering channel that the state of a replica class is sent on.
+    
+    @param  rClass  The class name of the replica.
+    **/
+    static unsigned char getStateChannel( const String& rClass );
+    /**
+    Query if transforms are sent unreliable, in which case every transform must be complete.
+    **/
+    inline static bool isTransformUnreliable() { return msSettings.mEnabled; }
+
+private:
+    static void parseComponentChannels();
+
+    static std::map<String, unsigned char>  msComponentChannels;
+    static String                           msParsedComponentChannels;
+
+    /**
+    Settings for replication channels.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mEnabled( true ),
+            mTransformChannel( 1 ),
+            mStateChannel( 2 ),
+            mRestDelayMS( 250 ),
+            mComponentChannels( "" )
+        {
+
+        }
+
+        bool            mEnabled;           ///< False to send everything reliable ordered.
+        unsigned int    mTransformChannel;
+        unsigned int    mStateChannel;      ///< Channel of properties and function calls.
+        unsigned int    mRestDelayMS;       ///< Time without changes before an object is at rest.
+        String          mComponentChannels; ///< Space separated list of <Class>=<channel>.
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static ReplicationChannels::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace ObjectSystem
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::ObjectSystem::ReplicationChannels::Settings, 
+    &Diversia::ObjectSystem::Bindings::CampBindings::bindReplicationChannelsSettings );
+
+#endif // DIVERSIA_OBJECT_REPLICATIONCHANNELS_H
@@ -0,0 +1,334 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Object/Platform/StableHeaders.h"
+
+#include "Object/TransformCodec.h"
+
+namespace Diversia
+{
+namespace ObjectSystem
+{
+//------------------------------------------------------------------------------
+
+/// Range of the three smallest quaternion components, 1 / sqrt( 2 ).
+static const Real cOrientationRange = (Real)0.7071067811865475;
+/// Largest amount of bits per position component, the mantissa of a single precision float.
+static const unsigned char cMaxPositionBits = 24;
+
+unsigned char TransformCodec::msDefaultPositionBits = 20;
+unsigned char TransformCodec::msDefaultOrientationBits = 10;
+
+TransformCodec::TransformCodec():
+    mPositionBits( msDefaultPositionBits ),
+    mOrientationBits( msDefaultOrientationBits )
+{
+
+}
+
+TransformCodec::TransformCodec( unsigned char positionBits, unsigned char orientationBits ):
+    mPositionBits( msDefaultPositionBits ),
+    mOrientationBits( msDefaultOrientationBits )
+{
+    TransformCodec::setPositionBits( positionBits );
+    TransformCodec::setOrientationBits( orientationBits );
+}
+
+void TransformCodec::writePosition( RakNet::BitStream& rStream, const Vector3& rPosition ) const
+{
+    const Real range = (Real)DIVERSIA_SERVER_SIZE;
+
+    if( Math::Abs( rPosition.x ) > range || Math::Abs( rPosition.y ) > range || 
+        Math::Abs( rPosition.z ) > range )
+    {
+        // Out of range, use full precision.
+        rStream.Write1();
+        rStream << rPosition;
+        return;
+    }
+
+    rStream.Write0();
+    TransformCodec::writeBits( rStream, quantize( rPosition.x, range, mPositionBits ), 
+        mPositionBits );
+    TransformCodec::writeBits( rStream, quantize( rPosition.y, range, mPositionBits ), 
+        mPositionBits );
+    TransformCodec::writeBits( rStream, quantize( rPosition.z, range, mPositionBits ), 
+        mPositionBits );
+}
+
+void TransformCodec::readPosition( RakNet::BitStream& rStream, Vector3& rPosition ) const
+{
+    const Real range = (Real)DIVERSIA_SERVER_SIZE;
+
+    if( rStream.ReadBit() )
+    {
+        rStream >> rPosition;
+        return;
+    }
+
+    rPosition.x = dequantize( TransformCodec::readBits( rStream, mPositionBits ), range, 
+        mPositionBits );
+    rPosition.y = dequantize( TransformCodec::readBits( rStream, mPositionBits ), range, 
+        mPositionBits );
+    rPosition.z = dequantize( TransformCodec::readBits( rStream, mPositionBits ), range, 
+        mPositionBits );
+}
+
+void TransformCodec::writeOrientation( RakNet::BitStream& rStream, 
+    const Quaternion& rOrientation ) const
+{
+    Quaternion q = rOrientation;
+    q.normalise();
+
+    Real components[4] = { q.w, q.x, q.y, q.z };
+
+    // Find the largest component, it is left out.
+    unsigned char largest = 0;
+    for( unsigned char i = 1; i < 4; ++i )
+    {
+        if( Math::Abs( components[i] ) > Math::Abs( components[largest] ) ) largest = i;
+    }
+
+    // q and -q are the same orientation, make sure the left out component is positive.
+    const Real sign = components[largest] < 0 ? -1 : 1;
+    const Real range = cOrientationRange;
+
+    TransformCodec::writeBits( rStream, largest, 2 );
+    for( unsigned char i = 0; i < 4; ++i )
+    {
+        if( i == largest ) continue;
+        TransformCodec::writeBits( rStream, quantize( components[i] * sign, range, 
+            mOrientationBits ), mOrientationBits );
+    }
+}
+
+void TransformCodec::readOrientation( RakNet::BitStream& rStream, 
+    Quaternion& rOrientation ) const
+{
+    const Real range = cOrientationRange;
+
+    Real components[4];
+    unsigned char largest = (unsigned char)TransformCodec::readBits( rStream, 2 );
+    Real sum = 0;
+    for( unsigned char i = 0; i < 4; ++i )
+    {
+        if( i == largest ) continue;
+        components[i] = dequantize( TransformCodec::readBits( rStream, mOrientationBits ), range, 
+            mOrientationBits );
+        sum += components[i] * components[i];
+    }
+    components[largest] = Math::Sqrt( std::max( (Real)0, (Real)1 - sum ) );
+
+    rOrientation = Quaternion( components[0], components[1], components[2], components[3] );
+    rOrientation.normalise();
+}
+
+void TransformCodec::writeScale( RakNet::BitStream& rStream, const Vector3& rScale ) const
+{
+    if( rScale == Vector3::UNIT_SCALE )
+    {
+        rStream.Write1();
+        return;
+    }
+
+    rStream.Write0();
+    if( rScale.x == rScale.y && rScale.x == rScale.z )
+    {
+        rStream.Write1();
+        rStream.Write( rScale.x );
+    }
+    else
+    {
+        rStream.Write0();
+        rStream << rScale;
+    }
+}
+
+void TransformCodec::readScale( RakNet::BitStream& rStream, Vector3& rScale ) const
+{
+    if( rStream.ReadBit() )
+    {
+        rScale = Vector3::UNIT_SCALE;
+    }
+    else if( rStream.ReadBit() )
+    {
+        Real scale; rStream.Read( scale );
+        rScale = Vector3( scale, scale, scale );
+    }
+    else
+    {
+        rStream >> rScale;
+    }
+}
+
+void TransformCodec::writePrecision( RakNet::BitStream& rStream ) const
+{
+    TransformCodec::writeBits( rStream, mPositionBits, 5 );
+    TransformCodec::writeBits( rStream, mOrientationBits, 5 );
+}
+
+bool TransformCodec::readPrecision( RakNet::BitStream& rStream )
+{
+    unsigned char positionBits = (unsigned char)TransformCodec::readBits( rStream, 5 );
+    unsigned char orientationBits = (unsigned char)TransformCodec::readBits( rStream, 5 );
+    if( !TransformCodec::isValidPrecision( positionBits, orientationBits ) ) return false;
+
+    mPositionBits = positionBits;
+    mOrientationBits = orientationBits;
+    return true;
+}
+
+bool TransformCodec::isValidPrecision( unsigned char positionBits, 
+    unsigned char orientationBits )
+{
+    return positionBits >= 8 && positionBits <= cMaxPositionBits && orientationBits >= 6 && 
+        orientationBits <= 16;
+}
+
+bool TransformCodec::checkRoundTrip( unsigned char positionBits, unsigned char orientationBits )
+{
+    if( !TransformCodec::isValidPrecision( positionBits, orientationBits ) ) return false;
+
+    TransformCodec codec( positionBits, orientationBits );
+    const Real range = (Real)DIVERSIA_SERVER_SIZE;
+    const Real positionError = codec.getPositionError();
+    const Real orientationError = cOrientationRange * 2 / 
+        (Real)( ( 1u << orientationBits ) - 1 );
+    const Vector3 positions[3] = { Vector3( range, range, range ), 
+        Vector3( -range, -range, -range ), Vector3( range, -range, 0 ) };
+    const Quaternion orientations[3] = { Quaternion::IDENTITY, 
+        Quaternion( cOrientationRange, cOrientationRange, 0, 0 ), 
+        Quaternion( cOrientationRange, -cOrientationRange, 0, 0 ) };
+
+    RakNet::BitStream stream;
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        codec.writePosition( stream, positions[i] );
+        codec.writeOrientation( stream, orientations[i] );
+    }
+
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        Vector3 position;
+        Quaternion orientation;
+        codec.readPosition( stream, position );
+        codec.readOrientation( stream, orientation );
+
+        if( !position.positionEquals( positions[i], positionError ) ) return false;
+        if( Math::Abs( orientation.Dot( orientations[i] ) ) < 1 - orientationError ) return false;
+    }
+
+    return true;
+}
+
+void TransformCodec::setPositionBits( unsigned char bits )
+{
+    if( bits < 8 || bits > cMaxPositionBits )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, 
+            "Position precision must be between 8 and 24 bits.", 
+            "TransformCodec::setPositionBits" );
+    }
+
+    mPositionBits = bits;
+}
+
+void TransformCodec::setOrientationBits( unsigned char bits )
+{
+    if( bits < 6 || bits > 16 )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, 
+            "Orientation precision must be between 6 and 16 bits.", 
+            "TransformCodec::setOrientationBits" );
+    }
+
+    mOrientationBits = bits;
+}
+
+Real TransformCodec::getPositionError() const
+{
+    return (Real)DIVERSIA_SERVER_SIZE / (Real)( ( 1u << mPositionBits ) - 1 );
+}
+
+void TransformCodec::setDefaultPrecision( unsigned char positionBits, 
+    unsigned char orientationBits )
+{
+    // Validate through a temporary codec.
+    TransformCodec codec( positionBits, orientationBits );
+    assert( TransformCodec::checkRoundTrip( positionBits, orientationBits ) );
+    msDefaultPositionBits = codec.getPositionBits();
+    msDefaultOrientationBits = codec.getOrientationBits();
+}
+
+void TransformCodec::writeBits( RakNet::BitStream& rStream, boost::uint32_t value, 
+    unsigned char bits )
+{
+    // Write byte by byte so the result does not depend on endianness.
+    while( bits > 0 )
+    {
+        unsigned char count = std::min( bits, (unsigned char)8 );
+        unsigned char byte = (unsigned char)( value & ( ( 1u << count ) - 1 ) );
+        rStream.WriteBits( &byte, count, true );
+        value >>= count;
+        bits -= count;
+    }
+}
+
+boost::uint32_t TransformCodec::readBits( RakNet::BitStream& rStream, unsigned char bits )
+{
+    boost::uint32_t value = 0;
+    unsigned char shift = 0;
+
+    while( bits > 0 )
+    {
+        unsigned char count = std::min( bits, (unsigned char)8 );
+        unsigned char byte = 0;
+        rStream.ReadBits( &byte, count, true );
+        value |= (boost::uint32_t)byte << shift;
+        shift += count;
+        bits -= count;
+    }
+
+    return value;
+}
+
+boost::uint32_t TransformCodec::quantize( Real value, Real range, unsigned char bits )
+{
+    // Quantize in double precision and clamp, rounding in float can produce max + 1 which would 
+    // wrap around to 0 when written.
+    const boost::uint32_t max = ( 1u << bits ) - 1;
+    double normalized = ( (double)value + range ) / ( (double)range * 2 );
+    normalized = std::max( 0.0, std::min( 1.0, normalized ) );
+    return std::min( (boost::uint32_t)( normalized * max + 0.5 ), max );
+}
+
+Real TransformCodec::dequantize( boost::uint32_t value, Real range, unsigned char bits )
+{
+    const boost::uint32_t max = ( 1u << bits ) - 1;
+    return (Real)( ( (double)value / (double)max ) * range * 2 - range );
+}
+
+//------------------------------------------------------------------------------
+} // Namespace ObjectSystem
+} // Namespace Diversia
@@ -0,0 +1,167 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_OBJECT_TRANSFORMCODEC_H
+#define DIVERSIA_OBJECT_TRANSFORMCODEC_H
+
+#include "Object/Platform/Prerequisites.h"
+
+namespace Diversia
+{
+namespace ObjectSystem
+{
+//------------------------------------------------------------------------------
+
+/**
+Compresses transforms for replication. Positions are written as fixed point numbers within 
+[-DIVERSIA_SERVER_SIZE, DIVERSIA_SERVER_SIZE], positions outside of this range fall back to full
+precision. Orientations are written with the smallest three encoding, the largest component is 
+left out and reconstructed from the other three. Unit scale is written as a single bit.
+
+The precision is expressed in bits per component, both sides of a connection must use the same
+precision so it is written with write/readPrecision when it changes.
+**/
+class DIVERSIA_OBJECT_API TransformCodec
+{
+public:
+    /**
+    Constructor, uses the default precision.
+    **/
+    TransformCodec();
+    /**
+    Constructor. 
+    
+    @param  positionBits    Amount of bits per position component, between 8 and 24.
+    @param  orientationBits Amount of bits per orientation component, between 6 and 16.
+    **/
+    TransformCodec( unsigned char positionBits, unsigned char orientationBits );
+
+    /**
+    Writes a position.
+    **/
+    void writePosition( RakNet::BitStream& rStream, const Vector3& rPosition ) const;
+    /**
+    Reads a position.
+    **/
+    void readPosition( RakNet::BitStream& rStream, Vector3& rPosition ) const;
+    /**
+    Writes an orientation, the orientation is normalised before it is written.
+    **/
+    void writeOrientation( RakNet::BitStream& rStream, const Quaternion& rOrientation ) const;
+    /**
+    Reads an orientation.
+    **/
+    void readOrientation( RakNet::BitStream& rStream, Quaternion& rOrientation ) const;
+    /**
+    Writes a scale, unit and uniform scales are written compactly.
+    **/
+    void writeScale( RakNet::BitStream& rStream, const Vector3& rScale ) const;
+    /**
+    Reads a scale.
+    **/
+    void readScale( RakNet::BitStream& rStream, Vector3& rScale ) const;
+    /**
+    Writes the precision of this codec.
+    **/
+    void writePrecision( RakNet::BitStream& rStream ) const;
+    /**
+    Reads the precision of this codec. The precision comes from a remote peer, an invalid 
+    precision is not applied and does not throw.
+
+    @return True if the precision is valid, false if it is not. The rest of the stream cannot be 
+            read when it is not valid.
+    **/
+    bool readPrecision( RakNet::BitStream& rStream );
+    /**
+    Query if a precision can be used by a codec.
+    **/
+    static bool isValidPrecision( unsigned char positionBits, unsigned char orientationBits );
+    /**
+    Writes and reads back positions and orientations at the limits of the quantization range and 
+    checks that they decode within the error of the precision.
+    **/
+    static bool checkRoundTrip( unsigned char positionBits, unsigned char orientationBits );
+
+    /**
+    Sets the amount of bits per position component, between 8 and 24. More bits do not add 
+    precision because a single precision float has a 24 bit mantissa.
+    **/
+    void setPositionBits( unsigned char bits );
+    /**
+    Gets the amount of bits per position component.
+    **/
+    inline unsigned char getPositionBits() const { return mPositionBits; }
+    /**
+    Sets the amount of bits per orientation component, between 6 and 16.
+    **/
+    void setOrientationBits( unsigned char bits );
+    /**
+    Gets the amount of bits per orientation component.
+    **/
+    inline unsigned char getOrientationBits() const { return mOrientationBits; }
+    /**
+    Gets the largest position error in meters.
+    **/
+    Real getPositionError() const;
+
+    /**
+    Sets the default precision for new codecs.
+    **/
+    static void setDefaultPrecision( unsigned char positionBits, unsigned char orientationBits );
+    /**
+    Gets the default amount of bits per position component.
+    **/
+    static inline unsigned char getDefaultPositionBits() { return msDefaultPositionBits; }
+    /**
+    Gets the default amount of bits per orientation component.
+    **/
+    static inline unsigned char getDefaultOrientationBits() { return msDefaultOrientationBits; }
+
+    inline bool operator==( const TransformCodec& rCodec ) const
+    {
+        return mPositionBits == rCodec.mPositionBits && 
+            mOrientationBits == rCodec.mOrientationBits;
+    }
+    inline bool operator!=( const TransformCodec& rCodec ) const { return !( *this == rCodec ); }
+
+private:
+    static void writeBits( RakNet::BitStream& rStream, boost::uint32_t value, 
+        unsigned char bits );
+    static boost::uint32_t readBits( RakNet::BitStream& rStream, unsigned char bits );
+    static boost::uint32_t quantize( Real value, Real range, unsigned char bits );
+    static Real dequantize( boost::uint32_t value, Real range, unsigned char bits );
+
+    unsigned char mPositionBits;
+    unsigned char mOrientationBits;
+
+    static unsigned char msDefaultPositionBits;
+    static unsigned char msDefaultOrientationBits;
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace ObjectSystem
+} // Namespace Diversia
+
+#endif // DIVERSIA_OBJECT_TRANSFORMCODEC_H
@@ -0,0 +1,163 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Object/Platform/StableHeaders.h"
+
+#include "Object/TransformInterpolator.h"
+
+namespace Diversia
+{
+namespace ObjectSystem
+{
+//------------------------------------------------------------------------------
+
+TransformInterpolator::Settings TransformInterpolator::msSettings = 
+    TransformInterpolator::Settings();
+
+TransformInterpolator::TransformInterpolator():
+    mVelocity( Vector3::ZERO )
+{
+
+}
+
+bool TransformInterpolator::addSnapshot( RakNet::Time time, const Vector3& rPosition, 
+    const Quaternion& rOrientation, const Vector3& rScale )
+{
+    bool teleport = false;
+
+    if( !mSnapshots.empty() )
+    {
+        Snapshot& last = mSnapshots.back();
+
+        // Drop snapshots that arrive out of order.
+        if( time <= last.mTime ) return false;
+
+        teleport = last.mPosition.squaredDistance( rPosition ) > 
+            msSettings.mTeleportDistance * msSettings.mTeleportDistance;
+
+        if( teleport )
+        {
+            mSnapshots.clear();
+            mVelocity = Vector3::ZERO;
+        }
+        else
+        {
+            // Move from the last snapshot in one interpolation delay if the object has been 
+            // standing still.
+            if( msSettings.mInterpolationDelayMS && 
+                time - last.mTime > msSettings.mInterpolationDelayMS )
+                last.mTime = time - msSettings.mInterpolationDelayMS;
+
+            mVelocity = ( rPosition - last.mPosition ) / ( ( time - last.mTime ) / (Real)1000 );
+        }
+    }
+
+    Snapshot snapshot;
+    snapshot.mTime = time;
+    snapshot.mPosition = rPosition;
+    snapshot.mOrientation = rOrientation;
+    snapshot.mScale = rScale;
+    mSnapshots.push_back( snapshot );
+
+    while( mSnapshots.size() > std::max( msSettings.mMaxSnapshots, 2u ) ) mSnapshots.pop_front();
+
+    return teleport;
+}
+
+bool TransformInterpolator::sample( RakNet::Time time, Vector3& rPosition, 
+    Quaternion& rOrientation, Vector3& rScale )
+{
+    if( mSnapshots.empty() ) return false;
+
+    RakNet::Time renderTime = time > msSettings.mInterpolationDelayMS ? 
+        time - msSettings.mInterpolationDelayMS : 0;
+
+    // Remove snapshots that are no longer needed, keep one snapshot before the render time.
+    while( mSnapshots.size() > 1 && mSnapshots[1].mTime <= renderTime ) mSnapshots.pop_front();
+
+    const Snapshot& from = mSnapshots.front();
+    if( renderTime <= from.mTime )
+    {
+        rPosition = from.mPosition;
+        rOrientation = from.mOrientation;
+        rScale = from.mScale;
+        return true;
+    }
+
+    if( mSnapshots.size() > 1 )
+    {
+        // Interpolate between the snapshots around the render time.
+        const Snapshot& to = mSnapshots[1];
+        Real t = ( renderTime - from.mTime ) / (Real)( to.mTime - from.mTime );
+        rPosition = from.mPosition + ( to.mPosition - from.mPosition ) * t;
+        rOrientation = Quaternion::Slerp( t, from.mOrientation, to.mOrientation, true );
+        rScale = from.mScale + ( to.mScale - from.mScale ) * t;
+        return true;
+    }
+
+    // Buffer ran dry, extrapolate the position with the velocity between the last two snapshots.
+    RakNet::Time extrapolation = renderTime - from.mTime;
+    rOrientation = from.mOrientation;
+    rScale = from.mScale;
+
+    if( extrapolation > msSettings.mMaxExtrapolationMS + msSettings.mExtrapolationDecayMS )
+    {
+        if( mVelocity == Vector3::ZERO ) return false;
+
+        // No new snapshot arrived, the object most likely stopped at the last snapshot.
+        rPosition = from.mPosition;
+        mVelocity = Vector3::ZERO;
+        return true;
+    }
+
+    if( extrapolation <= msSettings.mMaxExtrapolationMS )
+    {
+        rPosition = from.mPosition + mVelocity * ( extrapolation / (Real)1000 );
+    }
+    else
+    {
+        // Decay the overshoot at the extrapolation limit back to the last snapshot.
+        Real t = ( extrapolation - msSettings.mMaxExtrapolationMS ) / 
+            (Real)msSettings.mExtrapolationDecayMS;
+        rPosition = from.mPosition + mVelocity * 
+            ( msSettings.mMaxExtrapolationMS / (Real)1000 ) * ( 1 - t );
+    }
+
+    return true;
+}
+
+bool TransformInterpolator::getLastSnapshot( Vector3& rPosition, Quaternion& rOrientation, 
+    Vector3& rScale ) const
+{
+    if( mSnapshots.empty() ) return false;
+
+    rPosition = mSnapshots.back().mPosition;
+    rOrientation = mSnapshots.back().mOrientation;
+    rScale = mSnapshots.back().mScale;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+} // Namespace ObjectSystem
+} // Namespace Diversia
@@ -0,0 +1,142 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_OBJECT_TRANSFORMINTERPOLATOR_H
+#define DIVERSIA_OBJECT_TRANSFORMINTERPOLATOR_H
+
+#include "Object/Platform/Prerequisites.h"
+
+namespace Diversia
+{
+namespace ObjectSystem
+{
+//------------------------------------------------------------------------------
+
+/**
+Buffers timestamped transform snapshots of a remote object and samples them with a delay, so 
+that the transform moves smoothly between snapshots even when snapshots arrive at a low rate or 
+with jitter. When the buffer runs dry the position is extrapolated for a limited time, after 
+which it decays back to the last snapshot so that an overshot position is not held. Snapshots 
+that are too far away from the previous snapshot are treated as teleports and applied directly.
+**/
+class DIVERSIA_OBJECT_API TransformInterpolator
+{
+public:
+    /**
+    Default constructor. 
+    **/
+    TransformInterpolator();
+
+    /**
+    Adds a snapshot.
+    
+    @param  time            The time at which the snapshot was taken, in local time.
+    @param  rPosition       The position.
+    @param  rOrientation    The orientation.
+    @param  rScale          The scale.
+
+    @return True if the snapshot is a teleport and the buffer has been reset to this snapshot.
+    **/
+    bool addSnapshot( RakNet::Time time, const Vector3& rPosition, 
+        const Quaternion& rOrientation, const Vector3& rScale );
+    /**
+    Samples the transform at given time minus the interpolation delay.
+    
+    @param  time                    The current time.
+    @param [in,out] rPosition       The position, only written when sampling succeeds.
+    @param [in,out] rOrientation    The orientation, only written when sampling succeeds.
+    @param [in,out] rScale          The scale, only written when sampling succeeds.
+
+    @return False if the buffer is empty or the transform has settled on the last snapshot, 
+            the transform will not change until a new snapshot is added.
+    **/
+    bool sample( RakNet::Time time, Vector3& rPosition, Quaternion& rOrientation, 
+        Vector3& rScale );
+    /**
+    Gets the last snapshot that was added.
+
+    @return False if there are no snapshots.
+    **/
+    bool getLastSnapshot( Vector3& rPosition, Quaternion& rOrientation, Vector3& rScale ) const;
+    /**
+    Query if there are no snapshots.
+    **/
+    inline bool isEmpty() const { return mSnapshots.empty(); }
+    /**
+    Removes all snapshots.
+    **/
+    inline void clear() { mSnapshots.clear(); mVelocity = Vector3::ZERO; }
+
+private:
+    struct Snapshot
+    {
+        RakNet::Time    mTime;
+        Vector3         mPosition;
+        Quaternion      mOrientation;
+        Vector3         mScale;
+    };
+
+    std::deque<Snapshot>    mSnapshots;
+    Vector3                 mVelocity;
+
+    /**
+    Settings for transform interpolation.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mEnabled( true ),
+            mInterpolationDelayMS( 100 ),
+            mMaxExtrapolationMS( 200 ),
+            mExtrapolationDecayMS( 200 ),
+            mTeleportDistance( 10 ),
+            mMaxSnapshots( 32 )
+        {
+
+        }
+
+        bool            mEnabled;
+        unsigned int    mInterpolationDelayMS;
+        unsigned int    mMaxExtrapolationMS;
+        unsigned int    mExtrapolationDecayMS;  ///< Time to return to the last snapshot.
+        Real            mTeleportDistance;  ///< Distance between snapshots that is a teleport.
+        unsigned int    mMaxSnapshots;
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static TransformInterpolator::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace ObjectSystem
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::ObjectSystem::TransformInterpolator::Settings, 
+    &Diversia::ObjectSystem::Bindings::CampBindings::bindTransformInterpolatorSettings );
+
+#endif // DIVERSIA_OBJECT_TRANSFORMINTERPOLATOR_H
@@ -34,8 +34,12 @@ THE SOFTWARE.
 #include "Shared/Plugin/PluginManager.h"
 #include "Shared/Communication/ServerDirection.h"
 #include "Shared/Communication/ServerInfo.h"
+#include "Shared/Communication/NetworkStage.h"
+#include "Shared/Communication/TrafficStatistics.h"
+#include "Shared/Communication/PacketReplay.h"
 #include "Shared/Communication/ServerNeighbors.h"
 #include "Shared/Communication/UserInfo.h"
+#include "Shared/Communication/WorldSnapshot.h"
 #include "Shared/Crash/CrashReporter.h"
 #include "Shared/Crash/WindowsCrashReporter.h"
 #include "Shared/Graphics/Graphics.h"
@@ -254,6 +258,78 @@ void CampBindings::bindUserInfo()
         // Operators
 }
 
+void CampBindings::bindWorldSnapshotSettings()
+{
+    camp::Class::declare<WorldSnapshot::Settings>( "WorldSnapshotSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Enabled", &WorldSnapshot::Settings::mEnabled )
+            .tag( "Configurable" )
+        .property( "ChunkSize", &WorldSnapshot::Settings::mChunkSize )
+            .tag( "Configurable" )
+        .property( "WindowSize", &WorldSnapshot::Settings::mWindowSize )
+            .tag( "Configurable" )
+        .property( "Timeout", &WorldSnapshot::Settings::mTimeoutMS )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindNetworkStageSettings()
+{
+    camp::Class::declare<NetworkStage::Settings>( "NetworkStageSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Threaded", &NetworkStage::Settings::mThreaded )
+            .tag( "Configurable" )
+        .property( "QueueSize", &NetworkStage::Settings::mQueueSize )
+            .tag( "Configurable" )
+        .property( "IdleSleepMS", &NetworkStage::Settings::mIdleSleepMS )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindTrafficStatisticsSettings()
+{
+    camp::Class::declare<TrafficStatistics::Settings>( "TrafficStatisticsSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Enabled", &TrafficStatistics::Settings::mEnabled )
+            .tag( "Configurable" )
+        .property( "DumpInterval", &TrafficStatistics::Settings::mDumpInterval )
+            .tag( "Configurable" )
+        .property( "DumpFile", &TrafficStatistics::Settings::mDumpFile )
+            .tag( "Configurable" )
+        .property( "LogCount", &TrafficStatistics::Settings::mLogCount )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindPacketReplaySettings()
+{
+    camp::Class::declare<PacketReplay::Settings>( "PacketReplaySettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Speed", &PacketReplay::Settings::mSpeed )
+            .tag( "Configurable" )
+        .property( "QuitWhenFinished", &PacketReplay::Settings::mQuitWhenFinished )
+            .tag( "Configurable" )
+        .property( "ReportFile", &PacketReplay::Settings::mReportFile )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
 void CampBindings::bindPhysicsType()
 {
     camp::Enum::declare<PhysicsType>( "PhysicsType" )
@@ -363,11 +439,13 @@ void CampBindings::bindPermission()
 
 void CampBindings::bindPropertySynchronization()
 {
-    camp::Class::declare<PropertySynchronization>( "PropertySynchronization" );
+    camp::Class::declare<PropertySynchronization>( "PropertySynchronization" )
         // Constructors
         // Properties (read-only)
         // Properties (read/write)
         // Functions
+        .function( "SetPropertyMaxRate", &PropertySynchronization::setPropertyMaxRate )
+        .function( "ResetPropertyMaxRate", &PropertySynchronization::resetPropertyMaxRate );
         // Static functions
         // Operators
 }
@@ -52,6 +52,10 @@ public:
     static void bindHeightmapTypeEnum();
     static void bindLayerInstance();
     static void bindUserInfo();
+    static void bindWorldSnapshotSettings();
+    static void bindNetworkStageSettings();
+    static void bindTrafficStatisticsSettings();
+    static void bindPacketReplaySettings();
     static void bindPhysicsType();
     static void bindPhysicsShape();
     static void bindLuaManager();
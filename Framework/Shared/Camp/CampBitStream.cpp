@@ -0,0 +1,356 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Shared/Platform/StableHeaders.h"
+
+#include "Shared/Camp/CampBitStream.h"
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+CampBitStream::Plans CampBitStream::msPlans = CampBitStream::Plans();
+
+void CampBitStream::serialize( const camp::UserObject& rObject, RakNet::BitStream& rBitStream, 
+    const camp::Value& rExcludeTag /*= camp::Value::nothing*/, 
+    const std::map<String, camp::Value>* pReference /*= 0*/, 
+    const std::set<String>* pHidden /*= 0*/ )
+{
+    using namespace camp;
+
+    const Plan& plan = CampBitStream::getPlan( rObject.getClass(), rExcludeTag );
+    for( Plan::const_iterator i = plan.begin(); i != plan.end(); ++i )
+    {
+        const Property& property = *i->mProperty;
+
+        if( pHidden && pHidden->count( property.name() ) )
+        {
+            // Written as different from the reference and unreadable, the receiver keeps its 
+            // own value.
+            if( pReference ) rBitStream.Write1();
+            rBitStream.Write0();
+            continue;
+        }
+
+        if( pReference )
+        {
+            // Skip properties that are equal to their reference value, composed types and arrays 
+            // are always sent.
+            if( i->mKind != PK_COMPOSED && i->mKind != PK_ARRAY && property.readable( rObject ) )
+            {
+                std::map<String, Value>::const_iterator j = pReference->find( property.name() );
+                if( j != pReference->end() && 
+                    CampBitStream::equals( property.get( rObject ), j->second ) )
+                {
+                    rBitStream.Write0();
+                    continue;
+                }
+            }
+
+            rBitStream.Write1();
+        }
+
+        // Check if property is readable
+        if( property.readable( rObject ) )
+        {
+            rBitStream.Write1();
+        }
+        else
+        {
+            rBitStream.Write0();
+            continue;
+        }
+
+        switch( i->mKind )
+        {
+            case PK_COMPOSED:
+            {
+                // The current property is a composed type: serialize it recursively.
+                CampBitStream::serialize( property.get( rObject ).to<UserObject>(), rBitStream, 
+                    rExcludeTag );
+                break;
+            }
+            case PK_ARRAY:
+            {
+                // The current property is an array.
+                const ArrayProperty& arrayProperty = static_cast<const ArrayProperty&>( property );
+
+                // Send array size.
+                std::size_t count = arrayProperty.size( rObject );
+                rBitStream.Write<std::size_t>( count );
+
+                // Iterate over the array elements.
+                if( arrayProperty.elementType() == userType )
+                {
+                    for( std::size_t j = 0; j < count; ++j )
+                        CampBitStream::writeElement( rBitStream, arrayProperty.get( rObject, j ), 
+                            rExcludeTag );
+                }
+                else
+                {
+                    // The array elements are simple properties: serialize value to bitstream.
+                    for( std::size_t j = 0; j < count; ++j )
+                        rBitStream << arrayProperty.get( rObject, j );
+                }
+                break;
+            }
+            default:
+                CampBitStream::writeValue( rBitStream, *i, property.get( rObject ) );
+        }
+    }
+}
+
+void CampBitStream::deserialize( const camp::UserObject& rObject, RakNet::BitStream& rBitStream, 
+    const camp::Value& rExcludeTag /*= camp::Value::nothing*/, 
+    const std::map<String, camp::Value>* pReference /*= 0*/ )
+{
+    using namespace camp;
+
+    const Plan& plan = CampBitStream::getPlan( rObject.getClass(), rExcludeTag );
+    for( Plan::const_iterator i = plan.begin(); i != plan.end(); ++i )
+    {
+        const Property& property = *i->mProperty;
+
+        if( pReference && !rBitStream.ReadBit() )
+        {
+            // Property was not sent because it is equal to its reference value.
+            std::map<String, Value>::const_iterator j = pReference->find( property.name() );
+            if( j != pReference->end() && property.writable( rObject ) ) 
+                property.set( rObject, j->second );
+            continue;
+        }
+
+        // Check if the property was sent (readable at serialization)
+        if( !rBitStream.ReadBit() )
+            continue;
+
+        // Check if the property is readable and writable, can't stop here because the 
+        // bitstream pointer needs to be advanced.
+        bool writable = property.writable( rObject );
+        bool readable = property.readable( rObject );
+
+        switch( i->mKind )
+        {
+            case PK_COMPOSED:
+            {
+                // TODO: What happens if property is not readable and it's a composed type?
+                if( !readable )
+                {
+                    Value value; rBitStream >> value;
+                    continue;
+                }
+
+                // The current property is a composed type: deserialize it recursively.
+                // TODO: What happens if property is not writable?
+                CampBitStream::deserialize( property.get( rObject ).to<UserObject>(), rBitStream, 
+                    rExcludeTag );
+                break;
+            }
+            case PK_ARRAY:
+            {
+                // The current property is an array.
+                const ArrayProperty& arrayProperty = static_cast<const ArrayProperty&>( property );
+
+                // Read array size.
+                std::size_t size; rBitStream.Read( size );
+
+                // Resize array if needed.
+                if( size > arrayProperty.size( rObject ) )
+                {
+                    if ( arrayProperty.dynamic() )
+                        arrayProperty.resize( rObject, size );
+                    else
+                        return;
+                }
+
+                for( std::size_t j = 0; j < size; ++j )
+                {
+                    if ( arrayProperty.elementType() == userType )
+                    {
+                        // TODO: What happens if property is not readable and it's a composed type?
+                        if( !readable )
+                        {
+                            Value value; rBitStream >> value;
+                            continue;
+                        }
+
+                        UserObject object = arrayProperty.get( rObject, j ).to<UserObject>();
+                        if( object.getClass().hasTag( "BindingType" ) )
+                        {
+                            // Property can be directly deserialized from the bitstream.
+                            Value value; rBitStream >> value;
+                            if( writable ) arrayProperty.set( rObject, j, value );
+                        }
+                        else
+                        {
+                            // The array elements are composed objects: deserialize them recursively.
+                            // TODO: What happens if property is not writable?
+                            CampBitStream::deserialize( object, rBitStream, rExcludeTag );
+                        }
+                    }
+                    else
+                    {
+                        // The array elements are simple properties: deserialize value from bitstream.
+                        Value value; rBitStream >> value;
+                        if( writable ) arrayProperty.set( rObject, j, value );
+                    }
+                }
+                break;
+            }
+            default:
+            {
+                // The current property can be directly deserialized from the bitstream.
+                // TODO: What happens if property is not readable and it's a user type?
+                Value value; rBitStream >> value;
+                if( writable && ( readable || i->mKind != PK_BINDING ) )
+                    property.set( rObject, value );
+            }
+        }
+    }
+}
+
+const CampBitStream::Plan& CampBitStream::getPlan( const camp::Class& rClass, 
+    const camp::Value& rExcludeTag )
+{
+    using namespace camp;
+
+    std::pair<const Class*, Value> key( &rClass, rExcludeTag );
+    Plans::iterator i = msPlans.find( key );
+    if( i != msPlans.end() ) return i->second;
+
+    // Build a plan for this class and exclude tag.
+    Plan& plan = msPlans[ key ];
+    for( std::size_t j = 0; j < rClass.propertyCount(); ++j )
+    {
+        const Property& property = rClass.property( j );
+
+        // If the property has the exclude tag, ignore it.
+        if( ( rExcludeTag != Value::nothing ) && property.hasTag( rExcludeTag ) )
+            continue;
+
+        switch( property.type() )
+        {
+            case boolType: plan.push_back( PlanEntry( property, PK_BOOL ) ); break;
+            case intType: plan.push_back( PlanEntry( property, PK_LONG ) ); break;
+            case enumType: plan.push_back( PlanEntry( property, PK_LONG ) ); break;
+            case realType: plan.push_back( PlanEntry( property, PK_DOUBLE ) ); break;
+            case stringType: plan.push_back( PlanEntry( property, PK_STRING ) ); break;
+            case arrayType: plan.push_back( PlanEntry( property, PK_ARRAY ) ); break;
+            case userType:
+            {
+                const Class& propertyClass = 
+                    static_cast<const UserProperty&>( property ).getClass();
+                if( propertyClass.hasTag( "BindingType" ) )
+                {
+                    // Property can be directly serialized to the bitstream.
+                    BindingType bindingType = propertyClass.tag( "BindingType" );
+                    plan.push_back( PlanEntry( property, PK_BINDING, bindingType ) );
+                }
+                else
+                {
+                    // The property is a composed type that is serialized recursively.
+                    plan.push_back( PlanEntry( property, PK_COMPOSED ) );
+                }
+                break;
+            }
+            default: plan.push_back( PlanEntry( property, PK_VALUE ) );
+        }
+    }
+
+    return plan;
+}
+
+void CampBitStream::writeValue( RakNet::BitStream& rBitStream, const PlanEntry& rEntry, 
+    const camp::Value& rValue )
+{
+    // Writes the same data as the camp::Value bitstream operator, without having to look up the
+    // type of the value.
+    switch( rEntry.mKind )
+    {
+        case PK_BOOL:
+            rBitStream.Write<BindingType>( BindingType_bool );
+            rBitStream.Write<bool>( rValue.to<bool>() );
+            break;
+        case PK_LONG:
+            rBitStream.Write<BindingType>( BindingType_long );
+            rBitStream.Write<long>( rValue.to<long>() );
+            break;
+        case PK_DOUBLE:
+            rBitStream.Write<BindingType>( BindingType_double );
+            rBitStream.Write<double>( rValue.to<double>() );
+            break;
+        case PK_STRING:
+            rBitStream.Write<BindingType>( BindingType_String );
+            rBitStream << rValue.to<String>();
+            break;
+        case PK_BINDING:
+            switch( rEntry.mBindingType )
+            {
+                case BindingType_Vector3:
+                    rBitStream.Write<BindingType>( BindingType_Vector3 );
+                    rBitStream << rValue.to<camp::UserObject>().get<Vector3>();
+                    break;
+                case BindingType_Quaternion:
+                    rBitStream.Write<BindingType>( BindingType_Quaternion );
+                    rBitStream << rValue.to<camp::UserObject>().get<Quaternion>();
+                    break;
+                default:
+                    rBitStream << rValue;
+            }
+            break;
+        default:
+            rBitStream << rValue;
+    }
+}
+
+void CampBitStream::writeElement( RakNet::BitStream& rBitStream, const camp::Value& rValue, 
+    const camp::Value& rExcludeTag )
+{
+    camp::UserObject object = rValue.to<camp::UserObject>();
+    if( object.getClass().hasTag( "BindingType" ) )
+    {
+        // Property can be directly serialized to the bitstream.
+        rBitStream << rValue;
+    }
+    else
+    {
+        // The current property is a composed type: serialize it recursively.
+        CampBitStream::serialize( object, rBitStream, rExcludeTag );
+    }
+}
+
+bool CampBitStream::equals( const camp::Value& rValue1, const camp::Value& rValue2 )
+{
+    if( rValue1.type() != camp::userType || rValue2.type() != camp::userType )
+        return rValue1 == rValue2;
+
+    // User objects are compared by value, using their serialized data.
+    RakNet::BitStream bitStream1; bitStream1 << rValue1;
+    RakNet::BitStream bitStream2; bitStream2 << rValue2;
+    return bitStream1.GetNumberOfBitsUsed() == bitStream2.GetNumberOfBitsUsed() && 
+        !memcmp( bitStream1.GetData(), bitStream2.GetData(), bitStream1.GetNumberOfBytesUsed() );
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
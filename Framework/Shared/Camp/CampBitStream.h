@@ -35,199 +35,96 @@ namespace Diversia
 {
 //------------------------------------------------------------------------------
 
+/**
+Serializes the properties of camp user objects to and from RakNet bitstreams.
+
+The reflection work needed to serialize an object of a certain class (iterating over the
+properties, resolving the exclude tag and determining how every property is written) is done once
+per class and exclude tag, the result is cached in a serialization plan that is reused for every
+object of that class.
+
+Objects can be serialized relative to a set of reference property values, for example the property
+values of the template the object was created from. Only the properties that differ from the
+reference values are sent, the other properties are set to the reference values at
+deserialization.
+**/
 class DIVERSIA_SHARED_API CampBitStream
 {
 public:
+    /**
+    Serializes the properties of an object to a bitstream.
+
+    @param  rObject             The object to serialize.
+    @param [in,out] rBitStream  The bitstream to write to.
+    @param  rExcludeTag         Properties with this tag are not serialized.
+    @param  pReference          Reference property values, properties that are equal to their
+                                reference value are not sent. Defaults to 0 to send all
+                                properties.
+    @param  pHidden             Names of properties that are written as unreadable, so that 
+                                their value is not sent while the layout stays the same as the
+                                layout that deserialize expects. Defaults to 0 to hide nothing.
+    **/
     static void serialize( const camp::UserObject& rObject, RakNet::BitStream& rBitStream, 
-        const camp::Value& rExcludeTag = camp::Value::nothing )
-    {
-        using namespace camp;
-
-        // Iterate over the object's properties using its metaclass.
-        const Class& metaclass = rObject.getClass();
-        for( std::size_t i = 0; i < metaclass.propertyCount(); ++i )
-        {
-            const Property& property = metaclass.property( i );
-
-            // If the property has the exclude tag, ignore it.
-            if( ( rExcludeTag != Value::nothing ) && property.hasTag( rExcludeTag ) )
-                continue;
-            
-            // Check if property is readable
-            if( property.readable( rObject ) )
-            {
-                rBitStream.Write1();
-            }
-            else
-            {
-                rBitStream.Write0();
-                continue;
-            }
-
-            if( property.type() == userType )
-            {
-                camp::Value val = property.get( rObject );
-                camp::UserObject object = val.to<UserObject>();
-                if( object.getClass().hasTag( "BindingType" ) )
-                {
-                    // Property can be directly serialized to the bitstream.
-                    rBitStream << val;
-                }
-                else
-                {
-                    // The current property is a composed type: serialize it recursively.
-                    CampBitStream::serialize( object, rBitStream, rExcludeTag );
-                }
-            }
-            else if( property.type() == arrayType )
-            {
-                // The current property is an array.
-                const ArrayProperty& arrayProperty = static_cast<const ArrayProperty&>( property );
-
-                // Send array size.
-                std::size_t count = arrayProperty.size( rObject );
-                rBitStream.Write<std::size_t>( count );
-
-                // Iterate over the array elements.
-                for ( std::size_t j = 0; j < count; ++j )
-                {
-                    camp::Value val = arrayProperty.get( rObject, j );
-                    if ( arrayProperty.elementType() == userType )
-                    {
-                        camp::UserObject object = val.to<UserObject>();
-                        if( object.getClass().hasTag( "BindingType" ) )
-                        {
-                            // Property can be directly serialized to the bitstream.
-                            rBitStream << val;
-                        }
-                        else
-                        {
-                            // The current property is a composed type: serialize it recursively.
-                            CampBitStream::serialize( object, rBitStream, rExcludeTag );
-                        }
-                    }
-                    else
-                    {
-                        // The array elements are simple properties: serialize value to bitstream.
-                        rBitStream << val;
-                    }
-                }
-            }
-            else
-            {
-                // The current property is a simple property: serialize value to bitstream.
-                rBitStream << property.get( rObject );
-            }
-        }
-    }
+        const camp::Value& rExcludeTag = camp::Value::nothing, 
+        const std::map<String, camp::Value>* pReference = 0, 
+        const std::set<String>* pHidden = 0 );
+    /**
+    Deserializes the properties of an object from a bitstream.
+
+    @param  rObject             The object to deserialize into.
+    @param [in,out] rBitStream  The bitstream to read from.
+    @param  rExcludeTag         Properties with this tag are not deserialized, must be the same tag
+                                as the tag that was used to serialize the object.
+    @param  pReference          Reference property values, must be the same values that were used
+                                to serialize the object. Properties that were not sent are set to
+                                their reference value.
+    **/
     static void deserialize( const camp::UserObject& rObject, RakNet::BitStream& rBitStream, 
-        const camp::Value& rExcludeTag = camp::Value::nothing )
+        const camp::Value& rExcludeTag = camp::Value::nothing, 
+        const std::map<String, camp::Value>* pReference = 0 );
+
+private:
+    /**
+    How a property is written to and read from a bitstream.
+    **/
+    enum PlanKind
+    {
+        PK_VALUE,       ///< Self describing camp::Value.
+        PK_BOOL,        ///< Boolean value.
+        PK_LONG,        ///< Integer or enum value.
+        PK_DOUBLE,      ///< Real value.
+        PK_STRING,      ///< String value.
+        PK_BINDING,     ///< User type that can be written directly, see BindingType.
+        PK_COMPOSED,    ///< User type that is serialized recursively.
+        PK_ARRAY        ///< Array property.
+    };
+
+    struct PlanEntry
     {
-        using namespace camp;
-
-        // Iterate over the object's properties using its metaclass.
-        const Class& metaclass = rObject.getClass();
-        for( std::size_t i = 0; i < metaclass.propertyCount(); ++i )
-        {
-            const Property& property = metaclass.property( i );
-
-            // If the property has the exclude tag, ignore it.
-            if( ( rExcludeTag != Value::nothing ) && property.hasTag( rExcludeTag ) )
-                continue;
-
-            // Check if the property was sent (readable at serialization)
-            if( !rBitStream.ReadBit() )
-                continue;
-
-            // Check if the property is readable and writable, can't stop here because the 
-            // bitstream pointer needs to be advanced.
-            bool writable = property.writable( rObject );
-            bool readable = property.readable( rObject );
-
-            if( property.type() == userType )
-            {
-                // TODO: What happens if property is not readable and it's a composed type?
-                if( !readable )
-                {
-                    Value value; rBitStream >> value;
-                    continue;
-                }
-
-                camp::UserObject object = property.get( rObject ).to<UserObject>();
-                if( object.getClass().hasTag( "BindingType" ) )
-                {
-                    // Property can be directly deserialized from the bitstream.
-                    Value value; rBitStream >> value;
-                    if( writable ) property.set( rObject, value );
-                }
-                else
-                {
-                    // The current property is a composed type: deserialize it recursively.
-                    // TODO: What happens if property is not writable?
-                    CampBitStream::deserialize( object, rBitStream, rExcludeTag );
-                }
-            }
-            else if( property.type() == arrayType )
-            {
-                // The current property is an array.
-                const ArrayProperty& arrayProperty = static_cast<const ArrayProperty&>( property );
-
-                // Read array size.
-                std::size_t size; rBitStream.Read( size );
-
-                // Resize array if needed.
-                if( size > arrayProperty.size( rObject ) )
-                {
-                    if ( arrayProperty.dynamic() )
-                        arrayProperty.resize( rObject, size );
-                    else
-                        break;
-                }
-
-                for( std::size_t j = 0; j < size; ++j )
-                {
-                    if ( arrayProperty.elementType() == userType )
-                    {
-                        // TODO: What happens if property is not readable and it's a composed type?
-                        if( !readable )
-                        {
-                            Value value; rBitStream >> value;
-                            continue;
-                        }
-
-                        camp::UserObject object = arrayProperty.get( rObject, j ).to<UserObject>();
-                        if( object.getClass().hasTag( "BindingType" ) )
-                        {
-                            // Property can be directly deserialized from the bitstream.
-                            Value value; rBitStream >> value;
-                            if( writable ) arrayProperty.set( rObject, j, value );
-                        }
-                        else
-                        {
-                            // The array elements are composed objects: deserialize them recursively.
-                            // TODO: What happens if property is not writable?
-                            CampBitStream::deserialize( object, rBitStream, rExcludeTag );
-                        }
-                    }
-                    else
-                    {
-                        // The array elements are simple properties: deserialize value from bitstream.
-                        Value value; rBitStream >> value;
-                        if( writable ) arrayProperty.set( rObject, j, value );
-                    }
-                }
-            }
-            else
-            {
-                // The current property is a simple property: deserialize value from bitstream.
-                Value value; rBitStream >> value;
-                if( writable ) property.set( rObject, value );
-            }
-        }
-    }
+        PlanEntry( const camp::Property& rProperty, PlanKind kind, 
+            BindingType bindingType = BindingType_unknown ): mProperty( &rProperty ), mKind( kind ),
+            mBindingType( bindingType ) {}
+
+        const camp::Property*   mProperty;
+        PlanKind                mKind;
+        BindingType             mBindingType;
+    };
+
+    typedef std::vector<PlanEntry> Plan;
+    typedef std::map<std::pair<const camp::Class*, camp::Value>, Plan> Plans;
+
+    static const Plan& getPlan( const camp::Class& rClass, const camp::Value& rExcludeTag );
+    static void writeValue( RakNet::BitStream& rBitStream, const PlanEntry& rEntry, 
+        const camp::Value& rValue );
+    static void writeElement( RakNet::BitStream& rBitStream, const camp::Value& rValue, 
+        const camp::Value& rExcludeTag );
+    static bool equals( const camp::Value& rValue1, const camp::Value& rValue2 );
+
+    static Plans msPlans;
+
 };
 
 //------------------------------------------------------------------------------
 } // Namespace Diversia
 
-#endif // DIVERSIA_SHARED_CAMPBITSTREAM_H
\ No newline at end of file
+#endif // DIVERSIA_SHARED_CAMPBITSTREAM_H
@@ -0,0 +1,152 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Shared/Platform/StableHeaders.h"
+
+#include "Shared/Camp/PropertyIdTable.h"
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+const PropertyId PropertyIdTable::cMaxId = 0x1FFFFF;
+PropertyIdTable::Tables PropertyIdTable::msTables = PropertyIdTable::Tables();
+PropertyIdTable::Tables PropertyIdTable::msFunctionTables = PropertyIdTable::Tables();
+
+PropertyIdTable::PropertyIdTable( const camp::Class& rClass, bool functions )
+{
+    std::size_t count = functions ? rClass.functionCount() : rClass.propertyCount();
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        const String& name = functions ? rClass.function( i ).name() : rClass.property( i ).name();
+        PropertyId id = PropertyIdTable::hash( name );
+
+        // Colliding names are sent by name, the identifier cannot be resolved to one of them.
+        Names::iterator j = mNames.find( id );
+        if( j != mNames.end() || mAmbiguous.count( id ) )
+        {
+            SLOGW << ( functions ? "Function " : "Property " ) << name << " of class " << 
+                rClass.name() << " has the same identifier as " << 
+                ( j != mNames.end() ? j->second : "another one" ) << 
+                ", they are sent by name.";
+
+            if( j != mNames.end() )
+            {
+                mIds.erase( j->second );
+                mNames.erase( j );
+            }
+            mAmbiguous.insert( id );
+            continue;
+        }
+
+        mIds.insert( std::make_pair( name, id ) );
+        mNames.insert( std::make_pair( id, name ) );
+    }
+}
+
+const PropertyIdTable& PropertyIdTable::get( const camp::Class& rClass )
+{
+    Tables::iterator i = msTables.find( &rClass );
+    if( i != msTables.end() ) return *i->second;
+
+    PropertyIdTable* table = new PropertyIdTable( rClass, false );
+    msTables.insert( std::make_pair( &rClass, table ) );
+    return *table;
+}
+
+const PropertyIdTable& PropertyIdTable::getFunctions( const camp::Class& rClass )
+{
+    Tables::iterator i = msFunctionTables.find( &rClass );
+    if( i != msFunctionTables.end() ) return *i->second;
+
+    PropertyIdTable* table = new PropertyIdTable( rClass, true );
+    msFunctionTables.insert( std::make_pair( &rClass, table ) );
+    return *table;
+}
+
+void PropertyIdTable::checkClasses()
+{
+    for( std::size_t i = 0; i < camp::classCount(); ++i )
+    {
+        const camp::Class& metaclass = camp::classByIndex( i );
+        PropertyIdTable::get( metaclass );
+        PropertyIdTable::getFunctions( metaclass );
+    }
+}
+
+PropertyId PropertyIdTable::getId( const String& rName ) const
+{
+    Ids::const_iterator i = mIds.find( rName );
+    if( i != mIds.end() ) return i->second;
+    return 0;
+}
+
+const String* PropertyIdTable::getName( PropertyId id ) const
+{
+    Names::const_iterator i = mNames.find( id );
+    if( i != mNames.end() ) return &i->second;
+    return 0;
+}
+
+void PropertyIdTable::writeName( RakNet::BitStream& rBitStream, const String& rName, 
+    bool useId /*= true*/ ) const
+{
+    PropertyId id = useId ? PropertyIdTable::getId( rName ) : 0;
+    RakNet::writeVarUInt( rBitStream, id );
+    if( !id ) rBitStream << rName;
+}
+
+bool PropertyIdTable::readName( RakNet::BitStream& rBitStream, String& rName, 
+    bool* pIdentifier /*= 0*/ ) const
+{
+    PropertyId id = (PropertyId)RakNet::readVarUInt( rBitStream );
+    if( pIdentifier ) *pIdentifier = id != 0;
+    if( !id )
+    {
+        rBitStream >> rName;
+        return true;
+    }
+
+    const String* name = PropertyIdTable::getName( id );
+    if( !name ) return false;
+    rName = *name;
+    return true;
+}
+
+PropertyId PropertyIdTable::hash( const String& rName )
+{
+    // FNV-1a, folded to the identifier range.
+    unsigned int hash = 2166136261u;
+    for( String::const_iterator i = rName.begin(); i != rName.end(); ++i )
+    {
+        hash ^= (unsigned char)*i;
+        hash *= 16777619u;
+    }
+    hash = ( hash >> 21 ^ hash ) & cMaxId;
+
+    return hash ? (PropertyId)hash : 1;
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
@@ -0,0 +1,134 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SHARED_PROPERTYIDTABLE_H
+#define DIVERSIA_SHARED_PROPERTYIDTABLE_H
+
+#include "Shared/Platform/Prerequisites.h"
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+typedef unsigned int PropertyId;
+
+/**
+Table of compact numeric property identifiers for a camp metaclass. The identifiers are hashed
+from the property names so that the client and server agree on them without any negotiation, even
+when the client and server classes do not declare the exact same set of properties. Functions get
+identifiers the same way in a separate table, see getFunctions().
+
+Identifier 0 is never used, it is reserved to indicate that a property is sent by name, which is 
+used for nested queries. Properties of the same class with names that hash to the same identifier
+have no identifier and are always sent by name, an identifier that is received for them is 
+ambiguous and is treated as unknown. Use checkClasses() at startup to report these collisions.
+
+The identifiers are 21 bits wide, so that a property that only exists on the sending side is 
+unlikely to be taken for another property of the receiving side. Receivers should still check the
+type of the received value, see PropertyTransaction.
+**/
+class DIVERSIA_SHARED_API PropertyIdTable
+{
+public:
+    /**
+    Gets the property identifier table for a metaclass, the table is created on first use.
+
+    @param  rClass  The metaclass.
+    **/
+    static const PropertyIdTable& get( const camp::Class& rClass );
+    /**
+    Gets the function identifier table for a metaclass, the table is created on first use.
+
+    @param  rClass  The metaclass.
+    **/
+    static const PropertyIdTable& getFunctions( const camp::Class& rClass );
+    /**
+    Creates the property and function identifier tables of every registered metaclass and logs the 
+    properties and functions that have to be sent by name because their identifiers collide.
+    **/
+    static void checkClasses();
+    /**
+    Gets the identifier of a property.
+
+    @param  rName   The name of the property.
+
+    @return The identifier of the property, 0 if the property has no identifier or its identifier
+            collides with another property.
+    **/
+    PropertyId getId( const String& rName ) const;
+    /**
+    Gets the name of a property by its identifier.
+
+    @param  id  The identifier of the property.
+
+    @return The name of the property, 0 if the identifier is not known in this class or is 
+            ambiguous.
+    **/
+    const String* getName( PropertyId id ) const;
+    /**
+    Writes a property name to a bitstream, as an identifier if the property has one.
+
+    @param [in,out] rBitStream  The bitstream to write to.
+    @param  rName               The name of the property.
+    @param  useId               False to always write the name.
+    **/
+    void writeName( RakNet::BitStream& rBitStream, const String& rName, bool useId = true ) const;
+    /**
+    Reads a property name written with writeName from a bitstream.
+
+    @param [in,out] rBitStream  The bitstream to read from.
+    @param [out] rName          The name of the property.
+    @param [out] pIdentifier    If not 0, set to true if the property was sent with an identifier.
+
+    @return False if the property was sent with an identifier that is unknown in this class.
+    **/
+    bool readName( RakNet::BitStream& rBitStream, String& rName, bool* pIdentifier = 0 ) const;
+
+    /**
+    Hashes a property name to an identifier in the range [1, cMaxId].
+    **/
+    static PropertyId hash( const String& rName );
+
+    static const PropertyId cMaxId;
+
+private:
+    PropertyIdTable( const camp::Class& rClass, bool functions );
+
+    typedef std::map<String, PropertyId> Ids;
+    typedef std::map<PropertyId, String> Names;
+    typedef std::map<const camp::Class*, PropertyIdTable*> Tables;
+
+    Ids             mIds;
+    Names           mNames;
+    std::set<PropertyId> mAmbiguous;
+
+    static Tables   msTables;
+    static Tables   msFunctionTables;
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
+
+#endif // DIVERSIA_SHARED_PROPERTYIDTABLE_H
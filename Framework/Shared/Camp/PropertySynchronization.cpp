@@ -29,10 +29,15 @@ THE SOFTWARE.
 #include "Shared/Camp/PropertySynchronization.h"
 #include "Shared/Camp/CampStringInterpreter.h"
 #include "Shared/Camp/CampBitStream.h"
+#include "Shared/Camp/PropertyIdTable.h"
 #include "Shared/Communication/BitStream.h"
+#include "Shared/Communication/TrafficStatistics.h"
+#include "Object/ReplicationChannels.h"
+#include "Object/DirtyReplicas.h"
 #include "Util/Signal/UserObjectChange.h"
 
 #include <RakNet/GetTime.h>
+#include <boost/cstdint.hpp>
 
 namespace Diversia
 {
@@ -40,17 +45,24 @@ namespace Diversia
 
 const unsigned int PropertySynchronization::cBitStreamPropertySlot = 7;
 const unsigned int PropertySynchronization::cBitStreamFunctionSlot = 6;
+std::map<String, AudienceSlot> PropertySynchronization::msAudiences = 
+    std::map<String, AudienceSlot>();
+boost::uint64_t PropertySynchronization::msDeserializedPropertyCount = 0;
 
 PropertySynchronization::PropertySynchronization( Mode mode, 
     RakNet::Time nextSerializeDelay /*= 0*/ ):
+    mReplica( 0 ),
     mMode( mode ),
     mNextPropertySerialization( MAXUINT ),
     mNextPropertySerializationDelay( nextSerializeDelay ),
     mNextFunctionSerialization( MAXUINT ),
     mNextFunctionSerializationDelay( nextSerializeDelay ),
+    mSerializedTime( 0 ),
+    mSerializedFiltered( false ),
     mQueue( false ),
     mQueueConstruction( false ),
-    mQueueConstructionProcess( false )
+    mQueueConstructionProcess( false ),
+    mQueuedConstructionHasReference( false )
 {
 
 }
@@ -59,6 +71,7 @@ PropertySynchronization::~PropertySynchronization()
 {
     mPropertyChangedConnection.disconnect();
     mValueInsertedConnection.disconnect();
+    if( mReplica ) DirtyReplicas::unmark( *mReplica );
 }
 
 void PropertySynchronization::set( const String& rQuery, const camp::Value& rValue )
@@ -110,26 +123,26 @@ camp::Value PropertySynchronization::get( const String& rQuery )
 void PropertySynchronization::call( const String& rQuery, 
     const camp::Args& rArgs /*= camp::Args()*/ )
 {
-    // Copy over function arguments.
-    camp::Args args;
-    for( std::size_t i = 0; i < rArgs.count(); ++i )
-    {
-        // Copy the value for user types.
-        camp::Value value;
-        if( rArgs[i].type() == camp::userType )
-            value = rArgs[i].to<camp::UserObject>().copy();
-        else
-            value = rArgs[i];
-
-        args += value;
-    }
-
     // TODO: Check permission
 
     // Queue function call if queuing is on.
     if( mQueue && !mQueueIgnore.count( rQuery ) )
     {
-        mOutputQueueFunctionCalls.insert( std::make_pair( rQuery, args ) );
+        // Copy over function arguments.
+        camp::Args args;
+        for( std::size_t i = 0; i < rArgs.count(); ++i )
+        {
+            // Copy the value for user types.
+            camp::Value value;
+            if( rArgs[i].type() == camp::userType )
+                value = rArgs[i].to<camp::UserObject>().copy();
+            else
+                value = rArgs[i];
+
+            args += value;
+        }
+
+        mOutputQueueFunctionCalls.push_back( std::make_pair( rQuery, args ) );
     }
     else
     {
@@ -137,18 +150,30 @@ void PropertySynchronization::call( const String& rQuery,
         // TODO: Support nested calls.
         const camp::Function& func = mUserObject.getClass().function( rQuery );
         if( !func.hasTag( "NoCall" ) )
-            mUserObject.call( rQuery, args );
+            mUserObject.call( rQuery, rArgs );
 
-        mOutputFunctionCalls.insert( std::make_pair( rQuery, args ) );
+        // The arguments are encoded right away so they don't have to be copied.
+        PropertySynchronization::addFunctionCall( rQuery, rArgs );
 
         // Serialize changes
         if( mNextFunctionSerialization == MAXUINT )
         {
             mNextFunctionSerialization = RakNet::GetTime() + mNextFunctionSerializationDelay;
         }
+        PropertySynchronization::markDirty();
     }
 }
 
+void PropertySynchronization::setPropertyMaxRate( const String& rQuery, Real rate )
+{
+    mPropertySendIntervals[rQuery] = rate > 0 ? (RakNet::Time)( 1000.0 / rate ) : 0;
+}
+
+void PropertySynchronization::resetPropertyMaxRate( const String& rQuery )
+{
+    mPropertySendIntervals.erase( rQuery );
+}
+
 void PropertySynchronization::queue( 
     const std::set<String>& rIgnoredProperties /*= std::set<String>()*/ )
 {
@@ -257,8 +282,13 @@ void PropertySynchronization::processQueuedConstruction()
 
         mQueueConstruction = false;
         if( mQueuedConstruction.GetNumberOfBytesUsed() )
-            CampBitStream::deserialize( mUserObject, mQueuedConstruction, "NoBitStream" );
+        {
+            CampBitStream::deserialize( mUserObject, mQueuedConstruction, "NoBitStream", 
+                mQueuedConstructionHasReference ? &mQueuedConstructionReference : 0 );
+        }
         mQueuedConstruction.Reset();
+        mQueuedConstructionHasReference = false;
+        mQueuedConstructionReference.clear();
 
         PropertySynchronization::blockChangeConnections( false );
     }
@@ -321,6 +351,7 @@ void PropertySynchronization::loadStoredState() const
 void PropertySynchronization::storeUserObject()
 {
     mUserObject = camp::UserObject( this );
+    mReplica = dynamic_cast<RakNet::Replica3*>( this );
 
     mPropertyChangedConnection = UserObjectChange::connectChange( mUserObject, sigc::mem_fun( this, 
         &PropertySynchronization::propertyChanged ) );
@@ -331,55 +362,331 @@ void PropertySynchronization::storeUserObject()
 void PropertySynchronization::doSerializeConstruction( RakNet::BitStream* pConstructionBitstream, 
     RakNet::Connection_RM3* pDestinationConnection )
 {
-    CampBitStream::serialize( mUserObject, *pConstructionBitstream, "NoBitStream" );
+    // Serialize the reference replica, if any.
+    const PropertyValueMap* reference = 0;
+    RakNet::Replica3* referenceReplica = getConstructionReference( pDestinationConnection, 
+        reference );
+    if( referenceReplica && reference )
+    {
+        pConstructionBitstream->Write1();
+        pConstructionBitstream->Write( referenceReplica->GetNetworkID() );
+    }
+    else
+    {
+        pConstructionBitstream->Write0();
+        reference = 0;
+    }
+
+    // Properties the destination may not see are hidden instead of excluded, the layout of the 
+    // construction is the same for all connections.
+    std::set<String> hidden;
+    if( mMode == SERVER )
+    {
+        const camp::Class& metaclass = mUserObject.getClass();
+        for( std::size_t i = 0; i < metaclass.propertyCount(); ++i )
+        {
+            const String& name = metaclass.property( i ).name();
+            if( PropertySynchronization::isPropertyFiltered( name ) && 
+                !PropertySynchronization::isPropertyVisible( name, 
+                pDestinationConnection->GetRakNetGUID() ) )
+                hidden.insert( name );
+        }
+    }
+
+    CampBitStream::serialize( mUserObject, *pConstructionBitstream, "NoBitStream", reference, 
+        hidden.empty() ? 0 : &hidden );
 }
 
-void PropertySynchronization::doDeserializeConstruction( RakNet::BitStream* pConstructionBitstream, 
+bool PropertySynchronization::doDeserializeConstruction( RakNet::BitStream* pConstructionBitstream, 
     RakNet::Connection_RM3* pSourceConnection )
 {
+    // Deserialize the reference replica, if any.
+    const PropertyValueMap* reference = 0;
+    if( pConstructionBitstream->ReadBit() )
+    {
+        RakNet::NetworkID networkID; pConstructionBitstream->Read( networkID );
+        reference = getConstructionReferenceProperties( networkID );
+        if( !reference )
+        {
+            // Properties equal to the reference are not in the stream, they cannot be restored.
+            SLOGE << "Reference replica " << networkID << " for construction of " << 
+                mUserObject.getClass().name() << " is not known, rejecting construction.";
+            return false;
+        }
+    }
+
     PropertySynchronization::blockChangeConnections( true );
 
     if( mQueueConstruction )
     {
         RakNet::BitSize_t offset = pConstructionBitstream->GetReadOffset();
         mQueuedConstruction.Write( pConstructionBitstream );
+        mQueuedConstructionHasReference = reference != 0;
+        if( reference ) mQueuedConstructionReference = *reference;
 
         if( mQueueConstructionProcess )
         {
             pConstructionBitstream->SetReadOffset( offset );
-            CampBitStream::deserialize( mUserObject, *pConstructionBitstream, "NoBitStream" );
+            CampBitStream::deserialize( mUserObject, *pConstructionBitstream, "NoBitStream", 
+                reference );
         }
     }
     else
-        CampBitStream::deserialize( mUserObject, *pConstructionBitstream, "NoBitStream" );
+        CampBitStream::deserialize( mUserObject, *pConstructionBitstream, "NoBitStream", 
+            reference );
 
     PropertySynchronization::blockChangeConnections( false );
+
+    return true;
+}
+
+bool PropertySynchronization::isSerializationPending() const
+{
+    RakNet::Time now = RakNet::GetTime();
+    return now >= mNextPropertySerialization || now >= mNextFunctionSerialization;
+}
+
+RakNet::RM3QuerySerializationResult PropertySynchronization::doQuerySerialization( 
+    RakNet::Connection_RM3* pDestinationConnection ) const
+{
+    // Skip building the payload of replicas that have nothing to send.
+    if( PropertySynchronization::isSerializationPending() ) 
+        return RakNet::RM3QSR_CALL_SERIALIZE;
+
+    // Changes that were taken in this serialize tick still have to be written to connections
+    // that did not get them yet.
+    if( ( !mSerializedTransaction.isEmpty() || !mSerializedFunctionCalls.empty() ) && 
+        !mSerializedConnections.count( pDestinationConnection->GetRakNetGUID() ) )
+        return RakNet::RM3QSR_CALL_SERIALIZE;
+
+    PropertySynchronization::markDirtyIfPending();
+    return RakNet::RM3QSR_DO_NOT_CALL_SERIALIZE;
 }
 
 RakNet::RM3SerializationResult PropertySynchronization::doSerialize( 
     RakNet::SerializeParameters* pSerializeParameters )
 {
+    RakNet::RakNetGUID connection = pSerializeParameters->destinationConnection->GetRakNetGUID();
+    const camp::Class& metaclass = mUserObject.getClass();
+    const String& className = metaclass.name();
+
+    // Properties and function calls share a reliable ordered channel so calls keep their order
+    // relative to property changes.
+    ReplicationChannels::setStateChannel( pSerializeParameters, cBitStreamPropertySlot, className );
+    ReplicationChannels::setStateChannel( pSerializeParameters, cBitStreamFunctionSlot, className );
+
+    // Serialize is called for every connection in a serialize tick, pending changes are only 
+    // taken once per tick.
+    if( pSerializeParameters->curTime != mSerializedTime || 
+        mSerializedConnections.count( connection ) )
+    {
+        PropertySynchronization::takeSerialization();
+        mSerializedTime = pSerializeParameters->curTime;
+    }
+    mSerializedConnections.insert( connection );
+
     bool serialize = false;
+    bool record = TrafficStatistics::getSettings().mEnabled;
+    std::map<String, RakNet::BitSize_t> sizes;
 
-    if( RakNet::GetTime() >= mNextPropertySerialization )
+    if( !mSerializedTransaction.isEmpty() )
     {
-        pSerializeParameters->outputBitstream[cBitStreamPropertySlot] << mOutputPropertyTransaction;
-        mOutputPropertyTransaction.reset();
-        mNextPropertySerialization = MAXUINT;
-        serialize = true;
+        RakNet::BitStream& bitStream = 
+            pSerializeParameters->outputBitstream[cBitStreamPropertySlot];
+
+        if( mSerializedFiltered )
+        {
+            // Only write the properties that this connection may receive.
+            PropertyTransaction transaction;
+            for( ValueMap::iterator i = mSerializedTransaction.getChangedProperties().begin(); 
+                i != mSerializedTransaction.getChangedProperties().end(); ++i )
+            {
+                if( PropertySynchronization::isPropertyVisible( i->first, connection ) )
+                    transaction.addChangedProperty( i->first, i->second );
+            }
+            for( ValueMultimap::iterator i = 
+                mSerializedTransaction.getInsertedProperties().begin(); 
+                i != mSerializedTransaction.getInsertedProperties().end(); ++i )
+            {
+                if( PropertySynchronization::isPropertyVisible( i->first, connection ) )
+                    transaction.addInsertedProperty( i->first, i->second );
+            }
+            for( ValueSet::iterator i = mSerializedTransaction.getRemovedProperties().begin(); 
+                i != mSerializedTransaction.getRemovedProperties().end(); ++i )
+            {
+                String name = i->to<String>();
+                if( PropertySynchronization::isPropertyVisible( name, connection ) )
+                    transaction.addRemovedProperty( name );
+            }
+
+            if( !transaction.isEmpty() )
+            {
+                transaction.serialize( bitStream, metaclass, record ? &sizes : 0 );
+                serialize = true;
+            }
+        }
+        else
+        {
+            mSerializedTransaction.serialize( bitStream, metaclass, record ? &sizes : 0 );
+            serialize = true;
+        }
     }
-    if( RakNet::GetTime() >= mNextFunctionSerialization )
+    if( !mSerializedFunctionCalls.empty() )
     {
-        pSerializeParameters->outputBitstream[cBitStreamFunctionSlot] << mOutputFunctionCalls;
-        mOutputFunctionCalls.clear();
-        mNextFunctionSerialization = MAXUINT;
+        // Send all calls since the last serialize tick as one batch. Each call is prefixed with
+        // its size so calls that cannot be decoded on the other side can be skipped.
+        RakNet::BitStream& bitStream = 
+            pSerializeParameters->outputBitstream[cBitStreamFunctionSlot];
+        RakNet::writeVarUInt( bitStream, (unsigned int)mSerializedFunctionCalls.size() );
+        for( EncodedFunctionCalls::iterator i = mSerializedFunctionCalls.begin(); 
+            i != mSerializedFunctionCalls.end(); ++i )
+        {
+            RakNet::writeVarUInt( bitStream, (unsigned int)i->mBits );
+            bitStream.WriteBits( &i->mData[0], i->mBits, false );
+            if( record ) sizes[i->mName] += i->mBits;
+        }
         serialize = true;
     } 
 
-    if( serialize )
-        return RakNet::RM3SR_SERIALIZED_ALWAYS_IDENTICALLY;	///< RakNet doesn't have to check changes.
-    else
+    if( serialize && record )
+    {
+        RakNet::BitSize_t bits = 
+            pSerializeParameters->outputBitstream[cBitStreamPropertySlot].GetNumberOfBitsUsed() + 
+            pSerializeParameters->outputBitstream[cBitStreamFunctionSlot].GetNumberOfBitsUsed();
+        sizes[""] = bits;
+
+        // Filtered serializations differ per connection, other serializations are sent to 
+        // every connection the replica is constructed on.
+        RakNet::Replica3* replica = dynamic_cast<RakNet::Replica3*>( this );
+        for( std::map<String, RakNet::BitSize_t>::iterator i = sizes.begin(); i != sizes.end(); 
+            ++i )
+        {
+            if( mSerializedFiltered || !replica )
+            {
+                TrafficStatistics::record( connection, getReplicaType(), className, i->first, 
+                    i->second );
+            }
+            else
+            {
+                TrafficStatistics::record( *replica, getReplicaType(), className, i->first, 
+                    i->second );
+            }
+        }
+    }
+
+    if( !serialize )
         return RakNet::RM3SR_DO_NOT_SERIALIZE;
+    else if( mSerializedFiltered )
+        return RakNet::RM3SR_SERIALIZED_ALWAYS;
+    else
+        return RakNet::RM3SR_SERIALIZED_ALWAYS_IDENTICALLY;	///< RakNet doesn't have to check changes.
+}
+
+void PropertySynchronization::markDirty() const
+{
+    if( mReplica ) DirtyReplicas::mark( *mReplica );
+}
+
+void PropertySynchronization::markDirtyIfPending() const
+{
+    // Changes that are delayed or rate limited stay dirty until they are due.
+    if( mNextPropertySerialization != MAXUINT || mNextFunctionSerialization != MAXUINT )
+        PropertySynchronization::markDirty();
+}
+
+void PropertySynchronization::takeSerialization()
+{
+    RakNet::Time now = RakNet::GetTime();
+
+    mSerializedTransaction.reset();
+    mSerializedFunctionCalls.clear();
+    mSerializedFiltered = false;
+    mSerializedConnections.clear();
+
+    if( now >= mNextPropertySerialization )
+    {
+        // Release held properties that may be sent again.
+        mNextPropertySerialization = MAXUINT;
+        for( ValueMap::iterator i = mHeldProperties.begin(); i != mHeldProperties.end(); )
+        {
+            RakNet::Time& next = mNextPropertySend[i->first];
+            if( now >= next )
+            {
+                mOutputPropertyTransaction.addChangedProperty( i->first, i->second );
+                next = now + PropertySynchronization::getPropertySendInterval( i->first );
+                mHeldProperties.erase( i++ );
+            }
+            else
+            {
+                mNextPropertySerialization = std::min( mNextPropertySerialization, next );
+                ++i;
+            }
+        }
+
+        std::swap( mSerializedTransaction, mOutputPropertyTransaction );
+    }
+    if( now >= mNextFunctionSerialization )
+    {
+        mSerializedFunctionCalls.swap( mOutputFunctionCalls );
+        mNextFunctionSerialization = MAXUINT;
+    }
+    PropertySynchronization::markDirtyIfPending();
+
+    // Only the server filters properties, clients send all their changes to the server.
+    if( mMode != SERVER ) return;
+    for( ValueMap::iterator i = mSerializedTransaction.getChangedProperties().begin(); 
+        i != mSerializedTransaction.getChangedProperties().end() && !mSerializedFiltered; ++i )
+    {
+        mSerializedFiltered = PropertySynchronization::isPropertyFiltered( i->first );
+    }
+    for( ValueMultimap::iterator i = mSerializedTransaction.getInsertedProperties().begin(); 
+        i != mSerializedTransaction.getInsertedProperties().end() && !mSerializedFiltered; ++i )
+    {
+        mSerializedFiltered = PropertySynchronization::isPropertyFiltered( i->first );
+    }
+    for( ValueSet::iterator i = mSerializedTransaction.getRemovedProperties().begin(); 
+        i != mSerializedTransaction.getRemovedProperties().end() && !mSerializedFiltered; ++i )
+    {
+        mSerializedFiltered = PropertySynchronization::isPropertyFiltered( i->to<String>() );
+    }
+}
+
+bool PropertySynchronization::isPropertyFiltered( const String& rName ) const
+{
+    const camp::Class& metaclass = mUserObject.getClass();
+    if( !metaclass.hasProperty( rName ) ) return false;
+
+    const camp::Property& prop = metaclass.property( rName );
+    return prop.hasTag( "ServerOnly" ) || prop.hasTag( "OwnerOnly" ) || prop.hasTag( "Audience" );
+}
+
+bool PropertySynchronization::isPropertyVisible( const String& rName, 
+    RakNet::RakNetGUID connection )
+{
+    const camp::Class& metaclass = mUserObject.getClass();
+    if( !metaclass.hasProperty( rName ) ) return true;
+
+    const camp::Property& prop = metaclass.property( rName );
+    if( prop.hasTag( "ServerOnly" ) ) return false;
+    if( prop.hasTag( "OwnerOnly" ) && connection != getPropertyOwner() ) return false;
+    if( prop.hasTag( "Audience" ) )
+    {
+        std::map<String, AudienceSlot>::iterator i = msAudiences.find( 
+            prop.tag( "Audience" ).to<String>() );
+        if( i == msAudiences.end() || !i->second( mUserObject, connection ) ) return false;
+    }
+
+    return true;
+}
+
+void PropertySynchronization::registerAudience( const String& rName, const AudienceSlot& rSlot )
+{
+    msAudiences[rName] = rSlot;
+}
+
+void PropertySynchronization::unregisterAudience( const String& rName )
+{
+    msAudiences.erase( rName );
 }
 
 void PropertySynchronization::doDeserialize( 
@@ -390,8 +697,13 @@ void PropertySynchronization::doDeserialize(
     // Properties
     if( pDeserializeParameters->bitstreamWrittenTo[cBitStreamPropertySlot] )
     {
-        pDeserializeParameters->serializationBitstream[cBitStreamPropertySlot] >> 
-            mInputPropertyTransaction;
+        mInputPropertyTransaction.deserialize( 
+            pDeserializeParameters->serializationBitstream[cBitStreamPropertySlot], 
+            mUserObject.getClass() );
+        msDeserializedPropertyCount += 
+            mInputPropertyTransaction.getChangedProperties().size() + 
+            mInputPropertyTransaction.getInsertedProperties().size() + 
+            mInputPropertyTransaction.getRemovedProperties().size();
 
         // TODO: Remove properties.
         // Insert properties
@@ -458,8 +770,55 @@ void PropertySynchronization::doDeserialize(
     // Function calls
     if( pDeserializeParameters->bitstreamWrittenTo[cBitStreamFunctionSlot] )
     {
-        pDeserializeParameters->serializationBitstream[cBitStreamFunctionSlot] >> 
-            mInputFunctionCalls;
+        RakNet::BitStream& bitStream = 
+            pDeserializeParameters->serializationBitstream[cBitStreamFunctionSlot];
+        const camp::Class& metaclass = mUserObject.getClass();
+        const PropertyIdTable& table = PropertyIdTable::getFunctions( metaclass );
+
+        unsigned int count = RakNet::readVarUInt( bitStream );
+        for( unsigned int i = 0; i < count; ++i )
+        {
+            RakNet::BitSize_t bits = RakNet::readVarUInt( bitStream );
+            RakNet::BitSize_t end = bitStream.GetReadOffset() + bits;
+
+            String name;
+            if( table.readName( bitStream, name ) && metaclass.hasFunction( name ) )
+            {
+                try
+                {
+                    const camp::Function& func = metaclass.function( name );
+                    camp::Args args;
+                    bool valid = true;
+                    for( std::size_t j = 0; j < func.argCount() && valid; ++j )
+                    {
+                        camp::Value value;
+                        valid = PropertySynchronization::readArgument( bitStream, 
+                            func.argType( j ), value );
+                        args += value;
+                    }
+
+                    if( valid )
+                        mInputFunctionCalls.push_back( std::make_pair( name, args ) );
+                    else
+                    {
+                        SLOGE << "Skipping remote call to function " << name << " in class " << 
+                            metaclass.name() << ", the argument types do not match";
+                    }
+                }
+                catch( camp::Error e )
+                {
+                    SLOGD << "Error decoding remote function call " << name << ": " << e.what();
+                }
+            }
+            else
+            {
+                SLOGD << "Skipping remote call to a function that is unknown in class " << 
+                    metaclass.name();
+            }
+
+            bitStream.SetReadOffset( end );
+        }
+        msDeserializedPropertyCount += mInputFunctionCalls.size();
 
         for( FunctionCalls::iterator i = mInputFunctionCalls.begin(); 
             i != mInputFunctionCalls.end(); ++i )
@@ -469,7 +828,7 @@ void PropertySynchronization::doDeserialize(
                 // Queue property change if queuing is on.
                 if( mQueue && !mQueueIgnore.count( i->first ) )
                 {
-                    mInputQueueFunctionCalls.insert( std::make_pair( i->first, i->second ) );
+                    mInputQueueFunctionCalls.push_back( std::make_pair( i->first, i->second ) );
                 }
                 else 
                 {
@@ -494,6 +853,102 @@ void PropertySynchronization::doDeserialize(
     }
 }
 
+void PropertySynchronization::addFunctionCall( const String& rQuery, const camp::Args& rArgs )
+{
+    const camp::Class& metaclass = mUserObject.getClass();
+    const camp::Function& func = metaclass.function( rQuery );
+
+    if( rArgs.count() != func.argCount() )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, "Wrong number of arguments for function " + 
+            rQuery + ".", "PropertySynchronization::addFunctionCall" );
+    }
+
+    // Encode the function identifier and arguments.
+    RakNet::BitStream bitStream;
+    PropertyIdTable::getFunctions( metaclass ).writeName( bitStream, rQuery );
+    for( std::size_t i = 0; i < rArgs.count(); ++i )
+        PropertySynchronization::writeArgument( bitStream, func.argType( i ), rArgs[i] );
+
+    EncodedFunctionCall call;
+    call.mName = rQuery;
+    call.mBits = bitStream.GetNumberOfBitsUsed();
+    call.mData.assign( bitStream.GetData(), bitStream.GetData() + 
+        bitStream.GetNumberOfBytesUsed() );
+
+    // Replace pending calls in the same coalesce group.
+    if( func.hasTag( "Coalesce" ) )
+    {
+        const camp::Value& group = func.tag( "Coalesce" );
+        call.mCoalesceGroup = group.type() == camp::stringType ? group.to<String>() : rQuery;
+
+        for( EncodedFunctionCalls::iterator i = mOutputFunctionCalls.begin(); 
+            i != mOutputFunctionCalls.end(); )
+        {
+            if( i->mCoalesceGroup == call.mCoalesceGroup )
+                i = mOutputFunctionCalls.erase( i );
+            else
+                ++i;
+        }
+    }
+
+    mOutputFunctionCalls.push_back( call );
+}
+
+void PropertySynchronization::writeArgument( RakNet::BitStream& rBitStream, camp::Type type, 
+    const camp::Value& rValue )
+{
+    // Arguments are packed by the argument type of the function, the type is written in front 
+    // so that a receiver with a different signature does not decode garbage.
+    unsigned char tag = (unsigned char)type;
+    rBitStream.WriteBits( &tag, 3 );
+
+    switch( type )
+    {
+        case camp::boolType: rBitStream.Write( rValue.to<bool>() ); break;
+        case camp::intType: 
+        case camp::enumType: 
+            rBitStream.WriteCompressed( (boost::int64_t)rValue.to<long>() ); break;
+        case camp::realType: rBitStream.Write( rValue.to<double>() ); break;
+        case camp::stringType: rBitStream << rValue.to<String>(); break;
+        default: rBitStream << rValue; break;
+    }
+}
+
+bool PropertySynchronization::readArgument( RakNet::BitStream& rBitStream, camp::Type type, 
+    camp::Value& rValue )
+{
+    unsigned char tag = 0; 
+    if( !rBitStream.ReadBits( &tag, 3 ) || tag != (unsigned char)type ) return false;
+
+    switch( type )
+    {
+        case camp::boolType: { bool value = false; rBitStream.Read( value ); rValue = value; 
+            break; }
+        case camp::intType: 
+        case camp::enumType: { boost::int64_t value = 0; rBitStream.ReadCompressed( value ); 
+            rValue = (long)value; break; }
+        case camp::realType: { double value = 0; rBitStream.Read( value ); rValue = value; 
+            break; }
+        case camp::stringType: { String value; rBitStream >> value; rValue = value; break; }
+        default: rBitStream >> rValue; break;
+    }
+
+    return true;
+}
+
+RakNet::Time PropertySynchronization::getPropertySendInterval( const String& rQuery ) const
+{
+    std::map<String, RakNet::Time>::const_iterator i = mPropertySendIntervals.find( rQuery );
+    if( i != mPropertySendIntervals.end() ) return i->second;
+
+    const camp::Property& prop = mUserObject.getClass().property( rQuery );
+    if( !prop.hasTag( "MaxRate" ) ) return 0;
+
+    Real rate = prop.tag( "MaxRate" ).to<Real>();
+    return rate > 0 ? (RakNet::Time)( 1000.0 / rate ) : 0;
+}
+
 void PropertySynchronization::blockChangeConnections( bool block )
 {
     mPropertyChangedConnection.block( block );
@@ -522,14 +977,33 @@ void PropertySynchronization::propertyChanged( const camp::UserObject& rObject,
     }
     else
     {
-        // Set property
-        mOutputPropertyTransaction.addChangedProperty( rProperty.name(), value );
+        RakNet::Time now = RakNet::GetTime();
 
-        // Serialize changes
-        if( mNextPropertySerialization == MAXUINT )
+        // Hold the change if the property was sent too recently, only the latest value is kept.
+        RakNet::Time interval = PropertySynchronization::getPropertySendInterval( 
+            rProperty.name() );
+        if( interval )
         {
-            mNextPropertySerialization = RakNet::GetTime() + mNextPropertySerializationDelay;
+            RakNet::Time& next = mNextPropertySend[rProperty.name()];
+            if( now < next )
+            {
+                mHeldProperties[rProperty.name()] = value;
+                mNextPropertySerialization = std::min( mNextPropertySerialization, next );
+                PropertySynchronization::markDirty();
+                return;
+            }
+
+            next = now + interval;
+            mHeldProperties.erase( rProperty.name() );
         }
+
+        // Set property
+        mOutputPropertyTransaction.addChangedProperty( rProperty.name(), value );
+
+        // Serialize changes, a held property may already have scheduled a later serialization.
+        mNextPropertySerialization = std::min( mNextPropertySerialization, 
+            now + mNextPropertySerializationDelay );
+        PropertySynchronization::markDirty();
     }
 }
 
@@ -559,10 +1033,9 @@ void PropertySynchronization::valueInserted( const camp::UserObject& rObject,
         mOutputPropertyTransaction.addInsertedProperty( rProperty.name(), value );
 
         // Serialize changes
-        if( mNextPropertySerialization == MAXUINT )
-        {
-            mNextPropertySerialization = RakNet::GetTime() + mNextPropertySerializationDelay;
-        }
+        mNextPropertySerialization = std::min( mNextPropertySerialization, 
+            RakNet::GetTime() + mNextPropertySerializationDelay );
+        PropertySynchronization::markDirty();
     }
 }
 
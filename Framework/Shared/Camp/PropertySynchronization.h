@@ -35,8 +35,9 @@ namespace Diversia
 {
 //------------------------------------------------------------------------------
 
-typedef std::multimap<String, camp::Args> FunctionCalls;
+typedef std::vector<std::pair<String, camp::Args> > FunctionCalls;
 typedef std::map<String, camp::Value> PropertyValueMap;
+typedef sigc::slot<bool, const camp::UserObject&, RakNet::RakNetGUID> AudienceSlot;
 
 class DIVERSIA_SHARED_API PropertySynchronization
 {
@@ -84,11 +85,69 @@ public:
     /**
     Makes properties serialize as soon as possible (when the next RakNet serialize tick occurs).
     **/
-    inline void forceSerializeProperties() { mNextPropertySerialization = 0; }
+    inline void forceSerializeProperties() 
+    { 
+        mNextPropertySerialization = 0; 
+        PropertySynchronization::markDirty();
+    }
     /**
     Makes function calls serialize as soon as possible (when the next RakNet serialize tick occurs).
     **/
-    inline void forceSerializeFunctionCalls() { mNextFunctionSerialization = 0; }
+    inline void forceSerializeFunctionCalls() 
+    { 
+        mNextFunctionSerialization = 0; 
+        PropertySynchronization::markDirty();
+    }
+    /**
+    Query if changed properties or function calls are due to be serialized in the next RakNet 
+    serialize tick.
+    **/
+    bool isSerializationPending() const;
+    /**
+    Overrides the maximum send rate of a property for this object. Changes to a property with a
+    send rate are held back until the property may be sent again, only the latest value is sent.
+    By default the send rate is taken from the "MaxRate" tag of the property.
+
+    @param  rQuery  The name of the property.
+    @param  rate    The maximum number of times per second the property is sent, 0 to send every
+                    change.
+    **/
+    void setPropertyMaxRate( const String& rQuery, Real rate );
+    /**
+    Removes the send rate override of a property, the "MaxRate" tag of the property is used again.
+
+    @param  rQuery  The name of the property.
+    **/
+    void resetPropertyMaxRate( const String& rQuery );
+    /**
+    Registers an audience for properties with the "Audience" tag. On the server, changes to a
+    property that is tagged with the name of an audience are only sent to the connections that
+    the slot accepts. Changes to properties of an audience that is not registered are not sent.
+
+    Properties with the "OwnerOnly" tag are only sent to the owner of the object, see 
+    getPropertyOwner(), and properties with the "ServerOnly" tag are never sent to clients. 
+    Serializations are only made per connection in serialize ticks that contain changes to such 
+    properties, all other serializations are sent identically to all connections. The values of
+    such properties are also left out of the construction for connections that may not see them.
+
+    @param  rName   The name of the audience.
+    @param  rSlot   The slot (signature: bool func(const camp::UserObject&, RakNet::RakNetGUID))
+                    that returns true if a connection is in the audience of an object.
+    **/
+    static void registerAudience( const String& rName, const AudienceSlot& rSlot );
+    /**
+    Unregisters an audience.
+
+    @param  rName   The name of the audience.
+    **/
+    static void unregisterAudience( const String& rName );
+    /**
+    Gets the amount of properties and function calls that were deserialized by all replicas.
+    **/
+    inline static boost::uint64_t getDeserializedPropertyCount() 
+    { 
+        return msDeserializedPropertyCount; 
+    }
 
     /**
     Turns on queuing, queuing all incoming property changes and insertions except for the
@@ -153,20 +212,21 @@ public:
     /**
     Serializes a function call.
 
+    Function calls are encoded when they are made and sent as one batch per replica at the next
+    serialize tick. Calls to functions with the "Coalesce" tag replace pending calls with the same 
+    coalesce group, the tag value is the group name or the function name if the tag has no value.
+
     @param  rQuery  The name of the function to call.
     **/
     void serializeCall( const String& rQuery )
     {
-        mOutputFunctionCalls.insert( std::make_pair( rQuery, camp::Args() ) );
+        PropertySynchronization::addFunctionCall( rQuery, camp::Args() );
         PropertySynchronization::forceSerializeFunctionCalls();
     }
 
     // Generate serializeCall for 1-20 parameters.
 #define serializeCallBody(z, n, unused) \
-    camp::Value value ## n = t ## n; \
-    if( value ## n.type() == camp::userType ) \
-        value ## n = value ## n.to<camp::UserObject>().copy(); \
-    args += value ## n;
+    args += camp::Value( t ## n );
 
 #define serializeCallSkeleton(z, n, unused) \
     template <BOOST_PP_ENUM_PARAMS(n, class T)> \
@@ -174,7 +234,7 @@ public:
     { \
         camp::Args args; \
         BOOST_PP_REPEAT(n, serializeCallBody, ~); \
-        mOutputFunctionCalls.insert( std::make_pair( rQuery, args ) ); \
+        PropertySynchronization::addFunctionCall( rQuery, args ); \
         PropertySynchronization::forceSerializeFunctionCalls(); \
     }
 
@@ -246,15 +306,95 @@ protected:
     **/
     inline virtual void queryCallFunctionDeserialize( const String& rQuery, camp::Args& rArgs,
         RakNet::RakNetGUID source ) {}
+    /**
+    Gets the connection that owns this object, changes to properties with the "OwnerOnly" tag are
+    only sent to the owner.
+
+    @note   Override this in a parent class, by default objects have no owner.
+    **/
+    inline virtual RakNet::RakNetGUID getPropertyOwner() { return RakNet::UNASSIGNED_RAKNET_GUID; }
+    /**
+    Gets the replica that the construction of this object is serialized relative to. Only the 
+    properties that differ from the property values of the reference replica are sent, instead of
+    all properties.
+
+    @param  pDestinationConnection  The connection that construction is serialized to.
+    @param [out] rpProperties       The property values of the reference replica.
+
+    @return The reference replica, or 0 to send all properties.
+
+    @note   Override this in a parent class to construct objects relative to the template they
+            were created from. The reference replica must already be constructed on the
+            destination connection.
+    **/
+    inline virtual RakNet::Replica3* getConstructionReference( 
+        RakNet::Connection_RM3* pDestinationConnection, const PropertyValueMap*& rpProperties ) 
+    { 
+        return 0; 
+    }
+    /**
+    Gets the property values of the replica that the construction of this object was serialized
+    relative to.
+
+    @param  networkID   The network ID of the reference replica.
+
+    @return The property values of the reference replica, or 0 if the replica is not known.
+
+    @see PropertySynchronization::getConstructionReference
+    **/
+    inline virtual const PropertyValueMap* getConstructionReferenceProperties( 
+        RakNet::NetworkID networkID ) 
+    { 
+        return 0; 
+    }
+
+    /**
+    Gets the replica type (REPLICATYPE_*) that serialized traffic is accounted to.
+
+    @note   Override this in a parent class that is not a plugin.
+    **/
+    inline virtual unsigned char getReplicaType() const { return REPLICATYPE_PLUGIN; }
 
     void doSerializeConstruction( RakNet::BitStream* pConstructionBitstream,
         RakNet::Connection_RM3* pDestinationConnection );
-    void doDeserializeConstruction( RakNet::BitStream* pConstructionBitstream,
+    /**
+    Deserializes the construction of the user object.
+
+    @return False if the construction refers to a reference replica that is not known, the 
+            construction must be rejected.
+    **/
+    bool doDeserializeConstruction( RakNet::BitStream* pConstructionBitstream,
         RakNet::Connection_RM3* pSourceConnection );
+    RakNet::RM3QuerySerializationResult doQuerySerialization( 
+        RakNet::Connection_RM3* pDestinationConnection ) const;
     RakNet::RM3SerializationResult doSerialize( RakNet::SerializeParameters* pSerializeParameters );
     void doDeserialize( RakNet::DeserializeParameters* pDeserializeParameters );
 
 private:
+    /**
+    A function call that is encoded and waiting to be serialized.
+    **/
+    struct EncodedFunctionCall
+    {
+        String                      mName;
+        String                      mCoalesceGroup; ///< Empty if the call is not coalesced.
+        RakNet::BitSize_t           mBits;
+        std::vector<unsigned char>  mData;
+    };
+    typedef std::vector<EncodedFunctionCall> EncodedFunctionCalls;
+
+    void addFunctionCall( const String& rQuery, const camp::Args& rArgs );
+    static void writeArgument( RakNet::BitStream& rBitStream, camp::Type type, 
+        const camp::Value& rValue );
+    static bool readArgument( RakNet::BitStream& rBitStream, camp::Type type, 
+        camp::Value& rValue );
+
+    RakNet::Time getPropertySendInterval( const String& rQuery ) const;
+    void markDirty() const;
+    void markDirtyIfPending() const;
+    void takeSerialization();
+    bool isPropertyFiltered( const String& rName ) const;
+    bool isPropertyVisible( const String& rName, RakNet::RakNetGUID connection );
     void blockChangeConnections( bool block );
     void propertyChanged( const camp::UserObject& rObject, const camp::Property& rProperty,
         const camp::Value& rValue, const int reason );
@@ -262,19 +402,32 @@ private:
         const camp::Value& rValue );
 
     camp::UserObject        mUserObject;
+    RakNet::Replica3*       mReplica;               ///< This as replica, to mark it dirty.
     Mode                    mMode;
 
     RakNet::Time            mNextPropertySerialization;
     RakNet::Time            mNextPropertySerializationDelay;
     PropertyTransaction     mOutputPropertyTransaction;
     PropertyTransaction     mInputPropertyTransaction;
+    ValueMap                mHeldProperties;        ///< Rate limited changes waiting to be sent.
+    std::map<String, RakNet::Time> mNextPropertySend;
+    std::map<String, RakNet::Time> mPropertySendIntervals;
 
     RakNet::Time            mNextFunctionSerialization;
     RakNet::Time            mNextFunctionSerializationDelay;
-    // TODO: Use vector so functions get called in the correct order.
-    FunctionCalls           mOutputFunctionCalls;
+    EncodedFunctionCalls    mOutputFunctionCalls;
     FunctionCalls           mInputFunctionCalls;
 
+    // Changes taken in the last serialize tick, written to every connection in that tick.
+    RakNet::Time            mSerializedTime;
+    PropertyTransaction     mSerializedTransaction;
+    EncodedFunctionCalls    mSerializedFunctionCalls;
+    bool                    mSerializedFiltered;    ///< Properties are filtered per connection.
+    std::set<RakNet::RakNetGUID> mSerializedConnections;
+
+    static std::map<String, AudienceSlot> msAudiences;
+    static boost::uint64_t  msDeserializedPropertyCount;
+
     bool                    mQueue;
     PropertyTransaction     mOutputQueueTransaction;
     PropertyTransaction     mInputQueueTransaction;
@@ -285,6 +438,8 @@ private:
     bool                    mQueueConstruction;
     bool                    mQueueConstructionProcess;
     RakNet::BitStream       mQueuedConstruction;
+    bool                    mQueuedConstructionHasReference;
+    PropertyValueMap        mQueuedConstructionReference;
 
     PropertyValueMap        mPropertyValueMap;
 
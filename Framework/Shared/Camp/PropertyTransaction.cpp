@@ -26,6 +26,7 @@ THE SOFTWARE.
 
 #include "Shared/Camp/PropertyTransaction.h"
 #include "Shared/Camp/CampStringInterpreter.h"
+#include "Shared/Camp/PropertyIdTable.h"
 
 namespace Diversia
 {
@@ -63,6 +64,57 @@ void PropertyTransaction::apply( camp::UserObject& rObject )
     }
 }
 
+void PropertyTransaction::serialize( RakNet::BitStream& rBitStream, 
+    const camp::Class& rClass, std::map<String, RakNet::BitSize_t>* pSizes /*= 0*/ ) const
+{
+    const PropertyIdTable& table = PropertyIdTable::get( rClass );
+
+    RakNet::writeVarUInt( rBitStream, mChangedProperties.size() );
+    for( ValueMap::const_iterator i = mChangedProperties.begin(); i != mChangedProperties.end(); 
+        ++i )
+    {
+        RakNet::BitSize_t start = rBitStream.GetNumberOfBitsUsed();
+        PropertyTransaction::writeProperty( rBitStream, table, i->first, i->second );
+        if( pSizes ) (*pSizes)[i->first] += rBitStream.GetNumberOfBitsUsed() - start;
+    }
+
+    RakNet::writeVarUInt( rBitStream, mInsertedProperties.size() );
+    for( ValueMultimap::const_iterator i = mInsertedProperties.begin(); 
+        i != mInsertedProperties.end(); ++i )
+    {
+        RakNet::BitSize_t start = rBitStream.GetNumberOfBitsUsed();
+        PropertyTransaction::writeProperty( rBitStream, table, i->first, i->second );
+        if( pSizes ) (*pSizes)[i->first] += rBitStream.GetNumberOfBitsUsed() - start;
+    }
+
+    rBitStream << mRemovedProperties;
+}
+
+void PropertyTransaction::deserialize( RakNet::BitStream& rBitStream, const camp::Class& rClass )
+{
+    const PropertyIdTable& table = PropertyIdTable::get( rClass );
+
+    unsigned int count = RakNet::readVarUInt( rBitStream );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        String name;
+        camp::Value value;
+        if( PropertyTransaction::readProperty( rBitStream, table, rClass, name, value ) )
+            mChangedProperties[ name ] = value;
+    }
+
+    count = RakNet::readVarUInt( rBitStream );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        String name;
+        camp::Value value;
+        if( PropertyTransaction::readProperty( rBitStream, table, rClass, name, value ) )
+            mInsertedProperties.insert( std::make_pair( name, value ) );
+    }
+
+    rBitStream >> mRemovedProperties;
+}
+
 void PropertyTransaction::reset()
 {
     mChangedProperties.clear();
@@ -70,5 +122,162 @@ void PropertyTransaction::reset()
     mRemovedProperties.clear();
 }
 
+bool PropertyTransaction::checkType( const camp::Class& rClass, const String& rName, 
+    const camp::Value& rValue )
+{
+    // Nested queries and array or map elements are not checked.
+    if( !rClass.hasProperty( rName ) ) return true;
+    camp::Type type = rClass.property( rName ).type();
+    if( type == camp::arrayType || type == camp::noType ) return true;
+
+    // Numbers convert into each other, strings and user types do not.
+    camp::Type valueType = rValue.type();
+    bool number = type == camp::boolType || type == camp::intType || type == camp::realType || 
+        type == camp::enumType;
+    bool valueNumber = valueType == camp::boolType || valueType == camp::intType || 
+        valueType == camp::realType || valueType == camp::enumType;
+    if( number ? valueNumber : type == valueType ) return true;
+
+    SLOGE << "Received value for property " << rName << " of class " << rClass.name() << 
+        " has the wrong type, the sender has another property with the same identifier.";
+    return false;
+}
+
+void PropertyTransaction::writeProperty( RakNet::BitStream& rBitStream, 
+    const PropertyIdTable& rTable, const String& rName, const camp::Value& rValue )
+{
+    // Only direct properties of the class can be sent with an identifier, the receiver reads 
+    // their value as the type of its own property.
+    RakNet::BitStream payload;
+    bool typed = false;
+    if( rTable.getId( rName ) )
+    {
+        try
+        {
+            typed = PropertyTransaction::writeTypedValue( payload, rValue );
+        }
+        catch( camp::Error e )
+        {
+            typed = false;
+        }
+    }
+    if( !typed )
+    {
+        payload.Reset();
+        payload << rValue;
+    }
+
+    rTable.writeName( rBitStream, rName, typed );
+    RakNet::writeVarUInt( rBitStream, payload.GetNumberOfBitsUsed() );
+    rBitStream.Write( payload, payload.GetNumberOfBitsUsed() );
+}
+
+bool PropertyTransaction::readProperty( RakNet::BitStream& rBitStream, 
+    const PropertyIdTable& rTable, const camp::Class& rClass, String& rName, camp::Value& rValue )
+{
+    bool identifier = false;
+    bool known = rTable.readName( rBitStream, rName, &identifier );
+    RakNet::BitSize_t bits = RakNet::readVarUInt( rBitStream );
+    RakNet::BitSize_t end = rBitStream.GetReadOffset() + bits;
+
+    bool valid = false;
+    if( !known )
+    {
+        SLOGD << "Skipping property with unknown identifier for class " << rClass.name();
+    }
+    else if( identifier )
+    {
+        try
+        {
+            valid = PropertyTransaction::readTypedValue( rBitStream, rClass.property( rName ), 
+                rValue ) && rBitStream.GetReadOffset() == end;
+        }
+        catch( camp::Error e )
+        {
+            valid = false;
+        }
+
+        if( !valid )
+        {
+            SLOGE << "Received value for property " << rName << " of class " << rClass.name() << 
+                " has the wrong type, the sender has another type for this property.";
+        }
+    }
+    else
+    {
+        rBitStream >> rValue;
+        valid = PropertyTransaction::checkType( rClass, rName, rValue );
+    }
+
+    rBitStream.SetReadOffset( end );
+    return valid;
+}
+
+bool PropertyTransaction::writeTypedValue( RakNet::BitStream& rBitStream, 
+    const camp::Value& rValue )
+{
+    // The type is written in front so that a receiver with another type for the property does 
+    // not decode garbage, integers and enums are interchangeable.
+    camp::Type type = rValue.type() == camp::enumType ? camp::intType : rValue.type();
+    unsigned char tag = (unsigned char)type;
+    rBitStream.WriteBits( &tag, 3 );
+
+    switch( type )
+    {
+        case camp::boolType: rBitStream.Write( rValue.to<bool>() ); return true;
+        case camp::intType: 
+            rBitStream.WriteCompressed( (boost::int64_t)rValue.to<long>() ); return true;
+        case camp::realType: rBitStream.Write( rValue.to<double>() ); return true;
+        case camp::stringType: rBitStream << rValue.to<String>(); return true;
+        case camp::userType:
+        {
+            camp::UserObject object = rValue.to<camp::UserObject>();
+            const camp::Class& metaclass = object.getClass();
+            if( !metaclass.hasTag( "BindingType" ) ) return false;
+
+            BindingType bindingType = metaclass.tag( "BindingType" );
+            return RakNet::bindingValueToBitStream( rBitStream, object, bindingType );
+        }
+        default: return false;
+    }
+}
+
+bool PropertyTransaction::readTypedValue( RakNet::BitStream& rBitStream, 
+    const camp::Property& rProperty, camp::Value& rValue )
+{
+    camp::Type type = rProperty.type() == camp::enumType ? camp::intType : rProperty.type();
+    unsigned char tag = 0; 
+    if( !rBitStream.ReadBits( &tag, 3 ) || tag != (unsigned char)type ) return false;
+
+    switch( type )
+    {
+        case camp::boolType: { bool value = false; if( !rBitStream.Read( value ) ) return false; 
+            rValue = value; return true; }
+        case camp::intType: { boost::int64_t value = 0; 
+            if( !rBitStream.ReadCompressed( value ) ) return false; 
+            rValue = (long)value; return true; }
+        case camp::realType: { double value = 0; if( !rBitStream.Read( value ) ) return false; 
+            rValue = value; return true; }
+        case camp::stringType: { String value; rBitStream >> value; rValue = value; 
+            return true; }
+        case camp::userType:
+        {
+            const camp::Class& metaclass = 
+                static_cast<const camp::UserProperty&>( rProperty ).getClass();
+            if( !metaclass.hasTag( "BindingType" ) ) return false;
+
+            BindingType bindingType = metaclass.tag( "BindingType" );
+            return RakNet::bitStreamToBindingValue( rBitStream, rValue, bindingType );
+        }
+        default: return false;
+    }
+}
+
+bool PropertyTransaction::isEmpty() const
+{
+    return mChangedProperties.empty() && mInsertedProperties.empty() && 
+        mRemovedProperties.empty();
+}
+
 //------------------------------------------------------------------------------
 } // Namespace Diversia
@@ -70,6 +70,10 @@ public:
     Removes all property changes.
     **/
     void reset();
+    /**
+    Query if there are no property changes.
+    **/
+    bool isEmpty() const;
 
     /**
     Gets the changed properties. 
@@ -84,6 +88,29 @@ public:
     **/
     inline ValueSet& getRemovedProperties() { return mRemovedProperties; }
 
+    /**
+    Writes the property changes to a bitstream, using the compact property identifiers of a class
+    instead of property names where possible. Properties that are written with an identifier are
+    written by their type, other properties are written as a self describing value. Every 
+    property is prefixed with its size so that a receiver can skip properties it cannot read.
+    
+    @param [in,out] rBitStream  The bitstream to write to.
+    @param  rClass              The class of the object the properties belong to.
+    @param [out] pSizes         If not 0, the amount of bits written per property is added to it.
+    **/
+    void serialize( RakNet::BitStream& rBitStream, const camp::Class& rClass, 
+        std::map<String, RakNet::BitSize_t>* pSizes = 0 ) const;
+    /**
+    Reads property changes written with serialize from a bitstream. Property changes with an
+    identifier that is unknown in the class are skipped. Values that cannot belong to the property 
+    the identifier was resolved to are skipped with an error, this happens when the type of the
+    property differs between the sender and this class.
+    
+    @param [in,out] rBitStream  The bitstream to read from.
+    @param  rClass              The class of the object the properties belong to.
+    **/
+    void deserialize( RakNet::BitStream& rBitStream, const camp::Class& rClass );
+
     friend inline RakNet::BitStream& operator<<( RakNet::BitStream& out, PropertyTransaction& in )
     {
         out << in.mChangedProperties;
@@ -102,6 +129,38 @@ public:
     }
 
 private:
+    /**
+    Query if a received value can belong to a property of a class, logs an error if it cannot.
+    **/
+    static bool checkType( const camp::Class& rClass, const String& rName, 
+        const camp::Value& rValue );
+    /**
+    Writes a property name and value, see serialize.
+    **/
+    static void writeProperty( RakNet::BitStream& rBitStream, const PropertyIdTable& rTable, 
+        const String& rName, const camp::Value& rValue );
+    /**
+    Reads a property name and value written with writeProperty.
+
+    @return False if the property has to be skipped.
+    **/
+    static bool readProperty( RakNet::BitStream& rBitStream, const PropertyIdTable& rTable, 
+        const camp::Class& rClass, String& rName, camp::Value& rValue );
+    /**
+    Writes a value by its type, without the type information of a self describing value.
+
+    @return False if the value cannot be written by its type, the bitstream may be partially 
+            written to.
+    **/
+    static bool writeTypedValue( RakNet::BitStream& rBitStream, const camp::Value& rValue );
+    /**
+    Reads a value written with writeTypedValue as the type of a property.
+
+    @return False if the value does not have the type of the property.
+    **/
+    static bool readTypedValue( RakNet::BitStream& rBitStream, const camp::Property& rProperty, 
+        camp::Value& rValue );
+
     ValueMap        mChangedProperties;     
     ValueMultimap   mInsertedProperties;	///< For inserting into arrays/maps. 
     ValueSet        mRemovedProperties;	    ///< For removing from arrays/maps.
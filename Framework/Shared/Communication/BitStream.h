@@ -107,6 +107,34 @@ inline RakNet::BitStream& operator<<( RakNet::BitStream& out, const Diversia::Ut
     return out;
 }
 
+// Variable length unsigned integer
+//------------------------------------------------------------------------------
+/// Write an unsigned integer to a RakNet bitstream using 7 bits per byte, small values use less
+/// bytes.
+inline void writeVarUInt( RakNet::BitStream& out, unsigned int value )
+{
+    while( value >= 0x80 )
+    {
+        out.Write<unsigned char>( (unsigned char)( value | 0x80 ) );
+        value >>= 7;
+    }
+    out.Write<unsigned char>( (unsigned char)value );
+}
+/// Read an unsigned integer written with writeVarUInt from a RakNet bitstream.
+inline unsigned int readVarUInt( RakNet::BitStream& in )
+{
+    unsigned int value = 0;
+    unsigned char byte;
+    for( unsigned int shift = 0; shift < 35; shift += 7 )
+    {
+        bool success = in.Read<unsigned char>( byte );
+        DivAssert( success, "Reading variable length integer from bitstream failed" );
+        value |= (unsigned int)( byte & 0x7F ) << shift;
+        if( !( byte & 0x80 ) ) break;
+    }
+    return value;
+}
+
 // std::map
 //------------------------------------------------------------------------------
 /// Read a std::map from a RakNet bitstream. 
@@ -213,6 +241,78 @@ template <typename Key, typename Value> inline RakNet::BitStream& operator<<(
     return out;
 }
 
+/// Write the changes between two std::map's to a RakNet bitstream, values that were added or
+/// changed are written followed by the keys that were removed. Read with readMapDelta.
+template <typename Key, typename Value> inline void writeMapDelta( RakNet::BitStream& out, 
+    const std::map<Key, Value>& rPrevious, const std::map<Key, Value>& rCurrent )
+{
+    typedef typename std::map<Key, Value>::const_iterator Iterator;
+    std::vector<Iterator> changed;
+    std::vector<Iterator> removed;
+
+    for( Iterator i = rCurrent.begin(); i != rCurrent.end(); ++i )
+    {
+        Iterator j = rPrevious.find( i->first );
+        if( j == rPrevious.end() || !( j->second == i->second ) ) changed.push_back( i );
+    }
+    for( Iterator i = rPrevious.begin(); i != rPrevious.end(); ++i )
+    {
+        if( rCurrent.find( i->first ) == rCurrent.end() ) removed.push_back( i );
+    }
+
+    writeVarUInt( out, changed.size() );
+    for( typename std::vector<Iterator>::iterator i = changed.begin(); i != changed.end(); ++i )
+    {
+        Key key = (*i)->first;
+        Value value = (*i)->second;
+        out << key;
+        out << value;
+    }
+
+    writeVarUInt( out, removed.size() );
+    for( typename std::vector<Iterator>::iterator i = removed.begin(); i != removed.end(); ++i )
+    {
+        Key key = (*i)->first;
+        out << key;
+    }
+}
+/// Query if two std::map's differ, so that writeMapDelta would write any changes.
+template <typename Key, typename Value> inline bool mapDiffers( 
+    const std::map<Key, Value>& rPrevious, const std::map<Key, Value>& rCurrent )
+{
+    if( rPrevious.size() != rCurrent.size() ) return true;
+
+    typename std::map<Key, Value>::const_iterator i, j;
+    for( i = rPrevious.begin(), j = rCurrent.begin(); i != rPrevious.end(); ++i, ++j )
+    {
+        if( !( i->first == j->first ) || !( i->second == j->second ) ) return true;
+    }
+
+    return false;
+}
+/// Apply changes written with writeMapDelta to a std::map.
+template <typename Key, typename Value> inline void readMapDelta( RakNet::BitStream& in, 
+    std::map<Key, Value>& out )
+{
+    unsigned int changed = readVarUInt( in );
+    for( unsigned int i = 0; i < changed; ++i )
+    {
+        Key key; 
+        Value value;
+        in >> key;
+        in >> value;
+        out[key] = value;
+    }
+
+    unsigned int removed = readVarUInt( in );
+    for( unsigned int i = 0; i < removed; ++i )
+    {
+        Key key;
+        in >> key;
+        out.erase( key );
+    }
+}
+
 // std::multimap
 //------------------------------------------------------------------------------
 /// Read a std::multimap from a RakNet bitstream. 
@@ -398,6 +498,61 @@ case BindingType_ ## name: \
     break; \
 }
 
+/// Read a Camp Value of a user type that has a BindingType tag from a RakNet bitstream, the binding 
+/// type itself is not read. Returns false if the binding type cannot be read.
+inline bool bitStreamToBindingValue( RakNet::BitStream& in, camp::Value& out, 
+    Diversia::Util::BindingType bindingType )
+{
+    using namespace Diversia::Util;
+    using namespace Diversia;
+
+    switch( bindingType )
+    {
+        BITSTREAM_TO_VALUE_TYPE( Vector2 )
+        BITSTREAM_TO_VALUE_TYPE( Vector3 )
+        BITSTREAM_TO_VALUE_TYPE( Vector4 )
+        BITSTREAM_TO_VALUE_TYPE( Colour )
+        BITSTREAM_TO_VALUE_TYPE( Quaternion )
+        BITSTREAM_TO_VALUE_TYPE( Matrix3 )
+        BITSTREAM_TO_VALUE_TYPE( Matrix4 )
+        BITSTREAM_TO_VALUE_TYPE( Radian )
+        BITSTREAM_TO_VALUE_TYPE( Degree )
+        BITSTREAM_TO_VALUE_TYPE( Angle )
+        BITSTREAM_TO_VALUE_TYPE( ResourceInfo )
+        default:
+            return false;
+    }
+
+    return true;
+}
+/// Write a Camp user object that has a BindingType tag to a RakNet bitstream, the binding type 
+/// itself is not written. Returns false if the binding type cannot be written.
+inline bool bindingValueToBitStream( RakNet::BitStream& rBitStream, 
+    const camp::UserObject& object, Diversia::Util::BindingType bindingType )
+{
+    using namespace Diversia::Util;
+    using namespace Diversia;
+
+    switch( bindingType )
+    {
+        VALUE_TO_BITSTREAM_TYPE( Vector2 )
+        VALUE_TO_BITSTREAM_TYPE( Vector3 )
+        VALUE_TO_BITSTREAM_TYPE( Vector4 )
+        VALUE_TO_BITSTREAM_TYPE( Colour )
+        VALUE_TO_BITSTREAM_TYPE( Quaternion )
+        VALUE_TO_BITSTREAM_TYPE( Matrix3 )
+        VALUE_TO_BITSTREAM_TYPE( Matrix4 )
+        VALUE_TO_BITSTREAM_TYPE( Radian )
+        VALUE_TO_BITSTREAM_TYPE( Degree )
+        VALUE_TO_BITSTREAM_TYPE( Angle )
+        VALUE_TO_BITSTREAM_TYPE( ResourceInfo )
+        default:
+            return false;
+    }
+
+    return true;
+}
+
 inline RakNet::BitStream& operator>>( RakNet::BitStream& in, camp::Value& out )
 {
     using namespace Diversia::Util;
@@ -422,18 +577,6 @@ inline RakNet::BitStream& operator>>( RakNet::BitStream& in, camp::Value& out )
             out = string;
             break;
         }
-        // User types.
-        BITSTREAM_TO_VALUE_TYPE( Vector2 )
-        BITSTREAM_TO_VALUE_TYPE( Vector3 )
-        BITSTREAM_TO_VALUE_TYPE( Vector4 )
-        BITSTREAM_TO_VALUE_TYPE( Colour )
-        BITSTREAM_TO_VALUE_TYPE( Quaternion )
-        BITSTREAM_TO_VALUE_TYPE( Matrix3 )
-        BITSTREAM_TO_VALUE_TYPE( Matrix4 )
-        BITSTREAM_TO_VALUE_TYPE( Radian )
-        BITSTREAM_TO_VALUE_TYPE( Degree )
-        BITSTREAM_TO_VALUE_TYPE( Angle )
-        BITSTREAM_TO_VALUE_TYPE( ResourceInfo )
         // TODO: Doesn't work yet, needs a fix in camp, should be fixed in camp 0.8.0.
         /*case BindingType_unknown:
         {
@@ -465,8 +608,10 @@ inline RakNet::BitStream& operator>>( RakNet::BitStream& in, camp::Value& out )
             
             break;
         }*/
+        // User types.
         default:
-            DivAssert( 0, "Reading Value from bitstream failed" );
+            success = RakNet::bitStreamToBindingValue( in, out, bindingType );
+            DivAssert( success, "Reading Value from bitstream failed" );
     }
 
     return in;
@@ -511,23 +656,8 @@ inline void valueToBitStream( RakNet::BitStream& rBitStream, const camp::Value&
 
                 try
                 {
-                    switch( bindingType )
-                    {
-                        VALUE_TO_BITSTREAM_TYPE( Vector2 )
-                        VALUE_TO_BITSTREAM_TYPE( Vector3 )
-                        VALUE_TO_BITSTREAM_TYPE( Vector4 )
-                        VALUE_TO_BITSTREAM_TYPE( Colour )
-                        VALUE_TO_BITSTREAM_TYPE( Quaternion )
-                        VALUE_TO_BITSTREAM_TYPE( Matrix3 )
-                        VALUE_TO_BITSTREAM_TYPE( Matrix4 )
-                        VALUE_TO_BITSTREAM_TYPE( Radian )
-                        VALUE_TO_BITSTREAM_TYPE( Degree )
-                        VALUE_TO_BITSTREAM_TYPE( Angle )
-                        VALUE_TO_BITSTREAM_TYPE( ResourceInfo )
-                        default:
-                            DivAssert( 0, "Writing Value to bitstream failed" );
-                            break;
-                    }
+                    if( !RakNet::bindingValueToBitStream( rBitStream, object, bindingType ) )
+                        DivAssert( 0, "Writing Value to bitstream failed" );
                 }
                 catch ( camp::Error e )
                 {
@@ -0,0 +1,343 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Shared/Platform/StableHeaders.h"
+
+#include "Shared/Communication/LoopbackPeer.h"
+#include "Shared/Communication/ServerInfo.h"
+
+#include <RakNet/MessageIdentifiers.h>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+boost::mutex LoopbackPeer::msMutex;
+std::map<String, LoopbackPeer*> LoopbackPeer::msListeners;
+unsigned short LoopbackPeer::msNextPort = 1;
+
+LoopbackPeer::LoopbackPeer():
+    mAddress( RakNet::UNASSIGNED_SYSTEM_ADDRESS )
+{
+
+}
+
+LoopbackPeer::~LoopbackPeer()
+{
+    LoopbackPeer::Shutdown( 0 );
+}
+
+bool LoopbackPeer::listen( const ServerInfo& rServerInfo )
+{
+    boost::mutex::scoped_lock lock( msMutex );
+
+    String address = rServerInfo.getAddressMerged();
+    std::map<String, LoopbackPeer*>::iterator i = msListeners.find( address );
+    if( i != msListeners.end() ) return i->second == this;
+
+    msListeners.insert( std::make_pair( address, this ) );
+    mListenAddress = address;
+    mAddress = RakNet::SystemAddress( rServerInfo.mAddress.c_str(), rServerInfo.mPort );
+    return true;
+}
+
+bool LoopbackPeer::connect( const ServerInfo& rServerInfo )
+{
+    boost::mutex::scoped_lock lock( msMutex );
+
+    std::map<String, LoopbackPeer*>::iterator i = msListeners.find( 
+        rServerInfo.getAddressMerged() );
+    if( i == msListeners.end() || i->second == this ) return false;
+    LoopbackPeer& peer = *i->second;
+    if( LoopbackPeer::findLink( peer.GetMyGUID() ) != mLinks.end() ) return false;
+
+    // A peer that does not listen gets an address no remote system can have.
+    if( mAddress == RakNet::UNASSIGNED_SYSTEM_ADDRESS ) 
+        mAddress = RakNet::SystemAddress( "0.0.0.0", msNextPort++ );
+
+    mLinks.push_back( Link( &peer, peer.mAddress, peer.GetMyGUID() ) );
+    peer.mLinks.push_back( Link( this, mAddress, RakPeer::GetMyGUID() ) );
+
+    unsigned char messageID = ID_NEW_INCOMING_CONNECTION;
+    LoopbackPeer::deliver( peer, (const char*)&messageID, sizeof( messageID ) );
+    messageID = ID_CONNECTION_REQUEST_ACCEPTED;
+    peer.deliver( *this, (const char*)&messageID, sizeof( messageID ) );
+    return true;
+}
+
+bool LoopbackPeer::isListening( const ServerInfo& rServerInfo )
+{
+    boost::mutex::scoped_lock lock( msMutex );
+    return msListeners.find( rServerInfo.getAddressMerged() ) != msListeners.end();
+}
+
+unsigned int LoopbackPeer::getLoopbackConnectionCount() const
+{
+    boost::mutex::scoped_lock lock( msMutex );
+    return mLinks.size();
+}
+
+uint32_t LoopbackPeer::Send( const char* data, const int length, PacketPriority priority, 
+    PacketReliability reliability, char orderingChannel, 
+    const RakNet::AddressOrGUID systemIdentifier, bool broadcast, 
+    uint32_t forceReceiptNumber /*= 0*/ )
+{
+    if( !data || length <= 0 ) return 0;
+
+    {
+        boost::mutex::scoped_lock lock( msMutex );
+
+        if( broadcast )
+        {
+            // Broadcasts go to every loopback connection except the given one.
+            Links::const_iterator exclude = LoopbackPeer::findLink( systemIdentifier );
+            for( Links::const_iterator i = mLinks.begin(); i != mLinks.end(); ++i )
+            {
+                if( i != exclude ) LoopbackPeer::deliver( *i->mPeer, data, length );
+            }
+        }
+        else
+        {
+            Links::const_iterator i = LoopbackPeer::findLink( systemIdentifier );
+            if( i != mLinks.end() )
+            {
+                // Loopback messages are delivered immediately, there is no receipt to wait for.
+                LoopbackPeer::deliver( *i->mPeer, data, length );
+                return 1;
+            }
+        }
+    }
+
+    if( broadcast && !RakPeer::IsActive() ) return 1;
+
+    return RakPeer::Send( data, length, priority, reliability, orderingChannel, systemIdentifier, 
+        broadcast, forceReceiptNumber );
+}
+
+uint32_t LoopbackPeer::Send( const RakNet::BitStream* bitStream, PacketPriority priority, 
+    PacketReliability reliability, char orderingChannel, 
+    const RakNet::AddressOrGUID systemIdentifier, bool broadcast, 
+    uint32_t forceReceiptNumber /*= 0*/ )
+{
+    return LoopbackPeer::Send( (const char*)bitStream->GetData(), 
+        bitStream->GetNumberOfBytesUsed(), priority, reliability, orderingChannel, 
+        systemIdentifier, broadcast, forceReceiptNumber );
+}
+
+RakNet::Packet* LoopbackPeer::Receive()
+{
+    // Take the whole inbox at once so the lock is only taken when the received packets ran out.
+    if( mReceived.empty() )
+    {
+        boost::mutex::scoped_lock lock( msMutex );
+        mReceived.swap( mInbox );
+    }
+
+    if( !mReceived.empty() )
+    {
+        RakNet::Packet* packet = mReceived.front();
+        mReceived.pop_front();
+        return packet;
+    }
+
+    return RakPeer::Receive();
+}
+
+void LoopbackPeer::Shutdown( unsigned int blockDuration, unsigned char orderingChannel /*= 0*/, 
+    PacketPriority disconnectionNotificationPriority /*= LOW_PRIORITY*/ )
+{
+    LoopbackPeer::closeLinks( ID_DISCONNECTION_NOTIFICATION );
+
+    // Packets that were not received yet belong to the old connections.
+    std::deque<RakNet::Packet*> packets;
+    {
+        boost::mutex::scoped_lock lock( msMutex );
+        packets.swap( mInbox );
+    }
+    packets.insert( packets.end(), mReceived.begin(), mReceived.end() );
+    mReceived.clear();
+    for( std::deque<RakNet::Packet*>::iterator i = packets.begin(); i != packets.end(); ++i )
+        RakPeer::DeallocatePacket( *i );
+
+    RakPeer::Shutdown( blockDuration, orderingChannel, disconnectionNotificationPriority );
+}
+
+void LoopbackPeer::CloseConnection( const RakNet::AddressOrGUID target, 
+    bool sendDisconnectionNotification, unsigned char orderingChannel /*= 0*/, 
+    PacketPriority disconnectionNotificationPriority /*= LOW_PRIORITY*/ )
+{
+    {
+        boost::mutex::scoped_lock lock( msMutex );
+
+        Links::const_iterator i = LoopbackPeer::findLink( target );
+        if( i != mLinks.end() )
+        {
+            LoopbackPeer::unlink( *i->mPeer, sendDisconnectionNotification ? 
+                ID_DISCONNECTION_NOTIFICATION : ID_CONNECTION_LOST );
+            return;
+        }
+    }
+
+    RakPeer::CloseConnection( target, sendDisconnectionNotification, orderingChannel, 
+        disconnectionNotificationPriority );
+}
+
+bool LoopbackPeer::IsActive() const
+{
+    if( RakPeer::IsActive() ) return true;
+
+    boost::mutex::scoped_lock lock( msMutex );
+    return !mListenAddress.empty() || !mLinks.empty();
+}
+
+RakNet::ConnectionState LoopbackPeer::GetConnectionState( 
+    const RakNet::AddressOrGUID systemIdentifier )
+{
+    {
+        boost::mutex::scoped_lock lock( msMutex );
+        if( LoopbackPeer::findLink( systemIdentifier ) != mLinks.end() ) 
+            return RakNet::IS_CONNECTED;
+    }
+
+    return RakPeer::GetConnectionState( systemIdentifier );
+}
+
+unsigned int LoopbackPeer::GetMaximumNumberOfPeers() const
+{
+    return RakPeer::GetMaximumNumberOfPeers() + LoopbackPeer::getLoopbackConnectionCount();
+}
+
+RakNet::SystemAddress LoopbackPeer::GetSystemAddressFromIndex( unsigned int index )
+{
+    unsigned int remotePeers = RakPeer::GetMaximumNumberOfPeers();
+    if( index < remotePeers ) return RakPeer::GetSystemAddressFromIndex( index );
+
+    boost::mutex::scoped_lock lock( msMutex );
+    index -= remotePeers;
+    return index < mLinks.size() ? mLinks[index].mAddress : RakNet::UNASSIGNED_SYSTEM_ADDRESS;
+}
+
+RakNet::RakNetGUID LoopbackPeer::GetGUIDFromIndex( unsigned int index )
+{
+    unsigned int remotePeers = RakPeer::GetMaximumNumberOfPeers();
+    if( index < remotePeers ) return RakPeer::GetGUIDFromIndex( index );
+
+    boost::mutex::scoped_lock lock( msMutex );
+    index -= remotePeers;
+    return index < mLinks.size() ? mLinks[index].mGUID : RakNet::UNASSIGNED_RAKNET_GUID;
+}
+
+RakNet::SystemAddress LoopbackPeer::GetSystemAddressFromGuid( 
+    const RakNet::RakNetGUID input ) const
+{
+    {
+        boost::mutex::scoped_lock lock( msMutex );
+        Links::const_iterator i = LoopbackPeer::findLink( input );
+        if( i != mLinks.end() ) return i->mAddress;
+    }
+
+    return RakPeer::GetSystemAddressFromGuid( input );
+}
+
+const RakNet::RakNetGUID& LoopbackPeer::GetGuidFromSystemAddress( 
+    const RakNet::SystemAddress input ) const
+{
+    {
+        boost::mutex::scoped_lock lock( msMutex );
+        Links::const_iterator i = LoopbackPeer::findLink( input );
+        if( i != mLinks.end() )
+        {
+            // Links can be removed by other threads, do not hand out a reference to the link.
+            mGUIDResult = i->mGUID;
+            return mGUIDResult;
+        }
+    }
+
+    return RakPeer::GetGuidFromSystemAddress( input );
+}
+
+LoopbackPeer::Links::const_iterator LoopbackPeer::findLink( 
+    const RakNet::AddressOrGUID& rSystemIdentifier ) const
+{
+    Links::const_iterator i;
+    for( i = mLinks.begin(); i != mLinks.end(); ++i )
+    {
+        if( rSystemIdentifier.rakNetGuid != RakNet::UNASSIGNED_RAKNET_GUID ? 
+            i->mGUID == rSystemIdentifier.rakNetGuid : 
+            i->mAddress == rSystemIdentifier.systemAddress ) 
+            break;
+    }
+
+    return i;
+}
+
+void LoopbackPeer::deliver( LoopbackPeer& rPeer, const char* pData, unsigned int length )
+{
+    // The message is copied once into a packet of the receiving peer, the packet itself is 
+    // handed over.
+    RakNet::Packet* packet = rPeer.AllocatePacket( length );
+    memcpy( packet->data, pData, length );
+    packet->systemAddress = mAddress;
+    packet->guid = RakPeer::GetMyGUID();
+    packet->wasGeneratedLocally = false;
+    rPeer.mInbox.push_back( packet );
+}
+
+void LoopbackPeer::closeLinks( unsigned char messageID )
+{
+    boost::mutex::scoped_lock lock( msMutex );
+
+    while( !mLinks.empty() ) LoopbackPeer::unlink( *mLinks.back().mPeer, messageID );
+
+    if( !mListenAddress.empty() )
+    {
+        msListeners.erase( mListenAddress );
+        mListenAddress.clear();
+    }
+}
+
+void LoopbackPeer::unlink( LoopbackPeer& rPeer, unsigned char messageID )
+{
+    for( Links::iterator i = mLinks.begin(); i != mLinks.end(); ++i )
+    {
+        if( i->mPeer == &rPeer ) 
+        {
+            mLinks.erase( i );
+            break;
+        }
+    }
+    for( Links::iterator i = rPeer.mLinks.begin(); i != rPeer.mLinks.end(); ++i )
+    {
+        if( i->mPeer == this ) 
+        {
+            rPeer.mLinks.erase( i );
+            break;
+        }
+    }
+
+    LoopbackPeer::deliver( rPeer, (const char*)&messageID, sizeof( messageID ) );
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
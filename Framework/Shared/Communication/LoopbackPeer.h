@@ -0,0 +1,160 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SHARED_LOOPBACKPEER_H
+#define DIVERSIA_SHARED_LOOPBACKPEER_H
+
+#include "Shared/Platform/Prerequisites.h"
+
+#include <RakNet/RakPeer.h>
+#include <boost/thread/mutex.hpp>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+/**
+RakPeer that can also connect to other peers in the same process without sockets. A peer that 
+listens on an address can be connected to by any other loopback peer in the process that 
+connects to the same address. Messages sent over a loopback connection are put in the inbox of 
+the other peer as a packet directly, they do not go through sockets, the reliability layer or the
+RakPeer threads. Connection and disconnection messages are generated the same way RakPeer 
+generates them, so plugins and connection handling do not need to know about loopback 
+connections.
+
+Connections to other processes still go through RakPeer, a listening peer can have loopback 
+connections and remote connections at the same time. Loopback connections are indexed after the 
+remote connections.
+**/
+class DIVERSIA_SHARED_API LoopbackPeer : public RakNet::RakPeer
+{
+public:
+    /**
+    Default constructor.
+    **/
+    LoopbackPeer();
+    /**
+    Destructor, closes all loopback connections.
+    **/
+    ~LoopbackPeer();
+
+    /**
+    Accepts loopback connections to an address, call this after the RakPeer has been started if 
+    remote connections are accepted as well.
+
+    @param  rServerInfo The address and port to accept connections on.
+
+    @return True if it succeeds, false if another peer in this process already listens on the 
+            address.
+    **/
+    bool listen( const ServerInfo& rServerInfo );
+    /**
+    Connects to a peer in this process that listens on an address. Both peers receive their 
+    connection message on the next receive.
+
+    @param  rServerInfo The address and port to connect to.
+
+    @return True if it succeeds, false if no peer in this process listens on the address.
+    **/
+    bool connect( const ServerInfo& rServerInfo );
+    /**
+    Query if a peer in this process listens on an address.
+    **/
+    static bool isListening( const ServerInfo& rServerInfo );
+    /**
+    Gets the amount of loopback connections.
+    **/
+    unsigned int getLoopbackConnectionCount() const;
+
+    // RakPeerInterface overrides that handle loopback connections.
+    uint32_t Send( const char* data, const int length, PacketPriority priority, 
+        PacketReliability reliability, char orderingChannel, 
+        const RakNet::AddressOrGUID systemIdentifier, bool broadcast, 
+        uint32_t forceReceiptNumber = 0 );
+    uint32_t Send( const RakNet::BitStream* bitStream, PacketPriority priority, 
+        PacketReliability reliability, char orderingChannel, 
+        const RakNet::AddressOrGUID systemIdentifier, bool broadcast, 
+        uint32_t forceReceiptNumber = 0 );
+    RakNet::Packet* Receive();
+    void Shutdown( unsigned int blockDuration, unsigned char orderingChannel = 0, 
+        PacketPriority disconnectionNotificationPriority = LOW_PRIORITY );
+    void CloseConnection( const RakNet::AddressOrGUID target, bool sendDisconnectionNotification, 
+        unsigned char orderingChannel = 0, 
+        PacketPriority disconnectionNotificationPriority = LOW_PRIORITY );
+    bool IsActive() const;
+    RakNet::ConnectionState GetConnectionState( const RakNet::AddressOrGUID systemIdentifier );
+    unsigned int GetMaximumNumberOfPeers() const;
+    RakNet::SystemAddress GetSystemAddressFromIndex( unsigned int index );
+    RakNet::RakNetGUID GetGUIDFromIndex( unsigned int index );
+    RakNet::SystemAddress GetSystemAddressFromGuid( const RakNet::RakNetGUID input ) const;
+    const RakNet::RakNetGUID& GetGuidFromSystemAddress( const RakNet::SystemAddress input ) const;
+
+private:
+    /**
+    A loopback connection to another peer.
+    **/
+    struct Link
+    {
+        Link( LoopbackPeer* pPeer, const RakNet::SystemAddress& rAddress, 
+            const RakNet::RakNetGUID& rGUID ): mPeer( pPeer ), mAddress( rAddress ), 
+            mGUID( rGUID ) {}
+
+        LoopbackPeer*           mPeer;
+        RakNet::SystemAddress   mAddress;   ///< Address of the other peer.
+        RakNet::RakNetGUID      mGUID;      ///< GUID of the other peer.
+    };
+    typedef std::vector<Link> Links;
+
+    Links::const_iterator findLink( const RakNet::AddressOrGUID& rSystemIdentifier ) const;
+    /**
+    Puts a message from this peer in the inbox of another peer, msMutex must be locked.
+    **/
+    void deliver( LoopbackPeer& rPeer, const char* pData, unsigned int length );
+    /**
+    Closes all loopback connections, the other peers receive a message with the given ID.
+    **/
+    void closeLinks( unsigned char messageID );
+    /**
+    Removes the link to a peer and lets it receive a message with the given ID, msMutex must be 
+    locked.
+    **/
+    void unlink( LoopbackPeer& rPeer, unsigned char messageID );
+
+    String                          mListenAddress;
+    RakNet::SystemAddress           mAddress;   ///< Address other peers see this peer at.
+    Links                           mLinks;
+    std::deque<RakNet::Packet*>     mInbox;
+    std::deque<RakNet::Packet*>     mReceived;  ///< Only used by the receiving thread.
+    mutable RakNet::RakNetGUID      mGUIDResult;
+
+    static boost::mutex                             msMutex;
+    static std::map<String, LoopbackPeer*>          msListeners;
+    static unsigned short                           msNextPort;
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
+
+#endif // DIVERSIA_SHARED_LOOPBACKPEER_H
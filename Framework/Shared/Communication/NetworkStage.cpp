@@ -0,0 +1,243 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Shared/Platform/StableHeaders.h"
+
+#include "Shared/Communication/NetworkStage.h"
+#include "Shared/Communication/PacketRecorder.h"
+#include "Shared/Communication/PacketReplay.h"
+
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/PluginInterface2.h>
+#include <RakNet/MessageIdentifiers.h>
+#include <boost/bind.hpp>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+NetworkStage::Settings NetworkStage::msSettings = NetworkStage::Settings();
+
+NetworkStage::NetworkStage( RakNet::RakPeerInterface& rRakPeer ):
+    mRakPeer( rRakPeer ),
+    mQueue( msSettings.mQueueSize ? msSettings.mQueueSize : 1 ),
+    mRunning( false ),
+    mThreaded( false ),
+    mRecorder( 0 ),
+    mReplay( 0 )
+{
+
+}
+
+NetworkStage::~NetworkStage()
+{
+    NetworkStage::stop();
+
+    for( std::vector<RakNet::PluginInterface2*>::iterator i = mPlugins.begin(); 
+        i != mPlugins.end(); ++i )
+    {
+        (*i)->OnDetach();
+        (*i)->SetRakPeerInterface( 0 );
+    }
+}
+
+void NetworkStage::attachPlugin( RakNet::PluginInterface2& rPlugin )
+{
+    if( std::find( mPlugins.begin(), mPlugins.end(), &rPlugin ) != mPlugins.end() ) return;
+
+    mPlugins.push_back( &rPlugin );
+    rPlugin.SetRakPeerInterface( &mRakPeer );
+    rPlugin.OnAttach();
+    if( mRunning ) rPlugin.OnRakPeerStartup();
+}
+
+void NetworkStage::detachPlugin( RakNet::PluginInterface2& rPlugin )
+{
+    std::vector<RakNet::PluginInterface2*>::iterator i = std::find( mPlugins.begin(), 
+        mPlugins.end(), &rPlugin );
+    if( i == mPlugins.end() ) return;
+
+    mPlugins.erase( i );
+    rPlugin.OnDetach();
+    rPlugin.SetRakPeerInterface( 0 );
+}
+
+void NetworkStage::start()
+{
+    if( mRunning ) return;
+
+    mRunning = true;
+    mThreaded = msSettings.mThreaded && !mReplay;
+
+    for( std::vector<RakNet::PluginInterface2*>::iterator i = mPlugins.begin(); 
+        i != mPlugins.end(); ++i )
+    {
+        (*i)->OnRakPeerStartup();
+    }
+
+    if( mThreaded )
+        mThread.reset( new boost::thread( boost::bind( &NetworkStage::networkLoop, this ) ) );
+}
+
+void NetworkStage::stop()
+{
+    if( !mRunning ) return;
+
+    mRunning = false;
+    if( mThread )
+    {
+        mThread->join();
+        mThread.reset();
+    }
+
+    // Packets that were not received yet belong to the old connections.
+    RakNet::Packet* packet;
+    while( mQueue.pop( packet ) ) mRakPeer.DeallocatePacket( packet );
+
+    for( std::vector<RakNet::PluginInterface2*>::iterator i = mPlugins.begin(); 
+        i != mPlugins.end(); ++i )
+    {
+        (*i)->OnRakPeerShutdown();
+    }
+}
+
+void NetworkStage::update()
+{
+    if( !mRunning ) return;
+
+    if( mRecorder ) mRecorder->tick();
+    if( mReplay ) mReplay->tick();
+
+    for( std::vector<RakNet::PluginInterface2*>::iterator i = mPlugins.begin(); 
+        i != mPlugins.end(); ++i )
+    {
+        (*i)->Update();
+    }
+}
+
+RakNet::Packet* NetworkStage::receive()
+{
+    if( !mRunning ) return 0;
+
+    RakNet::Packet* packet;
+    while( ( packet = NetworkStage::pop() ) != 0 )
+    {
+        if( mRecorder ) mRecorder->record( *packet );
+
+        std::vector<RakNet::PluginInterface2*>::iterator i;
+        for( i = mPlugins.begin(); i != mPlugins.end(); ++i )
+        {
+            NetworkStage::notifyPlugin( **i, *packet );
+
+            RakNet::PluginReceiveResult result = (*i)->OnReceive( packet );
+            if( result == RakNet::RR_STOP_PROCESSING_AND_DEALLOCATE )
+            {
+                mRakPeer.DeallocatePacket( packet );
+                break;
+            }
+            else if( result == RakNet::RR_STOP_PROCESSING )
+            {
+                // Plugin took ownership of the packet.
+                break;
+            }
+        }
+
+        if( i == mPlugins.end() ) return packet;
+    }
+
+    return 0;
+}
+
+void NetworkStage::networkLoop()
+{
+    while( mRunning )
+    {
+        // Stop draining the RakPeer when the simulation thread is behind, RakPeer keeps the 
+        // packets until there is room again.
+        RakNet::Packet* packet = mQueue.full() ? 0 : mRakPeer.Receive();
+        if( packet )
+        {
+            mQueue.push( packet );
+        }
+        else
+        {
+            boost::this_thread::sleep( boost::posix_time::milliseconds( 
+                msSettings.mIdleSleepMS ) );
+        }
+    }
+}
+
+RakNet::Packet* NetworkStage::pop()
+{
+    if( mReplay ) return mReplay->receive();
+    if( !mThreaded ) return mRakPeer.Receive();
+
+    RakNet::Packet* packet;
+    return mQueue.pop( packet ) ? packet : 0;
+}
+
+void NetworkStage::notifyPlugin( RakNet::PluginInterface2& rPlugin, RakNet::Packet& rPacket )
+{
+    // Connection notifications that RakPeer::Receive would send to attached plugins.
+    switch( rPacket.data[0] )
+    {
+        case ID_DISCONNECTION_NOTIFICATION:
+            rPlugin.OnClosedConnection( rPacket.systemAddress, rPacket.guid, 
+                RakNet::LCR_DISCONNECTION_NOTIFICATION );
+            break;
+        case ID_CONNECTION_LOST:
+            rPlugin.OnClosedConnection( rPacket.systemAddress, rPacket.guid, 
+                RakNet::LCR_CONNECTION_LOST );
+            break;
+        case ID_NEW_INCOMING_CONNECTION:
+            rPlugin.OnNewConnection( rPacket.systemAddress, rPacket.guid, true );
+            break;
+        case ID_CONNECTION_REQUEST_ACCEPTED:
+            rPlugin.OnNewConnection( rPacket.systemAddress, rPacket.guid, false );
+            break;
+        case ID_CONNECTION_ATTEMPT_FAILED:
+            rPlugin.OnFailedConnectionAttempt( &rPacket, 
+                RakNet::FCAR_CONNECTION_ATTEMPT_FAILED );
+            break;
+        case ID_ALREADY_CONNECTED:
+            rPlugin.OnFailedConnectionAttempt( &rPacket, RakNet::FCAR_ALREADY_CONNECTED );
+            break;
+        case ID_NO_FREE_INCOMING_CONNECTIONS:
+            rPlugin.OnFailedConnectionAttempt( &rPacket, 
+                RakNet::FCAR_NO_FREE_INCOMING_CONNECTIONS );
+            break;
+        case ID_CONNECTION_BANNED:
+            rPlugin.OnFailedConnectionAttempt( &rPacket, RakNet::FCAR_CONNECTION_BANNED );
+            break;
+        case ID_INVALID_PASSWORD:
+            rPlugin.OnFailedConnectionAttempt( &rPacket, RakNet::FCAR_INVALID_PASSWORD );
+            break;
+        case ID_INCOMPATIBLE_PROTOCOL_VERSION:
+            rPlugin.OnFailedConnectionAttempt( &rPacket, RakNet::FCAR_INCOMPATIBLE_PROTOCOL );
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
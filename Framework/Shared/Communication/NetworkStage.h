@@ -0,0 +1,174 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SHARED_NETWORKSTAGE_H
+#define DIVERSIA_SHARED_NETWORKSTAGE_H
+
+#include "Shared/Platform/Prerequisites.h"
+
+#include "Util/Job/SPSCQueue.h"
+#include <boost/thread/thread.hpp>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+/**
+Moves receiving packets from a RakPeer off the simulation thread. A network thread drains the 
+RakPeer and hands the packets to the simulation thread through a bounded lock-free queue. When 
+the queue is full the network thread stops draining until the simulation thread catches up, 
+packets are never dropped.
+
+Plugins are not attached to the RakPeer but to the network stage, because RakPeer runs them 
+inside Receive() and they modify the replicated objects. The network stage runs them on the 
+simulation thread in receive() and update() the same way RakPeer would. Outgoing messages do not 
+need a stage of their own, RakPeer::Send only queues the message for the RakPeer thread.
+
+Usage:
+@code
+stage.update();
+for( packet = stage.receive(); packet; stage.deallocatePacket( packet ), 
+    packet = stage.receive() )
+{
+    // Handle packet
+}
+@endcode
+**/
+class DIVERSIA_SHARED_API NetworkStage : public boost::noncopyable
+{
+public:
+    /**
+    Constructor.
+
+    @param [in,out] rRakPeer    The RakPeer to receive packets from.
+    **/
+    NetworkStage( RakNet::RakPeerInterface& rRakPeer );
+    /**
+    Destructor, stops the network thread.
+    **/
+    ~NetworkStage();
+
+    /**
+    Attaches a plugin. Use this instead of RakPeerInterface::AttachPlugin.
+    **/
+    void attachPlugin( RakNet::PluginInterface2& rPlugin );
+    /**
+    Detaches a plugin. Use this instead of RakPeerInterface::DetachPlugin.
+    **/
+    void detachPlugin( RakNet::PluginInterface2& rPlugin );
+    /**
+    Starts receiving packets, call this after the RakPeer has been started.
+    **/
+    void start();
+    /**
+    Stops receiving packets and deallocates packets that have not been received yet, call this
+    before the RakPeer is shut down.
+    **/
+    void stop();
+    /**
+    Updates all plugins, call this once per tick before receiving packets.
+    **/
+    void update();
+    /**
+    Gets the next packet that was not consumed by a plugin. 
+
+    @return The packet, deallocate it with deallocatePacket(). 0 if there are no more packets.
+    **/
+    RakNet::Packet* receive();
+    /**
+    Deallocates a packet returned by receive().
+    **/
+    inline void deallocatePacket( RakNet::Packet* pPacket ) 
+    { 
+        mRakPeer.DeallocatePacket( pPacket ); 
+    }
+    /**
+    Query if packets are received on a network thread.
+    **/
+    inline bool isThreaded() const { return mThreaded; }
+    /**
+    Gets the amount of packets that are waiting for the simulation thread.
+    **/
+    inline unsigned int getQueuedPacketCount() const { return mQueue.size(); }
+    /**
+    Sets the recorder that received packets are recorded with, before plugins process them.
+
+    @param [in,out] pRecorder   The recorder, 0 to stop recording.
+    **/
+    inline void setRecorder( PacketRecorder* pRecorder ) { mRecorder = pRecorder; }
+    /**
+    Sets the replay that packets are received from instead of the RakPeer, set this before the 
+    network stage is started. Replays are received on the simulation thread.
+
+    @param [in,out] pReplay The replay, 0 to receive from the RakPeer.
+    **/
+    inline void setReplay( PacketReplay* pReplay ) { mReplay = pReplay; }
+
+private:
+    void networkLoop();
+    RakNet::Packet* pop();
+    void notifyPlugin( RakNet::PluginInterface2& rPlugin, RakNet::Packet& rPacket );
+
+    RakNet::RakPeerInterface&               mRakPeer;
+    std::vector<RakNet::PluginInterface2*>  mPlugins;
+    Util::SPSCQueue<RakNet::Packet*>        mQueue;
+    boost::scoped_ptr<boost::thread>        mThread;
+    volatile bool                           mRunning;
+    bool                                    mThreaded;
+    PacketRecorder*                         mRecorder;
+    PacketReplay*                           mReplay;
+
+    /**
+    Settings for network stages.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mThreaded( true ),
+            mQueueSize( 4096 ),
+            mIdleSleepMS( 1 )
+        {
+        
+        }
+
+        bool            mThreaded;      ///< False to receive packets on the simulation thread.
+        unsigned int    mQueueSize;     ///< Maximum amount of packets waiting for the simulation.
+        unsigned int    mIdleSleepMS;   ///< Time the network thread sleeps when idle or blocked.
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static NetworkStage::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::NetworkStage::Settings, 
+    &Diversia::Shared::Bindings::CampBindings::bindNetworkStageSettings );
+
+#endif // DIVERSIA_SHARED_NETWORKSTAGE_H
@@ -0,0 +1,112 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Shared/Platform/StableHeaders.h"
+
+#include "Shared/Communication/PacketRecorder.h"
+
+#include <RakNet/GetTime.h>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+const char PacketRecorder::cMagic[4] = { 'D', 'V', 'P', 'C' };
+const unsigned int PacketRecorder::cVersion = 1;
+const unsigned char PacketRecorder::cTickEntry = 0;
+const unsigned char PacketRecorder::cPacketEntry = 1;
+
+PacketRecorder::PacketRecorder( const Path& rFile ):
+    mFile( rFile ),
+    mStream( rFile.file_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc ),
+    mLastTick( 0 ),
+    mPacketCount( 0 )
+{
+    if( !mStream.is_open() )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE, "Cannot open " + 
+            rFile.file_string() + " for writing.", "PacketRecorder::PacketRecorder" );
+    }
+
+    mStream.write( cMagic, sizeof( cMagic ) );
+    PacketRecorder::writeVarUInt( cVersion );
+}
+
+PacketRecorder::~PacketRecorder()
+{
+    mStream.close();
+}
+
+void PacketRecorder::tick()
+{
+    RakNet::Time now = RakNet::GetTime();
+
+    // The first tick holds the time the recording started so timestamps can be related to it.
+    mStream.put( (char)cTickEntry );
+    PacketRecorder::writeVarUInt( mLastTick ? now - mLastTick : now );
+    mLastTick = now;
+}
+
+void PacketRecorder::record( const RakNet::Packet& rPacket )
+{
+    // Packets that are received before the first tick belong to the first tick.
+    if( !mLastTick ) PacketRecorder::tick();
+
+    mStream.put( (char)cPacketEntry );
+
+    std::map<RakNet::RakNetGUID, unsigned int>::iterator i = mConnections.find( rPacket.guid );
+    if( i != mConnections.end() )
+    {
+        PacketRecorder::writeVarUInt( i->second );
+    }
+    else
+    {
+        // New connections get the next index, followed by their GUID and address.
+        unsigned int index = (unsigned int)mConnections.size();
+        mConnections.insert( std::make_pair( rPacket.guid, index ) );
+        PacketRecorder::writeVarUInt( index );
+        PacketRecorder::writeVarUInt( rPacket.guid.g );
+
+        String address = rPacket.systemAddress.ToString( true );
+        PacketRecorder::writeVarUInt( address.size() );
+        mStream.write( address.c_str(), address.size() );
+    }
+
+    PacketRecorder::writeVarUInt( rPacket.length );
+    mStream.write( (const char*)rPacket.data, rPacket.length );
+    ++mPacketCount;
+}
+
+void PacketRecorder::writeVarUInt( boost::uint64_t value )
+{
+    while( value >= 0x80 )
+    {
+        mStream.put( (char)( ( value & 0x7F ) | 0x80 ) );
+        value >>= 7;
+    }
+    mStream.put( (char)value );
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
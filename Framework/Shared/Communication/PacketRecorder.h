@@ -0,0 +1,112 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SHARED_PACKETRECORDER_H
+#define DIVERSIA_SHARED_PACKETRECORDER_H
+
+#include "Shared/Platform/Prerequisites.h"
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+/**
+Records the packets a network stage receives to a capture file so a session can be replayed 
+offline with PacketReplay. Packets are recorded before plugins process them, in the order and in
+the tick they were received in.
+
+The capture file starts with a header, followed by tick and packet entries. A tick entry holds the 
+milliseconds since the previous tick, the first tick holds the time the recording started. A 
+packet entry holds the index of the connection it came from, its length and its data, the GUID 
+and address of a connection are only written with its first packet. Integers are written as 
+variable length unsigned integers.
+
+The layout of a capture file is:
+- Header: the 4 bytes "DVPC", followed by the version (cVersion).
+- Tick entry: the byte cTickEntry, followed by the time.
+- Packet entry: the byte cPacketEntry, followed by the connection index. For the first packet of 
+  a connection the index is followed by RakNetGUID::g and the length and characters of the 
+  address as written by SystemAddress::ToString( true ) ("<ip>|<port>"). Then the length of the 
+  packet and the data of the packet follow.
+
+Variable length integers are written 7 bits at a time with the least significant group first, so
+the header and entries do not depend on byte order and hold values of up to 64 bits. The packet 
+data is stored as received and is not converted, it contains RakNet::Time timestamps and 
+bitstreams in the format of the build that recorded it. A capture can only be replayed by a build
+with the same RakNet::Time width, bitstream endian settings and replication protocol.
+**/
+class DIVERSIA_SHARED_API PacketRecorder : public boost::noncopyable
+{
+public:
+    /**
+    Constructor, opens the capture file.
+
+    @param  rFile   The capture file, it is overwritten.
+
+    @throws ERR_CANNOT_WRITE_TO_FILE when the file cannot be opened.
+    **/
+    PacketRecorder( const Path& rFile );
+    /**
+    Destructor, closes the capture file.
+    **/
+    ~PacketRecorder();
+
+    /**
+    Records the start of a tick, packets that are recorded after this were received in this tick.
+    **/
+    void tick();
+    /**
+    Records a received packet.
+    **/
+    void record( const RakNet::Packet& rPacket );
+    /**
+    Gets the capture file.
+    **/
+    inline const Path& getFile() const { return mFile; }
+    /**
+    Gets the amount of packets that were recorded.
+    **/
+    inline unsigned int getPacketCount() const { return mPacketCount; }
+
+    static const char           cMagic[4];
+    static const unsigned int   cVersion;
+
+    static const unsigned char  cTickEntry;
+    static const unsigned char  cPacketEntry;
+
+private:
+    void writeVarUInt( boost::uint64_t value );
+
+    Path                                        mFile;
+    std::ofstream                               mStream;
+    RakNet::Time                                mLastTick;
+    std::map<RakNet::RakNetGUID, unsigned int>  mConnections;
+    unsigned int                                mPacketCount;
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
+
+#endif // DIVERSIA_SHARED_PACKETRECORDER_H
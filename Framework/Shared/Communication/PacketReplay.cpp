@@ -0,0 +1,290 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Shared/Platform/StableHeaders.h"
+
+#include "Shared/Communication/PacketReplay.h"
+#include "Shared/Communication/PacketRecorder.h"
+#include "Shared/Camp/PropertySynchronization.h"
+#include "Util/Helper/TickScheduler.h"
+
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/BitStream.h>
+#include <RakNet/MessageIdentifiers.h>
+#include <RakNet/GetTime.h>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+PacketReplay::Settings PacketReplay::msSettings = PacketReplay::Settings();
+
+PacketReplay::PacketReplay( const Path& rFile, RakNet::RakPeerInterface& rRakPeer ):
+    mFile( rFile ),
+    mRakPeer( rRakPeer ),
+    mOffset( 0 ),
+    mInTick( false ),
+    mFinished( false ),
+    mRecordedTime( 0 ),
+    mRecordedStart( 0 ),
+    mStartUS( 0 ),
+    mEndUS( 0 ),
+    mPacketCount( 0 ),
+    mByteCount( 0 ),
+    mReplicaCount( 0 ),
+    mPropertyStart( PropertySynchronization::getDeserializedPropertyCount() ),
+    mPropertyEnd( 0 )
+{
+    std::ifstream file( rFile.file_string().c_str(), std::ios::in | std::ios::binary );
+    if( !file.is_open() )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot open " + rFile.file_string() + 
+            " for reading.", "PacketReplay::PacketReplay" );
+    }
+
+    mData.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+
+    if( mData.size() < sizeof( PacketRecorder::cMagic ) || !std::equal( 
+        PacketRecorder::cMagic, PacketRecorder::cMagic + sizeof( PacketRecorder::cMagic ), 
+        mData.begin() ) )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, rFile.file_string() + 
+            " is not a capture file.", "PacketReplay::PacketReplay" );
+    }
+    mOffset = sizeof( PacketRecorder::cMagic );
+
+    if( PacketReplay::readVarUInt() != PacketRecorder::cVersion )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, rFile.file_string() + 
+            " was recorded with another version.", "PacketReplay::PacketReplay" );
+    }
+
+    SLOGI << "Replaying " << mData.size() / 1024 << " KB of packets from " << 
+        rFile.file_string();
+}
+
+PacketReplay::~PacketReplay()
+{
+
+}
+
+void PacketReplay::tick()
+{
+    if( mFinished ) return;
+    if( !mStartUS ) mStartUS = TickScheduler::getMicroseconds();
+
+    // Packets of the current tick that were not received yet are received first.
+    if( mInTick && mOffset < mData.size() && mData[mOffset] != PacketRecorder::cTickEntry ) 
+        return;
+
+    mInTick = false;
+    if( mOffset >= mData.size() ) 
+    {
+        PacketReplay::finish();
+        return;
+    }
+
+    std::size_t offset = mOffset++;
+    bool first = mRecordedStart == 0;
+    RakNet::Time time = (RakNet::Time)PacketReplay::readVarUInt();
+    if( !first ) time += mRecordedTime;
+    RakNet::Time start = first ? time : mRecordedStart;
+
+    // Wait until the tick is due, ticks follow each other directly at maximum speed.
+    if( msSettings.mSpeed > 0 )
+    {
+        Real elapsed = ( TickScheduler::getMicroseconds() - mStartUS ) / 1000.0 * 
+            msSettings.mSpeed;
+        if( elapsed < time - start )
+        {
+            mOffset = offset;
+            return;
+        }
+    }
+
+    mRecordedStart = start;
+    mRecordedTime = time;
+    mInTick = true;
+}
+
+RakNet::Packet* PacketReplay::receive()
+{
+    if( !mInTick || mOffset >= mData.size() || 
+        mData[mOffset] != PacketRecorder::cPacketEntry ) 
+        return 0;
+    ++mOffset;
+
+    unsigned int index = (unsigned int)PacketReplay::readVarUInt();
+    if( index == mConnections.size() )
+    {
+        Connection connection;
+        connection.mGUID.g = PacketReplay::readVarUInt();
+
+        std::size_t size = (std::size_t)PacketReplay::readVarUInt();
+        PacketReplay::checkEnd( size );
+        String address( mData.begin() + mOffset, mData.begin() + mOffset + size );
+        connection.mAddress.FromString( address.c_str() );
+        mOffset += size;
+
+        mConnections.push_back( connection );
+    }
+    else if( index > mConnections.size() )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, mFile.file_string() + 
+            " is corrupt, unknown connection.", "PacketReplay::receive" );
+    }
+
+    unsigned int length = (unsigned int)PacketReplay::readVarUInt();
+    PacketReplay::checkEnd( length );
+
+    RakNet::Packet* packet = mRakPeer.AllocatePacket( length );
+    std::copy( mData.begin() + mOffset, mData.begin() + mOffset + length, packet->data );
+    mOffset += length;
+    packet->systemAddress = mConnections[index].mAddress;
+    packet->guid = mConnections[index].mGUID;
+    packet->bitSize = BYTES_TO_BITS( length );
+
+    // Move the timestamp to the time the packet is replayed at.
+    unsigned char id = packet->data[0];
+    if( id == ID_TIMESTAMP && length > sizeof( RakNet::MessageID ) + sizeof( RakNet::Time ) )
+    {
+        RakNet::BitStream stream( packet->data + sizeof( RakNet::MessageID ), 
+            sizeof( RakNet::Time ), false );
+        RakNet::Time time; stream.Read( time );
+        stream.SetWriteOffset( 0 );
+        stream.Write( time + ( RakNet::GetTime() - mRecordedTime ) );
+
+        id = packet->data[sizeof( RakNet::MessageID ) + sizeof( RakNet::Time )];
+    }
+
+    ++mPacketCount;
+    mByteCount += length;
+    if( id == ID_REPLICA_MANAGER_CONSTRUCTION || id == ID_REPLICA_MANAGER_SERIALIZE ) 
+        ++mReplicaCount;
+
+    return packet;
+}
+
+boost::uint64_t PacketReplay::getPropertyCount() const
+{
+    boost::uint64_t end = mFinished ? mPropertyEnd : 
+        PropertySynchronization::getDeserializedPropertyCount();
+    return end - mPropertyStart;
+}
+
+Real PacketReplay::getElapsedTime() const
+{
+    if( !mStartUS ) return 0;
+
+    boost::uint64_t end = mFinished ? mEndUS : TickScheduler::getMicroseconds();
+    return ( end - mStartUS ) / 1000000.0;
+}
+
+String PacketReplay::getReport() const
+{
+    Real seconds = PacketReplay::getElapsedTime();
+    boost::uint64_t properties = PacketReplay::getPropertyCount();
+
+    std::stringstream ss;
+    ss << "Replayed " << mPacketCount << " packets (" << mByteCount / 1024 << " KB) from " << 
+        mFile.file_string() << " in " << seconds << " seconds";
+    if( seconds > 0 )
+    {
+        ss << ", " << mPacketCount / seconds << " packets/s, " << mReplicaCount / seconds << 
+            " replicas/s, " << properties / seconds << " properties/s";
+    }
+
+    return ss.str();
+}
+
+void PacketReplay::writeCSV( const Path& rFile ) const
+{
+    bool empty = !boost::filesystem::exists( rFile ) || boost::filesystem::is_empty( rFile );
+    std::ofstream file( rFile.file_string().c_str(), std::ios::out | std::ios::app );
+    if( !file.is_open() )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE, "Cannot open " + 
+            rFile.file_string() + " for writing.", "PacketReplay::writeCSV" );
+    }
+
+    if( empty )
+    {
+        file << "File,Packets,Bytes,Replicas,Properties,Seconds,PacketsPerSecond," 
+            "ReplicasPerSecond,PropertiesPerSecond" << std::endl;
+    }
+
+    Real seconds = PacketReplay::getElapsedTime();
+    boost::uint64_t properties = PacketReplay::getPropertyCount();
+    file << mFile.file_string() << "," << mPacketCount << "," << mByteCount << "," << 
+        mReplicaCount << "," << properties << "," << seconds << "," << 
+        ( seconds > 0 ? mPacketCount / seconds : 0 ) << "," << 
+        ( seconds > 0 ? mReplicaCount / seconds : 0 ) << "," << 
+        ( seconds > 0 ? properties / seconds : 0 ) << std::endl;
+}
+
+boost::uint64_t PacketReplay::readVarUInt()
+{
+    boost::uint64_t value = 0;
+    for( unsigned int shift = 0; shift < 64; shift += 7 )
+    {
+        PacketReplay::checkEnd( 1 );
+        unsigned char byte = mData[mOffset++];
+        value |= (boost::uint64_t)( byte & 0x7F ) << shift;
+        if( !( byte & 0x80 ) ) return value;
+    }
+
+    DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, mFile.file_string() + 
+        " is corrupt, invalid integer.", "PacketReplay::readVarUInt" );
+}
+
+void PacketReplay::checkEnd( std::size_t size )
+{
+    if( mOffset + size > mData.size() )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, mFile.file_string() + 
+            " is corrupt, unexpected end of file.", "PacketReplay::checkEnd" );
+    }
+}
+
+void PacketReplay::finish()
+{
+    mFinished = true;
+    mEndUS = TickScheduler::getMicroseconds();
+    mPropertyEnd = PropertySynchronization::getDeserializedPropertyCount();
+
+    SLOGI << PacketReplay::getReport();
+
+    if( msSettings.mReportFile.empty() ) return;
+    try
+    {
+        PacketReplay::writeCSV( msSettings.mReportFile );
+    }
+    catch( Exception e )
+    {
+        SLOGW << "Could not write replay report: " << e.what();
+    }
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
@@ -0,0 +1,172 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SHARED_PACKETREPLAY_H
+#define DIVERSIA_SHARED_PACKETREPLAY_H
+
+#include "Shared/Platform/Prerequisites.h"
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+/**
+Replays a capture file that was recorded with PacketRecorder. A network stage with a replay 
+receives its packets from the replay instead of its RakPeer, so they go through the plugins, the 
+replica manager and property synchronization exactly like the recorded packets did. 
+
+Packets are replayed in the tick they were recorded in, either at the recorded speed or as fast 
+as possible. Timestamps in packets are moved to the time they are replayed at. When the replay
+has finished the throughput is logged as "Replayed <packets> packets (<KB> KB) from <file> in 
+<seconds> seconds, <packets/s> packets/s, <replicas/s> replicas/s, <properties/s> properties/s",
+and appended to the report file if one is set, so deserialization performance can be measured 
+against real traffic and compared between builds.
+**/
+class DIVERSIA_SHARED_API PacketReplay : public boost::noncopyable
+{
+public:
+    /**
+    Constructor, reads the capture file.
+
+    @param  rFile               The capture file.
+    @param [in,out] rRakPeer    The RakPeer to allocate packets with.
+
+    @throws ERR_FILE_NOT_FOUND when the file cannot be opened.
+    @throws ERR_INVALIDPARAMS when the file is not a capture file.
+    **/
+    PacketReplay( const Path& rFile, RakNet::RakPeerInterface& rRakPeer );
+    /**
+    Destructor.
+    **/
+    ~PacketReplay();
+
+    /**
+    Starts the next recorded tick when it is due, call this once per tick before receiving 
+    packets.
+    **/
+    void tick();
+    /**
+    Gets the next packet of the current tick.
+
+    @return The packet, deallocate it with RakPeerInterface::DeallocatePacket. 0 if there are no 
+            more packets in this tick.
+    **/
+    RakNet::Packet* receive();
+    /**
+    Query if all packets have been replayed.
+    **/
+    inline bool isFinished() const { return mFinished; }
+    /**
+    Gets the amount of packets that were replayed.
+    **/
+    inline unsigned int getPacketCount() const { return mPacketCount; }
+    /**
+    Gets the amount of replica construction and serialization messages that were replayed.
+    **/
+    inline unsigned int getReplicaCount() const { return mReplicaCount; }
+    /**
+    Gets the amount of properties and function calls that were deserialized during the replay.
+    **/
+    boost::uint64_t getPropertyCount() const;
+    /**
+    Gets the time the replay has been running, in seconds.
+    **/
+    Real getElapsedTime() const;
+    /**
+    Gets a readable report of the replay throughput.
+    **/
+    String getReport() const;
+    /**
+    Appends the replay throughput as a row to a CSV file, the column names are written first if
+    the file is empty.
+
+    @param  rFile   The file to append to.
+
+    @throws ERR_CANNOT_WRITE_TO_FILE when the file cannot be opened.
+    **/
+    void writeCSV( const Path& rFile ) const;
+
+private:
+    struct Connection
+    {
+        RakNet::RakNetGUID      mGUID;
+        RakNet::SystemAddress   mAddress;
+    };
+
+    boost::uint64_t readVarUInt();
+    void checkEnd( std::size_t size );
+    void finish();
+
+    Path                        mFile;
+    RakNet::RakPeerInterface&   mRakPeer;
+    std::vector<unsigned char>  mData;
+    std::size_t                 mOffset;
+    std::vector<Connection>     mConnections;
+
+    bool                        mInTick;
+    bool                        mFinished;
+    RakNet::Time                mRecordedTime;  ///< Recorded time of the current tick.
+    RakNet::Time                mRecordedStart;
+    boost::uint64_t             mStartUS;
+    boost::uint64_t             mEndUS;
+
+    unsigned int                mPacketCount;
+    boost::uint64_t             mByteCount;
+    unsigned int                mReplicaCount;
+    boost::uint64_t             mPropertyStart;
+    boost::uint64_t             mPropertyEnd;
+
+    /**
+    Settings for packet replays.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mSpeed( 1 ),
+            mQuitWhenFinished( true ),
+            mReportFile( "" )
+        {
+        
+        }
+
+        Real    mSpeed;             ///< Speed relative to the recording, 0 is as fast as possible.
+        bool    mQuitWhenFinished;  ///< Shuts a headless server down when the replay finished.
+        Path    mReportFile;        ///< CSV file to append the throughput to, empty to disable.
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static PacketReplay::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::PacketReplay::Settings, 
+    &Diversia::Shared::Bindings::CampBindings::bindPacketReplaySettings );
+
+#endif // DIVERSIA_SHARED_PACKETREPLAY_H
@@ -31,16 +31,20 @@ THE SOFTWARE.
 #include "Object/ObjectManager.h"
 #include "Object/Object.h"
 #include "Object/Component.h"
+#include "Object/DirtyReplicas.h"
 
 namespace Diversia
 {
 //------------------------------------------------------------------------------
 
 ReplicaConnection::ReplicaConnection( RakNet::SystemAddress systemAddress, RakNet::RakNetGUID guid, 
-    ObjectManager* pObjectManager, PluginManager& rPluginManager ):
+    ObjectManager* pObjectManager, PluginManager& rPluginManager, Mode mode, 
+    RakNet::ReplicaManager3& rReplicaManager ):
     Connection_RM3( systemAddress, guid ),
     mObjectManager( pObjectManager ),
-    mPluginManager( rPluginManager )
+    mPluginManager( rPluginManager ),
+    mReplicaManager( rReplicaManager ),
+    mWorldSnapshot( *this, mode )
 {
 
 }
@@ -135,5 +139,23 @@ RakNet::Replica3* ReplicaConnection::AllocReplica( RakNet::BitStream* pAllocatio
     return 0;
 }
 
+bool ReplicaConnection::QuerySerializationList( 
+    DataStructures::List<RakNet::Replica3*>& rReplicasToSerialize )
+{
+    if( !DirtyReplicas::isEnabled() ) return false;
+
+    const std::set<RakNet::Replica3*>& replicas = DirtyReplicas::query( mReplicaManager );
+    for( std::set<RakNet::Replica3*>::const_iterator i = replicas.begin(); i != replicas.end(); 
+        ++i )
+    {
+        if( !Connection_RM3::HasReplicaConstructed( *i ) ) continue;
+
+        if( (*i)->QuerySerialization( this ) == RakNet::RM3QSR_CALL_SERIALIZE )
+            rReplicasToSerialize.Push( *i, _FILE_AND_LINE_ );
+    }
+
+    return true;
+}
+
 //------------------------------------------------------------------------------
 } // Namespace Diversia
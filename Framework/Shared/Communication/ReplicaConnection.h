@@ -27,6 +27,8 @@ THE SOFTWARE.
 
 #include "Shared/Platform/Prerequisites.h"
 
+#include "Shared/Communication/WorldSnapshot.h"
+
 namespace Diversia
 {
 //------------------------------------------------------------------------------
@@ -35,16 +37,30 @@ class DIVERSIA_SHARED_API ReplicaConnection : public RakNet::Connection_RM3
 {
 public:
     ReplicaConnection( RakNet::SystemAddress systemAddress, RakNet::RakNetGUID guid, 
-        ObjectManager* pObjectManager, PluginManager& rPluginManager );
+        ObjectManager* pObjectManager, PluginManager& rPluginManager, Mode mode, 
+        RakNet::ReplicaManager3& rReplicaManager );
 
     RakNet::Replica3* AllocReplica( RakNet::BitStream* pAllocationIdBitstream, 
         RakNet::ReplicaManager3* pReplicaManager3 );
+    /**
+    Gets the replicas that must be serialized to this connection, only dirty replicas are
+    queried instead of every replica.
+    
+    @param [in,out] rReplicasToSerialize    The replicas to serialize.
+    
+    @return False to let the replica manager query every replica.
+    **/
+    bool QuerySerializationList( DataStructures::List<RakNet::Replica3*>& rReplicasToSerialize );
 
     inline void setObjectManager( ObjectManager& rObjectManager ) { mObjectManager = &rObjectManager; }
+    inline bool hasObjectManager() const { return mObjectManager != 0; }
+    inline WorldSnapshot& getWorldSnapshot() { return mWorldSnapshot; }
 
 private:
     ObjectManager*              mObjectManager;
     PluginManager&  mPluginManager;
+    RakNet::ReplicaManager3&    mReplicaManager;
+    WorldSnapshot               mWorldSnapshot;
 };
 
 //------------------------------------------------------------------------------
@@ -29,6 +29,7 @@ THE SOFTWARE.
 
 #include "Shared/Communication/ReplicaConnection.h"
 #include "Shared/Plugin/PluginManager.h"
+#include "Object/DirtyReplicas.h"
 
 namespace Diversia
 {
@@ -64,17 +65,85 @@ public:
     {
         DivAssert( mPluginManager, "PluginManager not set." );
         return new ReplicaConnection( systemAddress, guid, mObjectManager, 
-            *mPluginManager );
+            *mPluginManager, mPluginManager->getMode(), 
+            const_cast<ReplicaManager&>( *this ) );
     }
     void DeallocConnection( RakNet::Connection_RM3* pConnection ) const 
     {
         delete pConnection;
     }
 
+    /**
+    Connects a slot to the world snapshot progress signal, emitted on the client when a part of
+    the world snapshot of a connection is received.
+    
+    @param [in,out] rSlot   The slot (signature: void func(unsigned int [received bytes], 
+                            unsigned int [total bytes])) to connect. 
+    
+    @return Connection object to block or disconnect the connection.
+    **/
+    inline sigc::connection connectSnapshotProgress( 
+        const sigc::slot<void, unsigned int, unsigned int>& rSlot ) 
+    {
+        return mSnapshotProgressSignal.connect( rSlot );
+    }
+
+protected:
+    void Update()
+    {
+        for( DataStructures::DefaultIndexType i = 0; i < ReplicaManager3::GetConnectionCount();
+            ++i )
+        {
+            static_cast<ReplicaConnection*>( ReplicaManager3::GetConnectionAtIndex( i ) 
+                )->getWorldSnapshot().update( *this );
+        }
+
+        // Connections only query serialization of replicas that changed since the last 
+        // serialization tick.
+        DirtyReplicas::beginUpdate( *this );
+        ReplicaManager3::Update();
+        DirtyReplicas::endUpdate( *this );
+
+        // Construction of replicas is queried in the update, end capturing world snapshots.
+        for( DataStructures::DefaultIndexType i = 0; i < ReplicaManager3::GetConnectionCount();
+            ++i )
+        {
+            static_cast<ReplicaConnection*>( ReplicaManager3::GetConnectionAtIndex( i ) 
+                )->getWorldSnapshot().postUpdate();
+        }
+    }
+
+    RakNet::PluginReceiveResult OnReceive( RakNet::Packet* pPacket )
+    {
+        if( pPacket->data[0] < ID_WORLD_SNAPSHOT_CHUNK || 
+            pPacket->data[0] > ID_WORLD_SNAPSHOT_CANCEL )
+        {
+            return ReplicaManager3::OnReceive( pPacket );
+        }
+
+        for( DataStructures::DefaultIndexType i = 0; i < ReplicaManager3::GetConnectionCount();
+            ++i )
+        {
+            ReplicaConnection* connection = static_cast<ReplicaConnection*>( 
+                ReplicaManager3::GetConnectionAtIndex( i ) );
+            if( connection->GetRakNetGUID() != pPacket->guid ) continue;
+
+            WorldSnapshot& snapshot = connection->getWorldSnapshot();
+            snapshot.receive( *pPacket, *this );
+            if( pPacket->data[0] == ID_WORLD_SNAPSHOT_CHUNK )
+                mSnapshotProgressSignal( snapshot.getReceivedBytes(), snapshot.getTotalBytes() );
+            break;
+        }
+
+        return RakNet::RR_STOP_PROCESSING_AND_DEALLOCATE;
+    }
+
 private:
     ObjectManager*              mObjectManager;
     PluginManager*  mPluginManager;
 
+    sigc::signal<void, unsigned int, unsigned int> mSnapshotProgressSignal;
+
 };
 
 //------------------------------------------------------------------------------
@@ -32,11 +32,26 @@ namespace Diversia
 {
 //------------------------------------------------------------------------------
 
+ServerNeighbors::ServerNeighbors():
+    mVersion( 0 )
+{
+
+}
+
+ServerNeighbors& ServerNeighbors::operator=( const ServerNeighbors& rhs )
+{
+    mNeighbors = rhs.mNeighbors;
+    ++mVersion;
+
+    return *this;
+}
+
 void ServerNeighbors::addServer( Direction direction, const ServerInfo& rServerInfo )
 {
     if( !hasServer( direction ) )
     {
         mNeighbors.insert( std::make_pair( direction, rServerInfo ) );
+        ++mVersion;
     }
     else
         DIVERSIA_EXCEPT( Exception::ERR_DUPLICATE_ITEM, "Neighbor server already exists.", 
@@ -47,6 +62,7 @@ ServerInfo& ServerNeighbors::getServer( Direction direction )
 {
     if( hasServer( direction ) )
     {
+        ++mVersion;
         return mNeighbors.find( direction )->second;
     }
     else
@@ -64,6 +80,7 @@ void ServerNeighbors::removeServer( Direction direction )
     if( hasServer( direction ) )
     {
         mNeighbors.erase( direction );
+        ++mVersion;
     }
     else
         DIVERSIA_EXCEPT( Exception::ERR_ITEM_NOT_FOUND, "Neighbor server does not exist.", 
@@ -73,6 +90,7 @@ void ServerNeighbors::removeServer( Direction direction )
 void ServerNeighbors::clear()
 {
     mNeighbors.clear();
+    ++mVersion;
 }
 
 //------------------------------------------------------------------------------
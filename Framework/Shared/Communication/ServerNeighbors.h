@@ -42,6 +42,15 @@ typedef std::map<Direction, ServerInfo> NeighborsMap;
 class DIVERSIA_SHARED_API ServerNeighbors
 {
 public:
+    /**
+    Default constructor.
+    **/
+    ServerNeighbors();
+    /**
+    Assignment operator, counts as a change of all neighbors.
+    **/
+    ServerNeighbors& operator=( const ServerNeighbors& rhs );
+
     /**
     Adds a neighbor server. 
     
@@ -50,7 +59,7 @@ public:
     **/
     void addServer( Direction direction, const ServerInfo& rServerInfo );
     /**
-    Gets a server. 
+    Gets a server. The returned server info may be modified, so this counts as a change.
 
     @param  direction   The direction of the server. 
     **/
@@ -77,6 +86,15 @@ public:
     Removes all neighbors.
     **/
     void clear();
+    /**
+    Gets the version of the neighbors, which is incremented every time the neighbors (may) have
+    changed. Compare versions to skip serializing unchanged neighbors.
+    **/
+    inline unsigned int getVersion() const { return mVersion; }
+    /**
+    Applies changes written with writeMapDelta to the neighbors.
+    **/
+    inline void readDelta( RakNet::BitStream& in ) { readMapDelta( in, mNeighbors ); ++mVersion; }
 
     /**
     Read from a RakNet bitstream.
@@ -102,6 +120,7 @@ private:
     friend class Shared::Bindings::CampBindings;    ///< Allow private access for camp bindings.
 
     NeighborsMap mNeighbors;
+    unsigned int mVersion;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,264 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Shared/Platform/StableHeaders.h"
+
+#include "Shared/Communication/TrafficStatistics.h"
+
+#include <RakNet/GetTime.h>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+TrafficStatistics::Settings TrafficStatistics::msSettings = TrafficStatistics::Settings();
+TrafficStatistics::Counters TrafficStatistics::msCounters = TrafficStatistics::Counters();
+RakNet::Time TrafficStatistics::msLastDump = 0;
+const unsigned int TrafficStatistics::cWindowSeconds = 10;
+
+void TrafficStatistics::record( RakNet::RakNetGUID connection, unsigned char replicaType, 
+    const String& rClass, const String& rName, RakNet::BitSize_t bits )
+{
+    if( !msSettings.mEnabled ) return;
+
+    Key key;
+    key.mConnection = connection;
+    key.mReplicaType = replicaType;
+    key.mClass = rClass;
+    key.mName = rName;
+
+    msCounters[key].add( bits, RakNet::GetTime() / 1000 );
+}
+
+void TrafficStatistics::record( RakNet::Replica3& rReplica, unsigned char replicaType, 
+    const String& rClass, const String& rName, RakNet::BitSize_t bits )
+{
+    if( !msSettings.mEnabled || !rReplica.replicaManager ) return;
+
+    RakNet::ReplicaManager3& replicaManager = *rReplica.replicaManager;
+    for( DataStructures::DefaultIndexType i = 0; i < replicaManager.GetConnectionCount(); ++i )
+    {
+        RakNet::Connection_RM3* connection = replicaManager.GetConnectionAtIndex( i );
+        if( connection->HasReplicaConstructed( &rReplica ) )
+        {
+            TrafficStatistics::record( connection->GetRakNetGUID(), replicaType, rClass, rName, 
+                bits );
+        }
+    }
+}
+
+void TrafficStatistics::update()
+{
+    if( !msSettings.mEnabled || !msSettings.mDumpInterval ) return;
+
+    RakNet::Time time = RakNet::GetTime();
+    if( !msLastDump ) msLastDump = time;
+    if( time - msLastDump < msSettings.mDumpInterval * 1000 ) return;
+    msLastDump = time;
+
+    try
+    {
+        TrafficStatistics::writeCSV( msSettings.mDumpFile );
+    }
+    catch( Exception e )
+    {
+        SLOGW << "Could not dump traffic statistics: " << e.what();
+    }
+
+    if( msSettings.mLogCount ) SLOGI << TrafficStatistics::getReport( msSettings.mLogCount );
+}
+
+void TrafficStatistics::reset()
+{
+    msCounters.clear();
+}
+
+String TrafficStatistics::getReport( unsigned int count /*= 10*/ )
+{
+    RakNet::Time second = RakNet::GetTime() / 1000;
+
+    // Sum the rolling window per connection, replica type, class and name. Entries without a 
+    // name account for whole replicas, so connections, replica types and classes are summed 
+    // from those only.
+    std::map<String, boost::uint64_t> connections;
+    std::map<String, boost::uint64_t> replicaTypes;
+    std::map<String, boost::uint64_t> classes;
+    std::map<String, boost::uint64_t> names;
+    std::map<String, unsigned int> messages;
+    for( Counters::const_iterator i = msCounters.begin(); i != msCounters.end(); ++i )
+    {
+        boost::uint64_t bytes; unsigned int windowMessages;
+        i->second.getWindow( second, bytes, windowMessages );
+        if( !bytes ) continue;
+
+        if( i->first.mName.empty() )
+        {
+            connections[i->first.mConnection.ToString()] += bytes;
+            replicaTypes[TrafficStatistics::getReplicaTypeName( i->first.mReplicaType )] += bytes;
+            classes[i->first.mClass] += bytes;
+            messages[i->first.mClass] += windowMessages;
+        }
+        else
+            names[i->first.mClass + "." + i->first.mName] += bytes;
+    }
+
+    std::stringstream ss;
+    ss << "Replication traffic over the last " << cWindowSeconds << " seconds (bytes/s):";
+
+    ss << std::endl << "Connections:";
+    for( std::map<String, boost::uint64_t>::iterator i = connections.begin(); 
+        i != connections.end(); ++i )
+    {
+        ss << std::endl << "  " << i->first << ": " << i->second / cWindowSeconds;
+    }
+
+    ss << std::endl << "Replica types:";
+    for( std::map<String, boost::uint64_t>::iterator i = replicaTypes.begin(); 
+        i != replicaTypes.end(); ++i )
+    {
+        ss << std::endl << "  " << i->first << ": " << i->second / cWindowSeconds;
+    }
+
+    // Sort classes and names by traffic, heaviest first.
+    std::vector<std::pair<boost::uint64_t, String> > sorted;
+    for( std::map<String, boost::uint64_t>::iterator i = classes.begin(); i != classes.end(); 
+        ++i )
+    {
+        sorted.push_back( std::make_pair( i->second, i->first ) );
+    }
+    std::sort( sorted.rbegin(), sorted.rend() );
+    ss << std::endl << "Classes:";
+    for( std::size_t i = 0; i < sorted.size() && i < count; ++i )
+    {
+        ss << std::endl << "  " << sorted[i].second << ": " << sorted[i].first / cWindowSeconds << 
+            " (" << messages[sorted[i].second] / (Real)cWindowSeconds << " messages/s)";
+    }
+
+    sorted.clear();
+    for( std::map<String, boost::uint64_t>::iterator i = names.begin(); i != names.end(); ++i )
+    {
+        sorted.push_back( std::make_pair( i->second, i->first ) );
+    }
+    std::sort( sorted.rbegin(), sorted.rend() );
+    ss << std::endl << "Properties and functions:";
+    for( std::size_t i = 0; i < sorted.size() && i < count; ++i )
+    {
+        ss << std::endl << "  " << sorted[i].second << ": " << sorted[i].first / cWindowSeconds;
+    }
+
+    return ss.str();
+}
+
+void TrafficStatistics::writeCSV( const Path& rFile )
+{
+    std::ofstream file( rFile.file_string().c_str() );
+    if( !file.is_open() )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE, "Cannot open " + 
+            rFile.file_string() + " for writing.", "TrafficStatistics::writeCSV" );
+    }
+
+    RakNet::Time second = RakNet::GetTime() / 1000;
+
+    file << "Connection,ReplicaType,Class,Name,TotalBytes,TotalMessages,WindowBytesPerSecond," 
+        "WindowMessagesPerSecond" << std::endl;
+    for( Counters::const_iterator i = msCounters.begin(); i != msCounters.end(); ++i )
+    {
+        boost::uint64_t bytes; unsigned int messages;
+        i->second.getWindow( second, bytes, messages );
+
+        file << i->first.mConnection.ToString() << "," << 
+            TrafficStatistics::getReplicaTypeName( i->first.mReplicaType ) << "," << 
+            i->first.mClass << "," << i->first.mName << "," << 
+            ( i->second.mTotalBits + 7 ) / 8 << "," << i->second.mTotalMessages << "," << 
+            bytes / cWindowSeconds << "," << messages / (Real)cWindowSeconds << std::endl;
+    }
+}
+
+String TrafficStatistics::getReplicaTypeName( unsigned char replicaType )
+{
+    switch( replicaType )
+    {
+        case REPLICATYPE_OBJECT: return "Object";
+        case REPLICATYPE_COMPONENT: return "Component";
+        case REPLICATYPE_PLUGIN: return "Plugin";
+        case REPLICATYPE_OBJECTTEMPLATE: return "ObjectTemplate";
+        case REPLICATYPE_COMPONENTTEMPLATE: return "ComponentTemplate";
+        default: return "Unknown";
+    }
+}
+
+bool TrafficStatistics::Key::operator<( const Key& rKey ) const
+{
+    if( mConnection != rKey.mConnection ) return mConnection < rKey.mConnection;
+    if( mReplicaType != rKey.mReplicaType ) return mReplicaType < rKey.mReplicaType;
+    if( mClass != rKey.mClass ) return mClass < rKey.mClass;
+    return mName < rKey.mName;
+}
+
+TrafficStatistics::Counter::Counter():
+    mTotalBits( 0 ),
+    mTotalMessages( 0 ),
+    mWindowBits( cWindowSeconds, 0 ),
+    mWindowMessages( cWindowSeconds, 0 ),
+    mWindowSeconds( cWindowSeconds, 0 )
+{
+
+}
+
+void TrafficStatistics::Counter::add( RakNet::BitSize_t bits, RakNet::Time second )
+{
+    mTotalBits += bits;
+    ++mTotalMessages;
+
+    // Each second has its own slot in the window, a slot is reused when it is a full window old.
+    std::size_t slot = (std::size_t)( second % cWindowSeconds );
+    if( mWindowSeconds[slot] != second )
+    {
+        mWindowSeconds[slot] = second;
+        mWindowBits[slot] = 0;
+        mWindowMessages[slot] = 0;
+    }
+    mWindowBits[slot] += bits;
+    ++mWindowMessages[slot];
+}
+
+void TrafficStatistics::Counter::getWindow( RakNet::Time second, boost::uint64_t& rBytes, 
+    unsigned int& rMessages ) const
+{
+    boost::uint64_t bits = 0;
+    rMessages = 0;
+    for( std::size_t i = 0; i < cWindowSeconds; ++i )
+    {
+        if( mWindowSeconds[i] + cWindowSeconds > second )
+        {
+            bits += mWindowBits[i];
+            rMessages += mWindowMessages[i];
+        }
+    }
+    rBytes = ( bits + 7 ) / 8;
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
@@ -0,0 +1,166 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SHARED_TRAFFICSTATISTICS_H
+#define DIVERSIA_SHARED_TRAFFICSTATISTICS_H
+
+#include "Shared/Platform/Prerequisites.h"
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+/**
+Accounts the replication traffic that is serialized, per connection, replica type, class and 
+property or function name. Each entry counts bytes and messages in total and over a rolling 
+window of the last cWindowSeconds seconds.
+
+Replicas record one entry with an empty name for the whole serialization and one entry per 
+property, function or part of the replica that was written. Serializations that are sent
+identically to all connections are recorded once for every connection the replica is constructed
+on, so the statistics of a connection contain all bytes that are sent to it.
+
+Recording is disabled by default because it costs a map lookup per written property, enable it
+with the settings.
+**/
+class DIVERSIA_SHARED_API TrafficStatistics
+{
+public:
+    /**
+    Records serialized traffic if recording is enabled.
+
+    @param  connection  The GUID of the destination connection.
+    @param  replicaType The replica type (REPLICATYPE_*).
+    @param  rClass      The class name of the replica.
+    @param  rName       The name of the property or function, empty for the whole replica.
+    @param  bits        The amount of bits written.
+    **/
+    static void record( RakNet::RakNetGUID connection, unsigned char replicaType, 
+        const String& rClass, const String& rName, RakNet::BitSize_t bits );
+    /**
+    Records a serialization that is sent identically to all connections, once for every 
+    connection the replica is constructed on, if recording is enabled.
+
+    @param  rReplica    The replica that was serialized.
+    @param  replicaType The replica type (REPLICATYPE_*).
+    @param  rClass      The class name of the replica.
+    @param  rName       The name of the property or function, empty for the whole replica.
+    @param  bits        The amount of bits written.
+    **/
+    static void record( RakNet::Replica3& rReplica, unsigned char replicaType, 
+        const String& rClass, const String& rName, RakNet::BitSize_t bits );
+    /**
+    Writes the statistics to the dump file and the log when the dump interval has passed. 
+    **/
+    static void update();
+    /**
+    Removes all recorded statistics.
+    **/
+    static void reset();
+    /**
+    Gets a readable report of the traffic over the rolling window, per connection, per replica 
+    type and the heaviest classes and properties.
+
+    @param  count   The maximum number of classes and properties to list.
+    **/
+    static String getReport( unsigned int count = 10 );
+    /**
+    Writes all recorded statistics to a CSV file, one row per entry.
+
+    @param  rFile   The file to write to, it is overwritten.
+    **/
+    static void writeCSV( const Path& rFile );
+    /**
+    Gets a readable name for a replica type.
+    **/
+    static String getReplicaTypeName( unsigned char replicaType );
+
+    static const unsigned int cWindowSeconds;
+
+private:
+    struct Key
+    {
+        RakNet::RakNetGUID  mConnection;
+        unsigned char       mReplicaType;
+        String              mClass;
+        String              mName;
+
+        bool operator<( const Key& rKey ) const;
+    };
+
+    struct Counter
+    {
+        Counter();
+
+        void add( RakNet::BitSize_t bits, RakNet::Time second );
+        void getWindow( RakNet::Time second, boost::uint64_t& rBytes, 
+            unsigned int& rMessages ) const;
+
+        boost::uint64_t                 mTotalBits;
+        unsigned int                    mTotalMessages;
+        std::vector<RakNet::BitSize_t>  mWindowBits;
+        std::vector<unsigned int>       mWindowMessages;
+        std::vector<RakNet::Time>       mWindowSeconds;
+    };
+
+    typedef std::map<Key, Counter> Counters;
+
+    static Counters     msCounters;
+    static RakNet::Time msLastDump;
+
+    /**
+    Settings for traffic statistics.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mEnabled( false ),
+            mDumpInterval( 0 ),
+            mDumpFile( "traffic.csv" ),
+            mLogCount( 10 )
+        {
+        
+        }
+
+        bool            mEnabled;
+        unsigned int    mDumpInterval;  ///< Seconds between dumps, 0 disables dumping.
+        Path            mDumpFile;
+        unsigned int    mLogCount;      ///< Entries to log per dump, 0 disables logging.
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static TrafficStatistics::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::TrafficStatistics::Settings, 
+    &Diversia::Shared::Bindings::CampBindings::bindTrafficStatisticsSettings );
+
+#endif // DIVERSIA_SHARED_TRAFFICSTATISTICS_H
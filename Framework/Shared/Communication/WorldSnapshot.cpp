@@ -0,0 +1,587 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Shared/Platform/StableHeaders.h"
+
+#include "Shared/Communication/WorldSnapshot.h"
+#include "Shared/Communication/ReplicaConnection.h"
+
+#include <RakNet/GetTime.h>
+#include <RakNet/RakPeerInterface.h>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+WorldSnapshot::Settings WorldSnapshot::msSettings = WorldSnapshot::Settings();
+
+WorldSnapshot::WorldSnapshot( ReplicaConnection& rConnection, Mode mode ):
+    mConnection( rConnection ),
+    mMode( mode ),
+    mState( mode == SERVER && msSettings.mEnabled ? CAPTURING : NONE ),
+    mProbing( false ),
+    mTotal( 0 ),
+    mReceived( 0 ),
+    mSent( 0 ),
+    mLastProgress( 0 )
+{
+
+}
+
+RakNet::RM3ConstructionState WorldSnapshot::queryConstruction( RakNet::Replica3& rReplica, 
+    RakNet::RM3ConstructionState state, RakNet::ReplicaManager3& rReplicaManager )
+{
+    // Replicas created by the remote system already exist there.
+    if( mMode == SERVER && state == RakNet::RM3CS_SEND_CONSTRUCTION && 
+        rReplica.creatingSystemGUID != mConnection.GetRakNetGUID() )
+    {
+        if( mState == CAPTURING && WorldSnapshot::capture( rReplica ) ) 
+            return RakNet::RM3CS_NO_ACTION;
+        // Wait with construction until the client has applied the snapshot.
+        else if( mState == STREAMING ) 
+            return RakNet::RM3CS_NO_ACTION;
+    }
+
+    if( state != RakNet::RM3CS_SEND_CONSTRUCTION && state != RakNet::RM3CS_NEVER_CONSTRUCT )
+        return state;
+
+    std::set<RakNet::NetworkID>::iterator i = mExisting.find( rReplica.GetNetworkID() );
+    if( i == mExisting.end() ) return state;
+
+    // The replica manager only queries replicas that are not constructed yet, replicas that are
+    // destroyed on the remote system later on must be constructed again.
+    if( !mProbing ) mExisting.erase( i );
+    return RakNet::RM3CS_ALREADY_EXISTS_REMOTELY;
+}
+
+void WorldSnapshot::update( RakNet::ReplicaManager3& rReplicaManager )
+{
+    if( mState != STREAMING ) return;
+
+    if( mMode == SERVER )
+    {
+        // Fall back to constructing replicas per replica if the client stopped acknowledging or
+        // never reports that the snapshot has been applied.
+        if( msSettings.mTimeoutMS && 
+            RakNet::GetTime() - mLastProgress > msSettings.mTimeoutMS )
+        {
+            WorldSnapshot::cancel( rReplicaManager );
+            return;
+        }
+
+        // Send chunks while the amount of unacknowledged bytes fits in the window.
+        unsigned int chunkSize = std::max( msSettings.mChunkSize, 1u );
+        while( mSent < mTotal && mSent - mReceived < msSettings.mWindowSize )
+        {
+            unsigned int size = std::min( chunkSize, mTotal - mSent );
+
+            RakNet::BitStream stream;
+            stream.Write( (RakNet::MessageID)ID_WORLD_SNAPSHOT_CHUNK );
+            stream.WriteCompressed( mTotal );
+            stream.WriteCompressed( mSent );
+            stream.AlignWriteToByteBoundary();
+            stream.Write( (const char*)&mData[mSent], size );
+            WorldSnapshot::send( stream, rReplicaManager );
+
+            mSent += size;
+        }
+    }
+    else if( mReceived == mTotal && mConnection.hasObjectManager() )
+    {
+        // Objects can only be created when the object manager plugin has been constructed.
+        WorldSnapshot::apply( rReplicaManager );
+    }
+}
+
+void WorldSnapshot::postUpdate()
+{
+    // The replica manager queries the construction of all replicas at once, so everything that 
+    // is relevant has been captured as soon as anything has been captured.
+    if( mState == CAPTURING && !mEntries.empty() )
+    {
+        WorldSnapshot::write();
+        mState = STREAMING;
+        mLastProgress = RakNet::GetTime();
+    }
+}
+
+bool WorldSnapshot::receive( RakNet::Packet& rPacket, RakNet::ReplicaManager3& rReplicaManager )
+{
+    RakNet::BitStream stream( rPacket.data, rPacket.length, false );
+    stream.IgnoreBytes( sizeof( RakNet::MessageID ) );
+
+    switch( rPacket.data[0] )
+    {
+        case ID_WORLD_SNAPSHOT_CHUNK:
+        {
+            if( mMode != CLIENT ) return true;
+
+            unsigned int total; stream.ReadCompressed( total );
+            unsigned int offset; stream.ReadCompressed( offset );
+            stream.AlignReadToByteBoundary();
+            unsigned int size = BITS_TO_BYTES( stream.GetNumberOfUnreadBits() );
+
+            if( mState == NONE )
+            {
+                mState = STREAMING;
+                mTotal = total;
+                mData.resize( total );
+            }
+            if( mState != STREAMING || offset + size > mTotal )
+            {
+                SLOGE << "Received invalid world snapshot chunk from " << 
+                    mConnection.GetRakNetGUID().g;
+                return true;
+            }
+
+            stream.Read( (char*)&mData[offset], size );
+            mReceived = offset + size;
+
+            RakNet::BitStream ack;
+            ack.Write( (RakNet::MessageID)ID_WORLD_SNAPSHOT_ACK );
+            ack.WriteCompressed( mReceived );
+            WorldSnapshot::send( ack, rReplicaManager );
+            return true;
+        }
+        case ID_WORLD_SNAPSHOT_ACK:
+        {
+            unsigned int received; stream.ReadCompressed( received );
+            if( mMode == SERVER && received > mReceived )
+            {
+                mReceived = std::min( received, mSent );
+                mLastProgress = RakNet::GetTime();
+            }
+            return true;
+        }
+        case ID_WORLD_SNAPSHOT_APPLIED:
+            if( mMode == SERVER && mState == STREAMING ) WorldSnapshot::complete( rReplicaManager );
+            return true;
+        case ID_WORLD_SNAPSHOT_COMPLETE:
+            if( mMode == CLIENT && mState == APPLIED ) WorldSnapshot::refresh( stream, 
+                rReplicaManager );
+            return true;
+        case ID_WORLD_SNAPSHOT_CANCEL:
+            if( mMode == CLIENT ) WorldSnapshot::cancel( rReplicaManager );
+            return true;
+    }
+
+    return false;
+}
+
+bool WorldSnapshot::capture( RakNet::Replica3& rReplica )
+{
+    RakNet::BitStream allocationID;
+    rReplica.WriteAllocationID( &mConnection, &allocationID );
+
+    Entry entry;
+    entry.mNetworkID = rReplica.GetNetworkID();
+    allocationID.Read<ReplicaType>( entry.mReplicaType );
+
+    switch( entry.mReplicaType )
+    {
+        case REPLICATYPE_OBJECT:
+        {
+            RakNet::RakString name; allocationID.Read<RakNet::RakString>( name );
+            RakNet::RakString displayName; allocationID.Read<RakNet::RakString>( displayName );
+            entry.mName = WorldSnapshot::addString( name.C_String() );
+            entry.mDisplayName = WorldSnapshot::addString( displayName.C_String() );
+            break;
+        }
+        case REPLICATYPE_COMPONENT:
+        {
+            allocationID.Read<ComponentType>( entry.mComponentType );
+            RakNet::RakString name; allocationID.Read<RakNet::RakString>( name );
+            allocationID.Read<RakNet::NetworkID>( entry.mObjectID );
+            entry.mName = WorldSnapshot::addString( name.C_String() );
+            break;
+        }
+        default:
+            // Only objects and components are captured, other replicas are constructed as usual.
+            return false;
+    }
+
+    mConstruction.AlignWriteToByteBoundary();
+    entry.mConstructionOffset = mConstruction.GetNumberOfBytesUsed();
+    rReplica.SerializeConstruction( &mConstruction, &mConnection );
+    entry.mConstructionBits = mConstruction.GetNumberOfBitsUsed() - 
+        entry.mConstructionOffset * 8;
+
+    mEntries.push_back( entry );
+    mExisting.insert( entry.mNetworkID );
+    return true;
+}
+
+unsigned int WorldSnapshot::addString( const String& rString )
+{
+    StringIndices::iterator i = mStringIndices.find( rString );
+    if( i != mStringIndices.end() ) return i->second;
+
+    mStrings.push_back( rString );
+    mStringIndices.insert( std::make_pair( rString, mStrings.size() - 1 ) );
+    return mStrings.size() - 1;
+}
+
+void WorldSnapshot::write()
+{
+    RakNet::BitStream stream;
+
+    // String table, strings are huffman encoded.
+    stream.WriteCompressed( (unsigned int)mStrings.size() );
+    for( std::vector<String>::iterator i = mStrings.begin(); i != mStrings.end(); ++i )
+    {
+        RakNet::RakString( i->c_str() ).SerializeCompressed( &stream );
+    }
+
+    stream.WriteCompressed( (unsigned int)mEntries.size() );
+    RakNet::NetworkID previous = 0;
+    for( Entries::iterator i = mEntries.begin(); i != mEntries.end(); ++i )
+    {
+        stream.Write( i->mReplicaType == REPLICATYPE_COMPONENT );
+
+        // Network ID's are mostly increasing, write the difference with the previous ID.
+        stream.Write( i->mNetworkID >= previous );
+        stream.WriteCompressed( i->mNetworkID >= previous ? i->mNetworkID - previous : 
+            previous - i->mNetworkID );
+        previous = i->mNetworkID;
+
+        if( i->mReplicaType == REPLICATYPE_COMPONENT )
+        {
+            stream.Write( i->mComponentType );
+            stream.WriteCompressed( i->mName );
+            stream.WriteCompressed( i->mObjectID );
+        }
+        else
+        {
+            stream.WriteCompressed( i->mName );
+            stream.WriteCompressed( i->mDisplayName );
+        }
+
+        stream.WriteCompressed( i->mConstructionBits );
+        mConstruction.SetReadOffset( i->mConstructionOffset * 8 );
+        stream.Write( &mConstruction, i->mConstructionBits );
+    }
+
+    mData.assign( stream.GetData(), stream.GetData() + stream.GetNumberOfBytesUsed() );
+    mTotal = mData.size();
+    mSent = 0;
+    mReceived = 0;
+
+    // The string table is only needed while capturing.
+    mStrings.clear();
+    mStringIndices.clear();
+
+    SLOGI << "Captured world snapshot of " << mEntries.size() << " replicas (" << mTotal << 
+        " bytes) for " << mConnection.GetRakNetGUID().g;
+}
+
+void WorldSnapshot::send( RakNet::BitStream& rBitStream, RakNet::ReplicaManager3& rReplicaManager )
+{
+    // Same ordering channel as the replica manager, so replica messages cannot overtake the 
+    // snapshot.
+    rReplicaManager.GetRakPeerInterface()->Send( &rBitStream, HIGH_PRIORITY, RELIABLE_ORDERED, 0, 
+        mConnection.GetRakNetGUID(), false );
+}
+
+bool WorldSnapshot::read()
+{
+    RakNet::BitStream stream( &mData[0], mTotal, false );
+
+    unsigned int stringCount = 0; stream.ReadCompressed( stringCount );
+    mStrings.resize( stringCount );
+    for( std::vector<String>::iterator i = mStrings.begin(); i != mStrings.end(); ++i )
+    {
+        RakNet::RakString string; 
+        if( !string.DeserializeCompressed( &stream ) ) return false;
+        *i = string.C_String();
+    }
+
+    unsigned int entryCount = 0; stream.ReadCompressed( entryCount );
+    mEntries.resize( entryCount );
+    RakNet::NetworkID previous = 0;
+    for( Entries::iterator i = mEntries.begin(); i != mEntries.end(); ++i )
+    {
+        i->mReplicaType = stream.ReadBit() ? REPLICATYPE_COMPONENT : REPLICATYPE_OBJECT;
+
+        bool increasing = stream.ReadBit();
+        RakNet::NetworkID difference = 0; stream.ReadCompressed( difference );
+        i->mNetworkID = increasing ? previous + difference : previous - difference;
+        previous = i->mNetworkID;
+
+        if( i->mReplicaType == REPLICATYPE_COMPONENT )
+        {
+            stream.Read( i->mComponentType );
+            stream.ReadCompressed( i->mName );
+            stream.ReadCompressed( i->mObjectID );
+        }
+        else
+        {
+            stream.ReadCompressed( i->mName );
+            stream.ReadCompressed( i->mDisplayName );
+        }
+
+        stream.ReadCompressed( i->mConstructionBits );
+        if( i->mName >= mStrings.size() || i->mDisplayName >= mStrings.size() || 
+            i->mConstructionBits > stream.GetNumberOfUnreadBits() ) 
+            return false;
+
+        mConstruction.AlignWriteToByteBoundary();
+        i->mConstructionOffset = mConstruction.GetNumberOfBytesUsed();
+        mConstruction.Write( &stream, i->mConstructionBits );
+    }
+
+    return true;
+}
+
+void WorldSnapshot::apply( RakNet::ReplicaManager3& rReplicaManager )
+{
+    if( WorldSnapshot::read() )
+    {
+        // Allocate objects before components so that components can find their object, and 
+        // allocate everything before deserializing so that objects can find their parent.
+        const ReplicaType types[] = { REPLICATYPE_OBJECT, REPLICATYPE_COMPONENT };
+        for( unsigned int t = 0; t < 2; ++t )
+        {
+            for( Entries::iterator i = mEntries.begin(); i != mEntries.end(); ++i )
+            {
+                if( i->mReplicaType != types[t] ) continue;
+
+                // Construct the same allocation ID as the replica manager would have received.
+                RakNet::BitStream allocationID;
+                allocationID.Write<ReplicaType>( i->mReplicaType );
+                if( i->mReplicaType == REPLICATYPE_COMPONENT )
+                {
+                    allocationID.Write<ComponentType>( i->mComponentType );
+                    allocationID.Write<RakNet::RakString>( RakNet::RakString( 
+                        mStrings[i->mName].c_str() ) );
+                    allocationID.Write<RakNet::NetworkID>( i->mObjectID );
+                }
+                else
+                {
+                    allocationID.Write<RakNet::RakString>( RakNet::RakString( 
+                        mStrings[i->mName].c_str() ) );
+                    allocationID.Write<RakNet::RakString>( RakNet::RakString( 
+                        mStrings[i->mDisplayName].c_str() ) );
+                }
+
+                i->mReplica = mConnection.AllocReplica( &allocationID, &rReplicaManager );
+                if( !i->mReplica ) continue;
+
+                i->mReplica->SetNetworkID( i->mNetworkID );
+                i->mReplica->creatingSystemGUID = mConnection.GetRakNetGUID();
+            }
+        }
+
+        for( unsigned int t = 0; t < 2; ++t )
+        {
+            for( Entries::iterator i = mEntries.begin(); i != mEntries.end(); ++i )
+            {
+                if( i->mReplicaType != types[t] || !i->mReplica ) continue;
+
+                RakNet::BitStream construction;
+                mConstruction.SetReadOffset( i->mConstructionOffset * 8 );
+                construction.Write( &mConstruction, i->mConstructionBits );
+                i->mReplica->DeserializeConstruction( &construction, &mConnection );
+            }
+        }
+
+        for( Entries::iterator i = mEntries.begin(); i != mEntries.end(); ++i )
+        {
+            if( !i->mReplica ) continue;
+
+            mExisting.insert( i->mNetworkID );
+            rReplicaManager.Reference( i->mReplica );
+        }
+
+        SLOGI << "Applied world snapshot of " << mEntries.size() << " replicas (" << mTotal << 
+            " bytes) from " << mConnection.GetRakNetGUID().g;
+    }
+    else
+    {
+        SLOGE << "Received invalid world snapshot from " << mConnection.GetRakNetGUID().g;
+    }
+
+    mEntries.clear();
+    mStrings.clear();
+    mData.clear();
+    mConstruction.Reset();
+    mState = APPLIED;
+
+    // The server checks which replicas changed in the meantime, even if the snapshot was invalid.
+    RakNet::BitStream stream;
+    stream.Write( (RakNet::MessageID)ID_WORLD_SNAPSHOT_APPLIED );
+    WorldSnapshot::send( stream, rReplicaManager );
+}
+
+void WorldSnapshot::complete( RakNet::ReplicaManager3& rReplicaManager )
+{
+    mState = APPLIED;
+
+    // Find replicas that were destroyed or are no longer relevant to the client. Components are
+    // destroyed with their object.
+    std::set<RakNet::NetworkID> removed;
+    mProbing = true;
+    for( Entries::iterator i = mEntries.begin(); i != mEntries.end(); ++i )
+    {
+        i->mReplica = rReplicaManager.GetNetworkIDManager()->GET_OBJECT_FROM_ID<RakNet::Replica3*>( 
+            i->mNetworkID );
+        if( !i->mReplica || i->mReplica->QueryConstruction( &mConnection, &rReplicaManager ) != 
+            RakNet::RM3CS_ALREADY_EXISTS_REMOTELY )
+        {
+            removed.insert( i->mNetworkID );
+            mExisting.erase( i->mNetworkID );
+            i->mReplica = 0;
+        }
+    }
+    mProbing = false;
+
+    RakNet::BitStream removedStream;
+    unsigned int removedCount = 0;
+    RakNet::BitStream refreshedStream;
+    unsigned int refreshedCount = 0;
+    for( Entries::iterator i = mEntries.begin(); i != mEntries.end(); ++i )
+    {
+        if( !i->mReplica )
+        {
+            if( i->mReplicaType == REPLICATYPE_COMPONENT && removed.count( i->mObjectID ) ) 
+                continue;
+
+            removedStream.WriteCompressed( i->mNetworkID );
+            ++removedCount;
+            continue;
+        }
+
+        // Construct replicas that changed while the snapshot was streamed again.
+        RakNet::BitStream construction;
+        i->mReplica->SerializeConstruction( &construction, &mConnection );
+        if( !WorldSnapshot::isConstructionEqual( *i, construction ) )
+        {
+            refreshedStream.WriteCompressed( i->mNetworkID );
+            refreshedStream.WriteCompressed( construction.GetNumberOfBitsUsed() );
+            refreshedStream.Write( &construction, construction.GetNumberOfBitsUsed() );
+            ++refreshedCount;
+        }
+    }
+
+    RakNet::BitStream stream;
+    stream.Write( (RakNet::MessageID)ID_WORLD_SNAPSHOT_COMPLETE );
+    stream.WriteCompressed( removedCount );
+    stream.Write( &removedStream, removedStream.GetNumberOfBitsUsed() );
+    stream.WriteCompressed( refreshedCount );
+    stream.Write( &refreshedStream, refreshedStream.GetNumberOfBitsUsed() );
+    WorldSnapshot::send( stream, rReplicaManager );
+
+    SLOGI << "World snapshot applied by " << mConnection.GetRakNetGUID().g << ", " << 
+        removedCount << " replicas removed and " << refreshedCount << " replicas refreshed";
+
+    mEntries.clear();
+    mData.clear();
+    mConstruction.Reset();
+}
+
+void WorldSnapshot::cancel( RakNet::ReplicaManager3& rReplicaManager )
+{
+    if( mMode == SERVER )
+    {
+        SLOGW << "World snapshot for " << mConnection.GetRakNetGUID().g << " timed out, " << 
+            "constructing replicas per replica";
+
+        // Sent before any construction on the same ordering channel, so the client discards the
+        // snapshot before replicas are constructed again.
+        RakNet::BitStream stream;
+        stream.Write( (RakNet::MessageID)ID_WORLD_SNAPSHOT_CANCEL );
+        WorldSnapshot::send( stream, rReplicaManager );
+    }
+    else if( mState == APPLIED )
+    {
+        // The snapshot was applied after the server gave up on it, all replicas of the snapshot
+        // will be constructed again.
+        RakNet::NetworkIDManager& networkIDManager = *rReplicaManager.GetNetworkIDManager();
+        for( std::set<RakNet::NetworkID>::iterator i = mExisting.begin(); i != mExisting.end(); 
+            ++i )
+        {
+            RakNet::Replica3* replica = networkIDManager.GET_OBJECT_FROM_ID<RakNet::Replica3*>( 
+                *i );
+            if( replica ) replica->DeallocReplica( &mConnection );
+        }
+    }
+
+    mState = NONE;
+    mEntries.clear();
+    mStrings.clear();
+    mStringIndices.clear();
+    mExisting.clear();
+    mData.clear();
+    mConstruction.Reset();
+    mTotal = 0;
+    mReceived = 0;
+    mSent = 0;
+}
+
+void WorldSnapshot::refresh( RakNet::BitStream& rBitStream, 
+    RakNet::ReplicaManager3& rReplicaManager )
+{
+    RakNet::NetworkIDManager& networkIDManager = *rReplicaManager.GetNetworkIDManager();
+
+    unsigned int removedCount = 0; rBitStream.ReadCompressed( removedCount );
+    for( unsigned int i = 0; i < removedCount; ++i )
+    {
+        RakNet::NetworkID networkID; rBitStream.ReadCompressed( networkID );
+        RakNet::Replica3* replica = networkIDManager.GET_OBJECT_FROM_ID<RakNet::Replica3*>( 
+            networkID );
+        mExisting.erase( networkID );
+        if( replica ) replica->DeallocReplica( &mConnection );
+    }
+
+    unsigned int refreshedCount = 0; rBitStream.ReadCompressed( refreshedCount );
+    for( unsigned int i = 0; i < refreshedCount; ++i )
+    {
+        RakNet::NetworkID networkID; rBitStream.ReadCompressed( networkID );
+        unsigned int bits = 0; rBitStream.ReadCompressed( bits );
+        RakNet::BitStream construction;
+        construction.Write( &rBitStream, bits );
+
+        RakNet::Replica3* replica = networkIDManager.GET_OBJECT_FROM_ID<RakNet::Replica3*>( 
+            networkID );
+        if( replica ) replica->DeserializeConstruction( &construction, &mConnection );
+    }
+}
+
+bool WorldSnapshot::isConstructionEqual( const Entry& rEntry, RakNet::BitStream& rConstruction )
+{
+    if( rConstruction.GetNumberOfBitsUsed() != rEntry.mConstructionBits ) return false;
+
+    const unsigned char* captured = mConstruction.GetData() + rEntry.mConstructionOffset;
+    const unsigned char* current = rConstruction.GetData();
+    unsigned int bytes = rEntry.mConstructionBits / 8;
+    if( memcmp( captured, current, bytes ) != 0 ) return false;
+
+    // Only compare the used bits of the last byte.
+    unsigned int bits = rEntry.mConstructionBits % 8;
+    if( !bits ) return true;
+    unsigned char mask = (unsigned char)( 0xFF << ( 8 - bits ) );
+    return ( captured[bytes] & mask ) == ( current[bytes] & mask );
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
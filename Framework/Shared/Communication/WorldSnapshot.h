@@ -0,0 +1,213 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SHARED_WORLDSNAPSHOT_H
+#define DIVERSIA_SHARED_WORLDSNAPSHOT_H
+
+#include "Shared/Platform/Prerequisites.h"
+
+#include <RakNet/MessageIdentifiers.h>
+
+namespace Diversia
+{
+//------------------------------------------------------------------------------
+
+/**
+Values that represent the messages of the world snapshot stream.
+**/
+enum WorldSnapshotMessage
+{
+    ID_WORLD_SNAPSHOT_CHUNK = ID_USER_PACKET_ENUM,  ///< Part of the snapshot, server to client.
+    ID_WORLD_SNAPSHOT_ACK,                          ///< Bytes received, client to server.
+    ID_WORLD_SNAPSHOT_APPLIED,                      ///< Snapshot was applied, client to server.
+    ID_WORLD_SNAPSHOT_COMPLETE,                     ///< Stale replicas, server to client.
+    ID_WORLD_SNAPSHOT_CANCEL                        ///< Snapshot timed out, server to client.
+};
+
+/**
+Bulk construction of objects and components for a joining client. Instead of constructing every
+replica with its own construction message, the server captures the construction of all replicas 
+that are relevant to the client into a single snapshot. Names are stored once in a shared string
+table and compressed, network ID's are delta encoded. The snapshot is streamed to the client in 
+chunks while keeping a limited amount of bytes in flight. If the client makes no progress within
+the timeout the snapshot is cancelled, the client discards the snapshot and replicas are 
+constructed per replica instead.
+
+When the client has applied the snapshot, the server compares the construction of all replicas 
+in the snapshot with their current construction. Replicas that were destroyed or are no longer 
+relevant are destroyed on the client and replicas that changed are constructed again. After 
+that the replicas are marked as existing on the client and are serialized as usual, replicas 
+that were created while the snapshot was streamed are constructed per replica.
+**/
+class DIVERSIA_SHARED_API WorldSnapshot
+{
+public:
+    /**
+    Values that represent the state of a snapshot.
+    **/
+    enum State
+    {
+        NONE = 0,   ///< No snapshot is used, replicas are constructed per replica.
+        CAPTURING,  ///< Capturing the construction of replicas, server only.
+        STREAMING,  ///< Streaming the snapshot to or from the client.
+        APPLIED     ///< The snapshot has been applied on the client.
+    };
+
+    /**
+    Constructor. 
+    
+    @param [in,out] rConnection The connection to the remote system.
+    @param  mode                The mode (Client/Server) to run in.
+    **/
+    WorldSnapshot( ReplicaConnection& rConnection, Mode mode );
+
+    /**
+    Gets the construction state of a replica for the remote system, taking the snapshot into
+    account. Replicas that are constructed while capturing are added to the snapshot.
+
+    @param [in,out] rReplica    The replica.
+    @param  state               The construction state without snapshot.
+    @param [in,out] rReplicaManager The replica manager.
+    **/
+    RakNet::RM3ConstructionState queryConstruction( RakNet::Replica3& rReplica, 
+        RakNet::RM3ConstructionState state, RakNet::ReplicaManager3& rReplicaManager );
+    /**
+    Streams the snapshot to the client and applies a received snapshot. Call this every tick 
+    before the replica manager is updated.
+    
+    @param [in,out] rReplicaManager The replica manager.
+    **/
+    void update( RakNet::ReplicaManager3& rReplicaManager );
+    /**
+    Ends capturing when the replica manager has queried the construction of replicas. Call this 
+    every tick after the replica manager is updated.
+    **/
+    void postUpdate();
+    /**
+    Handles a snapshot message from the remote system. 
+    
+    @param [in,out] rPacket         The packet.
+    @param [in,out] rReplicaManager The replica manager.
+
+    @return True if the packet was a snapshot message, false if not.
+    **/
+    bool receive( RakNet::Packet& rPacket, RakNet::ReplicaManager3& rReplicaManager );
+
+    /**
+    Gets the snapshot state. 
+    **/
+    inline State getState() const { return mState; }
+    /**
+    Gets the amount of snapshot bytes that are received, or acknowledged on the server.
+    **/
+    inline unsigned int getReceivedBytes() const { return mReceived; }
+    /**
+    Gets the size of the snapshot in bytes, 0 if the size is not known yet.
+    **/
+    inline unsigned int getTotalBytes() const { return mTotal; }
+
+private:
+    struct Entry
+    {
+        Entry() : mNetworkID( 0 ), mReplicaType( 0 ), mComponentType( 0 ), mName( 0 ), 
+            mDisplayName( 0 ), mObjectID( 0 ), mConstructionOffset( 0 ), 
+            mConstructionBits( 0 ), mReplica( 0 ) {}
+
+        RakNet::NetworkID   mNetworkID;
+        ReplicaType         mReplicaType;
+        ComponentType       mComponentType;
+        unsigned int        mName;          ///< Index in the string table.
+        unsigned int        mDisplayName;   ///< Index in the string table.
+        RakNet::NetworkID   mObjectID;      ///< Object of a component.
+        unsigned int        mConstructionOffset;
+        unsigned int        mConstructionBits;
+        RakNet::Replica3*   mReplica;       ///< Allocated replica, client only.
+    };
+
+    typedef std::vector<Entry> Entries;
+    typedef std::map<String, unsigned int> StringIndices;
+
+    bool capture( RakNet::Replica3& rReplica );
+    unsigned int addString( const String& rString );
+    void write();
+    void send( RakNet::BitStream& rBitStream, RakNet::ReplicaManager3& rReplicaManager );
+    bool read();
+    void apply( RakNet::ReplicaManager3& rReplicaManager );
+    void complete( RakNet::ReplicaManager3& rReplicaManager );
+    void cancel( RakNet::ReplicaManager3& rReplicaManager );
+    void refresh( RakNet::BitStream& rBitStream, RakNet::ReplicaManager3& rReplicaManager );
+    bool isConstructionEqual( const Entry& rEntry, RakNet::BitStream& rConstruction );
+
+    ReplicaConnection&          mConnection;
+    Mode                        mMode;
+    State                       mState;
+    bool                        mProbing;
+
+    Entries                     mEntries;
+    std::vector<String>         mStrings;
+    StringIndices               mStringIndices;
+    RakNet::BitStream           mConstruction;
+    std::set<RakNet::NetworkID> mExisting;  ///< Replicas that exist on the remote system.
+
+    std::vector<unsigned char>  mData;
+    unsigned int                mTotal;
+    unsigned int                mReceived;
+    unsigned int                mSent;
+    RakNet::Time                mLastProgress;
+
+    /**
+    Settings for world snapshots.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mEnabled( true ),
+            mChunkSize( 4096 ),
+            mWindowSize( 32768 ),
+            mTimeoutMS( 10000 )
+        {
+        
+        }
+
+        bool            mEnabled;
+        unsigned int    mChunkSize;     ///< Size of a chunk in bytes.
+        unsigned int    mWindowSize;    ///< Maximum amount of unacknowledged bytes per client.
+        unsigned int    mTimeoutMS;     ///< Time without progress before cancelling, 0 to wait.
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static WorldSnapshot::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::WorldSnapshot::Settings, 
+    &Diversia::Shared::Bindings::CampBindings::bindWorldSnapshotSettings );
+
+#endif // DIVERSIA_SHARED_WORLDSNAPSHOT_H
@@ -35,6 +35,7 @@ namespace Diversia
 //------------------------------------------------------------------------------
 
 // Camp
+class PropertyIdTable;
 class PropertySynchronization;
 class PropertyTransaction;
 
@@ -46,12 +47,18 @@ class PluginFactoryManager;
 class PluginManager;
 
 // Communication
+class LoopbackPeer;
+class NetworkStage;
+class PacketRecorder;
+class PacketReplay;
 class ReplicaConnection;
 class ReplicaManager;
 class GridPosition;
 class ServerInfo;
 class ServerPosition;
 class UserInfo;
+class TrafficStatistics;
+class WorldSnapshot;
 
 // Crash
 class CrashReporter;
@@ -0,0 +1,208 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Util/Platform/StableHeaders.h"
+
+#include "Util/Helper/TickScheduler.h"
+
+#if DIVERSIA_PLATFORM == DIVERSIA_PLATFORM_LINUX
+#   include <time.h>
+#elif DIVERSIA_PLATFORM == DIVERSIA_PLATFORM_APPLE
+#   include <mach/mach_time.h>
+#endif
+
+namespace Diversia
+{
+namespace Util
+{
+//------------------------------------------------------------------------------
+
+TickScheduler::TickScheduler( Real tickRate /*= 60.0*/ ):
+    mTickRate( 0 ),
+    mTickIntervalUS( 0 ),
+    mSpinTimeUS( 1000 ),
+    mMaxCatchUpTicks( 5 ),
+    mDeadline( 0 ),
+    mTickStart( 0 ),
+    mStarted( false ),
+    mCatchingUp( false )
+{
+    TickScheduler::setTickRate( tickRate );
+    TickScheduler::resetStatistics();
+}
+
+void TickScheduler::start()
+{
+    mTickStart = TickScheduler::getMicroseconds();
+    mDeadline = mTickStart;
+    mStarted = true;
+    mCatchingUp = false;
+}
+
+Real TickScheduler::beginTick()
+{
+    if( !mStarted ) TickScheduler::start();
+
+    boost::uint64_t now = TickScheduler::getMicroseconds();
+    boost::uint64_t elapsed = now - mTickStart;
+    mTickStart = now;
+
+    // Ticks that are run back to back to catch up have no meaningful jitter.
+    if( !mCatchingUp )
+    {
+        boost::uint64_t jitter = now > mDeadline ? now - mDeadline : mDeadline - now;
+        mTotalJitterUS += jitter;
+        mMaxJitterUS = std::max( mMaxJitterUS, jitter );
+        ++mJitterCount;
+    }
+
+    return elapsed / 1000000.0;
+}
+
+void TickScheduler::endTick()
+{
+    boost::uint64_t now = TickScheduler::getMicroseconds();
+
+    mLastTickTimeUS = now - mTickStart;
+    mTotalTickTimeUS += mLastTickTimeUS;
+    mMaxTickTimeUS = std::max( mMaxTickTimeUS, mLastTickTimeUS );
+    ++mTickCount;
+
+    mDeadline += mTickIntervalUS;
+
+    if( now >= mDeadline )
+    {
+        // Tick overran its deadline.
+        ++mOverrunCount;
+
+        boost::uint64_t behind = ( now - mDeadline ) / mTickIntervalUS;
+        if( behind >= mMaxCatchUpTicks )
+        {
+            // Too far behind to catch up, skip ticks and reset the deadline.
+            mSkippedCount += (unsigned int)( behind - mMaxCatchUpTicks );
+            mDeadline = now - mMaxCatchUpTicks * mTickIntervalUS;
+        }
+
+        mCatchingUp = mMaxCatchUpTicks != 0;
+        if( !mCatchingUp ) mDeadline = now;
+    }
+    else
+    {
+        mCatchingUp = false;
+        TickScheduler::sleepUntil( mDeadline );
+    }
+}
+
+void TickScheduler::setTickRate( Real tickRate )
+{
+    if( tickRate <= 0 )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INVALIDPARAMS, "Tick rate must be greater than 0.",
+            "TickScheduler::setTickRate" );
+    }
+
+    mTickRate = tickRate;
+    mTickIntervalUS = (boost::uint64_t)( 1000000.0 / tickRate );
+    if( mTickIntervalUS == 0 ) mTickIntervalUS = 1;
+}
+
+Real TickScheduler::getAverageTickTime() const
+{
+    if( !mTickCount ) return 0;
+    return ( mTotalTickTimeUS / (Real)mTickCount ) / 1000.0;
+}
+
+Real TickScheduler::getAverageJitter() const
+{
+    if( !mJitterCount ) return 0;
+    return ( mTotalJitterUS / (Real)mJitterCount ) / 1000.0;
+}
+
+void TickScheduler::resetStatistics()
+{
+    mTickCount = 0;
+    mOverrunCount = 0;
+    mSkippedCount = 0;
+    mJitterCount = 0;
+    mLastTickTimeUS = 0;
+    mTotalTickTimeUS = 0;
+    mMaxTickTimeUS = 0;
+    mTotalJitterUS = 0;
+    mMaxJitterUS = 0;
+}
+
+boost::uint64_t TickScheduler::getMicroseconds()
+{
+#if DIVERSIA_PLATFORM == DIVERSIA_PLATFORM_WIN32
+    static LARGE_INTEGER frequency = { 0 };
+    if( !frequency.QuadPart ) QueryPerformanceFrequency( &frequency );
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter( &counter );
+    return (boost::uint64_t)( counter.QuadPart / frequency.QuadPart ) * 1000000 +
+        (boost::uint64_t)( counter.QuadPart % frequency.QuadPart ) * 1000000 / frequency.QuadPart;
+#elif DIVERSIA_PLATFORM == DIVERSIA_PLATFORM_APPLE
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if( !timebase.denom ) mach_timebase_info( &timebase );
+
+    return mach_absolute_time() * timebase.numer / timebase.denom / 1000;
+#else
+    timespec time;
+    clock_gettime( CLOCK_MONOTONIC, &time );
+    return (boost::uint64_t)time.tv_sec * 1000000 + time.tv_nsec / 1000;
+#endif
+}
+
+void TickScheduler::sleepUntil( boost::uint64_t deadline )
+{
+    boost::uint64_t now = TickScheduler::getMicroseconds();
+
+    // Sleep in coarse steps until the spin time is reached.
+    while( now + mSpinTimeUS < deadline )
+    {
+        boost::uint64_t sleepUS = deadline - now - mSpinTimeUS;
+#if DIVERSIA_PLATFORM == DIVERSIA_PLATFORM_WIN32
+        if( sleepUS < 1000 ) break;
+        Sleep( (DWORD)( sleepUS / 1000 ) );
+#else
+        usleep( (useconds_t)sleepUS );
+#endif
+        now = TickScheduler::getMicroseconds();
+    }
+
+    // Spin for the remaining time.
+    while( now < deadline )
+    {
+#if DIVERSIA_PLATFORM == DIVERSIA_PLATFORM_WIN32
+        Sleep( 0 );
+#endif
+        now = TickScheduler::getMicroseconds();
+    }
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Util
+} // Namespace Diversia
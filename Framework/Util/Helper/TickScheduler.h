@@ -0,0 +1,182 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_UTIL_TICKSCHEDULER_H
+#define DIVERSIA_UTIL_TICKSCHEDULER_H
+
+#include <boost/cstdint.hpp>
+
+namespace Diversia
+{
+namespace Util
+{
+//------------------------------------------------------------------------------
+
+/**
+Fixed timestep tick scheduler using a monotonic wall clock. Every tick has a deadline, the
+scheduler sleeps until shortly before the deadline and spins for the remaining time. When a tick
+overruns its deadline the scheduler catches up by running ticks back to back, up to a maximum
+amount of ticks, after which the remaining ticks are skipped and the deadline is reset.
+
+Usage:
+@code
+scheduler.start();
+while( running )
+{
+    Real elapsed = scheduler.beginTick();
+    // Do work
+    scheduler.endTick();
+}
+@endcode
+**/
+class DIVERSIA_UTIL_API TickScheduler
+{
+public:
+    /**
+    Constructor.
+
+    @param  tickRate    The target amount of ticks per second.
+    **/
+    TickScheduler( Real tickRate = 60.0 );
+
+    /**
+    Resets the tick deadline to the current time. Call this right before entering the loop.
+    **/
+    void start();
+    /**
+    Marks the start of a tick and updates the jitter statistics.
+
+    @return The wall time in seconds that has elapsed since the start of the previous tick.
+    **/
+    Real beginTick();
+    /**
+    Marks the end of a tick, updates the tick time and overrun statistics and waits until the
+    deadline of the next tick. Returns immediately if the scheduler is catching up.
+    **/
+    void endTick();
+
+    /**
+    Sets the target amount of ticks per second.
+    **/
+    void setTickRate( Real tickRate );
+    /**
+    Gets the target amount of ticks per second.
+    **/
+    inline Real getTickRate() const { return mTickRate; }
+    /**
+    Sets the amount of microseconds before the deadline at which the scheduler stops sleeping and
+    starts spinning. Higher values improve accuracy on platforms with a coarse sleep granularity at
+    the cost of CPU time.
+    **/
+    inline void setSpinTime( unsigned int spinTimeUS ) { mSpinTimeUS = spinTimeUS; }
+    /**
+    Gets the spin time in microseconds.
+    **/
+    inline unsigned int getSpinTime() const { return mSpinTimeUS; }
+    /**
+    Sets the maximum amount of ticks that will be run back to back to catch up after an overrun.
+    Set to 0 to never catch up, the deadline will be reset after each overrun.
+    **/
+    inline void setMaxCatchUpTicks( unsigned int ticks ) { mMaxCatchUpTicks = ticks; }
+    /**
+    Gets the maximum amount of ticks that will be run back to back to catch up after an overrun.
+    **/
+    inline unsigned int getMaxCatchUpTicks() const { return mMaxCatchUpTicks; }
+
+    /**
+    Gets the amount of ticks since the statistics were reset.
+    **/
+    inline unsigned int getTickCount() const { return mTickCount; }
+    /**
+    Gets the amount of ticks that overran their deadline.
+    **/
+    inline unsigned int getOverrunCount() const { return mOverrunCount; }
+    /**
+    Gets the amount of ticks that were skipped because catching up was not possible.
+    **/
+    inline unsigned int getSkippedCount() const { return mSkippedCount; }
+    /**
+    Gets the time in milliseconds that the last tick took, excluding waiting.
+    **/
+    inline Real getLastTickTime() const { return mLastTickTimeUS / 1000.0; }
+    /**
+    Gets the average time in milliseconds that a tick took, excluding waiting.
+    **/
+    Real getAverageTickTime() const;
+    /**
+    Gets the maximum time in milliseconds that a tick took, excluding waiting.
+    **/
+    inline Real getMaxTickTime() const { return mMaxTickTimeUS / 1000.0; }
+    /**
+    Gets the average difference in milliseconds between the deadline and the actual start of a
+    tick.
+    **/
+    Real getAverageJitter() const;
+    /**
+    Gets the maximum difference in milliseconds between the deadline and the actual start of a
+    tick.
+    **/
+    inline Real getMaxJitter() const { return mMaxJitterUS / 1000.0; }
+    /**
+    Resets all statistics.
+    **/
+    void resetStatistics();
+
+    /**
+    Gets the current time of the monotonic clock in microseconds.
+    **/
+    static boost::uint64_t getMicroseconds();
+
+private:
+    void sleepUntil( boost::uint64_t deadline );
+
+    Real            mTickRate;
+    boost::uint64_t mTickIntervalUS;
+    unsigned int    mSpinTimeUS;
+    unsigned int    mMaxCatchUpTicks;
+
+    boost::uint64_t mDeadline;
+    boost::uint64_t mTickStart;
+    bool            mStarted;
+    bool            mCatchingUp;
+
+    unsigned int    mTickCount;
+    unsigned int    mOverrunCount;
+    unsigned int    mSkippedCount;
+    unsigned int    mJitterCount;
+    boost::uint64_t mLastTickTimeUS;
+    boost::uint64_t mTotalTickTimeUS;
+    boost::uint64_t mMaxTickTimeUS;
+    boost::uint64_t mTotalJitterUS;
+    boost::uint64_t mMaxJitterUS;
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Util
+} // Namespace Diversia
+
+#endif // DIVERSIA_UTIL_TICKSCHEDULER_H
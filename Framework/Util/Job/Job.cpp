@@ -44,7 +44,10 @@ Job::Job( Request& rRequest, const sigc::slot<void,bool>& rFinishedSlot ):
     mLaterTimer( 0 ),
     mLaterRetries( 10 ),
     mLaterRetriesCounter( 0 ),
-    mIsCritical( true )
+    mIsCritical( true ),
+    mIsThreaded( false ),
+    mIsCancelled( false ),
+    mLaterTime( 0 )
 {
 
 }
@@ -60,7 +63,10 @@ Job::Job( Request& rRequest ):
     mLaterTimer( 0 ),
     mLaterRetries( 10 ),
     mLaterRetriesCounter( 0 ),
-    mIsCritical( true )
+    mIsCritical( true ),
+    mIsThreaded( false ),
+    mIsCancelled( false ),
+    mLaterTime( 0 )
 {
 
 }
@@ -70,6 +76,18 @@ Job::~Job()
     if( mRewindJob ) delete mRewindJob;
 }
 
+bool Job::isCancelled() const
+{
+    boost::mutex::scoped_lock lock( mCancelledMutex );
+    return mIsCancelled;
+}
+
+void Job::setCancelled( bool cancelled )
+{
+    boost::mutex::scoped_lock lock( mCancelledMutex );
+    mIsCancelled = cancelled;
+}
+
 Job::JobState Job::run()
 {
     return Job::JOB_FAILED;
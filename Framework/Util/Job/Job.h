@@ -25,6 +25,9 @@ THE SOFTWARE.
 #ifndef DIVERSIA_UTIL_JOB_H
 #define DIVERSIA_UTIL_JOB_H
 
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
 namespace Diversia
 {
 namespace Util
@@ -189,6 +192,28 @@ public:
      * @param   rFinishedSlot   The slot to set.
     **/
     inline void setFinishedSlot( const sigc::slot<void,bool>& rFinishedSlot ) { mFinishedSlot = rFinishedSlot; }
+    /**
+     * Query if this job runs on a worker thread of the RequestManager's thread pool.
+    **/
+    inline bool isThreaded() const { return mIsThreaded; }
+    /**
+     * Sets if this job runs on a worker thread of the RequestManager's thread pool. The request
+     * waits without blocking the main thread until run() returns, the result is handled by the
+     * next RequestManager::update() on the main thread so done() and failed() are always called
+     * on the main thread.
+     *
+     * @remarks
+     *          A threaded job may only touch data that is not used by the main thread while it
+     *          runs. runLater() and rewind() are always called on the main thread.
+     *
+     * @param   threaded    True to run this job on a worker thread.
+    **/
+    inline void setThreaded( bool threaded ) { mIsThreaded = threaded; }
+    /**
+     * Query if the request that owns this job has been cancelled. Long running (threaded) jobs
+     * should poll this and return Job::JOB_FAILED as soon as possible when it returns true.
+    **/
+    bool isCancelled() const;
 
 protected:
     JobState                mJobState;
@@ -204,6 +229,19 @@ protected:
     int                     mLaterRetriesCounter;
 
     bool                    mIsCritical;
+    bool                    mIsThreaded;
+
+private:
+    friend class Request;
+    friend class RequestManager;
+
+    void setCancelled( bool cancelled );
+
+    bool                    mIsCancelled;
+    mutable boost::mutex    mCancelledMutex;
+
+    boost::uint64_t         mLaterTime;
+
 };
 
 //------------------------------------------------------------------------------
@@ -21,7 +21,6 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 -----------------------------------------------------------------------------
 */
-
 #include "Util/Platform/StableHeaders.h"
 
 #include "Util/Job/RequestManager.h"
@@ -39,7 +38,12 @@ Request::Request( RequestManager* pRequestManager, unsigned int priority,
     mRequestManager( pRequestManager ),
     mPriority( priority ),
     mFinishedSlot( rFinishedSlot ),
-    mRequestState( Request::REQUEST_IDLE )
+    mRequestState( Request::REQUEST_IDLE ),
+    mThreadedState( Request::THREADED_NONE ),
+    mThreadedJobState( Job::JOB_IDLE ),
+    mIsCancelled( false ),
+    mDependencyFailed( false ),
+    mUnfinishedDependencies( 0 )
 {
 
 }
@@ -48,13 +52,29 @@ Request::Request( RequestManager* pRequestManager, unsigned int priority ):
     mRequestManager( pRequestManager ),
     mPriority( priority ),
     mFinishedSlot( sigc::slot<void,bool>() ),
-    mRequestState( Request::REQUEST_IDLE )
+    mRequestState( Request::REQUEST_IDLE ),
+    mThreadedState( Request::THREADED_NONE ),
+    mThreadedJobState( Job::JOB_IDLE ),
+    mIsCancelled( false ),
+    mDependencyFailed( false ),
+    mUnfinishedDependencies( 0 )
 {
 
 }
 
 Request::~Request()
 {
+    // Unregister from requests that this request depends on and from dependent requests.
+    for( std::set<Request*>::iterator i = mDependencies.begin(); i != mDependencies.end(); ++i )
+    {
+        ( *i )->mDependents.erase( this );
+    }
+
+    for( std::set<Request*>::iterator i = mDependents.begin(); i != mDependents.end(); ++i )
+    {
+        ( *i )->dependencyFinished( this, false );
+    }
+
     // Remove any Jobs from queue and stack.
     while ( mJobs.size() > 0 )
     {
@@ -78,9 +98,62 @@ Request::RequestState Request::run()
         return rewind();
     }
 
+    // Wait for the threaded job to return.
+    if ( mThreadedState == Request::THREADED_RUNNING )
+    {
+        return mRequestState;
+    }
+
+    if ( mThreadedState == Request::THREADED_NONE )
+    {
+        // Fail if this request or one of its dependencies was cancelled or has failed.
+        if ( mIsCancelled || mDependencyFailed )
+        {
+            Request::abort();
+            return mRequestState;
+        }
+
+        // Wait for the requests this request depends on.
+        if ( mUnfinishedDependencies )
+        {
+            mRequestState = Request::REQUEST_WAITING;
+            return mRequestState;
+        }
+    }
+
     if ( mJobs.size() > 0 )
     {
-        Job::JobState jobState = mJobs.front()->run();
+        Job* job = mJobs.front();
+        Job::JobState jobState;
+
+        if ( mThreadedState == Request::THREADED_FINISHED )
+        {
+            // Continue with the result of the threaded job.
+            jobState = mThreadedJobState;
+            mThreadedState = Request::THREADED_NONE;
+        }
+        else if ( job->isThreaded() )
+        {
+            // Run the job on a worker thread, the result is handed back by the RequestManager.
+            mThreadedState = Request::THREADED_RUNNING;
+            mRequestState = Request::REQUEST_WORKING;
+            mRequestManager->runThreaded( this, job );
+            return mRequestState;
+        }
+        else
+        {
+            jobState = job->run();
+        }
+
+        if ( mIsCancelled )
+        {
+            // Cancelled while the job was running, rewind whatever it has done.
+            mJobStack.push( job );
+            mJobs.pop();
+            Request::abort();
+            return mRequestState;
+        }
+
         switch ( jobState )
         {
             case Job::JOB_WORKING:
@@ -100,75 +173,57 @@ Request::RequestState Request::run()
             }
             case Job::JOB_DONE:
             {
-                // Is this not the last Job?
-                if ( mJobs.size() > 1 )
-                {
-                    // Put the finished Job on the stack and remove it from the queue.
-                    mJobStack.push( mJobs.front() );
-                    mJobs.pop();
-
-                    mRequestState = Request::REQUEST_IDLE;
-                }
-                else
-                {
-                    // This is the last Job and it is done, request is done!
-                    // Put the finished Job on the stack and remove it from the queue.
-                    mJobStack.push( mJobs.front() );
-                    mJobs.pop();
+                job->done();
 
-                    mRequestState = Request::REQUEST_DONE;
-                }
+                // Put the finished Job on the stack and remove it from the queue.
+                mJobStack.push( job );
+                mJobs.pop();
 
+                // If this was the last Job, the request is done!
+                mRequestState = mJobs.empty() ? Request::REQUEST_DONE : Request::REQUEST_IDLE;
                 break;
             }
             case Job::JOB_FAILED:
             {
                 // Damn! A Job has failed..
                 // Is this Job critical for the success of this Request?
-                if ( mJobs.front()->isCritical() )
+                if ( job->isCritical() )
                 {
+                    job->failed();
+
                     // Put the failed Job on the stack and remove it from the queue.
-                    mJobStack.push( mJobs.front() );
+                    mJobStack.push( job );
                     mJobs.pop();
 
-                    // Remove remaining Jobs from the queue
-                    while ( mJobs.size() > 0 )
-                    {
-                        Job* job = mJobs.front();
-                        mJobs.pop();
-                        delete job;
-                    }
-
-                    // Set state to rewinding so the next run() we can start rewinding.
-                    mRequestState = Request::REQUEST_REWINDING;
+                    // Remove remaining Jobs and start rewinding the next run().
+                    Request::abort();
                 }
                 else
                 {
-                    // Phew.. just add the Job to the 'later' list of the RequestManager
-                    mRequestManager->addLaterJob( mJobs.front() );
-
-                    // Is this the last Job?
-                    if ( mJobs.size() == 1 )
-                    {
-                        // Don't add it to the stack because the RequestManager now owns it,
-                        // this might cause problems if a Request needs to be rewinded.
-                        mJobs.pop();
-
-                        // Set state to done.
-                        mRequestState = Request::REQUEST_DONE;
-                    }
+                    // Phew.. just add the Job to the 'later' list of the RequestManager. Don't 
+                    // add it to the stack because the RequestManager now owns it, this might 
+                    // cause problems if a Request needs to be rewinded.
+                    mJobs.pop();
+                    mRequestManager->addLaterJob( job );
 
+                    mRequestState = mJobs.empty() ? Request::REQUEST_DONE : Request::REQUEST_IDLE;
                 }
                 break;
             }
         }
     }
+    else
+    {
+        // A request without jobs is done immediately.
+        mRequestState = Request::REQUEST_DONE;
+    }
 
     return mRequestState;
 }
 
 void Request::addJob( Job* pJob )
 {
+    pJob->setCancelled( mIsCancelled );
     mJobs.push( pJob );
 }
 
@@ -197,6 +252,7 @@ Request::RequestState Request::rewind()
             }
             case Job::JOB_REWINDING_DONE:
             {
+                delete mJobStack.top();
                 mJobStack.pop();
             }
         }
@@ -228,6 +284,69 @@ void Request::done()
     }
 }
 
+void Request::addDependency( Request* pRequest )
+{
+    if ( !pRequest || pRequest == this ) return;
+
+    if ( mDependencies.insert( pRequest ).second )
+    {
+        pRequest->mDependents.insert( this );
+        ++mUnfinishedDependencies;
+    }
+}
+
+void Request::cancel()
+{
+    mIsCancelled = true;
+
+    // Notify the jobs, the running job might be polling this on a worker thread.
+    std::queue<Job*> jobs( mJobs );
+    while ( jobs.size() > 0 )
+    {
+        jobs.front()->setCancelled( true );
+        jobs.pop();
+    }
+}
+
+void Request::abort()
+{
+    // Remove remaining Jobs from the queue
+    while ( mJobs.size() > 0 )
+    {
+        Job* job = mJobs.front();
+        mJobs.pop();
+        delete job;
+    }
+
+    // Set state to rewinding so the next run() we can start rewinding.
+    mRequestState = Request::REQUEST_REWINDING;
+}
+
+void Request::threadedJobFinished( Job::JobState state )
+{
+    mThreadedJobState = state;
+    mThreadedState = Request::THREADED_FINISHED;
+}
+
+void Request::dependencyFinished( Request* pRequest, bool success )
+{
+    if ( mDependencies.erase( pRequest ) )
+    {
+        --mUnfinishedDependencies;
+        if ( !success ) mDependencyFailed = true;
+    }
+}
+
+void Request::notifyDependents( bool success )
+{
+    for( std::set<Request*>::iterator i = mDependents.begin(); i != mDependents.end(); ++i )
+    {
+        ( *i )->dependencyFinished( this, success );
+    }
+
+    mDependents.clear();
+}
+
 //------------------------------------------------------------------------------
 }
 }
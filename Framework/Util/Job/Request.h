@@ -25,6 +25,8 @@ THE SOFTWARE.
 #ifndef DIVERSIA_UTIL_REQUEST_H
 #define DIVERSIA_UTIL_REQUEST_H
 
+#include "Util/Job/Job.h"
+
 namespace Diversia
 {
 namespace Util
@@ -32,7 +34,9 @@ namespace Util
 //------------------------------------------------------------------------------
 
 /**
- * A request holds one or more jobs that get executed sequentially.
+ * A request holds one or more jobs that get executed sequentially. A request can depend on other
+ * requests, it will not start before all requests it depends on are done and it fails if one of
+ * them fails.
 **/
 class DIVERSIA_UTIL_API Request
 {
@@ -98,6 +102,35 @@ public:
      * Calls the done event.
     **/
     void done();
+    /**
+     * Makes this request depend on another request, this request will not start before the other
+     * request is done and will fail if the other request fails.
+     *
+     * @remarks
+     *          Both requests must be owned by the same RequestManager and the other request must
+     *          not have finished yet.
+     *
+     * @param [in,out]  pRequest    The request to depend on.
+    **/
+    void addDependency( Request* pRequest );
+    /**
+     * Query if this request is waiting for requests it depends on.
+    **/
+    inline bool hasUnfinishedDependencies() const { return mUnfinishedDependencies != 0; }
+    /**
+     * Cancels this request. Jobs that have not run yet will not run and the completed jobs will
+     * be rewound. A running threaded job is notified through Job::isCancelled(), the request is
+     * rewound when that job returns.
+    **/
+    void cancel();
+    /**
+     * Query if this request has been cancelled.
+    **/
+    inline bool isCancelled() const { return mIsCancelled; }
+    /**
+     * Query if this request has a threaded job running on a worker thread.
+    **/
+    inline bool isRunningThreaded() const { return mThreadedState == THREADED_RUNNING; }
 
     /**
      * Sets finished slot ( void func(bool [false when request fails]) )
@@ -107,12 +140,35 @@ public:
     inline void setFinishedSlot( const sigc::slot<void,bool>& rFinishedSlot ) { mFinishedSlot = rFinishedSlot; }
 
 private:
+    friend class RequestManager;
+
+    enum ThreadedState
+    {
+        THREADED_NONE,
+        THREADED_RUNNING,
+        THREADED_FINISHED
+    };
+
+    void abort();
+    void threadedJobFinished( Job::JobState state );
+    void dependencyFinished( Request* pRequest, bool success );
+    void notifyDependents( bool success );
+
     RequestState            mRequestState;
     std::queue<Job*>        mJobs;
     std::stack<Job*>        mJobStack;
     unsigned int            mPriority;
     RequestManager*         mRequestManager;
     sigc::slot<void,bool>   mFinishedSlot;
+
+    ThreadedState           mThreadedState;
+    Job::JobState           mThreadedJobState;
+    bool                    mIsCancelled;
+    bool                    mDependencyFailed;
+    unsigned int            mUnfinishedDependencies;
+    std::set<Request*>      mDependencies;
+    std::set<Request*>      mDependents;
+
 };
 
 //------------------------------------------------------------------------------
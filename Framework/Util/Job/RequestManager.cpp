@@ -21,12 +21,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 -----------------------------------------------------------------------------
 */
-
 #include "Util/Platform/StableHeaders.h"
 
 #include "Util/Job/RequestManager.h"
 #include "Util/Job/Request.h"
 #include "Util/Job/Job.h"
+#include "Util/Job/ThreadPool.h"
+#include "Util/Helper/TickScheduler.h"
+#include "Util/Log/Log.h"
+
+#include <boost/bind.hpp>
 
 namespace Diversia
 {
@@ -34,14 +38,23 @@ namespace Util
 {
 //------------------------------------------------------------------------------
 
-RequestManager::RequestManager()
+RequestManager::RequestManager( unsigned int threads /*= 0*/ ):
+    mThreadPool( new ThreadPool( threads ) )
 {
 
 }
 
 RequestManager::~RequestManager()
 {
+    RequestManager::removeAll();
 
+    for ( std::list<Job*>::iterator i = mLaterJobs.begin(); i != mLaterJobs.end(); ++i )
+    {
+        delete ( *i );
+    }
+    mLaterJobs.clear();
+
+    mThreadPool.reset();
 }
 
 void RequestManager::addRequest( Request* pRequest )
@@ -49,13 +62,24 @@ void RequestManager::addRequest( Request* pRequest )
     mRequests.push_back( pRequest );
 }
 
+void RequestManager::cancelRequest( Request* pRequest )
+{
+    pRequest->cancel();
+}
+
 void RequestManager::addLaterJob( Job* pJob )
 {
+    pJob->mLaterRetriesCounter = 0;
+    pJob->mLaterTime = TickScheduler::getMicroseconds() + 
+        (boost::uint64_t)pJob->getLaterTimer() * 1000;
     mLaterJobs.push_back( pJob );
 }
 
 void RequestManager::update()
 {
+    // Hand results of threaded jobs back to their requests.
+    RequestManager::processFinishedJobs();
+
     // Run requests
     std::list<Request*>::iterator i;
     for ( i = mRequests.begin(); i != mRequests.end(); i++ )
@@ -67,11 +91,13 @@ void RequestManager::update()
             case Request::REQUEST_DONE:
             {
                 ( *i )->done();
+                ( *i )->notifyDependents( true );
                 mFinishedRequests.push( i );
                 break;
             }
             case Request::REQUEST_REWINDING_DONE:
             {
+                ( *i )->notifyDependents( false );
                 mFinishedRequests.push( i );
                 break;
             }
@@ -87,11 +113,37 @@ void RequestManager::update()
         delete request;
     }
 
-    // TODO: Run 'later' jobs
+    // Run 'later' jobs
+    RequestManager::runLaterJobs();
 }
 
 void RequestManager::removeAll()
 {
+    // Cancel everything first so running threaded jobs can return early, requests with a running
+    // threaded job cannot be deleted until it has returned.
+    for ( std::list<Request*>::iterator i = mRequests.begin(); i != mRequests.end(); ++i )
+    {
+        ( *i )->cancel();
+    }
+
+    while ( true )
+    {
+        RequestManager::processFinishedJobs();
+
+        bool running = false;
+        for ( std::list<Request*>::iterator i = mRequests.begin(); i != mRequests.end(); ++i )
+        {
+            if ( ( *i )->isRunningThreaded() ) 
+            {
+                running = true;
+                break;
+            }
+        }
+
+        if ( !running ) break;
+        boost::this_thread::yield();
+    }
+
     for ( std::list<Request*>::iterator i = mRequests.begin(); i != mRequests.end(); )
     {
         delete ( *i );
@@ -99,6 +151,104 @@ void RequestManager::removeAll()
     }
 }
 
+void RequestManager::runThreaded( Request* pRequest, Job* pJob )
+{
+    mThreadPool->submit( boost::bind( &RequestManager::runThreadedJob, this, pRequest, pJob ) );
+}
+
+void RequestManager::runThreadedJob( Request* pRequest, Job* pJob )
+{
+    // Runs on a worker thread.
+    Job::JobState state = Job::JOB_FAILED;
+
+    try
+    {
+        state = pJob->run();
+    }
+    catch( const Exception& e )
+    {
+        ULOGE << "Threaded job failed: " << e.what();
+    }
+    catch( const std::exception& e )
+    {
+        ULOGE << "Threaded job failed: " << e.what();
+    }
+    catch( ... )
+    {
+        // The job must always be handed back, or its request never leaves the threaded state.
+        ULOGE << "Threaded job failed with an unknown exception.";
+    }
+
+    boost::mutex::scoped_lock lock( mFinishedJobsMutex );
+    mFinishedJobs.push_back( std::make_pair( pRequest, state ) );
+}
+
+void RequestManager::processFinishedJobs()
+{
+    FinishedJobs finishedJobs;
+
+    {
+        boost::mutex::scoped_lock lock( mFinishedJobsMutex );
+        finishedJobs.swap( mFinishedJobs );
+    }
+
+    for ( FinishedJobs::iterator i = finishedJobs.begin(); i != finishedJobs.end(); ++i )
+    {
+        i->first->threadedJobFinished( i->second );
+    }
+}
+
+void RequestManager::runLaterJobs()
+{
+    if ( mLaterJobs.empty() ) return;
+
+    boost::uint64_t now = TickScheduler::getMicroseconds();
+
+    for ( std::list<Job*>::iterator i = mLaterJobs.begin(); i != mLaterJobs.end(); )
+    {
+        Job* job = *i;
+
+        if ( now < job->mLaterTime )
+        {
+            ++i;
+            continue;
+        }
+
+        Job::JobState state = job->runLater();
+        switch ( state )
+        {
+            case Job::JOB_DONE:
+            {
+                job->done();
+                delete job;
+                mLaterJobs.erase( i++ );
+                continue;
+            }
+            case Job::JOB_WORKING:
+            case Job::JOB_WAITING:
+            {
+                // Still busy, poll again next update without counting a retry.
+                break;
+            }
+            default:
+            {
+                if ( ++job->mLaterRetriesCounter >= job->getLaterRetries() )
+                {
+                    job->failed();
+                    delete job;
+                    mLaterJobs.erase( i++ );
+                    continue;
+                }
+
+                job->mLaterTime = now + (boost::uint64_t)job->getLaterTimer() * 1000;
+                break;
+            }
+        }
+
+        ++i;
+    }
+}
+
 //------------------------------------------------------------------------------
 }
 }
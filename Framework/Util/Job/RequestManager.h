@@ -25,6 +25,9 @@ THE SOFTWARE.
 #ifndef DIVERSIA_UTIL_REQUESTMANAGER_H
 #define DIVERSIA_UTIL_REQUESTMANAGER_H
 
+#include "Util/Job/Job.h"
+#include <boost/thread/mutex.hpp>
+
 namespace Diversia
 {
 namespace Util
@@ -32,15 +35,20 @@ namespace Util
 //------------------------------------------------------------------------------
 
 /**
- * Manages a queue of non threaded requests.
+ * Manages a queue of requests. Requests are advanced on the thread that calls update() (the main
+ * thread), threaded jobs are run on a work stealing thread pool and their results are handed back
+ * to their requests in the next update().
 **/
 class DIVERSIA_UTIL_API RequestManager
 {
 public:
     /**
-     * Default constructor.
+     * Constructor.
+     *
+     * @param   threads The amount of worker threads for threaded jobs, 0 to use the amount of
+     *                  hardware threads minus one.
     **/
-    RequestManager();
+    RequestManager( unsigned int threads = 0 );
     /**
      * Destructor.
     **/
@@ -52,9 +60,17 @@ public:
     **/
     void addRequest( Request* pRequest );
     /**
-     * Adds a job to the queue of jobs that get executed again at a later time.
+     * Cancels a request, it will be rewound and removed in a following update().
+     *
+     * @param [in,out]  pRequest    The request to cancel.
+    **/
+    void cancelRequest( Request* pRequest );
+    /**
+     * Adds a job to the queue of jobs that get executed again at a later time. The job will be
+     * run with Job::runLater() every Job::getLaterTimer() milliseconds until it is done or has
+     * been retried Job::getLaterRetries() times.
      *
-     * @param [in,out]  pJob    The job to add.
+     * @param [in,out]  pJob    The job to add, the RequestManager takes ownership.
     **/
     void addLaterJob( Job* pJob );
     /**
@@ -62,18 +78,43 @@ public:
     **/
     void update();
     /**
-     * Removes all requests.
+     * Removes all requests, waits for running threaded jobs to return.
     **/
     void removeAll();
+    /**
+     * Gets the amount of requests.
+    **/
+    inline unsigned int getRequestCount() const { return mRequests.size(); }
+    /**
+     * Gets the amount of 'later' jobs.
+    **/
+    inline unsigned int getLaterJobCount() const { return mLaterJobs.size(); }
+    /**
+     * Gets the thread pool that runs threaded jobs.
+    **/
+    inline ThreadPool& getThreadPool() { return *mThreadPool; }
 
 private:
+    friend class Request;
+    typedef std::vector<std::pair<Request*, Job::JobState> > FinishedJobs;
+
+    void runThreaded( Request* pRequest, Job* pJob );
+    void runThreadedJob( Request* pRequest, Job* pJob );
+    void processFinishedJobs();
+    void runLaterJobs();
+
     std::list<Request*>                         mRequests;
     std::stack<std::list<Request*>::iterator>   mFinishedRequests;
     std::list<Job*>                             mLaterJobs;
+
+    boost::scoped_ptr<ThreadPool>               mThreadPool;
+    boost::mutex                                mFinishedJobsMutex;
+    FinishedJobs                                mFinishedJobs;
+
 };
 
 //------------------------------------------------------------------------------
 }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,137 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_UTIL_SPSCQUEUE_H
+#define DIVERSIA_UTIL_SPSCQUEUE_H
+
+#include <boost/noncopyable.hpp>
+
+namespace Diversia
+{
+namespace Util
+{
+//------------------------------------------------------------------------------
+
+/**
+Bounded lock-free queue for exactly one producer thread and one consumer thread. Items are stored
+in a ring buffer, the producer only writes the tail index and the consumer only writes the head
+index so no locks are needed. push() and pop() never block, they fail when the queue is full or
+empty.
+**/
+template <typename T> class SPSCQueue : public boost::noncopyable
+{
+public:
+    /**
+    Constructor.
+
+    @param  capacity    The maximum amount of items in the queue.
+    **/
+    SPSCQueue( unsigned int capacity ): mBuffer( capacity + 1 ), mHead( 0 ), mTail( 0 ) {}
+
+    /**
+    Pushes an item to the back of the queue. May only be called from the producer thread.
+
+    @param  rItem   The item to push.
+
+    @return True if the item was pushed, false if the queue is full.
+    **/
+    bool push( const T& rItem )
+    {
+        unsigned int tail = mTail;
+        unsigned int next = SPSCQueue::increment( tail );
+        if( next == mHead ) return false;
+
+        mBuffer[tail] = rItem;
+        // Publish the item before publishing the new tail.
+        SPSCQueue::barrier();
+        mTail = next;
+        return true;
+    }
+    /**
+    Pops an item from the front of the queue. May only be called from the consumer thread.
+
+    @param [out] rItem  The popped item.
+
+    @return True if an item was popped, false if the queue is empty.
+    **/
+    bool pop( T& rItem )
+    {
+        unsigned int head = mHead;
+        if( head == mTail ) return false;
+
+        // Read the item after reading the tail and before releasing the slot.
+        SPSCQueue::barrier();
+        rItem = mBuffer[head];
+        SPSCQueue::barrier();
+        mHead = SPSCQueue::increment( head );
+        return true;
+    }
+    /**
+    Query if the queue is empty. Only exact when called from the consumer thread.
+    **/
+    inline bool empty() const { return mHead == mTail; }
+    /**
+    Query if the queue is full. Only exact when called from the producer thread.
+    **/
+    inline bool full() const { return SPSCQueue::increment( mTail ) == mHead; }
+    /**
+    Gets an estimate of the amount of items in the queue.
+    **/
+    inline unsigned int size() const
+    {
+        unsigned int head = mHead;
+        unsigned int tail = mTail;
+        return tail >= head ? tail - head : tail + (unsigned int)mBuffer.size() - head;
+    }
+    /**
+    Gets the maximum amount of items in the queue.
+    **/
+    inline unsigned int capacity() const { return (unsigned int)mBuffer.size() - 1; }
+
+private:
+    inline unsigned int increment( unsigned int index ) const
+    {
+        return ++index == mBuffer.size() ? 0 : index;
+    }
+    static inline void barrier()
+    {
+#if DIVERSIA_PLATFORM == DIVERSIA_PLATFORM_WIN32
+        MemoryBarrier();
+#else
+        __sync_synchronize();
+#endif
+    }
+
+    std::vector<T>          mBuffer;
+    volatile unsigned int   mHead;
+    char                    mPadding[64];   ///< Keeps head and tail on separate cache lines.
+    volatile unsigned int   mTail;
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Util
+} // Namespace Diversia
+
+#endif // DIVERSIA_UTIL_SPSCQUEUE_H
@@ -0,0 +1,174 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "Util/Platform/StableHeaders.h"
+
+#include "Util/Job/ThreadPool.h"
+#include "Util/Log/Log.h"
+
+#include <boost/bind.hpp>
+
+namespace Diversia
+{
+namespace Util
+{
+//------------------------------------------------------------------------------
+
+ThreadPool::ThreadPool( unsigned int threads /*= 0*/ ):
+    mPendingTasks( 0 ),
+    mNextWorker( 0 ),
+    mShutdown( false )
+{
+    if( !threads )
+    {
+        threads = boost::thread::hardware_concurrency();
+        threads = threads > 1 ? threads - 1 : 1;
+    }
+
+    for( unsigned int i = 0; i < threads; ++i )
+    {
+        mWorkers.push_back( new ThreadPool::Worker() );
+    }
+
+    for( unsigned int i = 0; i < threads; ++i )
+    {
+        mThreads.create_thread( boost::bind( &ThreadPool::workerLoop, this, i ) );
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        boost::mutex::scoped_lock lock( mSleepMutex );
+        mShutdown = true;
+    }
+
+    mSleepCondition.notify_all();
+    mThreads.join_all();
+
+    for( std::vector<ThreadPool::Worker*>::iterator i = mWorkers.begin(); i != mWorkers.end(); 
+        ++i )
+    {
+        delete *i;
+    }
+}
+
+void ThreadPool::submit( const Task& rTask )
+{
+    {
+        // Count the task before it can be taken, so the counter never drops below the amount of
+        // queued tasks.
+        boost::mutex::scoped_lock lock( mSleepMutex );
+        unsigned int index = mNextWorker++ % mWorkers.size();
+        ++mPendingTasks;
+
+        boost::mutex::scoped_lock workerLock( mWorkers[index]->mMutex );
+        mWorkers[index]->mTasks.push_back( rTask );
+    }
+
+    mSleepCondition.notify_one();
+}
+
+unsigned int ThreadPool::getPendingTaskCount() const
+{
+    boost::mutex::scoped_lock lock( mSleepMutex );
+    return mPendingTasks;
+}
+
+void ThreadPool::workerLoop( unsigned int index )
+{
+    ThreadPool::Task task;
+
+    while( true )
+    {
+        if( ThreadPool::popTask( index, task ) || ThreadPool::stealTask( index, task ) )
+        {
+            {
+                boost::mutex::scoped_lock lock( mSleepMutex );
+                --mPendingTasks;
+            }
+
+            try
+            {
+                task();
+            }
+            catch( const Exception& e )
+            {
+                ULOGE << "Exception in thread pool task: " << e.what();
+            }
+            catch( const std::exception& e )
+            {
+                ULOGE << "Exception in thread pool task: " << e.what();
+            }
+            catch( ... )
+            {
+                ULOGE << "Unknown exception in thread pool task.";
+            }
+
+            task.clear();
+            continue;
+        }
+
+        // No work available, sleep until a task is submitted or the pool is shut down. Workers 
+        // only stop when no tasks are pending, so the queues are drained on shutdown. The
+        // pending task counter may be non-zero while another worker is taking the task, in which 
+        // case the loop just tries again.
+        boost::mutex::scoped_lock lock( mSleepMutex );
+        if( mShutdown && !mPendingTasks ) return;
+        if( !mPendingTasks && !mShutdown ) mSleepCondition.wait( lock );
+    }
+}
+
+bool ThreadPool::popTask( unsigned int index, Task& rTask )
+{
+    ThreadPool::Worker& worker = *mWorkers[index];
+    boost::mutex::scoped_lock lock( worker.mMutex );
+
+    if( worker.mTasks.empty() ) return false;
+
+    rTask = worker.mTasks.back();
+    worker.mTasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::stealTask( unsigned int index, Task& rTask )
+{
+    for( unsigned int i = 1; i < mWorkers.size(); ++i )
+    {
+        ThreadPool::Worker& victim = *mWorkers[( index + i ) % mWorkers.size()];
+        boost::mutex::scoped_lock lock( victim.mMutex );
+
+        if( !victim.mTasks.empty() )
+        {
+            rTask = victim.mTasks.front();
+            victim.mTasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+}
+}
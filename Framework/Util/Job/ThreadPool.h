@@ -0,0 +1,106 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef DIVERSIA_UTIL_THREADPOOL_H
+#define DIVERSIA_UTIL_THREADPOOL_H
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace Diversia
+{
+namespace Util
+{
+//------------------------------------------------------------------------------
+
+/**
+ * Work stealing thread pool. Every worker thread has its own task queue, tasks are submitted
+ * round robin to these queues. A worker takes tasks from the back of its own queue and when its
+ * queue is empty it steals tasks from the front of the queues of other workers.
+ *
+ * Idle workers sleep on a condition variable until a task is submitted. Exceptions thrown by a
+ * task are logged and do not stop the worker, tasks that need to report failure have to catch
+ * their own exceptions. Tasks may run in any order and on any worker.
+**/
+class DIVERSIA_UTIL_API ThreadPool : public boost::noncopyable
+{
+public:
+    typedef boost::function<void()> Task;
+
+    /**
+     * Constructor, starts the worker threads.
+     *
+     * @param   threads The amount of worker threads to start, 0 to use the amount of hardware
+     *                  threads minus one (for the main thread), with a minimum of 1.
+    **/
+    ThreadPool( unsigned int threads = 0 );
+    /**
+     * Destructor, runs all submitted tasks that have not started yet and waits for them to 
+     * finish before the worker threads are stopped.
+    **/
+    ~ThreadPool();
+    /**
+     * Submits a task to be executed on one of the worker threads. Can be called from any thread.
+     *
+     * @param   rTask   The task to execute.
+    **/
+    void submit( const Task& rTask );
+    /**
+     * Gets the amount of worker threads.
+    **/
+    inline unsigned int getThreadCount() const { return mWorkers.size(); }
+    /**
+     * Gets the amount of tasks that have been submitted but have not started yet.
+    **/
+    unsigned int getPendingTaskCount() const;
+
+private:
+    struct Worker
+    {
+        boost::mutex        mMutex;
+        std::deque<Task>    mTasks;
+    };
+
+    void workerLoop( unsigned int index );
+    bool popTask( unsigned int index, Task& rTask );
+    bool stealTask( unsigned int index, Task& rTask );
+
+    std::vector<Worker*>                mWorkers;
+    boost::thread_group                 mThreads;
+
+    mutable boost::mutex                mSleepMutex;
+    boost::condition_variable           mSleepCondition;
+    unsigned int                        mPendingTasks;
+    unsigned int                        mNextWorker;
+    bool                                mShutdown;
+
+};
+
+//------------------------------------------------------------------------------
+}
+}
+
+#endif
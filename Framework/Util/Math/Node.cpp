@@ -59,6 +59,7 @@ Node::Node(const String& name)
     mInitialOrientation(Quaternion::IDENTITY),
     mInitialScale(Vector3::UNIT_SCALE),
     mCachedTransformOutOfDate(true),
+    mTransformChanges(0),
     mListener(0)
 {
     needUpdate();
@@ -339,6 +340,7 @@ void Node::setOrientation( Quaternion q )
     }
 
     mOrientation = q;
+    mTransformChanges |= TC_ORIENTATION;
     needUpdate();
 }
 //-----------------------------------------------------------------------
@@ -346,6 +348,7 @@ void Node::setPosition(const Vector3& pos)
 {
     //assert(!pos.isNaN() && "Invalid vector supplied as parameter");
     mPosition = pos;
+    mTransformChanges |= TC_POSITION;
     needUpdate();
 }
 //-----------------------------------------------------------------------
@@ -389,6 +392,7 @@ void Node::translate(const Vector3& d, TransformSpace relativeTo)
         mPosition += d;
         break;
     }
+    mTransformChanges |= TC_POSITION;
     needUpdate();
 
 }
@@ -450,6 +454,7 @@ void Node::rotate(const Quaternion& q, TransformSpace relativeTo)
         mOrientation = mOrientation * qnorm;
         break;
     }
+    mTransformChanges |= TC_ORIENTATION;
     needUpdate();
 }
 
@@ -572,6 +577,7 @@ void Node::setScale(const Vector3& scale)
 {
     //assert(!scale.isNaN() && "Invalid vector supplied as parameter");
     mScale = scale;
+    mTransformChanges |= TC_SCALE;
     needUpdate();
 }
 //-----------------------------------------------------------------------
@@ -590,6 +596,7 @@ void Node::setInheritScale(bool inherit)
 void Node::scale(const Vector3& scale)
 {
     mScale = mScale * scale;
+    mTransformChanges |= TC_SCALE;
     needUpdate();
 
 }
@@ -599,6 +606,7 @@ void Node::scale(Real x, Real y, Real z)
     mScale.x *= x;
     mScale.y *= y;
     mScale.z *= z;
+    mTransformChanges |= TC_SCALE;
     needUpdate();
 
 }
@@ -615,6 +623,7 @@ void Node::resetToInitialState()
     mPosition = mInitialPosition;
     mOrientation = mInitialOrientation;
     mScale = mInitialScale;
+    mTransformChanges = TC_ALL;
 
     needUpdate();
 }
@@ -186,6 +186,9 @@ protected:
     mutable Matrix4 mCachedTransform;
     mutable bool mCachedTransformOutOfDate;
 
+    /// Local transform components that have changed, see TransformChange.
+    unsigned char mTransformChanges;
+
     /** Node listener - only one allowed (no list) for size & performance reasons. */
     Listener* mListener;
 
@@ -728,6 +731,29 @@ public:
         return mLocalTransformChangeSignal.connect( rSlot );
     }
 
+    /** Enumeration of the local transform components that are tracked for changes. */
+    enum TransformChange
+    {
+        TC_POSITION = 1,
+        TC_ORIENTATION = 2,
+        TC_SCALE = 4,
+        TC_ALL = TC_POSITION | TC_ORIENTATION | TC_SCALE
+    };
+    /**
+    Gets the local transform components (see TransformChange) that have been changed through the
+    transform methods since the last call to clearTransformChanges().
+    **/
+    inline unsigned char getTransformChanges() const { return mTransformChanges; }
+    /**
+    Query if any local transform component has changed since the last call to
+    clearTransformChanges().
+    **/
+    inline bool hasTransformChanges() const { return mTransformChanges != 0; }
+    /**
+    Clears the local transform changes.
+    **/
+    inline void clearTransformChanges() { mTransformChanges = 0; }
+
     static void bindNode();
     static void bindTransformSpace();
 };
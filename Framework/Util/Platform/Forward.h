@@ -39,6 +39,7 @@ class ConfigManager;
 // Helper
 class Exception;
 class ConsoleInput;
+class TickScheduler;
 
 // Math
 class Angle;
@@ -68,6 +69,7 @@ class MemorySerialization;
 class Job;
 class Request;
 class RequestManager;
+class ThreadPool;
 
 // State
 class State;
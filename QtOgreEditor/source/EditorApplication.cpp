@@ -20,6 +20,8 @@ This file is part of Diversia.
 #include "Log/QtLogger.h"
 #include "Object/EditorObjectManager.h"
 #include "Object/Object.h"
+#include "Object/ReplicationChannels.h"
+#include "Object/DirtyReplicas.h"
 #include "OgreClient/Audio/AudioManager.h"
 #include "OgreClient/GameMode/GameModePlugin.h"
 #include "OgreClient/Graphics/CameraManager.h"
@@ -45,6 +47,9 @@ This file is part of Diversia.
 #include "OgreClient/Object/Text.h"
 #include "OgreClient/Physics/PhysicsManager.h"
 #include "OgreClient/Resource/ResourceManager.h"
+#include "Shared/Communication/NetworkStage.h"
+#include "Shared/Communication/TrafficStatistics.h"
+#include "Shared/Communication/PacketReplay.h"
 #include "Shared/Crash/CrashReporter.h"
 #include "Shared/Object/TemplateComponentFactory.h"
 #include "Shared/Plugin/Factories/ObjectManagerFactory.h"
@@ -221,6 +226,12 @@ void EditorApplication::init( int argc, char* argv[] )
         mGridManager.reset( new GridManager( mUpdateSignal ) );
         mConfigManager->registerObject( mGridManager.get() );
         mConfigManager->registerObject( ServerConnection::getSettings() );
+        mConfigManager->registerObject( NetworkStage::getSettings() );
+        mConfigManager->registerObject( TrafficStatistics::getSettings() );
+        mConfigManager->registerObject( PacketReplay::getSettings() );
+        mConfigManager->registerObject( TransformInterpolator::getSettings() );
+        mConfigManager->registerObject( ReplicationChannels::getSettings() );
+        mConfigManager->registerObject( DirtyReplicas::getSettings() );
         mCameraManager->setGridManager( *mGridManager.get() );
         EditorGlobals::mGrid = mGridManager.get();
 
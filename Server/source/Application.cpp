@@ -29,6 +29,10 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "ClientServerPlugin/SkyPlugin.h"
 #include "ClientServerPlugin/Terrain.h"
 #include "Communication/ClientConnection.h"
+#include "Communication/IdleWorldBenchmark.h"
+#include "Communication/InterestManager.h"
+#include "Communication/ReplicationScheduler.h"
+#include "Communication/ServerLink.h"
 #include "Communication/ServerNeighborsPlugin.h"
 #include "GameMode/GameModePlugin.h"
 #include "Object/Animation.h"
@@ -38,6 +42,8 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "Object/LuaObjectScript.h"
 #include "Object/Mesh.h"
 #include "Object/Particle.h"
+#include "Object/ReplicationChannels.h"
+#include "Object/DirtyReplicas.h"
 #include "Object/RigidBody.h"
 #include "Object/ServerObject.h"
 #include "Object/ServerObjectManager.h"
@@ -46,12 +52,20 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "Permission/PermissionManager.h"
 #include "Physics/PhysicsManager.h"
 #include "Resource/LocalResourceManager.h"
+#include "Shared/Camp/PropertyIdTable.h"
 #include "Shared/ClientServerPlugin/Factories/ObjectManagerFactory.h"
 #include "Shared/ClientServerPlugin/Factories/TemplatePluginFactory.h"
+#include "Shared/Communication/NetworkStage.h"
+#include "Shared/Communication/TrafficStatistics.h"
+#include "Shared/Communication/PacketReplay.h"
+#include "Shared/Communication/WorldSnapshot.h"
 #include "Shared/Crash/CrashReporter.h"
 #include "Shared/Lua/LuaManager.h"
 #include "Shared/Object/TemplateComponentFactory.h"
 #include "Util/Helper/ConsoleInput.h"
+#include "Util/Helper/TickScheduler.h"
+#include "Util/Job/RequestManager.h"
+#include "Util/Job/ThreadPool.h"
 #include "Util/Serialization/XMLSerializationFile.h"
 
 namespace Diversia
@@ -62,8 +76,9 @@ namespace Server
 
 Application::Application():
     mShutdown( false ),
+    mTickScheduler( new TickScheduler( 60.0 ) ),
     mLogLevel( LOG_INFO ),
-    mSleepMS( 10 )
+    mWorkerThreads( 0 )
 {
     Globals::mApp = this;
     Globals::mUpdateSignal = &mUpdateSignal;
@@ -76,6 +91,7 @@ Application::~Application()
 {
     Globals::mFrameSignal = 0;
     Globals::mUpdateSignal = 0;
+    Globals::mRequest = 0;
     Globals::mConfig = 0;
     Globals::mApp = 0;
 }
@@ -103,6 +119,12 @@ void Application::init()
         mCrashReporter->setAppVersion( "trunk" ); // TODO: Get revision number
         mConfigManager->registerObject( reporter );
 
+        // Initialize request manager
+        mRequestManager.reset( new RequestManager( mWorkerThreads ) );
+        Globals::mRequest = mRequestManager.get();
+        LOGI << "Running threaded jobs on " << mRequestManager->getThreadPool().getThreadCount() << 
+            " worker threads";
+
         // Add component factories
         TemplateComponentFactory<Mesh, ServerObject, false>::registerFactory();
         TemplateComponentFactory<Entity, ServerObject, false>::registerFactory();
@@ -123,6 +145,9 @@ void Application::init()
         TemplatePluginFactory<GameModePlugin, ClientPluginManager>::registerFactory();
         TemplatePluginFactory<Terrain, ClientPluginManager>::registerFactory();
 
+        // Report properties that are sent by name because their identifiers collide.
+        PropertyIdTable::checkClasses();
+
         // Initialize scripting
         mLuaManager.reset( new LuaManager() );
         Globals::mLua = mLuaManager.get();
@@ -150,6 +175,16 @@ void Application::init()
 
         // Initialize client connection
         mConfigManager->registerObject( ClientConnection::getSettings() );
+        mConfigManager->registerObject( InterestManager::getSettings() );
+        mConfigManager->registerObject( ReplicationScheduler::getSettings() );
+        mConfigManager->registerObject( ServerLink::getSettings() );
+        mConfigManager->registerObject( WorldSnapshot::getSettings() );
+        mConfigManager->registerObject( NetworkStage::getSettings() );
+        mConfigManager->registerObject( TrafficStatistics::getSettings() );
+        mConfigManager->registerObject( PacketReplay::getSettings() );
+        mConfigManager->registerObject( ReplicationChannels::getSettings() );
+        mConfigManager->registerObject( DirtyReplicas::getSettings() );
+        mConfigManager->registerObject( IdleWorldBenchmark::getSettings() );
         mClientConnection.reset( new ClientConnection( mUpdateSignal ) );
         mClientConnection->listen();
 
@@ -178,22 +213,38 @@ void Application::init()
 
 void Application::run()
 {
-    boost::timer timer;
+    LOGI << "Running at " << mTickScheduler->getTickRate() << " ticks per second";
+
+    mTickScheduler->start();
 
     while( !mShutdown )
     {
-        const Real elapsed = timer.elapsed();
-        timer.restart();
+        const Real elapsed = mTickScheduler->beginTick();
+        IdleWorldBenchmark* benchmark = mClientConnection ? mClientConnection->getBenchmark() : 0;
+        if( benchmark && !benchmark->isFinished() ) benchmark->beginTick();
 
         // Fire update signals.
         mUpdateSignal();
         mFrameSignal( elapsed );
 
-#if DIVERSIA_PLATFORM == DIVERSIA_PLATFORM_WIN32
-        Sleep( mSleepMS );
-#else
-        usleep( mSleepMS * 1000.0 );
-#endif
+        // Hand finished threaded jobs back to their requests and advance requests.
+        mRequestManager->update();
+
+        if( mClientConnection && mClientConnection->isReplayFinished() && 
+            PacketReplay::getSettings().mQuitWhenFinished )
+            Application::quit();
+
+        if( benchmark && !benchmark->isFinished() )
+        {
+            benchmark->endTick();
+            if( benchmark->isFinished() && IdleWorldBenchmark::getSettings().mQuitWhenFinished )
+                Application::quit();
+        }
+
+        // Wait until the deadline of the next tick, replays at maximum speed do not wait.
+        if( !mClientConnection || !mClientConnection->isReplaying() || 
+            PacketReplay::getSettings().mSpeed > 0 )
+            mTickScheduler->endTick();
     }
 }
 
@@ -40,6 +40,15 @@ public:
     void init();
     void run();
     inline void quit() { mShutdown = true; }
+
+    /**
+    Gets the tick scheduler that drives the main loop.
+    **/
+    inline TickScheduler& getTickScheduler() { return *mTickScheduler; }
+    /**
+    Gets the request manager that runs (threaded) jobs, it is updated once every tick.
+    **/
+    inline RequestManager& getRequestManager() { return *mRequestManager; }
     
 private:
     friend class Bindings::CampBindings;    ///< Allow private access for camp bindings.
@@ -48,6 +57,7 @@ private:
     sigc::signal<void, Real>            mFrameSignal;
     bool                                mShutdown;
 
+    boost::scoped_ptr<TickScheduler>        mTickScheduler;
     boost::scoped_ptr<Logger>               mLogger;
     boost::scoped_ptr<ConfigManager>        mConfigManager;
     boost::scoped_ptr<CrashReporter>        mCrashReporter;
@@ -55,10 +65,11 @@ private:
     boost::scoped_ptr<LuaManager>           mLuaManager;
     boost::scoped_ptr<PhysicsManager>       mPhysicsManager;
     boost::scoped_ptr<ClientConnection>     mClientConnection;
+    boost::scoped_ptr<RequestManager>       mRequestManager;
 
     // Settings
     LogLevel        mLogLevel;
-    unsigned int    mSleepMS;
+    unsigned int    mWorkerThreads;
 
 };
 
@@ -30,6 +30,10 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "ClientServerPlugin/SkyPlugin.h"
 #include "ClientServerPlugin/Terrain.h"
 #include "Communication/ClientConnection.h"
+#include "Communication/IdleWorldBenchmark.h"
+#include "Communication/InterestManager.h"
+#include "Communication/ReplicationScheduler.h"
+#include "Communication/ServerLink.h"
 #include "Communication/ServerNeighborsPlugin.h"
 #include "GameMode/GameModePlugin.h"
 #include "Object/Animation.h"
@@ -64,11 +68,13 @@ void CampBindings::bindServerObjectManager()
 {
     camp::Class::declare<ServerObjectManager>( "ServerObjectManager" )
         .base<ObjectManager>()
-        .base<ClientPlugin>();
+        .base<ClientPlugin>()
         // Constructors
         // Properties (read-only)
         // Properties (read/write)
         // Functions
+        .function( "SetComponentReplicationWeight", boost::function<void(ServerObjectManager&, ComponentType, Real)>( boost::bind( &ReplicationScheduler::setComponentWeight, _2, _3 ) ) )
+        .function( "GetComponentReplicationWeight", boost::function<Real(ServerObjectManager&, ComponentType)>( boost::bind( &ReplicationScheduler::getComponentWeight, _2 ) ) );
         // Static functions
         // Operators
 }
@@ -76,10 +82,14 @@ void CampBindings::bindServerObjectManager()
 void CampBindings::bindServerObject()
 {
     camp::Class::declare<ServerObject>( "ServerObject" )
-        .base<Object>();
+        .base<Object>()
         // Constructors
         // Properties (read-only)
         // Properties (read/write)
+        .property( "RelevanceRadius", &ServerObject::mRelevanceRadius )
+        .property( "ViewRadius", &ServerObject::mViewRadius )
+        .property( "ReplicationPriority", &ServerObject::mReplicationPriority )
+        .property( "MaxControlSpeed", &ServerObject::mMaxControlSpeed );
         // Functions
         // Static functions
         // Operators
@@ -245,6 +255,101 @@ void CampBindings::bindClientConnectionSettings()
         .property( "Timeout", &ClientConnection::Settings::mTimeoutMS )
             .tag( "Configurable" )
         .property( "ShutdownBlockDuraction", &ClientConnection::Settings::mShutdownBlockDuractionMS )
+        .property( "Loopback", &ClientConnection::Settings::mLoopback )
+            .tag( "Configurable" )
+        .property( "RecordFile", &ClientConnection::Settings::mRecordFile )
+            .tag( "Configurable" )
+        .property( "ReplayFile", &ClientConnection::Settings::mReplayFile )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindIdleWorldBenchmarkSettings()
+{
+    camp::Class::declare<IdleWorldBenchmark::Settings>( "IdleWorldBenchmarkSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "ReplicaCount", &IdleWorldBenchmark::Settings::mReplicaCount )
+            .tag( "Configurable" )
+        .property( "Spacing", &IdleWorldBenchmark::Settings::mSpacing )
+            .tag( "Configurable" )
+        .property( "Ticks", &IdleWorldBenchmark::Settings::mTicks )
+            .tag( "Configurable" )
+        .property( "SettleTicks", &IdleWorldBenchmark::Settings::mSettleTicks )
+            .tag( "Configurable" )
+        .property( "QuitWhenFinished", &IdleWorldBenchmark::Settings::mQuitWhenFinished )
+            .tag( "Configurable" )
+        .property( "ReportFile", &IdleWorldBenchmark::Settings::mReportFile )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindInterestManagerSettings()
+{
+    camp::Class::declare<InterestManager::Settings>( "InterestManagerSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Enabled", &InterestManager::Settings::mEnabled )
+            .tag( "Configurable" )
+        .property( "CellSize", &InterestManager::Settings::mCellSize )
+            .tag( "Configurable" )
+        .property( "ViewRadius", &InterestManager::Settings::mViewRadius )
+            .tag( "Configurable" )
+        .property( "Hysteresis", &InterestManager::Settings::mHysteresis )
+            .tag( "Configurable" )
+        .property( "UpdateInterval", &InterestManager::Settings::mUpdateIntervalMS )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindReplicationSchedulerSettings()
+{
+    camp::Class::declare<ReplicationScheduler::Settings>( "ReplicationSchedulerSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Enabled", &ReplicationScheduler::Settings::mEnabled )
+            .tag( "Configurable" )
+        .property( "BytesPerSecond", &ReplicationScheduler::Settings::mBytesPerSecond )
+            .tag( "Configurable" )
+        .property( "MaxBurst", &ReplicationScheduler::Settings::mMaxBurstMS )
+            .tag( "Configurable" )
+        .property( "DistanceScale", &ReplicationScheduler::Settings::mDistanceScale )
+            .tag( "Configurable" );
+        // Functions
+        // Static functions
+        // Operators
+}
+
+void CampBindings::bindServerLinkSettings()
+{
+    camp::Class::declare<ServerLink::Settings>( "ServerLinkSettings" )
+        // Constructors
+        // Properties (read-only)
+        // Properties (read/write)
+        .property( "Enabled", &ServerLink::Settings::mEnabled )
+            .tag( "Configurable" )
+        .property( "PortOffset", &ServerLink::Settings::mPortOffset )
+            .tag( "Configurable" )
+        .property( "GhostMargin", &ServerLink::Settings::mGhostMargin )
+            .tag( "Configurable" )
+        .property( "MigrationMargin", &ServerLink::Settings::mMigrationMargin )
+            .tag( "Configurable" )
+        .property( "UpdateInterval", &ServerLink::Settings::mUpdateIntervalMS )
+            .tag( "Configurable" )
+        .property( "AckTimeout", &ServerLink::Settings::mAckTimeoutMS )
+            .tag( "Configurable" )
+        .property( "ArrivalTimeout", &ServerLink::Settings::mArrivalTimeoutMS )
+            .tag( "Configurable" )
+        .property( "ConnectInterval", &ServerLink::Settings::mConnectIntervalMS )
             .tag( "Configurable" );
         // Functions
         // Static functions
@@ -259,9 +364,25 @@ void CampBindings::bindApplication()
         // Properties (read/write)
         .property( "LogLevel", &Application::mLogLevel )
             .tag( "Configurable" )
-        .property( "SleepMS", &Application::mSleepMS )
+        .property( "TickRate", &TickScheduler::getTickRate, &TickScheduler::setTickRate, &Application::getTickScheduler )
+            .tag( "Configurable" )
+        .property( "TickSpinTime", &TickScheduler::getSpinTime, &TickScheduler::setSpinTime, &Application::getTickScheduler )
             .tag( "Configurable" )
+        .property( "TickMaxCatchUp", &TickScheduler::getMaxCatchUpTicks, &TickScheduler::setMaxCatchUpTicks, &Application::getTickScheduler )
+            .tag( "Configurable" )
+        .property( "WorkerThreads", &Application::mWorkerThreads )
+            .tag( "Configurable" )
+        // Tick statistics (read-only)
+        .property( "TickCount", &TickScheduler::getTickCount, &Application::getTickScheduler )
+        .property( "TickOverruns", &TickScheduler::getOverrunCount, &Application::getTickScheduler )
+        .property( "TickSkipped", &TickScheduler::getSkippedCount, &Application::getTickScheduler )
+        .property( "TickTime", &TickScheduler::getLastTickTime, &Application::getTickScheduler )
+        .property( "TickTimeAverage", &TickScheduler::getAverageTickTime, &Application::getTickScheduler )
+        .property( "TickTimeMax", &TickScheduler::getMaxTickTime, &Application::getTickScheduler )
+        .property( "TickJitterAverage", &TickScheduler::getAverageJitter, &Application::getTickScheduler )
+        .property( "TickJitterMax", &TickScheduler::getMaxJitter, &Application::getTickScheduler )
         // Functions
+        .function( "ResetTickStatistics", &TickScheduler::resetStatistics, &Application::getTickScheduler )
         .function( "Quit", &Application::quit );
         // Static functions
         // Operators
@@ -350,9 +471,11 @@ void CampBindings::bindAnimation()
         .property( "Enabled", &Animation::mEnabled )
         .property( "Loop", &Animation::mLoop )
         .property( "Position", &Animation::mPosition )
+            .tag( "MaxRate", 10 )
         .property( "Length", &Animation::mLength )
         .property( "AutoLength", &Animation::mAutoLength )
-        .property( "Weight", &Animation::mWeight );
+        .property( "Weight", &Animation::mWeight )
+            .tag( "MaxRate", 10 );
         // Functions
         // Static functions
         // Operators
@@ -394,7 +517,7 @@ void CampBindings::bindRigidBody()
         // Constructors
         // Properties (read-only)
         // Properties (read/write)
-        .property( "PhysicsType", &RigidBody::mPhysicsType )
+        .property( "PhysicsType", &RigidBody::mPhysicsType, &RigidBody::setPhysicsType )
         .property( "Mass", &RigidBody::mMass )
         .property( "Friction", &btRigidBody::getFriction, &btRigidBody::setFriction, &RigidBody::getRigidBody )
             .readable( &RigidBody::isLoaded )
@@ -439,11 +562,20 @@ void CampBindings::bindLocalResourceManager()
 
 void CampBindings::bindClientConnection()
 {
-    camp::Class::declare<ClientConnection>( "ClientConnection" );
+    camp::Class::declare<ClientConnection>( "ClientConnection" )
         // Constructors
         // Properties (read-only)
         // Properties (read/write)
+        .property( "TrafficStatistics", &ClientConnection::getTrafficStatistics, 
+            &ClientConnection::setTrafficStatistics )
         // Functions
+        .function( "GetTrafficReport", &ClientConnection::getTrafficReport )
+        .function( "DumpTraffic", &ClientConnection::dumpTraffic )
+        .function( "ResetTraffic", &ClientConnection::resetTraffic )
+        .function( "StartRecording", &ClientConnection::startRecording )
+        .function( "StopRecording", &ClientConnection::stopRecording )
+        .function( "IsRecording", &ClientConnection::isRecording )
+        .function( "GetReplayReport", &ClientConnection::getReplayReport );
         // Static functions
         // Operators
 }
@@ -457,7 +589,9 @@ void CampBindings::bindAudio()
         // Properties (read/write)
         .property( "File", &Audio::mFile )
         .property( "Volume", &Audio::mVolume )
+            .tag( "MaxRate", 10 )
         .property( "VolumeSmooth", &Audio::mVolume )
+            .tag( "MaxRate", 10 )
         .property( "VolumeSmoothTimescale", &Audio::mVolumeSmoothTimescale )
         .property( "Loop", &Audio::mLoop )
         .property( "AutoPlay", &Audio::mAutoPlay )
@@ -472,10 +606,13 @@ void CampBindings::bindAudio()
         // Functions
         .function( "Play", boost::function<void(Audio&)>( boost::bind( &Audio::serializeCall, _1, String( "Play" ) ) ) )
             .tag( "NoCall" )
+            .tag( "Coalesce", "Playback" )
         .function( "Stop", boost::function<void(Audio&)>( boost::bind( &Audio::serializeCall, _1, String( "Stop" ) ) ) )
             .tag( "NoCall" )
+            .tag( "Coalesce", "Playback" )
         .function( "Pause", boost::function<void(Audio&)>( boost::bind( &Audio::serializeCall, _1, String( "Pause" ) ) ) )
-            .tag( "NoCall" );
+            .tag( "NoCall" )
+            .tag( "Coalesce", "Playback" );
         // Static functions
         // Operators
 }
@@ -491,8 +628,11 @@ void CampBindings::bindLuaObjectScript()
         .property( "ClientEnvironmentName", &LuaObjectScript::mClientEnvironmentName )
         .property( "ClientSecurityLevel", &LuaObjectScript::mClientSecurityLevel )
         .property( "ServerScriptFile", &LuaObjectScript::mServerScriptFile )
+            .tag( "OwnerOnly" )
         .property( "ServerEnvironmentName", &LuaObjectScript::mServerEnvironmentName )
-        .property( "ServerSecurityLevel", &LuaObjectScript::mServerSecurityLevel );
+            .tag( "OwnerOnly" )
+        .property( "ServerSecurityLevel", &LuaObjectScript::mServerSecurityLevel )
+            .tag( "OwnerOnly" );
         // Functions
         // Static functions
         // Operators
@@ -511,7 +651,8 @@ void CampBindings::bindParticle()
         .property( "Speed", &Particle::mSpeed )
         // Functions
         .function( "Clear", boost::function<void(Particle&)>( boost::bind( &Particle::serializeCall, _1, String( "Clear" ) ) ) )
-            .tag( "NoCall" );
+            .tag( "NoCall" )
+            .tag( "Coalesce" );
         // Static functions
         // Operators
 }
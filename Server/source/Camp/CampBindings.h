@@ -47,6 +47,10 @@ public:
     static void bindPrecipitationType();
     static void bindSkyPlugin();
     static void bindClientConnectionSettings();
+    static void bindIdleWorldBenchmarkSettings();
+    static void bindInterestManagerSettings();
+    static void bindReplicationSchedulerSettings();
+    static void bindServerLinkSettings();
     static void bindApplication();
     static void bindEntity();
     static void bindGameModePlugin();
@@ -73,6 +73,8 @@ protected:
     virtual RakNet::RM3SerializationResult Serialize( 
         RakNet::SerializeParameters* pSerializeParameters );
     virtual void Deserialize( RakNet::DeserializeParameters* pDeserializeParameters );
+    virtual RakNet::RM3QuerySerializationResult QuerySerialization( 
+        RakNet::Connection_RM3* pDestinationConnection );
 
 private:
     void pluginCreated( ClientServerPlugin& rPlugin, bool created );
@@ -24,6 +24,9 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 
 #include "ClientServerPlugin/ClientPluginManager.h"
 #include "Communication/ClientConnection.h"
+#include "Communication/IdleWorldBenchmark.h"
+#include "Communication/ServerLink.h"
+#include "Communication/ServerNeighborsPlugin.h"
 #include "Object/ServerObjectManager.h"
 #include "Permission/PermissionManager.h"
 #include "Shared/Lua/LuaManager.h"
@@ -38,7 +41,8 @@ namespace Server
 ClientConnection::Settings ClientConnection::msSettings = ClientConnection::Settings();
 
 ClientConnection::ClientConnection( sigc::signal<void>& rUpdateSignal ):
-    mRakPeer( *RakNet::RakPeerInterface::GetInstance() )
+    mRakPeer( *new LoopbackPeer() ),
+    mNetworkStage( mRakPeer )
 {
     LOGI << "Initializing client connection";
 
@@ -46,8 +50,8 @@ ClientConnection::ClientConnection( sigc::signal<void>& rUpdateSignal ):
 
     mRPC3.SetNetworkIDManager( &mNetworkIDManager );
     mReplicaManager.SetNetworkIDManager( &mNetworkIDManager );
-    mRakPeer.AttachPlugin( &mRPC3 );
-    mRakPeer.AttachPlugin( &mReplicaManager );
+    mNetworkStage.attachPlugin( mRPC3 );
+    mNetworkStage.attachPlugin( mReplicaManager );
 
     // Initialize plugin manager
     mPluginManager = new ClientPluginManager( SERVER, rUpdateSignal, mRakPeer, 
@@ -79,6 +83,23 @@ ClientConnection::ClientConnection( sigc::signal<void>& rUpdateSignal ):
         Globals::mConfig->registerObject( plugin );
     }
     
+    // Link with neighbor servers to hand off objects that cross the border of this server.
+    if( ServerLink::getSettings().mEnabled && mPluginManager->hasPlugin<ServerObjectManager>() && 
+        mPluginManager->hasPlugin<ServerNeighborsPlugin>() )
+    {
+        mServerLink.reset( new ServerLink( mPluginManager->getPlugin<ServerObjectManager>(), 
+            mPluginManager->getPlugin<ServerNeighborsPlugin>(), *mSessionManager.get(), 
+            rUpdateSignal ) );
+    }
+    
+    // Benchmark the tick time of a world full of idle replicas.
+    if( IdleWorldBenchmark::getSettings().mReplicaCount && 
+        mPluginManager->hasPlugin<ServerObjectManager>() )
+    {
+        mBenchmark.reset( new IdleWorldBenchmark( 
+            mPluginManager->getPlugin<ServerObjectManager>() ) );
+    }
+    
     // Load user settings after loading all plugins (PermissionManager), so default permissions get 
     // overridden.
     Globals::mConfig->registerObject( mUserManager );
@@ -94,15 +115,29 @@ ClientConnection::~ClientConnection()
 
     Globals::mClient = 0;
 
+    mServerLink.reset();
+    mBenchmark.reset();
     delete mPluginManager;
 
-    mRakPeer.DetachPlugin( &mRPC3 );
+    mNetworkStage.stop();
+    mNetworkStage.setRecorder( 0 );
+    mNetworkStage.setReplay( 0 );
+    mNetworkStage.detachPlugin( mRPC3 );
     mRakPeer.Shutdown( msSettings.mShutdownBlockDuractionMS );
-    RakNet::RakPeerInterface::DestroyInstance( &mRakPeer );
+    delete &mRakPeer;
 }
 
 bool ClientConnection::listen()
 {
+    if( !msSettings.mReplayFile.empty() )
+    {
+        // Replay a recorded session instead of listening for clients and neighbor servers.
+        mReplay.reset( new PacketReplay( msSettings.mReplayFile, mRakPeer ) );
+        mNetworkStage.setReplay( mReplay.get() );
+        mNetworkStage.start();
+        return true;
+    }
+
     RakNet::SocketDescriptor sd;
     sd.port = msSettings.mServerInfo.mPort;
     strcpy( sd.hostAddress, msSettings.mServerInfo.mAddress.c_str() );
@@ -117,22 +152,61 @@ bool ClientConnection::listen()
             "ClientConnection::listen" );
     }
 
+    mNetworkStage.start();
+
     LOGI << "Listening for client connections on " << msSettings.mServerInfo.getAddressMerged();
 
+    if( msSettings.mLoopback && !mRakPeer.listen( msSettings.mServerInfo ) )
+    {
+        LOGW << "Another server in this process listens on " << 
+            msSettings.mServerInfo.getAddressMerged() << ", not accepting clients in this process";
+    }
+
+    if( !msSettings.mRecordFile.empty() ) 
+        ClientConnection::startRecording( msSettings.mRecordFile );
+
+    if( mServerLink ) mServerLink->listen();
+
     return true;
 }
 
 void ClientConnection::disconnect()
 {
+    if( mServerLink ) mServerLink->disconnect();
+    ClientConnection::stopRecording();
+    mNetworkStage.stop();
     mRakPeer.Shutdown( msSettings.mShutdownBlockDuractionMS );
     mSessionManager->clear();
 }
 
+void ClientConnection::startRecording( const Path& rFile )
+{
+    PacketRecorder* recorder = new PacketRecorder( rFile );
+    mNetworkStage.setRecorder( recorder );
+    mRecorder.reset( recorder );
+
+    LOGI << "Recording client packets to " << rFile.file_string();
+}
+
+void ClientConnection::stopRecording()
+{
+    if( !mRecorder ) return;
+
+    LOGI << "Recorded " << mRecorder->getPacketCount() << " client packets to " << 
+        mRecorder->getFile().file_string();
+
+    mNetworkStage.setRecorder( 0 );
+    mRecorder.reset();
+}
+
 void ClientConnection::update()
 {
+    mNetworkStage.update();
+    TrafficStatistics::update();
+
     RakNet::Packet *packet;
-    for( packet = mRakPeer.Receive(); packet; mRakPeer.DeallocatePacket( packet ), 
-        packet = mRakPeer.Receive() )
+    for( packet = mNetworkStage.receive(); packet; mNetworkStage.deallocatePacket( packet ), 
+        packet = mNetworkStage.receive() )
     {
         switch ( packet->data[0] )
         {
@@ -26,7 +26,12 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "Platform/Prerequisites.h"
 
 #include "Shared/Communication/ServerInfo.h"
+#include "Shared/Communication/LoopbackPeer.h"
+#include "Shared/Communication/NetworkStage.h"
+#include "Shared/Communication/PacketRecorder.h"
+#include "Shared/Communication/PacketReplay.h"
 #include "Shared/Communication/ReplicaManager.h"
+#include "Shared/Communication/TrafficStatistics.h"
 #include "User/UserManager.h"
 
 namespace Diversia
@@ -63,7 +68,8 @@ public:
     inline SessionManager& getSessionManager() { return *mSessionManager.get(); }
 
     /**
-    Starts listening for clients.
+    Starts listening for clients, or replays the packets of a recorded session if a replay file is 
+    set. Clients in this process can connect without sockets.
 
     @return True if it succeeds, false if it fails. 
     **/
@@ -72,6 +78,67 @@ public:
     Disconnects all clients and stops listening. 
     **/
     void disconnect();
+
+    /**
+    Enables or disables recording of replication traffic statistics.
+    **/
+    inline void setTrafficStatistics( bool enabled ) 
+    { 
+        TrafficStatistics::getSettings().mEnabled = enabled; 
+    }
+    /**
+    Query if replication traffic statistics are recorded.
+    **/
+    inline bool getTrafficStatistics() const { return TrafficStatistics::getSettings().mEnabled; }
+    /**
+    Gets a report of the replication traffic over the rolling window.
+    
+    @param  count   The maximum number of classes and properties to list.
+    **/
+    inline String getTrafficReport( unsigned int count ) const 
+    { 
+        return TrafficStatistics::getReport( count ); 
+    }
+    /**
+    Writes the replication traffic statistics to a CSV file.
+    **/
+    inline void dumpTraffic( const Path& rFile ) const { TrafficStatistics::writeCSV( rFile ); }
+    /**
+    Removes all recorded replication traffic statistics.
+    **/
+    inline void resetTraffic() { TrafficStatistics::reset(); }
+    /**
+    Starts recording the packets that are received from clients to a capture file, replay it by 
+    setting the replay file in the settings. Only clients that connect after recording started 
+    can be replayed.
+
+    @param  rFile   The capture file, it is overwritten.
+    **/
+    void startRecording( const Path& rFile );
+    /**
+    Stops recording packets.
+    **/
+    void stopRecording();
+    /**
+    Query if packets are being recorded.
+    **/
+    inline bool isRecording() const { return mRecorder.get() != 0; }
+    /**
+    Gets a report of the throughput of the replay, empty if no replay is running.
+    **/
+    inline String getReplayReport() const { return mReplay ? mReplay->getReport() : ""; }
+    /**
+    Query if a replay is running.
+    **/
+    inline bool isReplaying() const { return mReplay && !mReplay->isFinished(); }
+    /**
+    Query if a replay has finished.
+    **/
+    inline bool isReplayFinished() const { return mReplay && mReplay->isFinished(); }
+    /**
+    Gets the idle world benchmark, 0 if it is disabled in the settings.
+    **/
+    inline IdleWorldBenchmark* getBenchmark() const { return mBenchmark.get(); }
     
 private:
     friend class Bindings::CampBindings;    ///< Allow private access for camp bindings.
@@ -85,12 +152,17 @@ private:
     ClientPluginManager*                mPluginManager;
     UserManager                         mUserManager;
     boost::scoped_ptr<SessionManager>   mSessionManager;
+    boost::scoped_ptr<ServerLink>       mServerLink;
+    boost::scoped_ptr<IdleWorldBenchmark>   mBenchmark;
     sigc::connection                    mPluginChangeConnection;
 
-    RakNet::RakPeerInterface&   mRakPeer;
+    LoopbackPeer&               mRakPeer;
     RakNet::NetworkIDManager    mNetworkIDManager;
     ReplicaManager              mReplicaManager;
     RakNet::RPC3                mRPC3;
+    NetworkStage                mNetworkStage;
+    boost::scoped_ptr<PacketRecorder>   mRecorder;
+    boost::scoped_ptr<PacketReplay>     mReplay;
 
     /**
     Settings for client connection.
@@ -104,7 +176,10 @@ private:
             mConnectionAttemptCount( 12 ),
             mTimeBetweenConnectionAttemptsMS( 500 ),
             mTimeoutMS( 0 ),
-            mShutdownBlockDuractionMS( 5000 ) 
+            mShutdownBlockDuractionMS( 5000 ),
+            mLoopback( true ),
+            mRecordFile( "" ),
+            mReplayFile( "" )
         {
             // Add default plugins.
             mPlugins.push_back( CLIENTSERVERPLUGINTYPE_RESOURCEMANAGER );
@@ -124,6 +199,9 @@ private:
         unsigned short  mTimeBetweenConnectionAttemptsMS;
         RakNet::Time    mTimeoutMS;	///< 0 uses default value. 
         unsigned short  mShutdownBlockDuractionMS;
+        bool            mLoopback;      ///< Accepts clients in this process without sockets.
+        Path            mRecordFile;    ///< Records received packets if not empty.
+        Path            mReplayFile;    ///< Replays instead of listening if not empty.
     } msSettings;
 
 public:
@@ -0,0 +1,175 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Diversia is free software: you can redistribute it and/or modify it under the 
+terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+Diversia is distributed in the hope that it will be useful, but WITHOUT ANY 
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+Diversia. If not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
+-----------------------------------------------------------------------------
+*/
+
+#include "Platform/StableHeaders.h"
+
+#include "Communication/IdleWorldBenchmark.h"
+#include "Object/ServerObject.h"
+#include "Object/ServerObjectManager.h"
+#include "Util/Helper/TickScheduler.h"
+
+namespace Diversia
+{
+namespace Server
+{
+//------------------------------------------------------------------------------
+
+IdleWorldBenchmark::Settings IdleWorldBenchmark::msSettings = IdleWorldBenchmark::Settings();
+
+IdleWorldBenchmark::IdleWorldBenchmark( ServerObjectManager& rObjectManager ):
+    mObjectManager( rObjectManager ),
+    mPhase( PHASE_BASELINE ),
+    mTick( 0 ),
+    mTickStartUS( 0 )
+{
+    LOGI << "Benchmarking an idle world of " << msSettings.mReplicaCount << " replicas";
+}
+
+IdleWorldBenchmark::~IdleWorldBenchmark()
+{
+
+}
+
+void IdleWorldBenchmark::beginTick()
+{
+    mTickStartUS = TickScheduler::getMicroseconds();
+}
+
+void IdleWorldBenchmark::endTick()
+{
+    boost::uint64_t elapsed = TickScheduler::getMicroseconds() - mTickStartUS;
+    ++mTick;
+
+    switch( mPhase )
+    {
+        case PHASE_BASELINE:
+        case PHASE_MEASURE:
+        {
+            Timing& timing = mPhase == PHASE_BASELINE ? mBaseline : mIdle;
+            ++timing.mTicks;
+            timing.mTotalUS += elapsed;
+            timing.mMaxUS = std::max( timing.mMaxUS, elapsed );
+
+            if( mTick < msSettings.mTicks ) break;
+            mTick = 0;
+            if( mPhase == PHASE_BASELINE )
+            {
+                // Creating the replicas is not measured, the next ticks construct and settle them.
+                IdleWorldBenchmark::createObjects();
+                mPhase = PHASE_SETTLE;
+            }
+            else
+            {
+                IdleWorldBenchmark::finish();
+            }
+            break;
+        }
+        case PHASE_SETTLE:
+        {
+            if( mTick < msSettings.mSettleTicks ) break;
+            mTick = 0;
+            mPhase = PHASE_MEASURE;
+            break;
+        }
+        default: break;
+    }
+}
+
+String IdleWorldBenchmark::getReport() const
+{
+    if( mPhase != PHASE_FINISHED ) return "";
+
+    std::stringstream ss;
+    ss << "Idle world of " << mObjects.size() << " replicas: " << mIdle.getMeanMS() << 
+        " ms mean, " << mIdle.getMaxMS() << " ms max per tick (baseline " << 
+        mBaseline.getMeanMS() << " ms mean, " << mBaseline.getMaxMS() << " ms max) over " << 
+        mIdle.mTicks << " ticks";
+
+    return ss.str();
+}
+
+void IdleWorldBenchmark::writeCSV( const Path& rFile ) const
+{
+    bool empty = !boost::filesystem::exists( rFile ) || boost::filesystem::is_empty( rFile );
+    std::ofstream file( rFile.file_string().c_str(), std::ios::out | std::ios::app );
+    if( !file.is_open() )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE, "Cannot open " + 
+            rFile.file_string() + " for writing.", "IdleWorldBenchmark::writeCSV" );
+    }
+
+    if( empty )
+    {
+        file << "Replicas,Ticks,MeanMS,MaxMS,BaselineMeanMS,BaselineMaxMS" << std::endl;
+    }
+
+    file << mObjects.size() << "," << mIdle.mTicks << "," << mIdle.getMeanMS() << "," << 
+        mIdle.getMaxMS() << "," << mBaseline.getMeanMS() << "," << mBaseline.getMaxMS() << 
+        std::endl;
+}
+
+void IdleWorldBenchmark::createObjects()
+{
+    unsigned int side = (unsigned int)Math::Ceil( Math::Sqrt( (Real)msSettings.mReplicaCount ) );
+    Real offset = ( side - 1 ) * msSettings.mSpacing * 0.5;
+
+    mObjects.reserve( msSettings.mReplicaCount );
+    for( unsigned int i = 0; i < msSettings.mReplicaCount; ++i )
+    {
+        String name = "IdleWorldBenchmark" + boost::lexical_cast<String>( i );
+        Object& object = mObjectManager.createRuntimeObject( name, REMOTE );
+        object.setPosition( ( i % side ) * msSettings.mSpacing - offset, 0, 
+            ( i / side ) * msSettings.mSpacing - offset );
+        mObjects.push_back( name );
+    }
+}
+
+void IdleWorldBenchmark::destroyObjects()
+{
+    for( std::vector<String>::iterator i = mObjects.begin(); i != mObjects.end(); ++i )
+    {
+        if( mObjectManager.hasObject( *i ) ) mObjectManager.destroyObject( *i );
+    }
+}
+
+void IdleWorldBenchmark::finish()
+{
+    mPhase = PHASE_FINISHED;
+
+    LOGI << IdleWorldBenchmark::getReport();
+
+    IdleWorldBenchmark::destroyObjects();
+
+    if( msSettings.mReportFile.empty() ) return;
+    try
+    {
+        IdleWorldBenchmark::writeCSV( msSettings.mReportFile );
+    }
+    catch( Exception e )
+    {
+        LOGW << "Could not write idle world benchmark report: " << e.what();
+    }
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Server
+} // Namespace Diversia
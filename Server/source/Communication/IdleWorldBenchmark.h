@@ -0,0 +1,159 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Diversia is free software: you can redistribute it and/or modify it under the 
+terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+Diversia is distributed in the hope that it will be useful, but WITHOUT ANY 
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+Diversia. If not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SERVER_IDLEWORLDBENCHMARK_H
+#define DIVERSIA_SERVER_IDLEWORLDBENCHMARK_H
+
+#include "Platform/Prerequisites.h"
+
+namespace Diversia
+{
+namespace Server
+{
+//------------------------------------------------------------------------------
+
+/**
+Measures the cost of a server tick in a world full of idle replicas. First the tick time of the
+world as it is is measured as a baseline, then the replica count of remote objects are created 
+in a grid on the X/Z plane, and after the objects have settled the tick time of the idle world is 
+measured. The replication scheduler and interest manager only visit objects that changed, so the
+idle tick time should stay close to the baseline regardless of the replica count.
+
+When the benchmark has finished the result is logged as "Idle world of <replicas> replicas: 
+<mean> ms mean, <max> ms max per tick (baseline <mean> ms mean, <max> ms max) over <ticks> ticks",
+and appended to the report file if one is set so it can be compared between builds. The created 
+objects are destroyed afterwards.
+**/
+class IdleWorldBenchmark : public boost::noncopyable
+{
+public:
+    /**
+    Constructor. 
+    
+    @param [in,out] rObjectManager  The object manager to create the idle objects in.
+    **/
+    IdleWorldBenchmark( ServerObjectManager& rObjectManager );
+    /**
+    Destructor. 
+    **/
+    ~IdleWorldBenchmark();
+
+    /**
+    Starts timing a tick, call this at the start of every tick.
+    **/
+    void beginTick();
+    /**
+    Stops timing a tick and advances the benchmark, call this at the end of every tick before 
+    waiting for the next one.
+    **/
+    void endTick();
+    /**
+    Query if the benchmark has finished.
+    **/
+    inline bool isFinished() const { return mPhase == PHASE_FINISHED; }
+    /**
+    Gets a readable report of the benchmark, empty if it has not finished yet.
+    **/
+    String getReport() const;
+    /**
+    Appends the result as a row to a CSV file, the column names are written first if the file is
+    empty.
+
+    @param  rFile   The file to append to.
+
+    @throws ERR_CANNOT_WRITE_TO_FILE when the file cannot be opened.
+    **/
+    void writeCSV( const Path& rFile ) const;
+
+private:
+    enum Phase
+    {
+        PHASE_BASELINE,
+        PHASE_SETTLE,
+        PHASE_MEASURE,
+        PHASE_FINISHED
+    };
+
+    struct Timing
+    {
+        Timing() : mTicks( 0 ), mTotalUS( 0 ), mMaxUS( 0 ) {}
+
+        inline Real getMeanMS() const { return mTicks ? mTotalUS / 1000.0 / mTicks : 0; }
+        inline Real getMaxMS() const { return mMaxUS / 1000.0; }
+
+        unsigned int    mTicks;
+        boost::uint64_t mTotalUS;
+        boost::uint64_t mMaxUS;
+    };
+
+    void createObjects();
+    void destroyObjects();
+    void finish();
+
+    ServerObjectManager&    mObjectManager;
+    std::vector<String>     mObjects;
+    Phase                   mPhase;
+    unsigned int            mTick;          ///< Ticks in the current phase.
+    boost::uint64_t         mTickStartUS;
+    Timing                  mBaseline;
+    Timing                  mIdle;
+
+    /**
+    Settings for the idle world benchmark.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mReplicaCount( 0 ),
+            mSpacing( 10 ),
+            mTicks( 300 ),
+            mSettleTicks( 60 ),
+            mQuitWhenFinished( true ),
+            mReportFile( "" )
+        {
+        
+        }
+
+        unsigned int    mReplicaCount;      ///< Amount of idle replicas, 0 disables the benchmark.
+        Real            mSpacing;           ///< Distance between the replicas in the grid.
+        unsigned int    mTicks;             ///< Ticks to measure, for the baseline and idle world.
+        unsigned int    mSettleTicks;       ///< Ticks to wait after creating the replicas.
+        bool            mQuitWhenFinished;  ///< Shuts the server down when finished.
+        Path            mReportFile;        ///< CSV file to append the result to, empty to disable.
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static IdleWorldBenchmark::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Server
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::Server::IdleWorldBenchmark::Settings, 
+    &Diversia::Server::Bindings::CampBindings::bindIdleWorldBenchmarkSettings );
+
+#endif // DIVERSIA_SERVER_IDLEWORLDBENCHMARK_H
@@ -0,0 +1,381 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Diversia is free software: you can redistribute it and/or modify it under the 
+terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+Diversia is distributed in the hope that it will be useful, but WITHOUT ANY 
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+Diversia. If not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
+-----------------------------------------------------------------------------
+*/
+
+#include "Platform/StableHeaders.h"
+
+#include "Communication/InterestManager.h"
+#include "Object/ServerObject.h"
+#include "Object/ServerObjectManager.h"
+
+namespace Diversia
+{
+namespace Server
+{
+//------------------------------------------------------------------------------
+
+InterestManager::Settings InterestManager::msSettings = InterestManager::Settings();
+
+InterestManager::InterestManager( ServerObjectManager& rObjectManager, 
+    RakNet::ReplicaManager3& rReplicaManager, sigc::signal<void>& rUpdateSignal ):
+    mObjectManager( rObjectManager ),
+    mReplicaManager( rReplicaManager ),
+    mNextUpdate( 0 ),
+    mForceUpdate( true )
+{
+    mUpdateConnection = rUpdateSignal.connect( sigc::mem_fun( this, &InterestManager::update ) );
+    mObjectConnection = mObjectManager.connect( sigc::mem_fun( this, 
+        &InterestManager::objectChange ) );
+    mStateChangeConnection = mObjectManager.connectStateChange( sigc::mem_fun( this, 
+        &InterestManager::stateChange ) );
+
+    // Track objects that already exist.
+    const Objects& objects = mObjectManager.getObjects();
+    for( Objects::const_iterator i = objects.begin(); i != objects.end(); ++i )
+    {
+        InterestManager::objectChange( *i->second, true );
+    }
+}
+
+InterestManager::~InterestManager()
+{
+    mUpdateConnection.disconnect();
+    mObjectConnection.disconnect();
+    mStateChangeConnection.disconnect();
+}
+
+bool InterestManager::isRelevant( const ServerObject& rObject, RakNet::RakNetGUID client ) const
+{
+    if( !msSettings.mEnabled ) return true;
+
+    // Objects created or controlled by a client are always relevant to that client.
+    if( rObject.isCreatedBy( client ) || rObject.getClientController() == client ) return true;
+
+    Relevances::const_iterator i = mRelevances.find( client );
+    if( i == mRelevances.end() )
+    {
+        // New client, determine relevance as soon as possible.
+        mNextUpdate = 0;
+        return false;
+    }
+
+    if( i->second.mAll ) return true;
+
+    return i->second.mObjects.find( &InterestManager::getRoot( rObject ) ) != 
+        i->second.mObjects.end();
+}
+
+unsigned int InterestManager::getRelevantCount( RakNet::RakNetGUID client ) const
+{
+    Relevances::const_iterator i = mRelevances.find( client );
+    if( i == mRelevances.end() ) return 0;
+    if( i->second.mAll ) return mEntries.size();
+    return i->second.mObjects.size();
+}
+
+Real InterestManager::getDistance( const ServerObject& rObject, RakNet::RakNetGUID client ) const
+{
+    Relevances::const_iterator i = mRelevances.find( client );
+    if( i == mRelevances.end() || i->second.mViewpoints.empty() ) return -1;
+
+    const Vector3& position = InterestManager::getRoot( rObject )._getDerivedPosition();
+    Real distance = -1;
+    for( std::vector<ServerObject*>::const_iterator j = i->second.mViewpoints.begin(); 
+        j != i->second.mViewpoints.end(); ++j )
+    {
+        Real squaredDistance = position.squaredDistance( (*j)->_getDerivedPosition() );
+        if( distance < 0 || squaredDistance < distance ) distance = squaredDistance;
+    }
+
+    return Math::Sqrt( distance );
+}
+
+void InterestManager::update()
+{
+    if( !msSettings.mEnabled ) return;
+
+    RakNet::Time time = RakNet::GetTime();
+    if( time < mNextUpdate ) return;
+    mNextUpdate = time + msSettings.mUpdateIntervalMS;
+
+    InterestManager::updateRelevance();
+}
+
+void InterestManager::updateRelevance()
+{
+    // Update the grid, viewpoints and always relevant objects from the objects that changed since
+    // the last update only, an idle world costs nothing here.
+    bool changed = !mChanged.empty() || mForceUpdate;
+    mForceUpdate = false;
+    for( std::set<ServerObject*>::iterator i = mChanged.begin(); i != mChanged.end(); ++i )
+    {
+        Entries::iterator entry = mEntries.find( *i );
+        if( entry != mEntries.end() ) InterestManager::updateEntry( **i, entry->second );
+    }
+    mChanged.clear();
+
+    std::set<RakNet::RakNetGUID> connected;
+    for( unsigned int c = 0; c < mReplicaManager.GetConnectionCount(); ++c )
+    {
+        RakNet::RakNetGUID client = mReplicaManager.GetConnectionAtIndex( c )->GetRakNetGUID();
+        connected.insert( client );
+        if( !mRelevances.count( client ) ) changed = true;
+    }
+
+    // Relevance only changes when objects changed or clients connected or disconnected.
+    if( !changed && connected.size() == mRelevances.size() ) return;
+
+    Real maxRelevanceRadius = mRadii.empty() ? 0 : *mRadii.rbegin();
+
+    for( std::set<RakNet::RakNetGUID>::iterator c = connected.begin(); c != connected.end(); 
+        ++c )
+    {
+        RakNet::RakNetGUID client = *c;
+        Relevance& relevance = mRelevances[client];
+
+        // Clients without a viewpoint get all objects.
+        ObjectsByClient::iterator vps = mViewpoints.find( client );
+        if( vps == mViewpoints.end() )
+        {
+            relevance.mAll = true;
+            relevance.mObjects.clear();
+            relevance.mViewpoints.clear();
+            continue;
+        }
+
+        std::set<ServerObject*> relevant( mGlobal );
+
+        ObjectsByClient::iterator own = mOwned.find( client );
+        if( own != mOwned.end() )
+        {
+            for( std::set<ServerObject*>::iterator i = own->second.begin(); 
+                i != own->second.end(); ++i )
+            {
+                relevant.insert( &InterestManager::getRoot( **i ) );
+            }
+        }
+
+        for( std::set<ServerObject*>::iterator i = vps->second.begin(); 
+            i != vps->second.end(); ++i )
+        {
+            ServerObject& viewpoint = **i;
+            relevant.insert( &InterestManager::getRoot( viewpoint ) );
+
+            const Vector3& position = viewpoint._getDerivedPosition();
+            Real viewRadius = viewpoint.getViewRadius() > 0 ? viewpoint.getViewRadius() : 
+                msSettings.mViewRadius;
+            Real range = std::max( viewRadius, maxRelevanceRadius ) + msSettings.mHysteresis;
+
+            Cell min = InterestManager::getCell( position - Vector3( range, 0, range ) );
+            Cell max = InterestManager::getCell( position + Vector3( range, 0, range ) );
+
+            for( int x = min.mX; x <= max.mX; ++x )
+            {
+                for( int z = min.mZ; z <= max.mZ; ++z )
+                {
+                    Cells::iterator cell = mCells.find( Cell( x, z ) );
+                    if( cell == mCells.end() ) continue;
+
+                    for( std::set<ServerObject*>::iterator j = cell->second.begin(); 
+                        j != cell->second.end(); ++j )
+                    {
+                        ServerObject& object = **j;
+
+                        Real radius = object.getRelevanceRadius() > 0 ? 
+                            object.getRelevanceRadius() : viewRadius;
+
+                        // Objects that were relevant stay relevant until they leave the radius 
+                        // plus the hysteresis.
+                        if( !relevance.mAll && relevance.mObjects.count( &object ) )
+                            radius += msSettings.mHysteresis;
+
+                        if( position.squaredDistance( object._getDerivedPosition() ) <= 
+                            radius * radius )
+                        {
+                            relevant.insert( &object );
+                        }
+                    }
+                }
+            }
+        }
+
+        relevance.mAll = false;
+        relevance.mObjects.swap( relevant );
+        relevance.mViewpoints.assign( vps->second.begin(), vps->second.end() );
+    }
+
+    // Forget clients that have disconnected.
+    for( Relevances::iterator i = mRelevances.begin(); i != mRelevances.end(); )
+    {
+        if( !connected.count( i->first ) )
+            mRelevances.erase( i++ );
+        else
+            ++i;
+    }
+}
+
+void InterestManager::updateEntry( ServerObject& rObject, Entry& rEntry )
+{
+    RakNet::RakNetGUID controller = rObject.getClientController();
+    if( controller != rEntry.mController )
+    {
+        if( rEntry.mController != RakNet::UNASSIGNED_RAKNET_GUID )
+        {
+            ObjectsByClient::iterator i = mViewpoints.find( rEntry.mController );
+            i->second.erase( &rObject );
+            if( i->second.empty() ) mViewpoints.erase( i );
+        }
+        if( controller != RakNet::UNASSIGNED_RAKNET_GUID ) 
+            mViewpoints[controller].insert( &rObject );
+        rEntry.mController = controller;
+    }
+
+    // Only root objects are in the grid, child objects share the relevance of their root.
+    if( rEntry.mGlobal ) mGlobal.erase( &rObject );
+    if( rEntry.mRadius > 0 ) mRadii.erase( mRadii.find( rEntry.mRadius ) );
+    rEntry.mGlobal = false;
+    rEntry.mRadius = 0;
+
+    if( rObject.getParentObject() )
+    {
+        InterestManager::removeFromGrid( rObject, rEntry );
+        return;
+    }
+
+    InterestManager::updateGrid( rObject, rEntry );
+
+    Real radius = rObject.getRelevanceRadius();
+    if( radius < 0 )
+    {
+        mGlobal.insert( &rObject );
+        rEntry.mGlobal = true;
+    }
+    else if( radius > 0 )
+    {
+        mRadii.insert( radius );
+        rEntry.mRadius = radius;
+    }
+}
+
+void InterestManager::removeEntry( ServerObject& rObject, Entry& rEntry )
+{
+    if( rEntry.mController != RakNet::UNASSIGNED_RAKNET_GUID )
+    {
+        ObjectsByClient::iterator i = mViewpoints.find( rEntry.mController );
+        i->second.erase( &rObject );
+        if( i->second.empty() ) mViewpoints.erase( i );
+    }
+
+    if( !rObject.isCreatedByServer() )
+    {
+        ObjectsByClient::iterator i = mOwned.find( rObject.getSourceGUID() );
+        if( i != mOwned.end() )
+        {
+            i->second.erase( &rObject );
+            if( i->second.empty() ) mOwned.erase( i );
+        }
+    }
+
+    if( rEntry.mGlobal ) mGlobal.erase( &rObject );
+    if( rEntry.mRadius > 0 ) mRadii.erase( mRadii.find( rEntry.mRadius ) );
+    InterestManager::removeFromGrid( rObject, rEntry );
+}
+
+void InterestManager::updateGrid( ServerObject& rObject, Entry& rEntry )
+{
+    Cell cell = InterestManager::getCell( rObject._getDerivedPosition() );
+
+    if( rEntry.mInGrid && !( cell != rEntry.mCell ) ) return;
+
+    InterestManager::removeFromGrid( rObject, rEntry );
+    mCells[cell].insert( &rObject );
+    rEntry.mCell = cell;
+    rEntry.mInGrid = true;
+}
+
+void InterestManager::removeFromGrid( ServerObject& rObject, Entry& rEntry )
+{
+    if( !rEntry.mInGrid ) return;
+
+    Cells::iterator i = mCells.find( rEntry.mCell );
+    if( i != mCells.end() )
+    {
+        i->second.erase( &rObject );
+        if( i->second.empty() ) mCells.erase( i );
+    }
+
+    rEntry.mInGrid = false;
+}
+
+void InterestManager::objectChange( Object& rObject, bool created )
+{
+    ServerObject& object = static_cast<ServerObject&>( rObject );
+
+    if( created )
+    {
+        mEntries.insert( std::make_pair( &object, Entry() ) );
+        if( !object.isCreatedByServer() ) mOwned[object.getSourceGUID()].insert( &object );
+        mChanged.insert( &object );
+    }
+    else
+    {
+        Entries::iterator i = mEntries.find( &object );
+        if( i != mEntries.end() )
+        {
+            InterestManager::removeEntry( object, i->second );
+            mEntries.erase( i );
+        }
+        mChanged.erase( &object );
+
+        for( Relevances::iterator j = mRelevances.begin(); j != mRelevances.end(); ++j )
+        {
+            j->second.mObjects.erase( &object );
+
+            std::vector<ServerObject*>& viewpoints = j->second.mViewpoints;
+            viewpoints.erase( std::remove( viewpoints.begin(), viewpoints.end(), &object ), 
+                viewpoints.end() );
+        }
+    }
+}
+
+void InterestManager::stateChange( Object& rObject )
+{
+    // Objects can change while they are being created, they are tracked once they are created.
+    ServerObject& object = static_cast<ServerObject&>( rObject );
+    if( mEntries.count( &object ) ) mChanged.insert( &object );
+}
+
+InterestManager::Cell InterestManager::getCell( const Vector3& rPosition ) const
+{
+    return Cell( (int)Math::Floor( rPosition.x / msSettings.mCellSize ), 
+        (int)Math::Floor( rPosition.z / msSettings.mCellSize ) );
+}
+
+ServerObject& InterestManager::getRoot( const ServerObject& rObject )
+{
+    const Object* root = &rObject;
+    while( root->getParentObject() ) root = root->getParentObject();
+    return const_cast<ServerObject&>( static_cast<const ServerObject&>( *root ) );
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Server
+} // Namespace Diversia
@@ -0,0 +1,205 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Diversia is free software: you can redistribute it and/or modify it under the 
+terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+Diversia is distributed in the hope that it will be useful, but WITHOUT ANY 
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+Diversia. If not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SERVER_INTERESTMANAGER_H
+#define DIVERSIA_SERVER_INTERESTMANAGER_H
+
+#include "Platform/Prerequisites.h"
+
+namespace Diversia
+{
+namespace Server
+{
+//------------------------------------------------------------------------------
+
+/**
+Area of interest management for object replication. Keeps root objects in a spatial grid on the
+X/Z plane and periodically determines, per client, which objects are within view of the objects
+that the client controls. Objects that are not relevant to a client are not constructed on that
+client, destroyed on that client when they leave relevance and not serialized to that client.
+
+An object becomes relevant when it comes within the view radius of a viewpoint and stops being 
+relevant when it is further away than the view radius plus the hysteresis. Child objects share 
+the relevance of their root object. Objects created or controlled by a client are always relevant
+to that client, clients that do not control any object receive all objects.
+
+The grid, viewpoints and relevance radii are only updated for objects that changed since the last
+update (see ObjectManager::connectStateChange), and relevance is not recalculated at all while
+nothing changes, so an idle world costs nothing.
+**/
+class InterestManager : public sigc::trackable, public boost::noncopyable
+{
+public:
+    /**
+    Constructor. 
+    
+    @param [in,out] rObjectManager      The object manager to track objects from.
+    @param [in,out] rReplicaManager     The replica manager to get client connections from.
+    @param [in,out] rUpdateSignal       The update signal. 
+    **/
+    InterestManager( ServerObjectManager& rObjectManager, RakNet::ReplicaManager3& rReplicaManager,
+        sigc::signal<void>& rUpdateSignal );
+    /**
+    Destructor. 
+    **/
+    ~InterestManager();
+
+    /**
+    Query if an object is relevant to a client.
+    
+    @param  rObject The object.
+    @param  client  The GUID of the client.
+    **/
+    bool isRelevant( const ServerObject& rObject, RakNet::RakNetGUID client ) const;
+    /**
+    Gets the amount of root objects that are relevant to a client, or the amount of all objects if
+    the client has no viewpoint.
+
+    @param  client  The GUID of the client.
+    **/
+    unsigned int getRelevantCount( RakNet::RakNetGUID client ) const;
+    /**
+    Gets the distance from an object to the nearest viewpoint of a client, as of the last
+    relevance update.
+    
+    @param  rObject The object.
+    @param  client  The GUID of the client.
+
+    @return The distance, or a negative value if the client has no viewpoint.
+    **/
+    Real getDistance( const ServerObject& rObject, RakNet::RakNetGUID client ) const;
+    /**
+    Makes relevance be recalculated in the next update.
+    **/
+    inline void forceUpdate() { mNextUpdate = 0; mForceUpdate = true; }
+
+private:
+    struct Cell
+    {
+        Cell( int x = 0, int z = 0 ) : mX( x ), mZ( z ) {}
+        inline bool operator<( const Cell& rCell ) const 
+        { 
+            return mX < rCell.mX || ( mX == rCell.mX && mZ < rCell.mZ ); 
+        }
+        inline bool operator!=( const Cell& rCell ) const 
+        { 
+            return mX != rCell.mX || mZ != rCell.mZ; 
+        }
+
+        int mX;
+        int mZ;
+    };
+
+    struct Entry
+    {
+        Entry() : mInGrid( false ), mController( RakNet::UNASSIGNED_RAKNET_GUID ), 
+            mRadius( 0 ), mGlobal( false ) {}
+
+        Cell                mCell;
+        bool                mInGrid;
+        RakNet::RakNetGUID  mController;    ///< Client the object is a viewpoint of.
+        Real                mRadius;        ///< Relevance radius in mRadii, 0 if none.
+        bool                mGlobal;        ///< In mGlobal.
+    };
+
+    struct Relevance
+    {
+        Relevance() : mAll( false ) {}
+
+        bool                        mAll;
+        std::set<ServerObject*>     mObjects;
+        std::vector<ServerObject*>  mViewpoints;
+    };
+
+    typedef std::map<ServerObject*, Entry> Entries;
+    typedef std::map<Cell, std::set<ServerObject*> > Cells;
+    typedef std::map<RakNet::RakNetGUID, Relevance> Relevances;
+    typedef std::map<RakNet::RakNetGUID, std::set<ServerObject*> > ObjectsByClient;
+
+    void update();
+    void updateRelevance();
+    void updateEntry( ServerObject& rObject, Entry& rEntry );
+    void removeEntry( ServerObject& rObject, Entry& rEntry );
+    void updateGrid( ServerObject& rObject, Entry& rEntry );
+    void removeFromGrid( ServerObject& rObject, Entry& rEntry );
+    void objectChange( Object& rObject, bool created );
+    void stateChange( Object& rObject );
+    Cell getCell( const Vector3& rPosition ) const;
+    static ServerObject& getRoot( const ServerObject& rObject );
+
+    ServerObjectManager&        mObjectManager;
+    RakNet::ReplicaManager3&    mReplicaManager;
+    sigc::connection            mUpdateConnection;
+    sigc::connection            mObjectConnection;
+    sigc::connection            mStateChangeConnection;
+
+    Entries                     mEntries;
+    Cells                       mCells;
+    Relevances                  mRelevances;
+    mutable RakNet::Time        mNextUpdate;
+    bool                        mForceUpdate;
+
+    // Kept up to date from the objects that changed, instead of visiting every object.
+    std::set<ServerObject*>     mChanged;
+    ObjectsByClient             mViewpoints;    ///< Controlled objects per client.
+    ObjectsByClient             mOwned;         ///< Objects created by a client.
+    std::set<ServerObject*>     mGlobal;        ///< Root objects that are always relevant.
+    std::multiset<Real>         mRadii;         ///< Relevance radii of root objects.
+
+    /**
+    Settings for interest management.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mEnabled( true ),
+            mCellSize( 50 ),
+            mViewRadius( 250 ),
+            mHysteresis( 25 ),
+            mUpdateIntervalMS( 200 )
+        {
+        
+        }
+
+        bool            mEnabled;
+        Real            mCellSize;
+        Real            mViewRadius;    ///< Default view radius for viewpoints.
+        Real            mHysteresis;
+        unsigned int    mUpdateIntervalMS;
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static InterestManager::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Server
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::Server::InterestManager::Settings, 
+    &Diversia::Server::Bindings::CampBindings::bindInterestManagerSettings );
+
+#endif // DIVERSIA_SERVER_INTERESTMANAGER_H
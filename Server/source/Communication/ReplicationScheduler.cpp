@@ -0,0 +1,284 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Diversia is free software: you can redistribute it and/or modify it under the 
+terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+Diversia is distributed in the hope that it will be useful, but WITHOUT ANY 
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+Diversia. If not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
+-----------------------------------------------------------------------------
+*/
+
+#include "Platform/StableHeaders.h"
+
+#include "Communication/InterestManager.h"
+#include "Communication/ReplicationScheduler.h"
+#include "Object/Component.h"
+#include "Object/DirtyReplicas.h"
+#include "Object/ServerObject.h"
+#include "Object/ServerObjectManager.h"
+
+namespace Diversia
+{
+namespace Server
+{
+//------------------------------------------------------------------------------
+
+ReplicationScheduler::Settings ReplicationScheduler::msSettings = 
+    ReplicationScheduler::Settings();
+std::map<ComponentType, Real> ReplicationScheduler::msComponentWeights;
+
+ReplicationScheduler::ReplicationScheduler( ServerObjectManager& rObjectManager, 
+    InterestManager& rInterestManager, RakNet::ReplicaManager3& rReplicaManager, 
+    sigc::signal<void>& rUpdateSignal ):
+    mObjectManager( rObjectManager ),
+    mInterestManager( rInterestManager ),
+    mReplicaManager( rReplicaManager ),
+    mLastUpdate( 0 )
+{
+    mUpdateConnection = rUpdateSignal.connect( sigc::mem_fun( this, 
+        &ReplicationScheduler::update ) );
+    mObjectConnection = mObjectManager.connect( sigc::mem_fun( this, 
+        &ReplicationScheduler::objectChange ) );
+    mStateChangeConnection = mObjectManager.connectStateChange( sigc::mem_fun( this, 
+        &ReplicationScheduler::stateChange ) );
+
+    // Track objects that already exist.
+    const Objects& objects = mObjectManager.getObjects();
+    for( Objects::const_iterator i = objects.begin(); i != objects.end(); ++i )
+    {
+        ReplicationScheduler::objectChange( *i->second, true );
+    }
+}
+
+ReplicationScheduler::~ReplicationScheduler()
+{
+    mUpdateConnection.disconnect();
+    mObjectConnection.disconnect();
+    mStateChangeConnection.disconnect();
+}
+
+bool ReplicationScheduler::isScheduled( const ServerObject& rObject, 
+    RakNet::RakNetGUID client ) const
+{
+    Connections::const_iterator i = mConnections.find( client );
+    if( i == mConnections.end() ) return false;
+
+    std::map<ServerObject*, Pending>::const_iterator j = i->second.mPending.find( 
+        const_cast<ServerObject*>( &rObject ) );
+    return j != i->second.mPending.end() && j->second.mScheduled;
+}
+
+unsigned char ReplicationScheduler::takeChanges( const ServerObject& rObject, 
+    RakNet::RakNetGUID client )
+{
+    Connections::iterator i = mConnections.find( client );
+    if( i == mConnections.end() ) return 0;
+
+    std::map<ServerObject*, Pending>::iterator j = i->second.mPending.find( 
+        const_cast<ServerObject*>( &rObject ) );
+    if( j == i->second.mPending.end() || !j->second.mScheduled ) return 0;
+
+    unsigned char changes = j->second.mChanges;
+    i->second.mPending.erase( j );
+    return changes;
+}
+
+void ReplicationScheduler::addChanges( const ServerObject& rObject, RakNet::RakNetGUID client,
+    unsigned char changes )
+{
+    mConnections[client].mPending[const_cast<ServerObject*>( &rObject )].mChanges |= changes;
+}
+
+void ReplicationScheduler::charge( RakNet::RakNetGUID client, unsigned int bytes )
+{
+    Connections::iterator i = mConnections.find( client );
+    if( i != mConnections.end() ) i->second.mBudget -= bytes;
+}
+
+unsigned int ReplicationScheduler::getDeferredCount( RakNet::RakNetGUID client ) const
+{
+    Connections::const_iterator i = mConnections.find( client );
+    if( i == mConnections.end() ) return 0;
+
+    unsigned int count = 0;
+    for( std::map<ServerObject*, Pending>::const_iterator j = i->second.mPending.begin(); 
+        j != i->second.mPending.end(); ++j )
+    {
+        if( !j->second.mScheduled ) ++count;
+    }
+
+    return count;
+}
+
+void ReplicationScheduler::setComponentWeight( ComponentType type, Real weight )
+{
+    msComponentWeights[type] = weight;
+}
+
+Real ReplicationScheduler::getComponentWeight( ComponentType type )
+{
+    std::map<ComponentType, Real>::const_iterator i = msComponentWeights.find( type );
+    if( i == msComponentWeights.end() ) return 1;
+    return i->second;
+}
+
+void ReplicationScheduler::update()
+{
+    RakNet::Time time = RakNet::GetTime();
+    Real elapsed = mLastUpdate ? ( time - mLastUpdate ) / 1000.0 : 0;
+    mLastUpdate = time;
+
+    if( !msSettings.mEnabled )
+    {
+        mConnections.clear();
+        mChanged.clear();
+        return;
+    }
+
+    // Take the changes of the objects that changed since the last update, from now on they are 
+    // serialized per client. Objects that did not change are not visited, so an idle world costs
+    // nothing here. Objects that still have to send their final transform stay tracked.
+    std::vector<std::pair<ServerObject*, unsigned char> > changed;
+    std::set<ServerObject*> resting;
+    for( std::set<ServerObject*>::iterator i = mChanged.begin(); i != mChanged.end(); ++i )
+    {
+        unsigned char changes = (*i)->takeSerializationChanges();
+        if( changes ) changed.push_back( std::make_pair( *i, changes ) );
+        if( (*i)->isRestPending() ) resting.insert( *i );
+    }
+    mChanged.swap( resting );
+
+    const Real maxBudget = msSettings.mBytesPerSecond * ( msSettings.mMaxBurstMS / 1000.0 );
+    std::set<RakNet::RakNetGUID> connected;
+    std::vector<PriorityEntry> priorities;
+
+    for( unsigned int c = 0; c < mReplicaManager.GetConnectionCount(); ++c )
+    {
+        RakNet::Connection_RM3* connection = mReplicaManager.GetConnectionAtIndex( c );
+        RakNet::RakNetGUID client = connection->GetRakNetGUID();
+        connected.insert( client );
+        Connection& state = mConnections[client];
+
+        // Merge new changes with the changes that were deferred. Objects that are not 
+        // constructed on the client get their full state when they are constructed.
+        for( std::vector<std::pair<ServerObject*, unsigned char> >::iterator i = 
+            changed.begin(); i != changed.end(); ++i )
+        {
+            if( connection->HasReplicaConstructed( i->first ) )
+                state.mPending[i->first].mChanges |= i->second;
+        }
+
+        state.mBudget = std::min( state.mBudget + msSettings.mBytesPerSecond * elapsed, 
+            maxBudget );
+
+        // Accumulate priority.
+        priorities.clear();
+        for( std::map<ServerObject*, Pending>::iterator i = state.mPending.begin(); 
+            i != state.mPending.end(); )
+        {
+            ServerObject& object = *i->first;
+            if( !connection->HasReplicaConstructed( &object ) )
+            {
+                // Destroyed on the client because it is no longer relevant.
+                state.mPending.erase( i++ );
+                continue;
+            }
+
+            Real priority = object.getReplicationPriority() * 
+                ReplicationScheduler::getWeight( object );
+            Real distance = mInterestManager.getDistance( object, client );
+            if( distance > 0 && msSettings.mDistanceScale > 0 ) 
+                priority /= 1 + distance / msSettings.mDistanceScale;
+
+            i->second.mPriority += priority * elapsed;
+            i->second.mScheduled = false;
+            priorities.push_back( PriorityEntry( i->second.mPriority, &object ) );
+            ++i;
+        }
+
+        // Schedule objects with the highest priority until their estimated size exceeds the 
+        // budget, the last object may exceed the budget so that large changes are not starved.
+        // The budget itself is charged in charge() when the objects are serialized, objects that
+        // are scheduled but not serialized before the next tick do not use up any budget.
+        std::sort( priorities.begin(), priorities.end(), std::greater<PriorityEntry>() );
+        Real available = state.mBudget;
+        for( std::vector<PriorityEntry>::iterator i = priorities.begin(); 
+            i != priorities.end() && available > 0; ++i )
+        {
+            Pending& pending = state.mPending[i->second];
+            pending.mScheduled = true;
+            available -= i->second->getSerializationSize( pending.mChanges );
+
+            // Scheduled objects may not have changed in this tick, make sure they are queried.
+            DirtyReplicas::mark( *i->second );
+        }
+    }
+
+    // Forget clients that have disconnected.
+    for( Connections::iterator i = mConnections.begin(); i != mConnections.end(); )
+    {
+        if( !connected.count( i->first ) )
+            mConnections.erase( i++ );
+        else
+            ++i;
+    }
+}
+
+void ReplicationScheduler::objectChange( Object& rObject, bool created )
+{
+    ServerObject& object = static_cast<ServerObject&>( rObject );
+
+    if( created )
+    {
+        mObjects.insert( &object );
+        mChanged.insert( &object );
+    }
+    else
+    {
+        mObjects.erase( &object );
+        mChanged.erase( &object );
+
+        for( Connections::iterator i = mConnections.begin(); i != mConnections.end(); ++i )
+        {
+            i->second.mPending.erase( &object );
+        }
+    }
+}
+
+void ReplicationScheduler::stateChange( Object& rObject )
+{
+    // Objects can change while they are being created, they are tracked once they are created.
+    ServerObject& object = static_cast<ServerObject&>( rObject );
+    if( mObjects.count( &object ) ) mChanged.insert( &object );
+}
+
+Real ReplicationScheduler::getWeight( const ServerObject& rObject ) const
+{
+    const ComponentsByType& components = rObject.getComponentsByType();
+    if( components.empty() ) return 1;
+
+    Real weight = 0;
+    for( ComponentsByType::const_iterator i = components.begin(); i != components.end(); 
+        i = components.upper_bound( i->first ) )
+    {
+        weight = std::max( weight, ReplicationScheduler::getComponentWeight( i->first ) );
+    }
+
+    return weight;
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Server
+} // Namespace Diversia
@@ -0,0 +1,195 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Diversia is free software: you can redistribute it and/or modify it under the 
+terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+Diversia is distributed in the hope that it will be useful, but WITHOUT ANY 
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+Diversia. If not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SERVER_REPLICATIONSCHEDULER_H
+#define DIVERSIA_SERVER_REPLICATIONSCHEDULER_H
+
+#include "Platform/Prerequisites.h"
+
+namespace Diversia
+{
+namespace Server
+{
+//------------------------------------------------------------------------------
+
+/**
+Schedules object serialization per client within a bandwidth budget. Every tick each client 
+receives a byte budget, changed objects that are relevant to that client accumulate priority 
+and are scheduled for the client in order of priority until the estimated size of the scheduled 
+objects exceeds the budget. The budget is only charged for the bytes that are actually written 
+when an object is serialized, see charge(). Objects that do not fit in the budget are deferred, 
+their changes are merged with later changes and serialized when their priority is high enough.
+
+The priority of an object grows every tick it is deferred, by the replication priority of the 
+object multiplied by the highest weight of its component types and divided by the distance to
+the nearest viewpoint of the client. Nearby and important objects are serialized more often 
+while far away objects are never starved.
+
+Only objects whose state changed since the last tick are visited to take their changes, see 
+ObjectManager::connectStateChange, the cost of a tick does not grow with the amount of idle 
+objects.
+**/
+class ReplicationScheduler : public sigc::trackable, public boost::noncopyable
+{
+public:
+    /**
+    Constructor. 
+    
+    @param [in,out] rObjectManager      The object manager to track objects from.
+    @param [in,out] rInterestManager    The interest manager to get relevance and distance from.
+    @param [in,out] rReplicaManager     The replica manager to get client connections from.
+    @param [in,out] rUpdateSignal       The update signal. 
+    **/
+    ReplicationScheduler( ServerObjectManager& rObjectManager, InterestManager& rInterestManager,
+        RakNet::ReplicaManager3& rReplicaManager, sigc::signal<void>& rUpdateSignal );
+    /**
+    Destructor. 
+    **/
+    ~ReplicationScheduler();
+
+    /**
+    Query if an object should be serialized to a client in this tick.
+    
+    @param  rObject The object.
+    @param  client  The GUID of the client.
+    **/
+    bool isScheduled( const ServerObject& rObject, RakNet::RakNetGUID client ) const;
+    /**
+    Gets the changes of an object that have to be serialized to a client and removes them from 
+    the schedule.
+    
+    @param  rObject The object.
+    @param  client  The GUID of the client.
+
+    @return Combination of Object::SerializationChange flags.
+    **/
+    unsigned char takeChanges( const ServerObject& rObject, RakNet::RakNetGUID client );
+    /**
+    Adds changes of an object that have to be serialized to a client, for example when the object
+    is marked as constructed on a client without sending its construction.
+    
+    @param  rObject The object.
+    @param  client  The GUID of the client.
+    @param  changes Combination of Object::SerializationChange flags.
+    **/
+    void addChanges( const ServerObject& rObject, RakNet::RakNetGUID client, 
+        unsigned char changes );
+    /**
+    Charges the budget of a client for bytes that were serialized to it. Must be called after 
+    serializing the changes returned by takeChanges().
+    
+    @param  client  The GUID of the client.
+    @param  bytes   The amount of bytes that were serialized.
+    **/
+    void charge( RakNet::RakNetGUID client, unsigned int bytes );
+    /**
+    Gets the amount of objects with changes that are deferred for a client.
+
+    @param  client  The GUID of the client.
+    **/
+    unsigned int getDeferredCount( RakNet::RakNetGUID client ) const;
+    /**
+    Sets the replication weight of a component type. Objects get the highest weight of their
+    component types, component types without a weight have a weight of 1.
+    **/
+    static void setComponentWeight( ComponentType type, Real weight );
+    /**
+    Gets the replication weight of a component type.
+    **/
+    static Real getComponentWeight( ComponentType type );
+
+private:
+    struct Pending
+    {
+        Pending() : mChanges( 0 ), mPriority( 0 ), mScheduled( false ) {}
+
+        unsigned char   mChanges;
+        Real            mPriority;
+        bool            mScheduled;
+    };
+
+    struct Connection
+    {
+        Connection() : mBudget( 0 ) {}
+
+        Real                                mBudget;
+        std::map<ServerObject*, Pending>    mPending;
+    };
+
+    typedef std::map<RakNet::RakNetGUID, Connection> Connections;
+    typedef std::pair<Real, ServerObject*> PriorityEntry;
+
+    void update();
+    void objectChange( Object& rObject, bool created );
+    void stateChange( Object& rObject );
+    Real getWeight( const ServerObject& rObject ) const;
+
+    ServerObjectManager&        mObjectManager;
+    InterestManager&            mInterestManager;
+    RakNet::ReplicaManager3&    mReplicaManager;
+    sigc::connection            mUpdateConnection;
+    sigc::connection            mObjectConnection;
+    sigc::connection            mStateChangeConnection;
+
+    std::set<ServerObject*>     mObjects;
+    std::set<ServerObject*>     mChanged;   ///< Objects that changed since the last update.
+    Connections                 mConnections;
+    RakNet::Time                mLastUpdate;
+
+    static std::map<ComponentType, Real> msComponentWeights;
+
+    /**
+    Settings for replication scheduling.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mEnabled( true ),
+            mBytesPerSecond( 32768 ),
+            mMaxBurstMS( 250 ),
+            mDistanceScale( 50 )
+        {
+        
+        }
+
+        bool            mEnabled;
+        unsigned int    mBytesPerSecond;    ///< Budget per client.
+        unsigned int    mMaxBurstMS;        ///< Maximum budget that can be saved up, in time.
+        Real            mDistanceScale;     ///< Distance at which the priority is halved.
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static ReplicationScheduler::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Server
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::Server::ReplicationScheduler::Settings, 
+    &Diversia::Server::Bindings::CampBindings::bindReplicationSchedulerSettings );
+
+#endif // DIVERSIA_SERVER_REPLICATIONSCHEDULER_H
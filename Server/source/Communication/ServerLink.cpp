@@ -0,0 +1,809 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Diversia is free software: you can redistribute it and/or modify it under the 
+terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+Diversia is distributed in the hope that it will be useful, but WITHOUT ANY 
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+Diversia. If not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
+-----------------------------------------------------------------------------
+*/
+
+#include "Platform/StableHeaders.h"
+
+#include "Communication/ClientConnection.h"
+#include "Communication/ServerLink.h"
+#include "Communication/ServerNeighborsPlugin.h"
+#include "Object/RigidBody.h"
+#include "Object/ServerObjectManager.h"
+#include "Physics/PhysicsManager.h"
+#include "Shared/Camp/CampBitStream.h"
+#include "Shared/Communication/GridPosition.h"
+#include "User/Session.h"
+#include "User/SessionManager.h"
+#include "User/User.h"
+
+namespace Diversia
+{
+namespace Server
+{
+//------------------------------------------------------------------------------
+
+ServerLink::Settings ServerLink::msSettings = ServerLink::Settings();
+
+ServerLink::ServerLink( ServerObjectManager& rObjectManager, ServerNeighborsPlugin& rNeighbors, 
+    SessionManager& rSessionManager, sigc::signal<void>& rUpdateSignal ):
+    mRakPeer( *RakNet::RakPeerInterface::GetInstance() ),
+    mNetworkStage( mRakPeer ),
+    mObjectManager( rObjectManager ),
+    mNeighbors( rNeighbors ),
+    mSessionManager( rSessionManager ),
+    mListening( false ),
+    mNextUpdate( 0 ),
+    mNextConnect( 0 )
+{
+    mUpdateConnection = rUpdateSignal.connect( sigc::mem_fun( this, &ServerLink::update ) );
+    mObjectConnection = mObjectManager.connect( sigc::mem_fun( this, 
+        &ServerLink::objectChange ) );
+}
+
+ServerLink::~ServerLink()
+{
+    mUpdateConnection.disconnect();
+    mObjectConnection.disconnect();
+
+    ServerLink::disconnect();
+    RakNet::RakPeerInterface::DestroyInstance( &mRakPeer );
+}
+
+void ServerLink::listen()
+{
+    const ServerInfo& serverInfo = ClientConnection::getSettings().mServerInfo;
+
+    RakNet::SocketDescriptor sd;
+    sd.port = serverInfo.mPort + msSettings.mPortOffset;
+    strcpy( sd.hostAddress, serverInfo.mAddress.c_str() );
+
+    mRakPeer.SetMaximumIncomingConnections( 8 );
+    if( mRakPeer.Startup( 8, &sd, 1 ) != RakNet::RAKNET_STARTED )
+    {
+        DIVERSIA_EXCEPT( Exception::ERR_INTERNAL_ERROR, "Could not create a new socket or thread.", 
+            "ServerLink::listen" );
+    }
+
+    mNetworkStage.start();
+    mListening = true;
+    mNextConnect = 0;
+
+    LOGI << "Listening for neighbor servers on port " << sd.port;
+}
+
+void ServerLink::disconnect()
+{
+    if( !mListening ) return;
+
+    mNetworkStage.stop();
+    mRakPeer.Shutdown( ClientConnection::getSettings().mShutdownBlockDuractionMS );
+    mListening = false;
+
+    while( !mLinks.empty() ) ServerLink::removeLink( mLinks.begin()->first );
+    mMigrations.clear();
+    mOrigins.clear();
+}
+
+void ServerLink::update()
+{
+    if( !mListening ) return;
+
+    mNetworkStage.update();
+
+    RakNet::Packet *packet;
+    for( packet = mNetworkStage.receive(); packet; mNetworkStage.deallocatePacket( packet ), 
+        packet = mNetworkStage.receive() )
+    {
+        ServerLink::handlePacket( *packet );
+    }
+
+    RakNet::Time time = RakNet::GetTime();
+    if( time >= mNextConnect )
+    {
+        ServerLink::connectNeighbors();
+        mNextConnect = time + msSettings.mConnectIntervalMS;
+    }
+    if( time >= mNextUpdate )
+    {
+        ServerLink::updateBorders();
+        mNextUpdate = time + msSettings.mUpdateIntervalMS;
+    }
+
+    if( !mArrivals.empty() ) ServerLink::updateArrivals();
+}
+
+void ServerLink::handlePacket( RakNet::Packet& rPacket )
+{
+    switch( rPacket.data[0] )
+    {
+        case ID_CONNECTION_ATTEMPT_FAILED:
+            LOGD << "Neighbor server connection attempt failed: " << 
+                rPacket.systemAddress.ToString();
+            break;
+        case ID_CONNECTION_REQUEST_ACCEPTED:
+        {
+            // Find the neighbor this server connected to and tell it where this server is.
+            const NeighborsMap& neighbors = mNeighbors.getServerNeighbors().getNeighbors();
+            for( NeighborsMap::const_iterator i = neighbors.begin(); i != neighbors.end(); ++i )
+            {
+                if( i->first < SOUTH && RakNet::SystemAddress( i->second.mAddress.c_str(), 
+                    i->second.mPort + msSettings.mPortOffset ) == rPacket.systemAddress )
+                {
+                    RakNet::BitStream bitStream;
+                    bitStream.Write( (RakNet::MessageID)ID_SERVERLINK_HELLO );
+                    bitStream.Write( (unsigned char)ServerLink::getOpposite( i->first ) );
+                    ServerLink::send( bitStream, rPacket.guid );
+                    ServerLink::addLink( rPacket.guid, i->first );
+                    return;
+                }
+            }
+
+            LOGW << "Connected to a server that is not a neighbor: " << 
+                rPacket.systemAddress.ToString();
+            mRakPeer.CloseConnection( rPacket.guid, true );
+            break;
+        }
+        case ID_DISCONNECTION_NOTIFICATION:
+        case ID_CONNECTION_LOST:
+            ServerLink::removeLink( rPacket.guid );
+            break;
+        case ID_SERVERLINK_HELLO:
+        {
+            unsigned char direction = rPacket.length > 1 ? rPacket.data[1] : 0xFF;
+            if( direction < 8 && mNeighbors.getServerNeighbors().hasServer( 
+                (Direction)direction ) )
+            {
+                ServerLink::addLink( rPacket.guid, (Direction)direction );
+            }
+            else
+            {
+                LOGW << "Refused link from a server that is not a neighbor: " << 
+                    rPacket.systemAddress.ToString();
+                mRakPeer.CloseConnection( rPacket.guid, true );
+            }
+            break;
+        }
+        case ID_SERVERLINK_GHOST:
+        case ID_SERVERLINK_GHOST_TRANSFORM:
+        case ID_SERVERLINK_GHOST_REMOVE:
+        case ID_SERVERLINK_MIGRATE:
+        case ID_SERVERLINK_MIGRATE_ACK:
+        {
+            if( !mLinks.count( rPacket.guid ) ) break;
+
+            RakNet::BitStream bitStream( rPacket.data, rPacket.length, false );
+            bitStream.IgnoreBytes( sizeof( RakNet::MessageID ) );
+
+            try
+            {
+                switch( rPacket.data[0] )
+                {
+                    case ID_SERVERLINK_GHOST: 
+                        ServerLink::receiveGhost( bitStream, rPacket.guid ); break;
+                    case ID_SERVERLINK_GHOST_TRANSFORM: 
+                        ServerLink::receiveGhostTransform( bitStream, rPacket.guid ); break;
+                    case ID_SERVERLINK_GHOST_REMOVE: 
+                        ServerLink::receiveGhostRemove( bitStream, rPacket.guid ); break;
+                    case ID_SERVERLINK_MIGRATE: 
+                        ServerLink::receiveMigrate( bitStream, rPacket.guid ); break;
+                    case ID_SERVERLINK_MIGRATE_ACK: 
+                        ServerLink::receiveMigrateAck( bitStream, rPacket.guid ); break;
+                }
+            }
+            catch( Exception e )
+            {
+                LOGE << "Error handling neighbor server message: " << e.what();
+            }
+            break;
+        }
+    }
+}
+
+void ServerLink::connectNeighbors()
+{
+    const NeighborsMap& neighbors = mNeighbors.getServerNeighbors().getNeighbors();
+    for( NeighborsMap::const_iterator i = neighbors.begin(); i != neighbors.end(); ++i )
+    {
+        // Neighbors in the other directions connect to this server.
+        if( i->first >= SOUTH ) continue;
+
+        bool linked = false;
+        for( Links::iterator j = mLinks.begin(); j != mLinks.end(); ++j )
+        {
+            if( j->second.mDirection == i->first ) linked = true;
+        }
+
+        if( !linked ) mRakPeer.Connect( i->second.mAddress.c_str(), 
+            i->second.mPort + msSettings.mPortOffset, 0, 0 );
+    }
+}
+
+void ServerLink::addLink( RakNet::RakNetGUID guid, Direction direction )
+{
+    mLinks[guid] = Link( direction );
+
+    LOGI << "Linked to " << camp::enumByType<Direction>().name( direction ) << 
+        " neighbor server " << mNeighbors.getServerNeighbors().getServer( direction ).mName;
+}
+
+void ServerLink::removeLink( RakNet::RakNetGUID guid )
+{
+    Links::iterator i = mLinks.find( guid );
+    if( i == mLinks.end() ) return;
+
+    LOGI << "Lost link to " << camp::enumByType<Direction>().name( i->second.mDirection ) << 
+        " neighbor server";
+
+    // Ghosts from the neighbor are no longer updated.
+    for( Ghosts::iterator j = mGhosts.begin(); j != mGhosts.end(); )
+    {
+        if( j->second == guid ) 
+        {
+            String name = j->first;
+            ++j;
+            ServerLink::removeGhost( name );
+        }
+        else ++j;
+    }
+
+    // Objects that were being handed off to the neighbor stay on this server.
+    for( Migrations::iterator j = mMigrations.begin(); j != mMigrations.end(); )
+    {
+        if( j->second.mLink == guid ) mMigrations.erase( j++ );
+        else ++j;
+    }
+
+    mLinks.erase( i );
+}
+
+void ServerLink::updateBorders()
+{
+    RakNet::Time time = RakNet::GetTime();
+
+    // Hand offs that were refused are tried again. Hand offs that are not acknowledged in time 
+    // are kept until the ack arrives, the neighbor may have accepted the object already and this
+    // server must not keep simulating it when it did.
+    for( Migrations::iterator i = mMigrations.begin(); i != mMigrations.end(); )
+    {
+        Migration& migration = i->second;
+        if( migration.mRefused && time >= migration.mTimeout )
+        {
+            LOGW << "Hand off of object " << i->first << " was not accepted, retrying";
+            mMigrations.erase( i++ );
+            continue;
+        }
+        else if( !migration.mTimedOut && time >= migration.mTimeout )
+        {
+            LOGW << "Hand off of object " << i->first << " was not acknowledged in time, " << 
+                "waiting for the acknowledgement";
+            migration.mTimedOut = true;
+        }
+        ++i;
+    }
+
+    std::map<RakNet::RakNetGUID, std::vector<Object*> > transforms;
+
+    const Objects& objects = mObjectManager.getObjects();
+    for( Objects::const_iterator i = objects.begin(); i != objects.end(); ++i )
+    {
+        Object& object = *i->second;
+        if( object.hasParent() || object.getNetworkingType() != REMOTE || 
+            ServerLink::isGhost( i->first ) || ServerLink::isMigrating( i->first ) ) continue;
+
+        const Vector3& position = object.getPosition();
+
+        // Hand off objects that left the cell of this server.
+        Direction direction;
+        if( ServerLink::getCrossedDirection( position, msSettings.mMigrationMargin, direction ) )
+        {
+            Links::iterator link = mLinks.begin();
+            while( link != mLinks.end() && link->second.mDirection != direction ) ++link;
+
+            if( link != mLinks.end() ) 
+            {
+                ServerLink::migrate( object, link->first, link->second );
+                continue;
+            }
+        }
+
+        // Create, update and remove ghosts of objects near borders.
+        for( Links::iterator j = mLinks.begin(); j != mLinks.end(); ++j )
+        {
+            Link& link = j->second;
+            bool near = ServerLink::isNear( position, link.mDirection, msSettings.mGhostMargin );
+            bool ghosted = link.mGhosts.count( i->first ) != 0;
+
+            if( near && !ghosted )
+            {
+                RakNet::BitStream bitStream;
+                bitStream.Write( (RakNet::MessageID)ID_SERVERLINK_GHOST );
+                bitStream << i->first;
+                ServerLink::writeObject( bitStream, object, 
+                    ServerLink::getOffset( link.mDirection ) );
+                ServerLink::send( bitStream, j->first );
+                link.mGhosts.insert( i->first );
+            }
+            else if( near )
+            {
+                transforms[j->first].push_back( &object );
+            }
+            else if( ghosted )
+            {
+                RakNet::BitStream bitStream;
+                bitStream.Write( (RakNet::MessageID)ID_SERVERLINK_GHOST_REMOVE );
+                bitStream << i->first;
+                ServerLink::send( bitStream, j->first );
+                link.mGhosts.erase( i->first );
+            }
+        }
+    }
+
+    // Send the transforms of all ghosts of a link in one message, only the latest is needed.
+    for( std::map<RakNet::RakNetGUID, std::vector<Object*> >::iterator i = transforms.begin(); 
+        i != transforms.end(); ++i )
+    {
+        Vector3 offset = ServerLink::getOffset( mLinks[i->first].mDirection );
+
+        RakNet::BitStream bitStream;
+        bitStream.Write( (RakNet::MessageID)ID_SERVERLINK_GHOST_TRANSFORM );
+        RakNet::writeVarUInt( bitStream, (unsigned int)i->second.size() );
+        for( std::vector<Object*>::iterator j = i->second.begin(); j != i->second.end(); ++j )
+        {
+            Vector3 position = (*j)->getPosition() - offset;
+            Quaternion orientation = (*j)->getOrientation();
+            bitStream << (*j)->getName() << position << orientation;
+        }
+        ServerLink::send( bitStream, i->first, UNRELIABLE_SEQUENCED );
+    }
+}
+
+void ServerLink::updateArrivals()
+{
+    RakNet::Time time = RakNet::GetTime();
+
+    for( Arrivals::iterator i = mArrivals.begin(); i != mArrivals.end(); )
+    {
+        Arrival& arrival = i->second;
+        if( !mObjectManager.hasObject( i->first ) )
+        {
+            mArrivals.erase( i++ );
+            continue;
+        }
+        Object& object = mObjectManager.getObject( i->first );
+
+        // Give control back to the user once it has a session on this server.
+        if( !arrival.mController.empty() )
+        {
+            const Sessions& sessions = mSessionManager.getSessions();
+            for( Sessions::const_iterator j = sessions.begin(); j != sessions.end(); ++j )
+            {
+                if( j->second->getUser().getName() == arrival.mController )
+                {
+                    object.setClientControlled( j->first );
+                    arrival.mController.clear();
+                    break;
+                }
+            }
+        }
+
+        // Restore the velocity once the rigid body is created.
+        if( arrival.mVelocity && object.hasComponent<RigidBody>() && 
+            object.getComponent<RigidBody>().isLoaded() )
+        {
+            btRigidBody& body = *object.getComponent<RigidBody>().getRigidBody();
+            body.setLinearVelocity( toVector3<btVector3>( arrival.mLinearVelocity ) );
+            body.setAngularVelocity( toVector3<btVector3>( arrival.mAngularVelocity ) );
+            body.activate();
+            arrival.mVelocity = false;
+        }
+
+        if( arrival.mController.empty() && !arrival.mVelocity )
+        {
+            mArrivals.erase( i++ );
+        }
+        else if( time >= arrival.mTimeout )
+        {
+            LOGW << "Could not restore the controller or velocity of handed off object " << 
+                i->first;
+            mArrivals.erase( i++ );
+        }
+        else ++i;
+    }
+}
+
+void ServerLink::migrate( Object& rObject, RakNet::RakNetGUID guid, const Link& rLink )
+{
+    const String& name = rObject.getName();
+
+    // Users have a different GUID on every server, identify the controller by user name.
+    String controller;
+    if( rObject.isClientControlled() && mSessionManager.hasSession( 
+        rObject.getClientController() ) )
+    {
+        controller = mSessionManager.getSession( rObject.getClientController() ).getUser().
+            getName();
+    }
+
+    RakNet::BitStream bitStream;
+    bitStream.Write( (RakNet::MessageID)ID_SERVERLINK_MIGRATE );
+    bitStream << name << controller;
+
+    bool velocity = rObject.hasComponent<RigidBody>() && 
+        rObject.getComponent<RigidBody>().isLoaded();
+    bitStream.Write( velocity );
+    if( velocity )
+    {
+        btRigidBody& body = *rObject.getComponent<RigidBody>().getRigidBody();
+        Vector3 linearVelocity = toVector3<Vector3>( body.getLinearVelocity() );
+        Vector3 angularVelocity = toVector3<Vector3>( body.getAngularVelocity() );
+        bitStream << linearVelocity << angularVelocity;
+    }
+
+    ServerLink::writeObject( bitStream, rObject, ServerLink::getOffset( rLink.mDirection ) );
+    ServerLink::send( bitStream, guid );
+
+    Migration migration;
+    migration.mLink = guid;
+    migration.mTimeout = RakNet::GetTime() + msSettings.mAckTimeoutMS;
+    mMigrations[name] = migration;
+
+    LOGI << "Handing off object " << name << " to " << 
+        camp::enumByType<Direction>().name( rLink.mDirection ) << " neighbor server";
+}
+
+void ServerLink::receiveGhost( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid )
+{
+    String name; rBitStream >> name;
+
+    if( mObjectManager.hasObject( name ) && !ServerLink::isGhost( name ) )
+    {
+        LOGD << "Ignoring ghost " << name << ", an object with that name already exists";
+        return;
+    }
+
+    try
+    {
+        mGhosts[name] = guid;
+        ServerLink::readObject( rBitStream, LOCAL );
+    }
+    catch( Exception e )
+    {
+        LOGW << "Could not create ghost " << name << ": " << e.what();
+        ServerLink::removeGhost( name );
+    }
+}
+
+void ServerLink::receiveGhostTransform( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid )
+{
+    unsigned int count = RakNet::readVarUInt( rBitStream );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        String name; Vector3 position; Quaternion orientation;
+        rBitStream >> name >> position >> orientation;
+
+        Ghosts::iterator j = mGhosts.find( name );
+        if( j != mGhosts.end() && j->second == guid && mObjectManager.hasObject( name ) )
+        {
+            Object& object = mObjectManager.getObject( name );
+            object.setPosition( position );
+            object.setOrientation( orientation );
+        }
+    }
+}
+
+void ServerLink::receiveGhostRemove( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid )
+{
+    String name; rBitStream >> name;
+
+    Ghosts::iterator i = mGhosts.find( name );
+    if( i != mGhosts.end() && i->second == guid ) ServerLink::removeGhost( name );
+}
+
+void ServerLink::receiveMigrate( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid )
+{
+    String name;
+    Arrival arrival;
+    rBitStream >> name >> arrival.mController;
+    rBitStream.Read( arrival.mVelocity );
+    if( arrival.mVelocity ) rBitStream >> arrival.mLinearVelocity >> arrival.mAngularVelocity;
+
+    RakNet::BitStream ack;
+    ack.Write( (RakNet::MessageID)ID_SERVERLINK_MIGRATE_ACK );
+    ack << name;
+
+    if( mObjectManager.hasObject( name ) && !ServerLink::isGhost( name ) )
+    {
+        // The neighbor handed off this object before but did not get the acknowledgement, for 
+        // example because the link was lost. Accept it again so that the neighbor destroys its 
+        // copy.
+        Origins::iterator origin = mOrigins.find( name );
+        if( origin != mOrigins.end() && origin->second == guid )
+        {
+            LOGI << "Accepted repeated hand off of object " << name;
+            ack.Write( true );
+            ServerLink::send( ack, guid );
+            return;
+        }
+
+        LOGW << "Refused hand off of object " << name << ", an object with that name already " <<
+            "exists";
+        ack.Write( false );
+        ServerLink::send( ack, guid );
+        return;
+    }
+
+    try
+    {
+        // Promote the ghost instead of creating the object, so that its components do not have
+        // to be loaded again. 
+        if( ServerLink::isGhost( name ) )
+        {
+            mGhosts.erase( name );
+            if( mObjectManager.hasObject( name ) ) 
+                mObjectManager.getObject( name ).setNetworkingType( REMOTE );
+        }
+
+        ServerLink::readObject( rBitStream, REMOTE );
+
+        arrival.mTimeout = RakNet::GetTime() + msSettings.mArrivalTimeoutMS;
+        if( !arrival.mController.empty() || arrival.mVelocity ) mArrivals[name] = arrival;
+        mOrigins[name] = guid;
+
+        ack.Write( true );
+
+        LOGI << "Accepted hand off of object " << name;
+    }
+    catch( Exception e )
+    {
+        LOGE << "Could not accept hand off of object " << name << ": " << e.what();
+        if( mObjectManager.hasObject( name ) ) 
+            mObjectManager.destroyObjectTree( mObjectManager.getObject( name ) );
+        ack.Write( false );
+    }
+
+    ServerLink::send( ack, guid );
+}
+
+void ServerLink::receiveMigrateAck( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid )
+{
+    String name; bool accepted;
+    rBitStream >> name;
+    rBitStream.Read( accepted );
+
+    Migrations::iterator i = mMigrations.find( name );
+    if( i == mMigrations.end() || i->second.mLink != guid ) return;
+
+    if( !accepted )
+    {
+        // Try again after the timeout.
+        i->second.mRefused = true;
+        i->second.mTimeout = RakNet::GetTime() + msSettings.mAckTimeoutMS;
+        return;
+    }
+
+    if( i->second.mTimedOut ) LOGI << "Late acknowledgement of hand off of object " << name;
+
+    // The neighbor is the authority now. The migration is kept until the object is destroyed 
+    // so that it is not handed off again in the meantime.
+    mLinks[guid].mGhosts.erase( name );
+    if( mObjectManager.hasObject( name ) ) 
+        mObjectManager.destroyObjectTree( mObjectManager.getObject( name ) );
+}
+
+void ServerLink::writeObject( RakNet::BitStream& rBitStream, Object& rObject, 
+    const Vector3& rOffset )
+{
+    Vector3 position = rObject.getPosition() - rOffset;
+    Quaternion orientation = rObject.getOrientation();
+    Vector3 scale = rObject.getScale();
+    rBitStream << rObject.getName() << rObject.getDisplayName() << position << orientation << 
+        scale;
+
+    // Components with their serialized state, auto created components are created by the object.
+    std::vector<Component*> components;
+    const ComponentsByType& componentsByType = rObject.getComponentsByType();
+    for( ComponentsByType::const_iterator i = componentsByType.begin(); 
+        i != componentsByType.end(); ++i )
+    {
+        if( !Object::hasAutoCreateComponent( i->first ) ) components.push_back( i->second );
+    }
+
+    RakNet::writeVarUInt( rBitStream, (unsigned int)components.size() );
+    for( std::vector<Component*>::iterator i = components.begin(); i != components.end(); ++i )
+    {
+        RakNet::writeVarUInt( rBitStream, (*i)->getType() );
+        rBitStream << (*i)->getName();
+        rBitStream.Write( (*i)->getLocalOverride() );
+
+        RakNet::BitStream state;
+        camp::UserObject userObject = *i;
+        CampBitStream::serialize( userObject, state, "NoBitStream" );
+        RakNet::writeVarUInt( rBitStream, (unsigned int)state.GetNumberOfBitsUsed() );
+        rBitStream.WriteBits( state.GetData(), state.GetNumberOfBitsUsed(), false );
+    }
+
+    // Child objects, their transform is relative to this object.
+    ObjectHashMap childs = rObject.getChildObjects();
+    RakNet::writeVarUInt( rBitStream, (unsigned int)childs.size() );
+    for( ObjectHashMap::iterator i = childs.begin(); i != childs.end(); ++i )
+    {
+        ServerLink::writeObject( rBitStream, *i->second, Vector3::ZERO );
+    }
+}
+
+Object& ServerLink::readObject( RakNet::BitStream& rBitStream, NetworkingType type )
+{
+    String name, displayName; Vector3 position, scale; Quaternion orientation;
+    rBitStream >> name >> displayName >> position >> orientation >> scale;
+
+    Object& object = mObjectManager.hasObject( name ) ? mObjectManager.getObject( name ) :
+        mObjectManager.createObject( name, type, displayName );
+    object.setRuntimeObject( type == LOCAL );
+    object.setDisplayName( displayName );
+    object.setPosition( position );
+    object.setOrientation( orientation );
+    object.setScale( scale );
+
+    std::set<String> names;
+    unsigned int count = RakNet::readVarUInt( rBitStream );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        ComponentType componentType = (ComponentType)RakNet::readVarUInt( rBitStream );
+        String componentName; rBitStream >> componentName;
+        bool localOverride; rBitStream.Read( localOverride );
+        RakNet::BitSize_t bits = RakNet::readVarUInt( rBitStream );
+        RakNet::BitSize_t end = rBitStream.GetReadOffset() + bits;
+
+        // Scripts of the original already run on the neighbor.
+        if( type == LOCAL && componentType == COMPONENTTYPE_LUAOBJECTSCRIPT )
+        {
+            rBitStream.SetReadOffset( end );
+            continue;
+        }
+        names.insert( componentName );
+
+        try
+        {
+            Component& component = object.hasComponent( componentName ) ? 
+                object.getComponent( componentName ) : 
+                object.createComponent( componentType, componentName, localOverride );
+            camp::UserObject userObject = &component;
+            CampBitStream::deserialize( userObject, rBitStream, "NoBitStream" );
+
+            // Ghosts follow the original, they must not be simulated.
+            if( type == LOCAL && componentType == COMPONENTTYPE_RIGIDBODY )
+                static_cast<RigidBody&>( component ).setPhysicsType( PHYSICSTYPE_KINEMATIC );
+        }
+        catch( Exception e )
+        {
+            LOGW << "Could not restore component " << componentName << " of object " << name << 
+                ": " << e.what();
+        }
+        catch( camp::Error e )
+        {
+            LOGW << "Could not restore component " << componentName << " of object " << name << 
+                ": " << e.what();
+        }
+
+        rBitStream.SetReadOffset( end );
+    }
+
+    // Remove components that the original does not have (anymore).
+    std::vector<String> removed;
+    const ComponentsByName& componentsByName = object.getComponentsByName();
+    for( ComponentsByName::const_iterator i = componentsByName.begin(); 
+        i != componentsByName.end(); ++i )
+    {
+        if( !names.count( i->first ) && !Object::hasAutoCreateComponent( 
+            i->second->getType() ) ) removed.push_back( i->first );
+    }
+    for( std::vector<String>::iterator i = removed.begin(); i != removed.end(); ++i )
+        object.destroyComponent( *i );
+
+    unsigned int childCount = RakNet::readVarUInt( rBitStream );
+    for( unsigned int i = 0; i < childCount; ++i )
+    {
+        Object& child = ServerLink::readObject( rBitStream, type );
+        if( child.getParentObject() != &object ) child.parent( &object );
+    }
+
+    return object;
+}
+
+void ServerLink::removeGhost( const String& rName )
+{
+    mGhosts.erase( rName );
+    if( mObjectManager.hasObject( rName ) ) 
+        mObjectManager.destroyObjectTree( mObjectManager.getObject( rName ) );
+}
+
+void ServerLink::send( const RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid, 
+    PacketReliability reliability /*= RELIABLE_ORDERED*/ )
+{
+    mRakPeer.Send( &rBitStream, HIGH_PRIORITY, reliability, 0, guid, false );
+}
+
+void ServerLink::objectChange( Object& rObject, bool created )
+{
+    if( created ) return;
+
+    const String& name = rObject.getName();
+    mGhosts.erase( name );
+    mMigrations.erase( name );
+    mArrivals.erase( name );
+    mOrigins.erase( name );
+
+    // Remove ghosts of the object from neighbors.
+    for( Links::iterator i = mLinks.begin(); i != mLinks.end(); ++i )
+    {
+        if( i->second.mGhosts.erase( name ) )
+        {
+            RakNet::BitStream bitStream;
+            bitStream.Write( (RakNet::MessageID)ID_SERVERLINK_GHOST_REMOVE );
+            bitStream << name;
+            ServerLink::send( bitStream, i->first );
+        }
+    }
+}
+
+Vector3 ServerLink::getOffset( Direction direction )
+{
+    std::pair<short, short> position = GridPosition().getPositionAtDirection( direction );
+    return Vector3( position.first * DIVERSIA_SERVER_SIZE, 0, 
+        position.second * DIVERSIA_SERVER_SIZE );
+}
+
+bool ServerLink::isNear( const Vector3& rPosition, Direction direction, Real margin )
+{
+    std::pair<short, short> position = GridPosition().getPositionAtDirection( direction );
+    Real half = DIVERSIA_SERVER_SIZE / 2.0;
+
+    bool x = position.first == 0 || ( position.first > 0 ? rPosition.x >= half - margin : 
+        rPosition.x < -half + margin );
+    bool z = position.second == 0 || ( position.second > 0 ? rPosition.z >= half - margin : 
+        rPosition.z < -half + margin );
+    return x && z;
+}
+
+bool ServerLink::getCrossedDirection( const Vector3& rPosition, Real margin, 
+    Direction& rDirection )
+{
+    Real half = DIVERSIA_SERVER_SIZE / 2.0;
+    short x = rPosition.x >= half + margin ? 1 : ( rPosition.x < -half - margin ? -1 : 0 );
+    short z = rPosition.z >= half + margin ? 1 : ( rPosition.z < -half - margin ? -1 : 0 );
+    if( !x && !z ) return false;
+
+    for( int i = NORTH; i <= NORTH_WEST; ++i )
+    {
+        std::pair<short, short> position = GridPosition().getPositionAtDirection( (Direction)i );
+        if( position.first == x && position.second == z )
+        {
+            rDirection = (Direction)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+} // Namespace Server
+} // Namespace Diversia
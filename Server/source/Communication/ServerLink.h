@@ -0,0 +1,230 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2008-2010 Diversia
+
+This file is part of Diversia.
+
+Diversia is free software: you can redistribute it and/or modify it under the 
+terms of the GNU General Public License as published by the Free Software 
+Foundation, either version 3 of the License, or (at your option) any later 
+version.
+
+Diversia is distributed in the hope that it will be useful, but WITHOUT ANY 
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with 
+Diversia. If not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
+-----------------------------------------------------------------------------
+*/
+
+#ifndef DIVERSIA_SERVER_SERVERLINK_H
+#define DIVERSIA_SERVER_SERVERLINK_H
+
+#include "Platform/Prerequisites.h"
+
+#include "Shared/Communication/NetworkStage.h"
+#include "Shared/Communication/ServerDirection.h"
+
+namespace Diversia
+{
+namespace Server
+{
+//------------------------------------------------------------------------------
+
+/**
+Link between this server and its neighbors in the server grid, used to hand off objects that 
+cross a grid cell border.
+
+Root objects near a border are mirrored to the neighbor as ghosts. A ghost is a local runtime 
+object on the neighbor that is not replicated to its clients and follows the transform of the 
+original. Its rigid body is kinematic and its scripts are not created, so that the object is not
+simulated twice. When an object leaves the cell of this server it is handed off to the neighbor 
+in that direction, together with the serialized state of its components and child objects, the 
+name of the user that controls it and its physics velocity. The neighbor promotes its ghost (or 
+creates the object) and acknowledges the hand off, only then is the object destroyed here. This 
+server keeps simulating the object until the acknowledgement arrives, so the object always has 
+exactly one authority.
+
+Servers link on their client port plus a port offset. A server connects to its neighbors to the
+north, north east, east and south east and accepts connections from the other neighbors.
+**/
+class ServerLink : public sigc::trackable, public boost::noncopyable
+{
+public:
+    /**
+    Constructor. 
+    
+    @param [in,out] rObjectManager      The object manager to hand off objects from and to.
+    @param [in,out] rNeighbors          The neighbors of this server.
+    @param [in,out] rSessionManager     The session manager to find object controllers in.
+    @param [in,out] rUpdateSignal       The update signal. 
+    **/
+    ServerLink( ServerObjectManager& rObjectManager, ServerNeighborsPlugin& rNeighbors, 
+        SessionManager& rSessionManager, sigc::signal<void>& rUpdateSignal );
+    /**
+    Destructor. 
+    **/
+    ~ServerLink();
+
+    /**
+    Starts listening for and connecting to neighbor servers.
+    **/
+    void listen();
+    /**
+    Disconnects from all neighbor servers. Objects that are being handed off stay on this server.
+    **/
+    void disconnect();
+    /**
+    Query if an object is a ghost of an object on a neighbor server.
+    **/
+    inline bool isGhost( const String& rName ) const { return mGhosts.count( rName ) != 0; }
+    /**
+    Query if an object is being handed off to a neighbor server.
+    **/
+    inline bool isMigrating( const String& rName ) const 
+    { 
+        return mMigrations.count( rName ) != 0; 
+    }
+    /**
+    Gets the amount of linked neighbor servers.
+    **/
+    inline unsigned int getLinkCount() const { return mLinks.size(); }
+
+private:
+    enum Message
+    {
+        ID_SERVERLINK_HELLO = ID_USER_PACKET_ENUM,  ///< Direction of the sender.
+        ID_SERVERLINK_GHOST,                        ///< Ghost is created.
+        ID_SERVERLINK_GHOST_TRANSFORM,              ///< Transforms of all ghosts of a link.
+        ID_SERVERLINK_GHOST_REMOVE,                 ///< Ghost is removed.
+        ID_SERVERLINK_MIGRATE,                      ///< Object is handed off.
+        ID_SERVERLINK_MIGRATE_ACK                   ///< Hand off is accepted or refused.
+    };
+
+    struct Link
+    {
+        Link( Direction direction = NORTH ) : mDirection( direction ) {}
+
+        Direction           mDirection;
+        std::set<String>    mGhosts;    ///< Objects of this server that are ghosted on the link.
+    };
+
+    struct Migration
+    {
+        Migration() : mTimeout( 0 ), mTimedOut( false ), mRefused( false ) {}
+
+        RakNet::RakNetGUID  mLink;
+        RakNet::Time        mTimeout;
+        bool                mTimedOut;  ///< Not acknowledged in time, still waiting for the ack.
+        bool                mRefused;   ///< Refused, tried again after the timeout.
+    };
+
+    struct Arrival
+    {
+        Arrival() : mVelocity( false ), mTimeout( 0 ) {}
+
+        String          mController;
+        bool            mVelocity;
+        Vector3         mLinearVelocity;
+        Vector3         mAngularVelocity;
+        RakNet::Time    mTimeout;
+    };
+
+    typedef std::map<RakNet::RakNetGUID, Link> Links;
+    typedef std::map<String, Migration> Migrations;
+    typedef std::map<String, RakNet::RakNetGUID> Ghosts;
+    typedef std::map<String, Arrival> Arrivals;
+    typedef std::map<String, RakNet::RakNetGUID> Origins;
+
+    void update();
+    void handlePacket( RakNet::Packet& rPacket );
+    void connectNeighbors();
+    void addLink( RakNet::RakNetGUID guid, Direction direction );
+    void removeLink( RakNet::RakNetGUID guid );
+    void updateBorders();
+    void updateArrivals();
+    void migrate( Object& rObject, RakNet::RakNetGUID guid, const Link& rLink );
+    void receiveGhost( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid );
+    void receiveGhostTransform( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid );
+    void receiveGhostRemove( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid );
+    void receiveMigrate( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid );
+    void receiveMigrateAck( RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid );
+    void writeObject( RakNet::BitStream& rBitStream, Object& rObject, const Vector3& rOffset );
+    Object& readObject( RakNet::BitStream& rBitStream, NetworkingType type );
+    void removeGhost( const String& rName );
+    void send( const RakNet::BitStream& rBitStream, RakNet::RakNetGUID guid, 
+        PacketReliability reliability = RELIABLE_ORDERED );
+    void objectChange( Object& rObject, bool created );
+    static Vector3 getOffset( Direction direction );
+    static bool isNear( const Vector3& rPosition, Direction direction, Real margin );
+    static bool getCrossedDirection( const Vector3& rPosition, Real margin, 
+        Direction& rDirection );
+    static inline Direction getOpposite( Direction direction ) 
+    { 
+        return (Direction)( ( direction + 4 ) % 8 ); 
+    }
+
+    RakNet::RakPeerInterface&   mRakPeer;
+    NetworkStage                mNetworkStage;
+    ServerObjectManager&        mObjectManager;
+    ServerNeighborsPlugin&      mNeighbors;
+    SessionManager&             mSessionManager;
+    sigc::connection            mUpdateConnection;
+    sigc::connection            mObjectConnection;
+
+    Links                       mLinks;
+    Migrations                  mMigrations;
+    Ghosts                      mGhosts;        ///< Ghosts on this server and their link.
+    Arrivals                    mArrivals;
+    Origins                     mOrigins;       ///< Handed off objects and their link.
+    bool                        mListening;
+    RakNet::Time                mNextUpdate;
+    RakNet::Time                mNextConnect;
+
+    /**
+    Settings for server links.
+    **/
+    static struct Settings
+    {
+        Settings():
+            mEnabled( false ),
+            mPortOffset( 1 ),
+            mGhostMargin( 50 ),
+            mMigrationMargin( 5 ),
+            mUpdateIntervalMS( 100 ),
+            mAckTimeoutMS( 2000 ),
+            mArrivalTimeoutMS( 10000 ),
+            mConnectIntervalMS( 5000 )
+        {
+        
+        }
+
+        bool            mEnabled;
+        unsigned short  mPortOffset;        ///< Offset from the client port to link on.
+        Real            mGhostMargin;       ///< Distance from a border where ghosts are created.
+        Real            mMigrationMargin;   ///< Distance past a border to hand off at.
+        unsigned int    mUpdateIntervalMS;
+        unsigned int    mAckTimeoutMS;
+        unsigned int    mArrivalTimeoutMS;  ///< Time to wait for the controller and rigid body.
+        unsigned int    mConnectIntervalMS;
+    } msSettings;
+
+public:
+    /**
+    Gets the settings. 
+    **/
+    inline static ServerLink::Settings& getSettings() { return msSettings; }
+
+};
+
+//------------------------------------------------------------------------------
+} // Namespace Server
+} // Namespace Diversia
+
+CAMP_AUTO_TYPE_NONCOPYABLE( Diversia::Server::ServerLink::Settings, 
+    &Diversia::Server::Bindings::CampBindings::bindServerLinkSettings );
+
+#endif // DIVERSIA_SERVER_SERVERLINK_H
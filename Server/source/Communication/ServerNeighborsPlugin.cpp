@@ -27,6 +27,7 @@ THE SOFTWARE.
 #include "Platform/StableHeaders.h"
 
 #include "Communication/ServerNeighborsPlugin.h"
+#include "Object/DirtyReplicas.h"
 
 namespace Diversia
 {
@@ -37,9 +38,17 @@ namespace Server
 ServerNeighborsPlugin::ServerNeighborsPlugin( Mode mode, ClientPluginManager& rPluginManager, 
     RakNet::RakPeerInterface& rRakPeer, RakNet::ReplicaManager3& rReplicaManager, 
     RakNet::NetworkIDManager& rNetworkIDManager ):
-    ClientPlugin( mode, rPluginManager, rRakPeer, rReplicaManager, rNetworkIDManager )
+    ClientPlugin( mode, rPluginManager, rRakPeer, rReplicaManager, rNetworkIDManager ),
+    mSerializedNeighborsVersion( 0 )
 {
+    mUpdateConnection = rPluginManager.getUpdateSignal().connect( sigc::mem_fun( this, 
+        &ServerNeighborsPlugin::update ) );
+}
 
+ServerNeighborsPlugin::~ServerNeighborsPlugin()
+{
+    mUpdateConnection.disconnect();
+    DirtyReplicas::unmark( *this );
 }
 
 void ServerNeighborsPlugin::SerializeConstruction( RakNet::BitStream* pConstructionBitstream, 
@@ -52,11 +61,27 @@ void ServerNeighborsPlugin::SerializeConstruction( RakNet::BitStream* pConstruct
 RakNet::RM3SerializationResult ServerNeighborsPlugin::Serialize( 
     RakNet::SerializeParameters* pSerializeParameters )
 {
-    // Send neighbor map.
-    pSerializeParameters->outputBitstream[0] << mServerNeighbors;
+    const NeighborsMap& neighbors = mServerNeighbors.getNeighbors();
+    mSerializedNeighborsVersion = mServerNeighbors.getVersion();
+    if( !mapDiffers( mSerializedNeighbors, neighbors ) ) return RakNet::RM3SR_DO_NOT_SERIALIZE;
 
-    // Let RakNet figure out if the neighbors should be serialized.
-    return RakNet::RM3SR_BROADCAST_IDENTICALLY;
+    // Send the changes since the last serialization, the same changes are sent to all clients.
+    // Clients that were constructed in between receive changes they already have, applying those
+    // again does no harm.
+    writeMapDelta( pSerializeParameters->outputBitstream[0], mSerializedNeighbors, neighbors );
+    mSerializedNeighbors = neighbors;
+
+    return RakNet::RM3SR_SERIALIZED_ALWAYS_IDENTICALLY;
+}
+
+RakNet::RM3QuerySerializationResult ServerNeighborsPlugin::QuerySerialization( 
+    RakNet::Connection_RM3* pDestinationConnection )
+{
+    // Neighbors are not property synchronized, only serialize when they have changed.
+    if( mServerNeighbors.getVersion() != mSerializedNeighborsVersion )
+        return RakNet::RM3QSR_CALL_SERIALIZE;
+    else
+        return RakNet::RM3QSR_DO_NOT_CALL_SERIALIZE;
 }
 
 void ServerNeighborsPlugin::create()
@@ -64,6 +89,12 @@ void ServerNeighborsPlugin::create()
 
 }
 
+void ServerNeighborsPlugin::update()
+{
+    if( mServerNeighbors.getVersion() != mSerializedNeighborsVersion ) 
+        DirtyReplicas::mark( *this );
+}
+
 //------------------------------------------------------------------------------
 } // Namespace Client
 } // Namespace Diversia
\ No newline at end of file
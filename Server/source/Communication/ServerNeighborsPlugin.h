@@ -53,6 +53,10 @@ public:
     ServerNeighborsPlugin( Mode mode, ClientPluginManager& rPluginManager, 
         RakNet::RakPeerInterface& rRakPeer, RakNet::ReplicaManager3& rReplicaManager, 
         RakNet::NetworkIDManager& rNetworkIDManager );
+    /**
+    Destructor. 
+    **/
+    ~ServerNeighborsPlugin();
     
     /**
     Gets the plugin type.
@@ -64,6 +68,10 @@ public:
     **/
     inline String getTypeName() const { return CLIENTSERVERPLUGINNAME_SERVERNEIGHBORS; }
     static inline String getTypeNameStatic() { return CLIENTSERVERPLUGINNAME_SERVERNEIGHBORS; }
+    /**
+    Gets the neighbors of this server.
+    **/
+    inline ServerNeighbors& getServerNeighbors() { return mServerNeighbors; }
 
 private:
     friend class Bindings::CampBindings;    ///< Allow private access for camp bindings.
@@ -73,14 +81,24 @@ private:
 	plugin is created.
 	**/
     void create();
+    /**
+    Marks the plugin dirty for serialization when the neighbors have changed, neighbors are 
+    changed through their own bindings so there is no change notification.
+    **/
+    void update();
 
     // TODO: Use property syncing once camp supports std::map.
     void SerializeConstruction( RakNet::BitStream* pConstructionBitstream, 
         RakNet::Connection_RM3* pDestinationConnection );
     RakNet::RM3SerializationResult Serialize( 
         RakNet::SerializeParameters* pSerializeParameters );
+    RakNet::RM3QuerySerializationResult QuerySerialization( 
+        RakNet::Connection_RM3* pDestinationConnection );
 
     ServerNeighbors mServerNeighbors;
+    NeighborsMap    mSerializedNeighbors;           ///< Neighbors as last sent to all clients.
+    unsigned int    mSerializedNeighborsVersion;
+    sigc::connection mUpdateConnection;
 
     CAMP_RTTI()
 
@@ -38,6 +38,7 @@ PhysicsManager*             Globals::mPhysics = 0;
 btDiscreteDynamicsWorld*    Globals::mWorld = 0;
 btAxisSweep3*               Globals::mBroadphase = 0;
 LuaManager*                 Globals::mLua = 0;
+RequestManager*             Globals::mRequest = 0;
 
 sigc::signal<void>*         Globals::mUpdateSignal = 0;
 sigc::signal<void, Real>*   Globals::mFrameSignal = 0;
@@ -46,6 +46,7 @@ public:
     static btDiscreteDynamicsWorld* mWorld;
     static btAxisSweep3*            mBroadphase;
     static LuaManager*              mLua;
+    static RequestManager*          mRequest;
 
     static sigc::signal<void>*          mUpdateSignal;
     static sigc::signal<void, Real>*    mFrameSignal;
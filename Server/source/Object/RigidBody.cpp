@@ -74,6 +74,39 @@ void RigidBody::setMass( Real mass )
     }
 }
 
+void RigidBody::setPhysicsType( PhysicsType type )
+{
+    if( mPhysicsType == type ) return;
+    mPhysicsType = type;
+
+    // Rigid body is not created yet, the physics type will be used when it is created.
+    if( !mRigidBody || !mCollisionShape ) return;
+
+    // Bullet only picks up mass and collision flag changes when the body is added to the world.
+    Globals::mPhysics->removeBody( *mRigidBody );
+
+    Real mass = mPhysicsType == PHYSICSTYPE_DYNAMIC ? mMass : 0;
+    btVector3 inertia( 0, 0, 0 );
+    mCollisionShape->calculateLocalInertia( mass, inertia );
+    mRigidBody->setMassProps( mass, inertia );
+    mRigidBody->updateInertiaTensor();
+
+    if( mPhysicsType == PHYSICSTYPE_KINEMATIC )
+    {
+        mRigidBody->setCollisionFlags( mRigidBody->getCollisionFlags() |
+            btCollisionObject::CF_KINEMATIC_OBJECT );
+        mRigidBody->setActivationState( DISABLE_DEACTIVATION );
+    }
+    else
+    {
+        mRigidBody->setCollisionFlags( mRigidBody->getCollisionFlags() &
+            ~btCollisionObject::CF_KINEMATIC_OBJECT );
+        mRigidBody->forceActivationState( ACTIVE_TAG );
+    }
+
+    Globals::mPhysics->addBody( *mRigidBody );
+}
+
 void RigidBody::create()
 {
     try
@@ -125,16 +158,17 @@ void RigidBody::collisionShapeLoaded( CollisionShape& rCollisionShape )
                 Component::getObject()._getDerivedScale() ) * mCollisionMarginScaling );
         }
 
-        // Check mass
+        // Check mass, keep the mass itself so that the physics type can be changed later.
+        Real mass = mMass;
         if( mPhysicsType == PHYSICSTYPE_STATIC || mPhysicsType == PHYSICSTYPE_KINEMATIC )
-            mMass = 0;
+            mass = 0;
 
         // Calculate inertia
         btVector3 inertia;
-        mCollisionShape->calculateLocalInertia( mMass, inertia );
+        mCollisionShape->calculateLocalInertia( mass, inertia );
 
         // Create the rigid body.
-        mRigidBody = new btRigidBody( mMass, this, mCollisionShape, inertia );
+        mRigidBody = new btRigidBody( mass, this, mCollisionShape, inertia );
         mRigidBody->setUserPointer( this );
 
         // If physics type is kinematic set the body to be kinematic.
@@ -149,7 +183,7 @@ void RigidBody::collisionShapeLoaded( CollisionShape& rCollisionShape )
 
         LOGD << "Adding " << camp::enumByType<PhysicsType>().name( mPhysicsType ) << 
             " " << camp::enumByType<PhysicsShape>().name( mShapeType ) << " rigid body" <<
-            " with mass " << mMass << ", scale " << Component::getObject().getScale() << 
+            " with mass " << mass << ", scale " << Component::getObject().getScale() << 
             ", friction " << mRigidBody->getFriction() << ", restitution " << 
             mRigidBody->getRestitution();
 
@@ -88,6 +88,14 @@ public:
     **/
     void setMass( Real mass );
     /**
+    Gets the physics type.
+    **/
+    inline PhysicsType getPhysicsType() const { return mPhysicsType; }
+    /**
+    Sets the physics type, an already created rigid body is changed in place.
+    **/
+    void setPhysicsType( PhysicsType type );
+    /**
     Gets the linear dampening. 
     **/
     inline Real getLinearDampening() const { return mRigidBody->getLinearDamping(); }
@@ -26,8 +26,10 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "Object/ServerObject.h"
 #include "Object/ComponentFactoryManager.h"
 #include "Object/ComponentFactory.h"
+#include "Object/ComponentTemplate.h"
 #include "Permission/PermissionManager.h"
 #include "Shared/Camp/CampStringInterpreter.h"
+#include "Shared/Communication/ReplicaConnection.h"
 
 namespace Diversia
 {
@@ -39,8 +41,17 @@ ServerComponent::ServerComponent( const String& rName, Mode mode, NetworkingType
     ComponentType type, RakNet::RakNetGUID source, bool localOverride, ServerObject& rObject ):
     Component( rName, mode, networkingType, type, source, localOverride, rObject ),
     PropertySynchronization( mode ),
-    mPermissionManager( rObject.getPermissionManager() )
+    mPermissionManager( rObject.getPermissionManager() ),
+    mCreatePermission( ComponentFactoryManager::getComponentFactory( type ).getTypeName() + 
+        String( "_Create" ) )
 {
+    // Compose the property permission prefixes once instead of for every deserialized property.
+    const String& typeName = ComponentFactoryManager::getComponentFactory( type ).getTypeName();
+    mInsertValuePermission[0] = String( "InsertValueInOther" ) + typeName + String( "Component_" );
+    mInsertValuePermission[1] = String( "InsertValueInOwn" ) + typeName + String( "Component_" );
+    mSetPropertyPermission[0] = String( "SetPropertyOnOther" ) + typeName + String( "Component_" );
+    mSetPropertyPermission[1] = String( "SetPropertyOnOwn" ) + typeName + String( "Component_" );
+
     // Need to use the source here because CreatingSystemGUID has not been set yet.
     if( ServerComponent::getNetworkingType() == REMOTE && 
         !Component::isCreatedByServer() )
@@ -61,9 +72,7 @@ ServerComponent::ServerComponent( const String& rName, Mode mode, NetworkingType
         }
 
         // Permission name: <Component>_Create
-        mPermissionManager.getPermission( source, 
-            ComponentFactoryManager::getComponentFactory( 
-            mType ).getTypeName() + String( "_Create" ) ).addItem();
+        mPermissionManager.getPermission( source, mCreatePermission ).addItem();
     }
 }
 
@@ -89,8 +98,7 @@ ServerComponent::~ServerComponent()
 
         // Permission name: <Component>_Create
         mPermissionManager.getPermission( Component::getSourceGUID(), 
-            ComponentFactoryManager::getComponentFactory( 
-            mType ).getTypeName() + String( "_Create" ) ).removeItem();
+            mCreatePermission ).removeItem();
     }
 }
 
@@ -103,9 +111,8 @@ void ServerComponent::querySetPropertyDeserialize( const String& rQuery, camp::V
     RakNet::RakNetGUID source )
 {
     // Permission name: InsertValueIn<Ownership><ComponentName>Component_<PropertyName>
-    mPermissionManager.checkPermissionThrows( source, String( "InsertValueIn" ) + 
-        String( Component::isCreatedBySource( source ) ? "Own" : "Other" ) + 
-        getTypeName() + String( "Component_" ) + 
+    mPermissionManager.checkPermissionThrows( source, 
+        mInsertValuePermission[Component::isCreatedBySource( source )] + 
         CampStringInterpreter::removeArrayIdentifiers( rQuery ), 
         rValue, "ServerComponent::querySetPropertyDeserialize" );
 }
@@ -114,19 +121,55 @@ void ServerComponent::queryInsertPropertyDeserialize( const String& rQuery, camp
     RakNet::RakNetGUID source )
 {
     // Permission name: SetPropertyOn<Ownership><ComponentName>Component_<PropertyName>
-    mPermissionManager.checkPermissionThrows( source, String( "SetPropertyOn" ) + 
-        String( Component::isCreatedBySource( source ) ? "Own" : "Other" ) + 
-        getTypeName() + String( "Component_" ) + 
+    mPermissionManager.checkPermissionThrows( source, 
+        mSetPropertyPermission[Component::isCreatedBySource( source )] + 
         CampStringInterpreter::removeArrayIdentifiers( rQuery ), 
         rValue, "ServerComponent::queryInsertPropertyDeserialize" );
 }
 
+RakNet::Replica3* ServerComponent::getConstructionReference( 
+    RakNet::Connection_RM3* pDestinationConnection, const PropertyValueMap*& rpProperties )
+{
+    // Construct the component relative to the component template it was created from, so that
+    // only the properties that differ from the template are sent. Many objects spawned by the 
+    // server from the same template (NPCs) then cost about a bit per unchanged property.
+    ComponentTemplate* componentTemplate = Component::getTemplate();
+    if( componentTemplate && componentTemplate->getNetworkingType() == REMOTE && 
+        pDestinationConnection->HasReplicaConstructed( componentTemplate ) )
+    {
+        rpProperties = &componentTemplate->getProperties();
+        return componentTemplate;
+    }
+
+    return 0;
+}
+
+const PropertyValueMap* ServerComponent::getConstructionReferenceProperties( 
+    RakNet::NetworkID networkID )
+{
+    RakNet::Replica3* replica = Replica3::GetNetworkIDManager()->
+        GET_OBJECT_FROM_ID<RakNet::Replica3*>( networkID );
+    ComponentTemplate* componentTemplate = dynamic_cast<ComponentTemplate*>( replica );
+    if( componentTemplate ) return &componentTemplate->getProperties();
+
+    return 0;
+}
+
 RakNet::RM3ConstructionState ServerComponent::QueryConstruction( 
     RakNet::Connection_RM3* pDestinationConnection, RakNet::ReplicaManager3* pReplicaManager3 )
 {
+    // Components share the relevance of their object.
+    if( Component::getMode() == SERVER && 
+        !ServerComponent::getServerObject().isRelevant( pDestinationConnection->GetRakNetGUID() ) )
+    {
+        return RakNet::RM3CS_NO_ACTION;
+    }
+
     // No permission checking needed, this is only called if the server creates a component.
-    return Replica3::QueryConstruction_ClientConstruction( pDestinationConnection,
-        Component::getMode() == SERVER ? true : false );
+    RakNet::RM3ConstructionState state = Replica3::QueryConstruction_ClientConstruction( 
+        pDestinationConnection, Component::getMode() == SERVER ? true : false );
+    return static_cast<ReplicaConnection*>( pDestinationConnection )->getWorldSnapshot(
+        ).queryConstruction( *this, state, *pReplicaManager3 );
 }
 
 bool ServerComponent::QueryRemoteConstruction( RakNet::Connection_RM3* pSourceConnection )
@@ -135,9 +178,24 @@ bool ServerComponent::QueryRemoteConstruction( RakNet::Connection_RM3* pSourceCo
     return true;
 }
 
+RakNet::RM3DestructionState ServerComponent::QueryDestruction( 
+    RakNet::Connection_RM3* pDestinationConnection, RakNet::ReplicaManager3* pReplicaManager3 )
+{
+    if( Component::getMode() == SERVER && 
+        !ServerComponent::getServerObject().isRelevant( pDestinationConnection->GetRakNetGUID() ) )
+    {
+        return RakNet::RM3DS_SEND_DESTRUCTION;
+    }
+
+    return RakNet::RM3DS_NO_ACTION;
+}
+
 RakNet::RM3QuerySerializationResult ServerComponent::QuerySerialization( 
     RakNet::Connection_RM3* pDestinationConnection )
 {
+    if( !ServerComponent::getServerObject().isRelevant( pDestinationConnection->GetRakNetGUID() ) )
+        return RakNet::RM3QSR_DO_NOT_CALL_SERIALIZE;
+
     // Allow serializations for components created by the same client. Override and replace this 
     // behavior if needed.
 /*
@@ -201,8 +259,8 @@ void ServerComponent::SerializeConstruction( RakNet::BitStream* pConstructionBit
 bool ServerComponent::DeserializeConstruction( RakNet::BitStream* pConstructionBitstream, 
     RakNet::Connection_RM3* pSourceConnection )
 {
-    PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, pSourceConnection );
-    return true;
+    return PropertySynchronization::doDeserializeConstruction( pConstructionBitstream, 
+        pSourceConnection );
 }
 
 RakNet::RM3SerializationResult ServerComponent::Serialize( 
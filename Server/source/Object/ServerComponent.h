@@ -76,6 +76,9 @@ protected:
         RakNet::RakNetGUID source );
     void queryInsertPropertyDeserialize( const String& rQuery, camp::Value& rValue, 
         RakNet::RakNetGUID source );
+    RakNet::Replica3* getConstructionReference( RakNet::Connection_RM3* pDestinationConnection, 
+        const PropertyValueMap*& rpProperties );
+    const PropertyValueMap* getConstructionReferenceProperties( RakNet::NetworkID networkID );
 
     /**
     Implemented in ServerComponent, but can be overridden.
@@ -84,6 +87,9 @@ protected:
         RakNet::Connection_RM3* pDestinationConnection, 
         RakNet::ReplicaManager3* pReplicaManager3 );
     virtual bool QueryRemoteConstruction( RakNet::Connection_RM3* pSourceConnection );
+    virtual RakNet::RM3DestructionState QueryDestruction( 
+        RakNet::Connection_RM3* pDestinationConnection, 
+        RakNet::ReplicaManager3* pReplicaManager3 );
     virtual RakNet::RM3QuerySerializationResult QuerySerialization( 
         RakNet::Connection_RM3* pDestinationConnection );
     inline virtual void SerializeDestruction( RakNet::BitStream* pDestructionBitstream, 
@@ -101,13 +107,24 @@ protected:
     virtual RakNet::RM3SerializationResult Serialize( 
         RakNet::SerializeParameters* pSerializeParameters );
     virtual void Deserialize( RakNet::DeserializeParameters* pDeserializeParameters );
+    inline virtual unsigned char getReplicaType() const { return REPLICATYPE_COMPONENT; }
+    /**
+    Components are owned by the client that controls their object.
+    **/
+    inline virtual RakNet::RakNetGUID getPropertyOwner() 
+    { 
+        return ServerComponent::getServerObject().getClientController(); 
+    }
 
     ResourceList mResourceList;
 
 private:
     friend class Bindings::CampBindings;    ///< Allow private access for camp bindings.
 
-    PermissionManager& mPermissionManager;
+    PermissionManager&  mPermissionManager;
+    String              mCreatePermission;
+    String              mInsertValuePermission[2];  ///< Indexed by ownership, other = 0, own = 1.
+    String              mSetPropertyPermission[2];  ///< Indexed by ownership, other = 0, own = 1.
 
     CAMP_RTTI()
 
@@ -22,6 +22,8 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 
 #include "Platform/StableHeaders.h"
 
+#include "Communication/InterestManager.h"
+#include "Communication/ReplicationScheduler.h"
 #include "Object/ServerObject.h"
 #include "Object/ServerObjectManager.h"
 #include "Object/ComponentFactoryManager.h"
@@ -29,6 +31,8 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "Object/Component.h"
 
 #include "Permission/PermissionManager.h"
+#include "Shared/Communication/ReplicaConnection.h"
+#include "Shared/Communication/TrafficStatistics.h"
 
 namespace Diversia
 {
@@ -36,6 +40,9 @@ namespace Server
 {
 //------------------------------------------------------------------------------
 
+/// Time in seconds of movement that a controlling client can save up.
+static const Real cMaxControlBurst = 0.5;
+
 ServerObject::ServerObject( const String& rName, Mode mode, NetworkingType type, 
     const String& rDisplayName, RakNet::RakNetGUID source, RakNet::RakNetGUID ownGUID,
     RakNet::RakNetGUID serverGUID, sigc::signal<void>& rUpdateSignal, 
@@ -44,7 +51,15 @@ ServerObject::ServerObject( const String& rName, Mode mode, NetworkingType type,
     RakNet::RPC3& rRPC3 ):
     Object( rName, mode, type, rDisplayName, source, ownGUID, serverGUID, rUpdateSignal, 
         rObjectManager, rReplicaManager, rNetworkIDManager, rRPC3 ),
-    mPermissionManager( rPermissionManager )
+    mPermissionManager( rPermissionManager ),
+    mInterestManager( rObjectManager.getInterestManager() ),
+    mReplicationScheduler( rObjectManager.getReplicationScheduler() ),
+    mRelevanceRadius( 0 ),
+    mViewRadius( 0 ),
+    mReplicationPriority( 1 ),
+    mMaxControlSpeed( 0 ),
+    mControlBudget( 0 ),
+    mLastControlTime( 0 )
 {
     if( ServerObject::getNetworkingType() == REMOTE && !Object::isCreatedByServer() )
     {
@@ -136,9 +151,150 @@ void ServerObject::queryDestroyComponent( Component& rComponent, RakNet::RakNetG
 RakNet::RM3ConstructionState ServerObject::QueryConstruction( 
     RakNet::Connection_RM3* pDestinationConnection, RakNet::ReplicaManager3* pReplicaManager3 )
 {
+    // Wait with construction until the object is relevant to the client.
+    if( Object::getMode() == SERVER && 
+        !ServerObject::isRelevant( pDestinationConnection->GetRakNetGUID() ) )
+    {
+        return RakNet::RM3CS_NO_ACTION;
+    }
+
     // Always allow the server to create objects.
-    return Replica3::QueryConstruction_ClientConstruction( pDestinationConnection,
-        Object::getMode() == SERVER ? true : false );
+    RakNet::RM3ConstructionState state = Replica3::QueryConstruction_ClientConstruction( 
+        pDestinationConnection, Object::getMode() == SERVER ? true : false );
+    state = static_cast<ReplicaConnection*>( pDestinationConnection )->getWorldSnapshot(
+        ).queryConstruction( *this, state, *pReplicaManager3 );
+
+    // Changes made while the world snapshot was streamed to the client were not scheduled for 
+    // the client, serialize the full state.
+    if( state == RakNet::RM3CS_ALREADY_EXISTS_REMOTELY && Object::getMode() == SERVER && 
+        ReplicationScheduler::getSettings().mEnabled )
+    {
+        mReplicationScheduler.addChanges( *this, pDestinationConnection->GetRakNetGUID(), 
+            Object::SC_ALL & ~Object::SC_CORRECTION );
+    }
+
+    return state;
+}
+
+RakNet::RM3DestructionState ServerObject::QueryDestruction( 
+    RakNet::Connection_RM3* pDestinationConnection, RakNet::ReplicaManager3* pReplicaManager3 )
+{
+    // Destroy the object on clients it is no longer relevant to, it will be constructed again 
+    // when it becomes relevant.
+    if( Object::getMode() == SERVER && 
+        !ServerObject::isRelevant( pDestinationConnection->GetRakNetGUID() ) )
+    {
+        return RakNet::RM3DS_SEND_DESTRUCTION;
+    }
+
+    return RakNet::RM3DS_NO_ACTION;
+}
+
+RakNet::RM3QuerySerializationResult ServerObject::QuerySerialization( 
+    RakNet::Connection_RM3* pDestinationConnection )
+{
+    if( !ServerObject::isRelevant( pDestinationConnection->GetRakNetGUID() ) )
+        return RakNet::RM3QSR_DO_NOT_CALL_SERIALIZE;
+
+    // Serialize to clients according to their bandwidth budget.
+    if( Object::getMode() == SERVER && ReplicationScheduler::getSettings().mEnabled )
+    {
+        if( mReplicationScheduler.isScheduled( *this, pDestinationConnection->GetRakNetGUID() ) )
+            return RakNet::RM3QSR_CALL_SERIALIZE;
+        else
+            return RakNet::RM3QSR_DO_NOT_CALL_SERIALIZE;
+    }
+
+    return Object::QuerySerialization( pDestinationConnection );
+}
+
+RakNet::RM3SerializationResult ServerObject::Serialize( 
+    RakNet::SerializeParameters* pSerializeParameters )
+{
+    if( Object::getMode() != SERVER || !ReplicationScheduler::getSettings().mEnabled )
+    {
+        // Serialize is called for every destination, only record the traffic to this one.
+        RakNet::RM3SerializationResult result = Object::Serialize( pSerializeParameters );
+        if( result != RakNet::RM3SR_DO_NOT_SERIALIZE )
+        {
+            ServerObject::recordTraffic( pSerializeParameters, 
+                pSerializeParameters->destinationConnection->GetRakNetGUID() );
+        }
+        return result;
+    }
+
+    RakNet::RakNetGUID client = pSerializeParameters->destinationConnection->GetRakNetGUID();
+    unsigned char changes = mReplicationScheduler.takeChanges( *this, client );
+    if( !changes ) return RakNet::RM3SR_DO_NOT_SERIALIZE;
+
+    // Deferred changes are merged per client so the serialization differs per client.
+    Object::serializeChanges( pSerializeParameters, changes );
+    ServerObject::recordTraffic( pSerializeParameters, client );
+
+    unsigned int bytes = 0;
+    for( unsigned int i = 0; i < RakNet::RM3_NUM_OUTPUT_BITSTREAM_CHANNELS; ++i )
+        bytes += pSerializeParameters->outputBitstream[i].GetNumberOfBytesUsed();
+    mReplicationScheduler.charge( client, bytes );
+    return RakNet::RM3SR_SERIALIZED_ALWAYS;
+}
+
+void ServerObject::recordTraffic( RakNet::SerializeParameters* pSerializeParameters, 
+    RakNet::RakNetGUID connection ) const
+{
+    if( !TrafficStatistics::getSettings().mEnabled ) return;
+
+    RakNet::BitSize_t parent = pSerializeParameters->outputBitstream[0].GetNumberOfBitsUsed() + 
+        pSerializeParameters->outputBitstream[1].GetNumberOfBitsUsed();
+    RakNet::BitSize_t displayName = 
+        pSerializeParameters->outputBitstream[2].GetNumberOfBitsUsed();
+    RakNet::BitSize_t transform = pSerializeParameters->outputBitstream[3].GetNumberOfBitsUsed();
+
+    TrafficStatistics::record( connection, REPLICATYPE_OBJECT, "Object", "", 
+        parent + displayName + transform );
+    if( parent ) 
+        TrafficStatistics::record( connection, REPLICATYPE_OBJECT, "Object", "Parent", parent );
+    if( displayName )
+    {
+        TrafficStatistics::record( connection, REPLICATYPE_OBJECT, "Object", "DisplayName", 
+            displayName );
+    }
+    if( transform )
+    {
+        TrafficStatistics::record( connection, REPLICATYPE_OBJECT, "Object", "Transform", 
+            transform );
+    }
+}
+
+bool ServerObject::correctControlledTransform( Vector3& rPosition, Quaternion& rOrientation, 
+    RakNet::Time time )
+{
+    if( mMaxControlSpeed <= 0 ) return false;
+
+    // Movement can be saved up for a short time to absorb jitter in the input rate.
+    const Real maxBudget = mMaxControlSpeed * cMaxControlBurst;
+    if( !mLastControlTime )
+        mControlBudget = maxBudget;
+    else if( time > mLastControlTime )
+        mControlBudget = std::min( mControlBudget + mMaxControlSpeed * 
+            ( ( time - mLastControlTime ) / (Real)1000 ), maxBudget );
+    mLastControlTime = time;
+
+    Vector3 movement = rPosition - Object::getPosition();
+    Real distance = movement.length();
+    if( distance <= mControlBudget )
+    {
+        mControlBudget -= distance;
+        return false;
+    }
+
+    rPosition = Object::getPosition() + movement * ( mControlBudget / distance );
+    mControlBudget = 0;
+    return true;
+}
+
+bool ServerObject::isRelevant( RakNet::RakNetGUID client ) const
+{
+    return mInterestManager.isRelevant( *this, client );
 }
 
 bool ServerObject::QueryRemoteConstruction( RakNet::Connection_RM3* pSourceConnection )
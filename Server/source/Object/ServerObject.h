@@ -41,9 +41,59 @@ public:
     Gets the permission manager. 
     **/
     inline PermissionManager& getPermissionManager() const { return mPermissionManager; }
+    /**
+    Query if this object is relevant to given client, irrelevant objects are not constructed on
+    and not serialized to that client.
+
+    @param  client  The GUID of the client.
+    **/
+    bool isRelevant( RakNet::RakNetGUID client ) const;
+    /**
+    Sets the distance from a client's viewpoint within which this object is relevant to that
+    client. 0 uses the view radius of the viewpoint, a negative value makes the object relevant to
+    all clients.
+    **/
+    inline void setRelevanceRadius( Real radius ) 
+    { 
+        mRelevanceRadius = radius; 
+        Object::markChanged(); 
+    }
+    /**
+    Gets the relevance radius.
+    **/
+    inline Real getRelevanceRadius() const { return mRelevanceRadius; }
+    /**
+    Sets the view radius of this object when a client controls it, objects within this radius are
+    relevant to that client. 0 uses the default view radius.
+    **/
+    inline void setViewRadius( Real radius ) { mViewRadius = radius; Object::markChanged(); }
+    /**
+    Gets the view radius.
+    **/
+    inline Real getViewRadius() const { return mViewRadius; }
+    /**
+    Sets the replication priority of this object, objects with a higher priority are serialized
+    more often when the bandwidth of a client is limited. Defaults to 1.
+    **/
+    inline void setReplicationPriority( Real priority ) { mReplicationPriority = priority; }
+    /**
+    Gets the replication priority.
+    **/
+    inline Real getReplicationPriority() const { return mReplicationPriority; }
+    /**
+    Sets the maximum speed in units per second at which the client that controls this object may
+    move it, faster movement is corrected. 0 does not limit the speed.
+    **/
+    inline void setMaxControlSpeed( Real speed ) { mMaxControlSpeed = speed; }
+    /**
+    Gets the maximum control speed.
+    **/
+    inline Real getMaxControlSpeed() const { return mMaxControlSpeed; }
 
 private:
     friend class ServerObjectManager;	///< Only the ServerObjectManager class may construct objects. 
+    friend class Bindings::CampBindings;    ///< Allow private access for camp bindings.
+    friend class ReplicationScheduler;  ///< Takes and estimates serialization changes.
     friend void camp::detail::destroy<ServerObject>( const UserObject& object );  ///< Allow private access for camp.
 
     ServerObject( const String& rName, Mode mode, NetworkingType type, const String& rDisplayName,
@@ -65,10 +115,27 @@ private:
         RakNet::Connection_RM3* pDestinationConnection, 
         RakNet::ReplicaManager3* pReplicaManager3 );
     bool QueryRemoteConstruction( RakNet::Connection_RM3* pSourceConnection );
+    RakNet::RM3DestructionState QueryDestruction( RakNet::Connection_RM3* pDestinationConnection, 
+        RakNet::ReplicaManager3* pReplicaManager3 );
+    RakNet::RM3QuerySerializationResult QuerySerialization( 
+        RakNet::Connection_RM3* pDestinationConnection );
+    RakNet::RM3SerializationResult Serialize( RakNet::SerializeParameters* pSerializeParameters );
+    void recordTraffic( RakNet::SerializeParameters* pSerializeParameters, 
+        RakNet::RakNetGUID connection ) const;
+    bool correctControlledTransform( Vector3& rPosition, Quaternion& rOrientation, 
+        RakNet::Time time );
     bool DeserializeDestruction( RakNet::BitStream* pDestructionBitstream, 
         RakNet::Connection_RM3* pSourceConnection );
 
-    PermissionManager&  mPermissionManager;
+    PermissionManager&      mPermissionManager;
+    InterestManager&        mInterestManager;
+    ReplicationScheduler&   mReplicationScheduler;
+    Real                    mRelevanceRadius;
+    Real                    mViewRadius;
+    Real                    mReplicationPriority;
+    Real                    mMaxControlSpeed;
+    Real                    mControlBudget;
+    RakNet::Time            mLastControlTime;
 
     CAMP_RTTI()
 
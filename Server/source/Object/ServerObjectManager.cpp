@@ -23,6 +23,8 @@ You may contact the author of Diversia by e-mail at: equabyte@sonologic.nl
 #include "Platform/StableHeaders.h"
 
 #include "ClientServerPlugin/ClientPluginManager.h"
+#include "Communication/InterestManager.h"
+#include "Communication/ReplicationScheduler.h"
 #include "Object/ServerObject.h"
 #include "Object/ServerObjectManager.h"
 #include "Permission/PermissionManager.h"
@@ -40,7 +42,10 @@ ServerObjectManager::ServerObjectManager( Mode mode, sigc::signal<void>& rUpdate
     ObjectManager( mode, rRakPeer.GetMyGUID(), rRakPeer.GetMyGUID(), rUpdateSignal, 
         rReplicaManager, rNetworkIDManager, rPluginManager.getRPC3() ),
     ClientPlugin( mode, rPluginManager, rRakPeer, rReplicaManager, rNetworkIDManager ),
-    mPermissionManager( rPluginManager.getPlugin<PermissionManager>() )
+    mPermissionManager( rPluginManager.getPlugin<PermissionManager>() ),
+    mInterestManager( new InterestManager( *this, rReplicaManager, rUpdateSignal ) ),
+    mReplicationScheduler( new ReplicationScheduler( *this, *mInterestManager, rReplicaManager, 
+        rUpdateSignal ) )
 {
     PropertySynchronization::storeUserObject();
 
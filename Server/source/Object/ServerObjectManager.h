@@ -65,6 +65,14 @@ public:
     **/
     inline String getTypeName() const { return CLIENTSERVERPLUGINNAME_OBJECTMANAGER; }
     static inline String getTypeNameStatic() { return CLIENTSERVERPLUGINNAME_OBJECTMANAGER; }
+    /**
+    Gets the interest manager that determines which objects are relevant to which client.
+    **/
+    inline InterestManager& getInterestManager() { return *mInterestManager; }
+    /**
+    Gets the replication scheduler that limits the bandwidth used per client.
+    **/
+    inline ReplicationScheduler& getReplicationScheduler() { return *mReplicationScheduler; }
     
 private:
     friend class ServerObject;	///< For delayed destruction.
@@ -79,7 +87,9 @@ private:
 	**/
     void create();
 
-    PermissionManager&  mPermissionManager;
+    PermissionManager&                      mPermissionManager;
+    boost::scoped_ptr<InterestManager>      mInterestManager;
+    boost::scoped_ptr<ReplicationScheduler> mReplicationScheduler;
 
     CAMP_RTTI()
 
@@ -56,6 +56,10 @@ class ResourceManagerPlugin;
 
 // Communication
 class ClientConnection;
+class IdleWorldBenchmark;
+class InterestManager;
+class ReplicationScheduler;
+class ServerLink;
 class ServerNeighborsPlugin;
 
 // Game mode